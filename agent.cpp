@@ -0,0 +1,215 @@
+#include "agent.hpp"
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace system_monitor {
+
+    Agent::Agent(std::string address, uint16_t port, std::string name)
+        : address_(std::move(address)), port_(port), name_(std::move(name)) {}
+
+    Agent::~Agent() {
+        disconnect();
+    }
+
+    std::string Agent::local_name() {
+        char name[256] = {};
+        if(gethostname(name, sizeof(name) - 1) != 0) return "localhost";
+        return name;
+    }
+
+    bool Agent::send(const HostSample& sample) {
+        if(!connect()) return false;
+        encoder_.append(out_, sample);
+        return write_all();
+    }
+
+    bool Agent::connect() {
+        if(fd_ >= 0 && !connecting_) return true;
+        auto now = std::chrono::steady_clock::now();
+        if(fd_ < 0) {
+            if(now < retry_at_) return false;
+            retry_at_ = now + retry_interval;
+
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            std::string port = std::to_string(port_);
+            if(getaddrinfo(address_.c_str(), port.c_str(), &hints, &addresses_) != 0) {
+                addresses_ = nullptr;
+                return false;
+            }
+            candidate_ = addresses_;
+            connect_deadline_ = now + connect_timeout;
+            if(!start_connect()) return false;
+        }
+
+        // Writable once the handshake is over, SO_ERROR tells how it went
+        pollfd pending{fd_, POLLOUT, 0};
+        int ready = poll(&pending, 1, 0);
+        if(ready == 0) {
+            if(now >= connect_deadline_) disconnect();      // a black-holed address
+            return false;
+        }
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if(ready < 0 || getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+            close(fd_);
+            fd_ = -1;
+            candidate_ = candidate_->ai_next;
+            start_connect();
+            return false;
+        }
+        connecting_ = false;
+        freeaddrinfo(addresses_);
+        addresses_ = candidate_ = nullptr;
+
+        // Blocking again: writes are bounded by SO_SNDTIMEO
+        fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) & ~O_NONBLOCK);
+        int on = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));     // one small frame per interval
+        timeval timeout{1, 0};                                          // a stalled aggregator drops us
+        setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        out_.clear();
+        frame::append_hello(out_, name_);
+        encoder_.reset();
+        return true;
+    }
+
+    bool Agent::start_connect() {
+        for(; candidate_; candidate_ = candidate_->ai_next) {
+            int fd = socket(candidate_->ai_family, candidate_->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, candidate_->ai_protocol);
+            if(fd < 0) continue;
+            if(::connect(fd, candidate_->ai_addr, candidate_->ai_addrlen) == 0 || errno == EINPROGRESS) {
+                fd_ = fd;
+                connecting_ = true;
+                return true;
+            }
+            close(fd);
+        }
+        disconnect();
+        return false;
+    }
+
+    bool Agent::write_all() {
+        size_t written = 0;
+        while(written < out_.size()) {
+            ssize_t n = ::send(fd_, out_.data() + written, out_.size() - written, MSG_NOSIGNAL);
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0) {
+                disconnect();
+                return false;
+            }
+            written += static_cast<size_t>(n);
+        }
+        out_.clear();
+        return true;
+    }
+
+    void Agent::disconnect() {
+        if(fd_ >= 0) close(fd_);
+        fd_ = -1;
+        out_.clear();
+        connecting_ = false;
+        if(addresses_) freeaddrinfo(addresses_);
+        addresses_ = candidate_ = nullptr;
+    }
+
+    AgentServer::AgentServer(uint16_t port, std::string name, const char* address) : name_(std::move(name)) {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if(listen_fd_ < 0) return;
+        int on = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        sockaddr_in bind_address{};
+        bind_address.sin_family = AF_INET;
+        bind_address.sin_port = htons(port);
+        if(inet_pton(AF_INET, address, &bind_address.sin_addr) != 1
+           || bind(listen_fd_, reinterpret_cast<const sockaddr*>(&bind_address), sizeof(bind_address)) != 0
+           || listen(listen_fd_, 16) != 0) {
+            close(listen_fd_);
+            listen_fd_ = -1;
+            return;
+        }
+        socklen_t length = sizeof(bind_address);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&bind_address), &length);
+        port_ = ntohs(bind_address.sin_port);
+    }
+
+    AgentServer::~AgentServer() {
+        for(const auto& viewer : viewers_) close(viewer.fd);
+        if(listen_fd_ >= 0) close(listen_fd_);
+    }
+
+    void AgentServer::publish(const HostSample& sample) {
+        accept_viewers();
+        for(size_t i = 0; i < viewers_.size();) {
+            Viewer& viewer = viewers_[i];
+            viewer.encoder.append(viewer.out, sample);
+            if(flush(viewer)) {
+                ++i;
+                continue;
+            }
+            close(viewer.fd);
+            viewers_[i] = std::move(viewers_.back());
+            viewers_.pop_back();
+        }
+    }
+
+    void AgentServer::accept_viewers() {
+        if(listen_fd_ < 0) return;
+        while(true) {
+            int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if(fd < 0) return;
+            if(viewers_.size() >= max_viewers) {
+                close(fd);
+                continue;
+            }
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            Viewer& viewer = viewers_.emplace_back();
+            viewer.fd = fd;
+            frame::append_hello(viewer.out, name_);
+        }
+    }
+
+    bool AgentServer::flush(Viewer& viewer) {
+        size_t written = 0;
+        while(written < viewer.out.size()) {
+            ssize_t n = ::send(viewer.fd, viewer.out.data() + written, viewer.out.size() - written, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if(n < 0 && errno == EINTR) continue;
+            if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if(n <= 0) return false;
+            written += static_cast<size_t>(n);
+        }
+        viewer.out.erase(0, written);
+        return viewer.out.size() <= max_buffered;
+    }
+
+    HostSample make_host_sample(const Cpu::Sample& cpu, const Ram::Sample& ram, const Network::Sample& network,
+                                const Drive::Sample& drive, const General::Sample& general) {
+        HostSample sample;
+        sample.time_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        sample.cpu_usage = cpu.usage;
+        sample.core_usages = cpu.core_usages;
+        sample.ram_usage = ram.usage;
+        sample.ram_total = ram.total;
+        sample.ram_used = ram.used;
+        sample.download_rate = network.download_rate;
+        sample.upload_rate = network.upload_rate;
+        sample.root_usage = drive.mounts.empty() ? 0.0 : drive.mounts.front().usage;
+        sample.uptime = general.uptime;
+        sample.procs_num = general.procs_num;
+        return sample;
+    }
+}
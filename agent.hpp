@@ -0,0 +1,104 @@
+#ifndef AGENT_HPP
+#define AGENT_HPP
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "sample_frame.hpp"
+#include "system_monitor.hpp"
+
+struct addrinfo;
+
+namespace system_monitor {
+
+    // Sends the samples of this host to an aggregator. The connection is
+    // made on the first send() and re-made after failures, at most once per
+    // retry_interval; every connection starts with a hello frame and a full
+    // sample, then only deltas are sent. Connecting never blocks: send()
+    // starts a non-blocking connect and the following calls check on it,
+    // dropping their samples until it completes or connect_timeout passes.
+    class Agent {
+        public:
+            static constexpr std::chrono::milliseconds retry_interval{2000};
+            static constexpr std::chrono::milliseconds connect_timeout{3000};
+
+            Agent(std::string address, uint16_t port, std::string name);
+            ~Agent();
+
+            Agent(const Agent&) = delete;
+            Agent& operator=(const Agent&) = delete;
+
+            // False if the sample could not be sent (not connected yet)
+            bool send(const HostSample& sample);
+            bool connected() const { return fd_ >= 0 && !connecting_; }
+
+            // Host name as reported by gethostname()
+            static std::string local_name();
+
+        private:
+            std::string address_;
+            uint16_t port_;
+            std::string name_;
+            int fd_ = -1;
+            std::string out_;
+            DeltaEncoder encoder_;
+            std::chrono::steady_clock::time_point retry_at_{};
+
+            // Connection in progress to *candidate_, the next ones are tried if it fails
+            bool connecting_ = false;
+            addrinfo* addresses_ = nullptr;
+            addrinfo* candidate_ = nullptr;
+            std::chrono::steady_clock::time_point connect_deadline_{};
+
+            bool connect();             // starts or checks on the connection, true once connected
+            bool start_connect();       // from candidate_ on
+            bool write_all();
+            void disconnect();
+    };
+
+    // Serves the samples of this host to viewers that connect to it
+    // (system_monitor --connect), e.g. through an SSH tunnel. Each viewer
+    // gets a hello frame and then the same delta stream as an aggregator.
+    // publish() never blocks: a viewer that cannot keep up is dropped.
+    // It listens on the loopback address unless told otherwise, since the
+    // stream is neither authenticated nor encrypted.
+    class AgentServer {
+        public:
+            static constexpr size_t max_viewers = 64;
+            static constexpr size_t max_buffered = 64 * 1024;      // per viewer
+
+            AgentServer(uint16_t port, std::string name, const char* address = "127.0.0.1");
+            ~AgentServer();
+
+            AgentServer(const AgentServer&) = delete;
+            AgentServer& operator=(const AgentServer&) = delete;
+
+            bool listening() const { return listen_fd_ >= 0; }
+            uint16_t port() const { return port_; }
+            size_t viewers() const { return viewers_.size(); }
+
+            // Accepts the pending viewers, then sends the sample to every viewer
+            void publish(const HostSample& sample);
+
+        private:
+            struct Viewer {
+                int fd = -1;
+                std::string out;            // bytes the socket did not take yet
+                DeltaEncoder encoder;
+            };
+
+            int listen_fd_ = -1;
+            uint16_t port_ = 0;
+            std::string name_;
+            std::vector<Viewer> viewers_;
+
+            void accept_viewers();
+            static bool flush(Viewer& viewer);      // false once the viewer is gone or too slow
+    };
+
+    // Sample of the local collectors in the wire format
+    HostSample make_host_sample(const Cpu::Sample& cpu, const Ram::Sample& ram, const Network::Sample& network,
+                                const Drive::Sample& drive, const General::Sample& general);
+}
+
+#endif
@@ -0,0 +1,119 @@
+// Headless agent: samples this host and streams it to an aggregator
+// (HOST:PORT) and/or to the viewers connecting to it (--listen PORT).
+//
+//   system_monitor_agent [HOST:PORT] [--listen PORT] [--listen-address ADDR] [--interval ms] [--name NAME] [--budget PERCENT]
+//
+// Viewers are served on 127.0.0.1 (reach it through an SSH tunnel);
+// --listen-address binds another IPv4 address, e.g. 0.0.0.0 for all.
+// --budget caps the sampler at a share of one core by stretching the
+// periods of its costliest collectors (see OverheadMeter).
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include "agent.hpp"
+#include "sampler.hpp"
+#include "system_monitor.hpp"
+
+using namespace system_monitor;
+
+namespace {
+    // The GUI's cgroup collector is of no use to the aggregator
+    using AgentMonitor = BasicMonitor<General, Network, Cpu, Ram, Drive>;
+
+    struct Options {
+        std::string address;
+        uint16_t port = 0;              // aggregator, 0 for none
+        uint16_t listen_port = 0;       // viewers, 0 for none
+        std::string listen_address = "127.0.0.1";
+        std::string name = Agent::local_name();
+        std::chrono::milliseconds interval{1000};
+        double budget = 0.0;            // share of one core, 0 for none
+    };
+
+    bool parse_port(const char* text, uint16_t& port) {
+        unsigned long value = std::strtoul(text, nullptr, 10);
+        if(value == 0 || value > UINT16_MAX) return false;
+        port = static_cast<uint16_t>(value);
+        return true;
+    }
+
+    bool parse_options(int argc, char** argv, Options& options) {
+        for(int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if(arg == "--interval" && has_value) options.interval = std::chrono::milliseconds(std::atoi(argv[++i]));
+            else if(arg == "--name" && has_value) options.name = argv[++i];
+            else if(arg == "--budget" && has_value) {
+                options.budget = std::atof(argv[++i]) / 100.0;
+                if(options.budget <= 0.0) return false;
+            }
+            else if(arg == "--listen" && has_value) {
+                if(!parse_port(argv[++i], options.listen_port)) return false;
+            }
+            else if(arg == "--listen-address" && has_value) options.listen_address = argv[++i];
+            else if(size_t colon = arg.rfind(':'); i == 1 && colon != std::string::npos && colon > 0) {
+                options.address = arg.substr(0, colon);
+                if(!parse_port(arg.c_str() + colon + 1, options.port)) return false;
+            }
+            else return false;
+        }
+        return (options.port != 0 || options.listen_port != 0) && options.interval.count() > 0 && !options.name.empty();
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if(!parse_options(argc, argv, options)) {
+        std::cerr << "usage: " << argv[0] << " [HOST:PORT] [--listen PORT] [--listen-address ADDR] [--interval ms] [--name NAME] [--budget PERCENT]\n";
+        return 2;
+    }
+
+    std::unique_ptr<AgentServer> server;
+    if(options.listen_port != 0) {
+        server = std::make_unique<AgentServer>(options.listen_port, options.name, options.listen_address.c_str());
+        if(!server->listening()) {
+            std::cerr << "could not listen on " << options.listen_address << ":" << options.listen_port << "\n";
+            return 1;
+        }
+    }
+
+    Sampler<AgentMonitor> sampler;
+    sampler.set_overhead_budget(options.budget);
+    Agent agent(options.address, options.port, options.name);
+
+    Cpu::Sample cpu;
+    Ram::Sample ram;
+    Network::Sample network;
+    Drive::Sample drive;
+    General::Sample general;
+    uint64_t cpu_seen = 0, ram_seen = 0, network_seen = 0, drive_seen = 0, general_seen = 0;
+
+    bool was_connected = false;
+    auto next = std::chrono::steady_clock::now();
+    while(true) {
+        next += options.interval;
+        std::this_thread::sleep_until(next);
+
+        sampler.read<Cpu>(cpu, cpu_seen);
+        sampler.read<Ram>(ram, ram_seen);
+        sampler.read<Network>(network, network_seen);
+        sampler.read<Drive>(drive, drive_seen);
+        sampler.read<General>(general, general_seen);
+        if(cpu_seen == 0) continue;     // nothing sampled yet
+
+        HostSample sample = make_host_sample(cpu, ram, network, drive, general);
+        if(server) server->publish(sample);
+        if(options.port == 0) continue;
+
+        agent.send(sample);
+        if(agent.connected() != was_connected) {
+            was_connected = agent.connected();
+            std::cerr << (was_connected ? "connected to " : "disconnected from ")
+                      << options.address << ":" << options.port << "\n";
+        }
+    }
+}
@@ -0,0 +1,298 @@
+#include "aggregator.hpp"
+#include <algorithm>
+#include <cerrno>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace system_monitor {
+
+    namespace {
+        enum SeriesRow : size_t { row_cpu, row_ram, row_download, row_upload };
+    }
+
+    Aggregator::Aggregator() {
+        start();
+    }
+
+    Aggregator::Aggregator(uint16_t port, const char* address) {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if(listen_fd_ < 0) return;
+        int on = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        sockaddr_in bind_address{};
+        bind_address.sin_family = AF_INET;
+        bind_address.sin_port = htons(port);
+        if(inet_pton(AF_INET, address, &bind_address.sin_addr) != 1
+           || bind(listen_fd_, reinterpret_cast<const sockaddr*>(&bind_address), sizeof(bind_address)) != 0
+           || listen(listen_fd_, SOMAXCONN) != 0) {
+            close(listen_fd_);
+            listen_fd_ = -1;
+            return;
+        }
+        socklen_t length = sizeof(bind_address);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&bind_address), &length);
+        port_ = ntohs(bind_address.sin_port);
+        start();
+    }
+
+    void Aggregator::start() {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        if(listen_fd_ >= 0) {
+            event.data.fd = listen_fd_;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event);
+        }
+        event.data.fd = wake_fd_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+        thread_ = std::thread([this] { run(); });
+    }
+
+    Aggregator::~Aggregator() {
+        if(thread_.joinable()) {
+            {
+                std::lock_guard lock(mutex_);
+                stop_ = true;
+            }
+            uint64_t one = 1;
+            [[maybe_unused]] ssize_t n = write(wake_fd_, &one, sizeof(one));
+            thread_.join();
+        }
+        for(size_t fd = 0; fd < connections_.size(); ++fd) {
+            if(connections_[fd]) close(static_cast<int>(fd));
+        }
+        for(int fd : pending_) close(fd);
+        if(wake_fd_ >= 0) close(wake_fd_);
+        if(epoll_fd_ >= 0) close(epoll_fd_);
+        if(listen_fd_ >= 0) close(listen_fd_);
+    }
+
+    bool Aggregator::connect(const std::string& address, uint16_t port) {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if(getaddrinfo(address.c_str(), std::to_string(port).c_str(), &hints, &result) != 0) return false;
+
+        // Non-blocking: a failed connect is reported by epoll like a closed connection
+        int fd = socket(result->ai_family, result->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, result->ai_protocol);
+        bool started = fd >= 0 && (::connect(fd, result->ai_addr, result->ai_addrlen) == 0 || errno == EINPROGRESS);
+        freeaddrinfo(result);
+        if(!started) {
+            if(fd >= 0) close(fd);
+            return false;
+        }
+
+        {
+            std::lock_guard lock(mutex_);
+            pending_.push_back(fd);
+            ++dialed_;
+        }
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = write(wake_fd_, &one, sizeof(one));
+        return true;
+    }
+
+    size_t Aggregator::dialed_connections() const {
+        std::lock_guard lock(mutex_);
+        return dialed_;
+    }
+
+    size_t Aggregator::host_count() const {
+        std::lock_guard lock(mutex_);
+        return hosts_.size();
+    }
+
+    bool Aggregator::read_host(size_t index, Host& out) const {
+        std::lock_guard lock(mutex_);
+        if(index >= hosts_.size()) return false;
+        out = hosts_[index];
+        return true;
+    }
+
+    bool Aggregator::read_history(size_t index, History& out) const {
+        std::lock_guard lock(mutex_);
+        if(index >= series_.size()) return false;
+        const Series& series = series_[index];
+        size_t first = (series.next + history_length - series.size) % history_length;
+        auto copy_row = [&](size_t row, std::vector<float>& values) {
+            values.resize(series.size);
+            for(size_t i = 0; i < series.size; ++i)
+                values[i] = series.values[row * history_length + (first + i) % history_length];
+        };
+        copy_row(row_cpu, out.cpu_usage);
+        copy_row(row_ram, out.ram_usage);
+        copy_row(row_download, out.download_rate);
+        copy_row(row_upload, out.upload_rate);
+        return true;
+    }
+
+    void Aggregator::read_hosts(std::vector<Host>& out) const {
+        std::lock_guard lock(mutex_);
+        out.resize(hosts_.size());
+        for(size_t i = 0; i < hosts_.size(); ++i)
+            out[i] = hosts_[i];         // reuses the strings and vectors of out
+    }
+
+    uint64_t Aggregator::generation() const {
+        std::lock_guard lock(mutex_);
+        return generation_;
+    }
+
+    void Aggregator::run() {
+        epoll_event events[256];
+        while(true) {
+            int n = epoll_wait(epoll_fd_, events, 256, -1);
+            if(n < 0) {
+                if(errno == EINTR) continue;
+                return;
+            }
+            for(int i = 0; i < n; ++i) {
+                int fd = events[i].data.fd;
+                if(fd == wake_fd_) {
+                    uint64_t count;
+                    [[maybe_unused]] ssize_t n = read(wake_fd_, &count, sizeof(count));
+                    std::vector<int> pending;
+                    {
+                        std::lock_guard lock(mutex_);
+                        if(stop_) return;
+                        pending.swap(pending_);
+                    }
+                    for(int connection : pending) add_connection(connection, true);
+                    continue;
+                }
+                if(fd == listen_fd_) {
+                    accept_connections();
+                    continue;
+                }
+                if(!read_connection(fd))
+                    close_connection(fd);
+            }
+        }
+    }
+
+    void Aggregator::accept_connections() {
+        while(true) {
+            int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if(fd < 0) return;          // EAGAIN, or out of descriptors until some close
+            add_connection(fd, false);
+        }
+    }
+
+    void Aggregator::add_connection(int fd, bool dialed) {
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        if(epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            if(dialed) {
+                std::lock_guard lock(mutex_);
+                --dialed_;
+            }
+            return;
+        }
+        auto index = static_cast<size_t>(fd);
+        if(index >= connections_.size()) connections_.resize(index + 1);
+        connections_[index] = std::make_unique<Connection>();
+        connections_[index]->dialed = dialed;
+    }
+
+    // Reads everything available, then handles the complete frames under one lock
+    bool Aggregator::read_connection(int fd) {
+        auto index = static_cast<size_t>(fd);
+        if(index >= connections_.size() || !connections_[index]) return false;
+        Connection& connection = *connections_[index];
+
+        char buffer[16384];
+        bool open = true;
+        while(true) {
+            ssize_t n = read(fd, buffer, sizeof(buffer));
+            if(n > 0) {
+                connection.reader.append(buffer, static_cast<size_t>(n));
+                continue;
+            }
+            if(n == 0 || (errno != EAGAIN && errno != EINTR)) open = false;
+            if(n < 0 && errno == EINTR) continue;
+            break;
+        }
+
+        std::lock_guard lock(mutex_);
+        process(connection);
+        return open && !connection.reader.failed();
+    }
+
+    void Aggregator::process(Connection& connection) {
+        FrameReader::Frame frame;
+        while(connection.reader.next(frame)) {
+            if(frame.type == frame::hello) {
+                std::string name;
+                if(!frame::decode_hello(frame.payload, name)) continue;
+                if(connection.host != no_host) hosts_[connection.host].connected = false;     // hello again
+
+                // Another live connection with that name, e.g. two agents on
+                // equally named machines, or a reconnect before the old
+                // connection was seen closing
+                std::string unique = name;
+                for(size_t n = 2;; ++n) {
+                    auto it = host_index_.find(unique);
+                    if(it == host_index_.end() || !hosts_[it->second].connected) break;
+                    unique = name + " (" + std::to_string(n) + ")";
+                }
+                auto [it, added] = host_index_.try_emplace(unique, hosts_.size());
+                if(added) {
+                    hosts_.emplace_back().name = unique;
+                    series_.emplace_back();
+                }
+                connection.host = it->second;
+                connection.last = HostSample{};
+                hosts_[connection.host].connected = true;
+                hosts_[connection.host].dialed |= connection.dialed;
+                ++generation_;
+            } else if((frame.type == frame::sample || frame.type == frame::delta) && connection.host != no_host) {
+                Host& host = hosts_[connection.host];
+                bool decoded = frame.type == frame::sample ? frame::decode_sample(frame.payload, connection.last)
+                                                           : frame::decode_delta(frame.payload, connection.last);
+                if(!decoded) continue;
+                host.last = connection.last;
+                ++host.samples;
+                host.last_seen = Clock::now();
+
+                Series& series = series_[connection.host];
+                series.values[row_cpu * history_length + series.next] = static_cast<float>(host.last.cpu_usage);
+                series.values[row_ram * history_length + series.next] = static_cast<float>(host.last.ram_usage);
+                series.values[row_download * history_length + series.next] = static_cast<float>(host.last.download_rate);
+                series.values[row_upload * history_length + series.next] = static_cast<float>(host.last.upload_rate);
+                series.next = (series.next + 1) % history_length;
+                series.size = std::min(series.size + 1, history_length);
+                ++generation_;
+            }
+            // Unknown frame types are skipped, newer agents may send more
+        }
+    }
+
+    void Aggregator::close_connection(int fd) {
+        auto index = static_cast<size_t>(fd);
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        if(index >= connections_.size() || !connections_[index]) return;
+
+        size_t host = connections_[index]->host;
+        bool dialed = connections_[index]->dialed;
+        connections_[index].reset();
+
+        std::lock_guard lock(mutex_);
+        if(dialed) --dialed_;
+        if(host == no_host) return;
+        hosts_[host].connected = false;
+        ++generation_;
+    }
+}
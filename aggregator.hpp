@@ -0,0 +1,122 @@
+#ifndef AGGREGATOR_HPP
+#define AGGREGATOR_HPP
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "sample_frame.hpp"
+
+namespace system_monitor {
+
+    // Receives the sample frames of many agents over TCP. One thread
+    // multiplexes every connection with epoll; hosts are identified by the
+    // name of their hello frame and keep their history across reconnects.
+    // A host has at most one connection: a hello naming a host that is
+    // still connected gets the first free "name (2)", "name (3)", ...
+    // The last sample and a ring of recent values are kept per host.
+    // Besides accepting agents it can dial out to agents serving viewers
+    // (remote-view mode, see AgentServer).
+    class Aggregator {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            static constexpr size_t history_length = 600;      // samples per host
+
+            struct Host {
+                std::string name;
+                bool connected = false;
+                bool dialed = false;            // reached through connect()
+                uint64_t samples = 0;
+                HostSample last;
+                Clock::time_point last_seen{};
+            };
+
+            // Recent values of a host, oldest first
+            struct History {
+                std::vector<float> cpu_usage;
+                std::vector<float> ram_usage;
+                std::vector<float> download_rate;
+                std::vector<float> upload_rate;
+            };
+
+            // Only dials out through connect()
+            Aggregator();
+            // Listens on address:port, port 0 picks a free one (see port())
+            explicit Aggregator(uint16_t port, const char* address = "0.0.0.0");
+            ~Aggregator();
+
+            Aggregator(const Aggregator&) = delete;
+            Aggregator& operator=(const Aggregator&) = delete;
+
+            bool listening() const { return listen_fd_ >= 0; }
+            uint16_t port() const { return port_; }
+
+            // Starts a connection to an agent serving viewers; its frames are
+            // handled like those of accepted agents. False if the address does
+            // not resolve, a refused connection shows up as a disconnected host
+            // or no host at all.
+            bool connect(const std::string& address, uint16_t port);
+            // Connections made by connect() that are still open or in progress
+            size_t dialed_connections() const;
+
+            // Hosts in the order they first connected
+            size_t host_count() const;
+            bool read_host(size_t index, Host& out) const;
+            bool read_history(size_t index, History& out) const;
+            void read_hosts(std::vector<Host>& out) const;
+
+            // Changes whenever a frame was processed or a host (dis)connected
+            uint64_t generation() const;
+
+        private:
+            struct Connection {
+                FrameReader reader;
+                HostSample last;            // the deltas of this connection apply to it
+                size_t host = no_host;
+                bool dialed = false;
+            };
+
+            // Ring of the recent values, one row of history_length per metric
+            struct Series {
+                std::vector<float> values = std::vector<float>(4 * history_length, 0.0f);
+                size_t next = 0;
+                size_t size = 0;
+            };
+
+            static constexpr size_t no_host = static_cast<size_t>(-1);
+
+            int listen_fd_ = -1;
+            int epoll_fd_ = -1;
+            int wake_fd_ = -1;              // eventfd waking the thread up for pending_ or stop_
+            uint16_t port_ = 0;
+
+            // Aggregator thread only, indexed by file descriptor
+            std::vector<std::unique_ptr<Connection>> connections_;
+
+            mutable std::mutex mutex_;
+            std::vector<int> pending_;      // connections made by connect(), not yet polled
+            size_t dialed_ = 0;
+            bool stop_ = false;
+            std::vector<Host> hosts_;
+            std::vector<Series> series_;
+            std::unordered_map<std::string, size_t> host_index_;
+            uint64_t generation_ = 0;
+
+            std::thread thread_;        // last, starts once everything above is set up
+
+            void start();
+            void run();
+            void accept_connections();
+            void add_connection(int fd, bool dialed);
+            bool read_connection(int fd);           // false once the connection is gone
+            void close_connection(int fd);
+            void process(Connection& connection);   // called with the lock held
+    };
+}
+
+#endif
@@ -0,0 +1,268 @@
+#include "catch_amalgamated.hpp"
+#include "aggregator.hpp"
+#include "agent.hpp"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using system_monitor::Agent;
+using system_monitor::AgentServer;
+using system_monitor::Aggregator;
+using system_monitor::HostSample;
+using namespace std::chrono_literals;
+
+namespace {
+    HostSample make_sample(double usage) {
+        HostSample sample;
+        sample.cpu_usage = usage;
+        sample.core_usages = {usage, usage};
+        sample.ram_usage = usage / 2.0;
+        sample.download_rate = usage * 1000.0;
+        sample.procs_num = 42;
+        return sample;
+    }
+
+    // Polls until the aggregator has seen `samples` samples in total
+    bool wait_for_samples(const Aggregator& aggregator, uint64_t samples, std::chrono::milliseconds timeout = 5000ms) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::vector<Aggregator::Host> hosts;
+        while(std::chrono::steady_clock::now() < deadline) {
+            aggregator.read_hosts(hosts);
+            uint64_t total = 0;
+            for(const auto& host : hosts) total += host.samples;
+            if(total >= samples) return true;
+            std::this_thread::sleep_for(2ms);
+        }
+        return false;
+    }
+
+    bool wait_for_connected(const Aggregator& aggregator, size_t index, bool connected) {
+        auto deadline = std::chrono::steady_clock::now() + 5000ms;
+        Aggregator::Host host;
+        while(std::chrono::steady_clock::now() < deadline) {
+            if(aggregator.read_host(index, host) && host.connected == connected) return true;
+            std::this_thread::sleep_for(2ms);
+        }
+        return false;
+    }
+}
+
+// Aggregator Tests
+// many agents on loopback
+TEST_CASE("Aggregator many agents", "[aggregator]") {
+    constexpr size_t n_agents = 200;
+    Aggregator aggregator(0, "127.0.0.1");
+    REQUIRE(aggregator.listening());
+    REQUIRE(aggregator.port() != 0);
+
+    std::vector<std::unique_ptr<Agent>> agents;
+    for(size_t i = 0; i < n_agents; ++i) {
+        agents.push_back(std::make_unique<Agent>("127.0.0.1", aggregator.port(), "host-" + std::to_string(i)));
+        REQUIRE(agents.back()->send(make_sample(0.1)));
+    }
+    for(size_t i = 0; i < n_agents; ++i)
+        REQUIRE(agents[i]->send(make_sample(static_cast<double>(i) / n_agents)));
+
+    REQUIRE(wait_for_samples(aggregator, 2 * n_agents));
+    REQUIRE(aggregator.host_count() == n_agents);
+
+    std::vector<Aggregator::Host> hosts;
+    aggregator.read_hosts(hosts);
+    for(const auto& host : hosts) {
+        size_t i = std::stoul(host.name.substr(5));
+        CHECK(host.connected);
+        CHECK(host.samples == 2);
+        CHECK(host.last.cpu_usage == Catch::Approx(static_cast<double>(i) / n_agents).margin(1e-4));
+        CHECK(host.last.core_usages.size() == 2);
+        CHECK(host.last.procs_num == 42);
+    }
+
+    Aggregator::History history;
+    REQUIRE(aggregator.read_history(0, history));
+    REQUIRE(history.cpu_usage.size() == 2);
+    CHECK(history.cpu_usage[0] == Catch::Approx(0.1).margin(1e-4));
+    CHECK(history.ram_usage[0] == Catch::Approx(0.05).margin(1e-4));
+    CHECK(history.download_rate[0] == Catch::Approx(100.0));
+    CHECK_FALSE(aggregator.read_history(n_agents, history));
+}
+
+// hosts outlive their connections
+TEST_CASE("Aggregator reconnect", "[aggregator]") {
+    Aggregator aggregator(0, "127.0.0.1");
+    REQUIRE(aggregator.listening());
+
+    auto agent = std::make_unique<Agent>("127.0.0.1", aggregator.port(), "web-1");
+    REQUIRE(agent->send(make_sample(0.2)));
+    REQUIRE(wait_for_samples(aggregator, 1));
+    uint64_t generation = aggregator.generation();
+
+    agent.reset();
+    REQUIRE(wait_for_connected(aggregator, 0, false));
+    CHECK(aggregator.generation() > generation);
+
+    // The same name maps back to the same host and history
+    agent = std::make_unique<Agent>("127.0.0.1", aggregator.port(), "web-1");
+    REQUIRE(agent->send(make_sample(0.3)));
+    REQUIRE(wait_for_samples(aggregator, 2));
+    CHECK(aggregator.host_count() == 1);
+    CHECK(wait_for_connected(aggregator, 0, true));
+
+    Aggregator::History history;
+    REQUIRE(aggregator.read_history(0, history));
+    REQUIRE(history.cpu_usage.size() == 2);
+    CHECK(history.cpu_usage[1] == Catch::Approx(0.3).margin(1e-4));
+}
+
+// two live agents with one name: each keeps its own deltas and connection
+TEST_CASE("Aggregator duplicate names", "[aggregator]") {
+    Aggregator aggregator(0, "127.0.0.1");
+    auto first = std::make_unique<Agent>("127.0.0.1", aggregator.port(), "web-1");
+    REQUIRE(first->send(make_sample(0.2)));
+    REQUIRE(wait_for_samples(aggregator, 1));
+    Agent second("127.0.0.1", aggregator.port(), "web-1");
+    REQUIRE(second.send(make_sample(0.8)));
+    REQUIRE(wait_for_samples(aggregator, 2));
+
+    // Deltas of both interleaved
+    for(int i = 0; i < 10; ++i) {
+        REQUIRE(first->send(make_sample(0.2 + i * 0.01)));
+        REQUIRE(second.send(make_sample(0.8 - i * 0.01)));
+    }
+    REQUIRE(wait_for_samples(aggregator, 22));
+    REQUIRE(aggregator.host_count() == 2);
+    Aggregator::Host host;
+    REQUIRE(aggregator.read_host(0, host));
+    CHECK(host.name == "web-1");
+    CHECK(host.last.cpu_usage == Catch::Approx(0.29).margin(1e-4));
+    CHECK(host.last.ram_usage == Catch::Approx(0.145).margin(1e-4));
+    REQUIRE(aggregator.read_host(1, host));
+    CHECK(host.name == "web-1 (2)");
+    CHECK(host.last.cpu_usage == Catch::Approx(0.71).margin(1e-4));
+
+    // One of them leaving does not disconnect the other
+    first.reset();
+    REQUIRE(wait_for_connected(aggregator, 0, false));
+    REQUIRE(aggregator.read_host(1, host));
+    CHECK(host.connected);
+}
+
+TEST_CASE("Aggregator history ring", "[aggregator]") {
+    Aggregator aggregator(0, "127.0.0.1");
+    Agent agent("127.0.0.1", aggregator.port(), "db-1");
+    size_t n_samples = Aggregator::history_length + 50;
+    for(size_t i = 0; i < n_samples; ++i)
+        REQUIRE(agent.send(make_sample(static_cast<double>(i % 100) / 100.0)));
+    REQUIRE(wait_for_samples(aggregator, n_samples));
+
+    Aggregator::History history;
+    REQUIRE(aggregator.read_history(0, history));
+    REQUIRE(history.cpu_usage.size() == Aggregator::history_length);
+    CHECK(history.cpu_usage.front() == Catch::Approx(0.5).margin(1e-4));      // sample 50
+    CHECK(history.cpu_usage.back() == Catch::Approx(0.49).margin(1e-4));      // sample 649
+}
+
+TEST_CASE("Aggregator ignores anonymous agents", "[aggregator]") {
+    Aggregator aggregator(0, "127.0.0.1");
+    Agent good("127.0.0.1", aggregator.port(), "good");
+    REQUIRE(good.send(make_sample(0.5)));
+    REQUIRE(wait_for_samples(aggregator, 1));
+
+    // An empty hello names no host, its samples are ignored
+    Agent agent("127.0.0.1", aggregator.port(), "");
+    agent.send(make_sample(0.5));
+    std::this_thread::sleep_for(50ms);
+    CHECK(aggregator.host_count() == 1);
+    REQUIRE(good.send(make_sample(0.6)));
+    REQUIRE(wait_for_samples(aggregator, 2));
+}
+
+// remote view: the aggregator dials out to an agent serving viewers, on
+// the loopback address by default
+TEST_CASE("Aggregator connects to an agent server", "[aggregator][AgentServer]") {
+    AgentServer server(0, "prod-1");
+    REQUIRE(server.listening());
+    CHECK_FALSE(AgentServer(0, "bad", "localhost").listening());       // an IPv4 address, not a name
+    Aggregator aggregator;
+    CHECK_FALSE(aggregator.listening());
+    REQUIRE(aggregator.connect("127.0.0.1", server.port()));
+    CHECK(aggregator.dialed_connections() == 1);
+
+    // The viewer is accepted on the next publish
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while(server.viewers() == 0 && std::chrono::steady_clock::now() < deadline) {
+        server.publish(make_sample(0.5));
+        std::this_thread::sleep_for(1ms);
+    }
+    REQUIRE(server.viewers() == 1);
+    server.publish(make_sample(0.25));          // a delta after the full sample
+    REQUIRE(wait_for_samples(aggregator, 2));
+
+    Aggregator::Host host;
+    REQUIRE(aggregator.read_host(0, host));
+    CHECK(host.name == "prod-1");
+    CHECK(host.dialed);
+    CHECK(host.last.cpu_usage == Catch::Approx(0.25).margin(1e-4));
+    CHECK(host.last.core_usages.size() == 2);
+}
+
+TEST_CASE("Aggregator refused connection", "[aggregator]") {
+    uint16_t port;
+    {
+        AgentServer server(0, "gone", "127.0.0.1");
+        port = server.port();
+    }
+    Aggregator aggregator;
+    REQUIRE(aggregator.connect("127.0.0.1", port));
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while(aggregator.dialed_connections() != 0 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(1ms);
+    CHECK(aggregator.dialed_connections() == 0);
+    CHECK(aggregator.host_count() == 0);
+}
+
+// an unreachable aggregator never stalls the agent's loop
+TEST_CASE("Agent unreachable aggregator", "[aggregator][Agent]") {
+    Agent agent("192.0.2.1", 7070, "lost");         // TEST-NET-1, nothing answers
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < 5; ++i)
+        CHECK_FALSE(agent.send(make_sample(0.5)));
+    CHECK(std::chrono::steady_clock::now() - start < 500ms);
+    CHECK_FALSE(agent.connected());
+
+    // A refused connection is found out by a later send, then retried
+    uint16_t port;
+    {
+        Aggregator gone(0, "127.0.0.1");
+        port = gone.port();
+    }
+    Agent refused("127.0.0.1", port, "refused");
+    refused.send(make_sample(0.5));
+    std::this_thread::sleep_for(10ms);
+    CHECK_FALSE(refused.send(make_sample(0.5)));
+    CHECK_FALSE(refused.connected());
+}
+
+// 1000 hosts at 1 Hz must fit on a fraction of a core
+TEST_CASE("Aggregator throughput", "[aggregator][benchmark]") {
+    constexpr size_t n_agents = 10;
+    constexpr size_t per_agent = 2000;
+    Aggregator aggregator(0, "127.0.0.1");
+    std::vector<std::unique_ptr<Agent>> agents;
+    for(size_t i = 0; i < n_agents; ++i)
+        agents.push_back(std::make_unique<Agent>("127.0.0.1", aggregator.port(), "bulk-" + std::to_string(i)));
+
+    HostSample sample = make_sample(0.5);
+    sample.core_usages.assign(64, 0.5);
+    auto start = std::chrono::steady_clock::now();
+    for(size_t n = 0; n < per_agent; ++n) {
+        for(auto& agent : agents)
+            REQUIRE(agent->send(sample));
+    }
+    REQUIRE(wait_for_samples(aggregator, n_agents * per_agent, 10000ms));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // 20000 samples of 64 cores, i.e. 20 s of a 1000-host fleet
+    CHECK(elapsed < 2s);
+}
@@ -0,0 +1,126 @@
+#include "alert_hook.hpp"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace system_monitor {
+
+    AlertHook::AlertHook() : thread_([this] { run(); }) {}
+
+    AlertHook::~AlertHook() {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+        if(socket_ >= 0) close(socket_);
+    }
+
+    void AlertHook::configure(std::string_view source) {
+        std::string command, socket_path;
+        while(!source.empty()) {
+            size_t end = source.find('\n');
+            std::string_view line = source.substr(0, end);
+            source = end == std::string_view::npos ? std::string_view{} : source.substr(end + 1);
+
+            constexpr std::string_view prefix = "on_alert ";
+            size_t begin = line.find_first_not_of(" \t");
+            if(begin == std::string_view::npos || line.compare(begin, prefix.size(), prefix) != 0) continue;
+            line.remove_prefix(begin + prefix.size());
+            while(!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.remove_suffix(1);
+
+            if(line.compare(0, 8, "command ") == 0) command = std::string(line.substr(8));
+            else if(line.compare(0, 7, "socket ") == 0) socket_path = std::string(line.substr(7));
+        }
+
+        std::lock_guard lock(mutex_);
+        command_ = std::move(command);
+        socket_path_ = std::move(socket_path);
+    }
+
+    bool AlertHook::enabled() const {
+        std::lock_guard lock(mutex_);
+        return !command_.empty() || !socket_path_.empty();
+    }
+
+    void AlertHook::deliver(std::string line) {
+        {
+            std::lock_guard lock(mutex_);
+            if(command_.empty() && socket_path_.empty()) return;
+            if(queue_.size() >= max_queued) queue_.pop_front();
+            queue_.push_back(std::move(line));
+        }
+        wake_.notify_one();
+    }
+
+    std::string AlertHook::format(const AlertRules& rules, const AlertEvent& event) {
+        char value[32];
+        std::snprintf(value, sizeof(value), "%g", event.value);
+        const std::string& name = rules.name(event.rule);
+        const std::string& text = rules.text(event.rule);
+        std::string line = event.firing ? "firing " : "resolved ";
+        line += name;
+        line += ' ';
+        line += value;
+        if(text != name) {      // named rule, add its expression
+            line += ' ';
+            line += text.substr(text.find(": ") + 2);
+        }
+        return line;
+    }
+
+    void AlertHook::run() {
+        std::unique_lock lock(mutex_);
+        while(true) {
+            wake_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if(stop_) return;
+            std::string line = std::move(queue_.front());
+            queue_.pop_front();
+            std::string command = command_;
+            std::string socket_path = socket_path_;
+            lock.unlock();
+
+            send(line, command, socket_path);
+            lock.lock();
+        }
+    }
+
+    void AlertHook::send(const std::string& line, const std::string& command, const std::string& socket_path) {
+        if(!socket_path.empty()) {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if(socket_path.size() < sizeof(address.sun_path)) {
+                std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+                if(socket_ < 0) socket_ = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+                if(socket_ >= 0)
+                    sendto(socket_, line.data(), line.size(), MSG_DONTWAIT, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+            }
+        }
+
+        if(!command.empty()) {
+            std::vector<std::string> variables;
+            for(char** variable = environ; *variable; ++variable)
+                variables.emplace_back(*variable);
+            variables.push_back("SYSTEM_MONITOR_ALERT=" + line);
+            std::vector<char*> envp;
+            for(auto& variable : variables)
+                envp.push_back(variable.data());
+            envp.push_back(nullptr);
+
+            char shell[] = "/bin/sh", flag[] = "-c";
+            char* argv[] = {shell, flag, const_cast<char*>(command.c_str()), nullptr};
+            pid_t pid;
+            if(posix_spawn(&pid, shell, nullptr, nullptr, argv, envp.data()) == 0)
+                waitpid(pid, nullptr, 0);
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef ALERT_HOOK_HPP
+#define ALERT_HOOK_HPP
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "alerts.hpp"
+
+namespace system_monitor {
+
+    // Hands alert lines to a local command and/or a unix datagram socket
+    // from its own thread, so a slow hook never holds up the sampler. Set
+    // up by the "on_alert" lines of the rules file:
+    //
+    //     on_alert command notify-send "System monitor" "$SYSTEM_MONITOR_ALERT"
+    //     on_alert socket /run/user/1000/system_monitor.sock
+    //
+    // The command runs through /bin/sh with the line in SYSTEM_MONITOR_ALERT;
+    // the socket gets one datagram per line.
+    class AlertHook {
+        public:
+            static constexpr size_t max_queued = 1024;      // older lines are dropped beyond
+
+            AlertHook();
+            ~AlertHook();
+
+            AlertHook(const AlertHook&) = delete;
+            AlertHook& operator=(const AlertHook&) = delete;
+
+            void configure(std::string_view source);
+            bool enabled() const;
+
+            // Queues a line for delivery
+            void deliver(std::string line);
+
+            // "firing ram_high 93.1 ram.usage > 90 for 2m"
+            static std::string format(const AlertRules& rules, const AlertEvent& event);
+
+        private:
+            mutable std::mutex mutex_;
+            std::condition_variable wake_;
+            std::deque<std::string> queue_;
+            std::string command_;
+            std::string socket_path_;
+            bool stop_ = false;
+
+            int socket_ = -1;           // hook thread only
+
+            std::thread thread_;        // last, starts once everything above is constructed
+
+            void run();
+            void send(const std::string& line, const std::string& command, const std::string& socket_path);
+    };
+}
+
+#endif
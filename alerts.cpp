@@ -0,0 +1,210 @@
+#include "alerts.hpp"
+#include <charconv>
+
+namespace system_monitor {
+
+    namespace {
+        std::string_view trim(std::string_view text) {
+            size_t begin = text.find_first_not_of(" \t\r");
+            if(begin == std::string_view::npos) return {};
+            size_t end = text.find_last_not_of(" \t\r");
+            return text.substr(begin, end - begin + 1);
+        }
+
+        // Next run of characters up to a space or a parenthesis
+        std::string_view next_token(std::string_view& text) {
+            text = trim(text);
+            size_t end = 0;
+            while(end < text.size() && text[end] != ' ' && text[end] != '\t' && text[end] != '(' && text[end] != ')') ++end;
+            if(end == 0 && !text.empty()) end = 1;          // a parenthesis on its own
+            std::string_view token = text.substr(0, end);
+            text.remove_prefix(end);
+            return token;
+        }
+
+        bool parse_double(std::string_view text, double& value) {
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            return error == std::errc() && end == text.data() + text.size();
+        }
+
+        // "90s", "2m", "1h"
+        bool parse_duration(std::string_view text, std::chrono::steady_clock::duration& duration) {
+            if(text.size() < 2) return false;
+            double count = 0.0;
+            if(!parse_double(text.substr(0, text.size() - 1), count) || count < 0.0) return false;
+            double seconds = 0.0;
+            switch(text.back()) {
+                case 's': seconds = count; break;
+                case 'm': seconds = count * 60.0; break;
+                case 'h': seconds = count * 3600.0; break;
+                default: return false;
+            }
+            duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+            return true;
+        }
+    }
+
+    std::vector<AlertRules::Error> AlertRules::compile(std::string_view source, MetricTable& metrics) {
+        std::vector<Error> errors;
+        plan_.clear();
+        names_.clear();
+        texts_.clear();
+        lines_.clear();
+
+        size_t line_number = 0;
+        while(!source.empty()) {
+            size_t end = source.find('\n');
+            std::string_view line = trim(source.substr(0, end));
+            source = end == std::string_view::npos ? std::string_view{} : source.substr(end + 1);
+            ++line_number;
+
+            if(line.empty() || line.front() == '#') continue;
+            if(line.compare(0, 9, "on_alert ") == 0) continue;      // hooks, see AlertHook
+
+            Step step{};
+            std::string name, error;
+            if(!parse_rule(line, metrics, step, name, error)) {
+                errors.push_back({line_number, std::move(error)});
+                continue;
+            }
+            plan_.push_back(step);
+            names_.push_back(std::move(name));
+            texts_.emplace_back(line);
+            lines_.push_back(line_number);
+        }
+
+        size_t n = plan_.size();
+        since_.assign(n, Clock::time_point{});
+        seen_.assign(n, Clock::time_point{});
+        gaps_.assign(n, Clock::duration::zero());
+        previous_.assign(n, 0.0);
+        values_.assign(n, 0.0);
+        ready_.assign(n, 0);
+        firing_.assign(n, 0);
+        stale_.assign(n, 0);
+        return errors;
+    }
+
+    // [name:] metric|rate(metric) op threshold [for duration]
+    bool AlertRules::parse_rule(std::string_view line, MetricTable& metrics, Step& step, std::string& name, std::string& error) {
+        size_t colon = line.find(": ");
+        if(colon != std::string_view::npos) {
+            name = std::string(trim(line.substr(0, colon)));
+            line.remove_prefix(colon + 2);
+        } else {
+            name = std::string(line);
+        }
+
+        std::string_view metric = next_token(line);
+        step.rate = metric == "rate";
+        if(step.rate) {
+            if(next_token(line) != "(") {
+                error = "expected '(' after rate";
+                return false;
+            }
+            metric = next_token(line);
+            if(next_token(line) != ")") {
+                error = "expected ')' after the metric";
+                return false;
+            }
+        }
+        if(metric.empty() || metric == "(" || metric == ")") {
+            error = "expected a metric";
+            return false;
+        }
+
+        std::string_view op = next_token(line);
+        if(op == ">") step.op = Op::greater;
+        else if(op == ">=") step.op = Op::greater_equal;
+        else if(op == "<") step.op = Op::less;
+        else if(op == "<=") step.op = Op::less_equal;
+        else {
+            error = "expected one of > >= < <=";
+            return false;
+        }
+
+        if(!parse_double(next_token(line), step.threshold)) {
+            error = "expected a number";
+            return false;
+        }
+
+        step.hold = Clock::duration::zero();
+        std::string_view keyword = next_token(line);
+        if(!keyword.empty()) {
+            if(keyword != "for" || !parse_duration(next_token(line), step.hold)) {
+                error = "expected 'for' and a duration like 30s, 2m or 1h";
+                return false;
+            }
+            if(!next_token(line).empty()) {
+                error = "unexpected text after the duration";
+                return false;
+            }
+        }
+
+        step.metric = metrics.add(metric);
+        return true;
+    }
+
+    std::vector<AlertRules::Error> AlertRules::unrecorded(const MetricTable& metrics) const {
+        std::vector<Error> errors;
+        for(size_t i = 0; i < plan_.size(); ++i) {
+            if(metrics.updated(plan_[i].metric) == Clock::time_point{})
+                errors.push_back({lines_[i], "no collector records '" + metrics.name(plan_[i].metric) + "', the rule never fires"});
+        }
+        return errors;
+    }
+
+    size_t AlertRules::evaluate(const MetricTable& metrics, Clock::time_point now, AlertEvent* events, size_t capacity) {
+        size_t n_events = 0;
+        for(size_t i = 0; i < plan_.size(); ++i) {
+            const Step& step = plan_[i];
+            Clock::time_point updated = metrics.updated(step.metric);
+            if(updated == Clock::time_point{}) continue;        // no value yet
+
+            if(updated != seen_[i]) {
+                double value = metrics.last(step.metric);
+                if(!step.rate) {
+                    values_[i] = value;
+                    ready_[i] = 1;
+                } else if(seen_[i] != Clock::time_point{}) {
+                    double seconds = std::chrono::duration<double>(updated - seen_[i]).count();
+                    values_[i] = seconds > 0.0 ? (value - previous_[i]) / seconds : 0.0;
+                    ready_[i] = 1;
+                }
+                if(seen_[i] != Clock::time_point{}) gaps_[i] = updated - seen_[i];
+                previous_[i] = value;
+                seen_[i] = updated;
+            }
+            if(!ready_[i]) continue;        // a rate needs two values
+
+            // An old value says nothing about now
+            stale_[i] = gaps_[i] != Clock::duration::zero() && now - updated > stale_updates * gaps_[i];
+
+            double value = values_[i];
+            bool holds = false;
+            if(!stale_[i]) {
+                switch(step.op) {
+                    case Op::greater: holds = value > step.threshold; break;
+                    case Op::greater_equal: holds = value >= step.threshold; break;
+                    case Op::less: holds = value < step.threshold; break;
+                    case Op::less_equal: holds = value <= step.threshold; break;
+                }
+            }
+
+            bool firing = false;
+            if(holds) {
+                if(since_[i] == Clock::time_point{}) since_[i] = seen_[i];     // time of the value
+                firing = now - since_[i] >= step.hold;
+            } else {
+                since_[i] = Clock::time_point{};
+            }
+
+            // A transition not fitting into events is reported by the next evaluation
+            if(firing != (firing_[i] != 0) && n_events < capacity) {
+                firing_[i] = firing;
+                events[n_events++] = {static_cast<uint32_t>(i), firing, value, now};
+            }
+        }
+        return n_events;
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef ALERTS_HPP
+#define ALERTS_HPP
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "metrics.hpp"
+
+namespace system_monitor {
+
+    // Transition of a rule, produced by AlertRules::evaluate()
+    struct AlertEvent {
+        uint32_t rule = 0;
+        bool firing = false;            // false when the alert resolved
+        double value = 0.0;             // value (or rate) the rule was evaluated on
+        std::chrono::steady_clock::time_point time{};
+    };
+
+    // Threshold rules over the metrics of a MetricTable, one per line:
+    //
+    //     # comment
+    //     ram_high: ram.usage > 90 for 2m
+    //     root_filling: rate(drive./.usage) > 0.01 for 10m
+    //     cpu.usage >= 99
+    //
+    // rate() is the change per second between the last two values of the
+    // metric. A rule fires once its condition held for the duration (s, m,
+    // h; none fires at once) and resolves as soon as it no longer holds.
+    // A metric not updated for stale_updates times its last update interval
+    // (a collector no longer sampled, a drive unmounted) does not hold.
+    // compile() turns the text into a flat plan of steps, evaluate() runs it
+    // in O(rules) without allocating.
+    class AlertRules {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            static constexpr int stale_updates = 3;
+
+            struct Error {
+                size_t line = 0;                // 1-based
+                std::string message;
+            };
+
+            // Replaces the rules; metrics not registered yet are added to the
+            // table. Lines with errors are skipped, the others are kept.
+            std::vector<Error> compile(std::string_view source, MetricTable& metrics);
+
+            // Rules whose metric has no value in the table, as errors; once
+            // every collector recorded its metrics these are misspelt names
+            std::vector<Error> unrecorded(const MetricTable& metrics) const;
+
+            // Evaluates every rule against the last values of the metrics and
+            // writes the transitions into events, at most `capacity` of them;
+            // returns their number
+            size_t evaluate(const MetricTable& metrics, Clock::time_point now, AlertEvent* events, size_t capacity);
+
+            size_t size() const { return plan_.size(); }
+            const std::string& name(uint32_t rule) const { return names_[rule]; }
+            const std::string& text(uint32_t rule) const { return texts_[rule]; }
+            bool firing(uint32_t rule) const { return firing_[rule] != 0; }
+            bool stale(uint32_t rule) const { return stale_[rule] != 0; }
+            MetricTable::Id metric(uint32_t rule) const { return plan_[rule].metric; }
+            double value(uint32_t rule) const { return values_[rule]; }
+
+        private:
+            enum class Op : uint8_t { greater, greater_equal, less, less_equal };
+
+            struct Step {
+                MetricTable::Id metric;
+                Op op;
+                bool rate;
+                double threshold;
+                Clock::duration hold;
+            };
+
+            std::vector<Step> plan_;
+
+            // Evaluation state, parallel to plan_
+            std::vector<Clock::time_point> since_;          // condition holds since, default if it does not
+            std::vector<Clock::time_point> seen_;           // update of the metric evaluated last
+            std::vector<Clock::duration> gaps_;             // between the last two updates, zero before
+            std::vector<double> previous_;                  // value at that update, for rates
+            std::vector<double> values_;
+            std::vector<uint8_t> ready_;                    // values_ holds a value (rates need two updates)
+            std::vector<uint8_t> firing_;
+            std::vector<uint8_t> stale_;
+
+            std::vector<std::string> names_;
+            std::vector<std::string> texts_;
+            std::vector<size_t> lines_;
+
+            bool parse_rule(std::string_view line, MetricTable& metrics, Step& step, std::string& name, std::string& error);
+    };
+}
+
+#endif
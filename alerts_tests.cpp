@@ -0,0 +1,262 @@
+#include "catch_amalgamated.hpp"
+#include "alerts.hpp"
+#include "alert_hook.hpp"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using system_monitor::AlertEvent;
+using system_monitor::AlertHook;
+using system_monitor::AlertRules;
+using system_monitor::MetricTable;
+using namespace std::chrono_literals;
+
+namespace {
+    constexpr size_t capacity = 16;
+}
+
+// Rules Tests
+// syntax and errors
+TEST_CASE("AlertRules compile", "[alerts][AlertRules]") {
+    MetricTable metrics;
+    AlertRules rules;
+
+    auto errors = rules.compile("# comment\n"
+                                "ram_high: ram.usage > 90 for 2m\n"
+                                "\n"
+                                "rate(drive./.usage) >= 0.01 for 30s\n"
+                                "on_alert command true\n"
+                                "cpu.usage > ninety\n"
+                                "cpu.usage = 5\n"
+                                "rate(cpu.usage > 5\n"
+                                "cpu.usage > 5 for 2 minutes\n", metrics);
+    CHECK(rules.size() == 2);
+    CHECK(rules.name(0) == "ram_high");
+    CHECK(rules.text(0) == "ram_high: ram.usage > 90 for 2m");
+    CHECK(rules.name(1) == "rate(drive./.usage) >= 0.01 for 30s");
+    CHECK(metrics.find("ram.usage") != MetricTable::no_metric);
+    CHECK(metrics.find("drive./.usage") != MetricTable::no_metric);
+
+    REQUIRE(errors.size() == 4);
+    CHECK(errors[0].line == 6);
+    CHECK(errors[1].line == 7);
+    CHECK(errors[2].line == 8);
+    CHECK(errors[3].line == 9);
+}
+
+// threshold and duration
+TEST_CASE("AlertRules threshold for duration", "[alerts][AlertRules]") {
+    MetricTable metrics;
+    AlertRules rules;
+    REQUIRE(rules.compile("ram_high: ram.usage > 90 for 2m", metrics).empty());
+    MetricTable::Id ram = metrics.find("ram.usage");
+    AlertEvent events[capacity];
+
+    AlertRules::Clock::time_point start{1h};
+    CHECK(rules.evaluate(metrics, start, events, capacity) == 0);      // no value yet
+
+    metrics.record(ram, 95.0, start);
+    CHECK(rules.evaluate(metrics, start, events, capacity) == 0);
+    metrics.record(ram, 96.0, start + 1min);
+    CHECK(rules.evaluate(metrics, start + 1min, events, capacity) == 0);
+    CHECK(!rules.firing(0));
+
+    metrics.record(ram, 97.0, start + 2min);
+    REQUIRE(rules.evaluate(metrics, start + 2min, events, capacity) == 1);
+    CHECK(events[0].rule == 0);
+    CHECK(events[0].firing);
+    CHECK(events[0].value == 97.0);
+    CHECK(rules.firing(0));
+    CHECK(rules.evaluate(metrics, start + 3min, events, capacity) == 0);    // still firing, no new event
+
+    metrics.record(ram, 50.0, start + 4min);
+    REQUIRE(rules.evaluate(metrics, start + 4min, events, capacity) == 1);
+    CHECK(!events[0].firing);
+
+    // A dip resets the duration
+    metrics.record(ram, 95.0, start + 5min);
+    rules.evaluate(metrics, start + 5min, events, capacity);
+    metrics.record(ram, 80.0, start + 6min);
+    rules.evaluate(metrics, start + 6min, events, capacity);
+    metrics.record(ram, 95.0, start + 7min);
+    CHECK(rules.evaluate(metrics, start + 8min, events, capacity) == 0);
+    CHECK(rules.evaluate(metrics, start + 9min, events, capacity) == 1);
+}
+
+// change per second between updates
+TEST_CASE("AlertRules rate", "[alerts][AlertRules]") {
+    MetricTable metrics;
+    AlertRules rules;
+    REQUIRE(rules.compile("filling: rate(drive./.usage) > 0.01\nshrinking: rate(drive./.usage) <= 0", metrics).empty());
+    MetricTable::Id drive = metrics.find("drive./.usage");
+    AlertEvent events[capacity];
+
+    AlertRules::Clock::time_point start{1h};
+    metrics.record(drive, 50.0, start);
+    CHECK(rules.evaluate(metrics, start, events, capacity) == 0);       // a rate needs two values
+
+    metrics.record(drive, 50.0, start + 30s);
+    REQUIRE(rules.evaluate(metrics, start + 30s, events, capacity) == 1);
+    CHECK(events[0].rule == 1);
+
+    metrics.record(drive, 51.5, start + 60s);       // 0.05 %/s
+    REQUIRE(rules.evaluate(metrics, start + 60s, events, capacity) == 2);
+    CHECK(rules.firing(0));
+    CHECK(!rules.firing(1));
+    CHECK(rules.value(0) == Catch::Approx(0.05));
+}
+
+// a metric no longer updated stops holding instead of firing on its last value
+TEST_CASE("AlertRules stale metric", "[alerts][AlertRules]") {
+    MetricTable metrics;
+    AlertRules rules;
+    REQUIRE(rules.compile("ram_high: ram.usage > 90 for 2m", metrics).empty());
+    MetricTable::Id ram = metrics.find("ram.usage");
+    AlertEvent events[capacity];
+
+    AlertRules::Clock::time_point start{1h};
+    metrics.record(ram, 95.0, start);
+    rules.evaluate(metrics, start, events, capacity);
+    metrics.record(ram, 95.0, start + 1s);
+    rules.evaluate(metrics, start + 1s, events, capacity);
+    CHECK(!rules.stale(0));
+
+    // Updates every second, then nothing: stale after three seconds
+    CHECK(rules.evaluate(metrics, start + 3s, events, capacity) == 0);
+    CHECK(!rules.stale(0));
+    CHECK(rules.evaluate(metrics, start + 2min, events, capacity) == 0);
+    CHECK(rules.stale(0));
+    CHECK(!rules.firing(0));
+
+    // A firing rule resolves once its metric goes stale
+    for(int second = 0; second <= 120; ++second) {
+        metrics.record(ram, 95.0, start + 3min + std::chrono::seconds(second));
+        rules.evaluate(metrics, start + 3min + std::chrono::seconds(second), events, capacity);
+    }
+    CHECK(rules.firing(0));
+    REQUIRE(rules.evaluate(metrics, start + 10min, events, capacity) == 1);
+    CHECK(!events[0].firing);
+    CHECK(rules.stale(0));
+}
+
+// rules on metrics nothing records, e.g. misspelt
+TEST_CASE("AlertRules unrecorded", "[alerts][AlertRules]") {
+    MetricTable metrics;
+    AlertRules rules;
+    REQUIRE(rules.compile("ram.usage > 90\n# typo\nram_typo: ram.usge > 90", metrics).empty());
+    CHECK(rules.unrecorded(metrics).size() == 2);
+
+    metrics.record(metrics.find("ram.usage"), 50.0, AlertRules::Clock::now());
+    auto errors = rules.unrecorded(metrics);
+    REQUIRE(errors.size() == 1);
+    CHECK(errors[0].line == 3);
+    CHECK(errors[0].message.find("'ram.usge'") != std::string::npos);
+}
+
+// transitions beyond the capacity come with the next evaluation
+TEST_CASE("AlertRules event capacity", "[alerts][AlertRules]") {
+    MetricTable metrics;
+    AlertRules rules;
+    std::string source;
+    for(int i = 0; i < 5; ++i)
+        source += "cpu.usage > " + std::to_string(i * 10) + "\n";
+    REQUIRE(rules.compile(source, metrics).empty());
+
+    AlertEvent events[3];
+    auto now = AlertRules::Clock::now();
+    metrics.record(metrics.find("cpu.usage"), 99.0, now);
+    CHECK(rules.evaluate(metrics, now, events, 3) == 3);
+    CHECK(rules.evaluate(metrics, now, events, 3) == 2);
+    CHECK(rules.evaluate(metrics, now, events, 3) == 0);
+}
+
+// thousands of rules well under a millisecond
+TEST_CASE("AlertRules evaluate cost", "[alerts][AlertRules]") {
+    MetricTable metrics;
+    AlertRules rules;
+    constexpr int n_rules = 5000;
+    std::string source;
+    for(int i = 0; i < n_rules; ++i)
+        source += "cpu.core" + std::to_string(i % 64) + ".usage > " + std::to_string(i % 100) + " for 1m\n";
+    REQUIRE(rules.compile(source, metrics).empty());
+    REQUIRE(rules.size() == n_rules);
+
+    AlertEvent events[capacity];
+    auto now = AlertRules::Clock::now();
+    for(MetricTable::Id id = 0; id < metrics.size(); ++id)
+        metrics.record(id, 50.0, now);
+
+    constexpr int iterations = 100;
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i) {
+        now += 10ms;
+        rules.evaluate(metrics, now, events, capacity);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    double us = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()) / iterations;
+    CHECK(us < 500.0);
+}
+
+// Hook Tests
+TEST_CASE("AlertHook format", "[alerts][AlertHook]") {
+    MetricTable metrics;
+    AlertRules rules;
+    REQUIRE(rules.compile("ram_high: ram.usage > 90 for 2m\ncpu.usage > 95", metrics).empty());
+
+    CHECK(AlertHook::format(rules, {0, true, 93.5, {}}) == "firing ram_high 93.5 ram.usage > 90 for 2m");
+    CHECK(AlertHook::format(rules, {1, false, 12.0, {}}) == "resolved cpu.usage > 95 12");
+}
+
+// lines reach the socket and the command
+TEST_CASE("AlertHook socket and command", "[alerts][AlertHook]") {
+    std::string directory = "/tmp/alert_hook_test_" + std::to_string(getpid());
+    std::string socket_path = directory + ".sock";
+    std::string output_path = directory + ".out";
+    unlink(socket_path.c_str());
+    unlink(output_path.c_str());
+
+    int receiver = socket(AF_UNIX, SOCK_DGRAM, 0);
+    REQUIRE(receiver >= 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::snprintf(address.sun_path, sizeof(address.sun_path), "%s", socket_path.c_str());
+    REQUIRE(bind(receiver, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0);
+    timeval timeout{5, 0};
+    setsockopt(receiver, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    {
+        AlertHook hook;
+        CHECK(!hook.enabled());
+        hook.deliver("dropped");        // not configured
+        hook.configure("ram_high: ram.usage > 90\n"
+                       "on_alert socket " + socket_path + "\n"
+                       "on_alert command echo \"$SYSTEM_MONITOR_ALERT\" >> " + output_path + "\n");
+        CHECK(hook.enabled());
+        hook.deliver("firing ram_high 93.5");
+
+        // The command runs after the datagram was sent
+        std::string output;
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while(output.empty() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(10ms);
+            std::ifstream file(output_path);
+            std::getline(file, output);
+        }
+        CHECK(output == "firing ram_high 93.5");
+    }
+
+    char buffer[256];
+    ssize_t n = recv(receiver, buffer, sizeof(buffer), 0);
+    REQUIRE(n > 0);
+    CHECK(std::string(buffer, static_cast<size_t>(n)) == "firing ram_high 93.5");
+    close(receiver);
+    unlink(socket_path.c_str());
+    unlink(output_path.c_str());
+}
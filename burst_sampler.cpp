@@ -0,0 +1,211 @@
+#include "burst_sampler.hpp"
+#include "procfs_parse.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <time.h>
+#include <unistd.h>
+
+namespace system_monitor {
+
+    namespace {
+        std::chrono::nanoseconds thread_cpu_time() {
+            timespec ts{};
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+            return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+        }
+
+        std::chrono::microseconds tick_span(int ticks) {
+            long hz = sysconf(_SC_CLK_TCK);
+            if(hz <= 0) hz = 100;
+            return std::chrono::microseconds(1000000 * ticks / hz);
+        }
+    }
+
+    BurstSampler::BurstSampler(std::chrono::milliseconds window) : window_(window), span_(tick_span(span_ticks)) {}
+
+    BurstSampler::~BurstSampler() {
+        stop();
+    }
+
+    void BurstSampler::start() {
+        if(running()) return;
+        stop_ = false;
+        thread_ = std::thread([this] { run(); });
+    }
+
+    void BurstSampler::stop() {
+        if(!running()) return;
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    bool BurstSampler::read(Summary& out, uint64_t& seen) const {
+        std::lock_guard lock(mutex_);
+        if(generation_ == seen) return false;
+        out.total = published_.total;
+        out.cores.assign(published_.cores.begin(), published_.cores.end());
+        out.samples = published_.samples;
+        out.interval = published_.interval;
+        out.overhead = published_.overhead;
+        seen = generation_;
+        return true;
+    }
+
+    BurstSampler::Window BurstSampler::summarize(float* values, size_t n) {
+        Window window;
+        if(n == 0) return window;
+        auto [min, max] = std::minmax_element(values, values + n);
+        window.min = *min;
+        window.max = *max;
+
+        size_t rank = static_cast<size_t>(std::ceil(0.99 * static_cast<double>(n))) - 1;
+        std::nth_element(values, values + rank, values + n);
+        window.p99 = values[rank];
+        return window;
+    }
+
+    void BurstSampler::run() {
+        auto window_start = std::chrono::steady_clock::now();
+        auto cpu_start = thread_cpu_time();
+        auto next = window_start;
+
+        std::unique_lock lock(mutex_);
+        while(!wake_.wait_until(lock, next, [this] { return stop_; })) {
+            lock.unlock();
+
+            auto now = std::chrono::steady_clock::now();
+            feed(stat_.read(), now);
+            if(now - window_start >= window_) {
+                auto cpu_now = thread_cpu_time();
+                publish_window(now - window_start, cpu_now - cpu_start);
+                window_start = now;
+                cpu_start = cpu_now;
+            }
+
+            next += interval_;
+            if(next < now) next = now + interval_;      // fell behind, do not catch up in a burst
+            lock.lock();
+        }
+    }
+
+    // One pass over the cpu lines; the usages over the trailing span go into the next ring row
+    bool BurstSampler::feed(std::string_view stat, std::chrono::steady_clock::time_point now) {
+        current_total_.clear();
+        current_idle_.clear();
+        std::string_view line;
+        while(next_line(stat, line) && line.compare(0, 3, "cpu") == 0) {
+            const char* p = line.data() + std::min(line.size(), line.find(' '));      // after "cpu" or "cpuN"
+            const char* end = line.data() + line.size();
+            unsigned long long total = 0, idle = 0;
+            for(int field = 0; field < 8 && p < end; ++field) {        // user .. steal
+                unsigned long long value = 0;
+                p = scan_number(p, end, value);
+                total += value;
+                if(field == 3 || field == 4) idle += value;     // idle, iowait
+            }
+            current_total_.push_back(total);
+            current_idle_.push_back(idle);
+        }
+
+        // First read or CPU hotplug: start over
+        if(current_total_.size() != columns_) resize(current_total_.size());
+        if(columns_ == 0) return false;
+
+        // Newest read at least one span old, the previous one if the interval is longer
+        size_t base = depth_;
+        for(size_t age = 1; age <= history_size_; ++age) {
+            size_t row = (history_head_ + depth_ - age) % depth_;
+            if(now - history_time_[row] >= span_) {
+                base = row;
+                break;
+            }
+        }
+
+        bool recorded = base != depth_ && rows_ < capacity_;
+        if(recorded) {
+            float* usages = &ring_[rows_ * columns_];
+            const unsigned long long* base_total = &history_total_[base * columns_];
+            const unsigned long long* base_idle = &history_idle_[base * columns_];
+            for(size_t column = 0; column < columns_; ++column) {
+                // No tick over the span, or the counters went back: no usage to report
+                if(current_total_[column] <= base_total[column] || current_idle_[column] < base_idle[column]) {
+                    usages[column] = std::numeric_limits<float>::quiet_NaN();
+                    continue;
+                }
+                float total_diff = static_cast<float>(current_total_[column] - base_total[column]);
+                float idle_diff = static_cast<float>(current_idle_[column] - base_idle[column]);
+                usages[column] = std::clamp(1.0f - idle_diff / total_diff, 0.0f, 1.0f);
+            }
+            ++rows_;
+        }
+
+        std::copy(current_total_.begin(), current_total_.end(), history_total_.begin() + static_cast<ptrdiff_t>(history_head_ * columns_));
+        std::copy(current_idle_.begin(), current_idle_.end(), history_idle_.begin() + static_cast<ptrdiff_t>(history_head_ * columns_));
+        history_time_[history_head_] = now;
+        history_head_ = (history_head_ + 1) % depth_;
+        history_size_ = std::min(history_size_ + 1, depth_);
+        return recorded;
+    }
+
+    // Sizes the ring for one window and the history for one span at the fastest rate
+    void BurstSampler::resize(size_t columns) {
+        columns_ = columns;
+        capacity_ = static_cast<size_t>(std::chrono::duration_cast<std::chrono::microseconds>(window_) / min_interval) + 1;
+        ring_.assign(capacity_ * columns_, 0.0f);
+        scratch_.assign(capacity_, 0.0f);
+        building_.cores.assign(columns_ > 0 ? columns_ - 1 : 0, Window{});
+        rows_ = 0;
+
+        depth_ = static_cast<size_t>(span_ / min_interval) + 2;
+        history_total_.assign(depth_ * columns_, 0);
+        history_idle_.assign(depth_ * columns_, 0);
+        history_time_.assign(depth_, std::chrono::steady_clock::time_point{});
+        history_head_ = 0;
+        history_size_ = 0;
+    }
+
+    const BurstSampler::Summary& BurstSampler::take_window() {
+        for(size_t column = 0; column < columns_; ++column) {
+            size_t n = 0;
+            for(size_t row = 0; row < rows_; ++row) {
+                float usage = ring_[row * columns_ + column];
+                if(!std::isnan(usage)) scratch_[n++] = usage;
+            }
+            Window window = summarize(scratch_.data(), n);
+            if(column == 0)
+                building_.total = window;
+            else
+                building_.cores[column - 1] = window;
+        }
+        building_.samples = rows_;
+        building_.interval = interval_;
+        rows_ = 0;
+        return building_;
+    }
+
+    void BurstSampler::publish_window(std::chrono::nanoseconds wall, std::chrono::nanoseconds cpu) {
+        take_window();
+        building_.overhead = wall.count() > 0 ? static_cast<double>(cpu.count()) / static_cast<double>(wall.count()) : 0.0;
+
+        {
+            std::lock_guard lock(mutex_);
+            published_.total = building_.total;
+            published_.cores.assign(building_.cores.begin(), building_.cores.end());
+            published_.samples = building_.samples;
+            published_.interval = building_.interval;
+            published_.overhead = building_.overhead;
+            ++generation_;
+        }
+
+        // Keep within the budget: back off quickly, come back slowly
+        if(building_.overhead > overhead_budget)
+            interval_ = std::min(max_interval, interval_ * 3 / 2);
+        else if(building_.overhead < overhead_budget / 2)
+            interval_ = std::max(min_interval, interval_ * 9 / 10);
+    }
+}
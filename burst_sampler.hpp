@@ -0,0 +1,112 @@
+#ifndef BURST_SAMPLER_HPP
+#define BURST_SAMPLER_HPP
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "procfs_reader.hpp"
+
+namespace system_monitor {
+
+    // Samples /proc/stat (aggregate and cores) every few milliseconds on its
+    // own thread to catch the short saturation bursts the normal cadence
+    // averages away. Usages go into a ring preallocated for one window; at
+    // the end of every window min/max/p99 are published. The thread measures
+    // its own CPU time and stretches the interval to stay within its budget.
+    //
+    // /proc/stat only advances once per USER_HZ tick, so a single 5-10 ms
+    // interval sees 0 or 1 tick per core. Every ring entry is therefore the
+    // usage over the trailing span_ticks ticks, and a core whose counters did
+    // not move over that span is left out of the window.
+    class BurstSampler {
+        public:
+            static constexpr std::chrono::microseconds min_interval{5000};
+            static constexpr std::chrono::microseconds start_interval{10000};
+            static constexpr std::chrono::microseconds max_interval{50000};
+            static constexpr double overhead_budget = 0.005;        // share of one core
+            static constexpr int span_ticks = 4;                    // USER_HZ ticks per usage
+
+            struct Window {
+                double min = 0.0;
+                double max = 0.0;
+                double p99 = 0.0;
+            };
+
+            struct Summary {
+                Window total;
+                std::vector<Window> cores;
+                size_t samples = 0;                     // in the window
+                std::chrono::microseconds interval{};
+                double overhead = 0.0;                  // CPU time of the thread / wall time
+            };
+
+            explicit BurstSampler(std::chrono::milliseconds window = std::chrono::milliseconds(500));
+            ~BurstSampler();
+
+            BurstSampler(const BurstSampler&) = delete;
+            BurstSampler& operator=(const BurstSampler&) = delete;
+
+            void start();
+            void stop();
+            bool running() const { return thread_.joinable(); }
+
+            // Copies the last published window into out if it is newer than `seen`
+            bool read(Summary& out, uint64_t& seen) const;
+
+            // Trailing span of every usage, span_ticks ticks of USER_HZ
+            std::chrono::microseconds span() const { return span_; }
+
+            // What the burst thread does with each read of /proc/stat: records
+            // one ring row once the history covers the span. Only for a
+            // sampler that is not running, e.g. to replay text in tests.
+            bool feed(std::string_view stat, std::chrono::steady_clock::time_point now);
+            // Summarizes the rows fed since the last window and starts a new one
+            const Summary& take_window();
+
+            // min/max/p99 of n usages, reorders them
+            static Window summarize(float* values, size_t n);
+
+        private:
+            const std::chrono::milliseconds window_;
+            const std::chrono::microseconds span_;
+            ProcfsFile stat_{"/proc/stat"};
+
+            // Burst thread only
+            std::vector<unsigned long long> current_total_;     // aggregate, then cores
+            std::vector<unsigned long long> current_idle_;
+
+            // Last depth_ reads of the counters, for the trailing span
+            std::vector<unsigned long long> history_total_;     // depth_ rows of columns_ counters
+            std::vector<unsigned long long> history_idle_;
+            std::vector<std::chrono::steady_clock::time_point> history_time_;
+            size_t depth_ = 0;
+            size_t history_head_ = 0;                       // next row to write
+            size_t history_size_ = 0;
+
+            std::vector<float> ring_;                       // capacity_ rows of columns_ usages, NaN if left out
+            std::vector<float> scratch_;
+            size_t columns_ = 0;
+            size_t capacity_ = 0;
+            size_t rows_ = 0;
+            std::chrono::microseconds interval_ = start_interval;
+            Summary building_;
+
+            mutable std::mutex mutex_;
+            std::condition_variable wake_;
+            bool stop_ = false;
+            Summary published_;
+            uint64_t generation_ = 0;
+
+            std::thread thread_;
+
+            void run();
+            void resize(size_t columns);
+            void publish_window(std::chrono::nanoseconds wall, std::chrono::nanoseconds cpu);
+    };
+}
+
+#endif
@@ -0,0 +1,100 @@
+#include "catch_amalgamated.hpp"
+#include "burst_sampler.hpp"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// BurstSampler Tests
+TEST_CASE("BurstSampler summarize", "[burst_sampler]") {
+    std::vector<float> values(200);
+    for(size_t i = 0; i < values.size(); ++i)
+        values[i] = static_cast<float>(values.size() - i) / 200.0f;     // 1.0 down to 0.005
+
+    auto window = system_monitor::BurstSampler::summarize(values.data(), values.size());
+    CHECK(window.min == Catch::Approx(0.005));
+    CHECK(window.max == Catch::Approx(1.0));
+    CHECK(window.p99 == Catch::Approx(0.99));       // rank 198 of 200
+
+    float single = 0.5f;
+    window = system_monitor::BurstSampler::summarize(&single, 1);
+    CHECK(window.min == Catch::Approx(0.5));
+    CHECK(window.p99 == Catch::Approx(0.5));
+    CHECK(system_monitor::BurstSampler::summarize(nullptr, 0).max == 0.0);
+}
+
+// /proc/stat advances once per tick: a core busy every other tick is at 50%,
+// not alternating between 0 and 100% from one 5 ms read to the next
+TEST_CASE("BurstSampler known load", "[burst_sampler]") {
+    system_monitor::BurstSampler burst(std::chrono::milliseconds(1000));
+    auto tick = burst.span() / system_monitor::BurstSampler::span_ticks;
+    REQUIRE(tick.count() > 0);
+
+    // cpu0 busy every other tick, cpu1 busy all the time
+    auto stat = [](unsigned long long busy0, unsigned long long idle0, unsigned long long busy1) {
+        auto line = [](const std::string& name, unsigned long long user, unsigned long long idle) {
+            return name + " " + std::to_string(user) + " 0 0 " + std::to_string(idle) + " 0 0 0 0 0 0\n";
+        };
+        return line("cpu ", busy0 + busy1, idle0) + line("cpu0", busy0, idle0) + line("cpu1", busy1, 0) + "intr 1234 0 0\n";
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    size_t recorded = 0;
+    for(unsigned long long read = 0; read < 200; ++read) {
+        unsigned long long ticks = read / 2;            // two reads per tick, half of them see none
+        unsigned long long busy = (ticks + 1) / 2;
+        if(burst.feed(stat(busy, ticks - busy, ticks), start + tick / 2 * read)) ++recorded;
+    }
+    CHECK(recorded > 150);          // all but the first span
+
+    const auto& window = burst.take_window();
+    CHECK(window.samples == recorded);
+    CHECK(window.total.min == Catch::Approx(0.75));
+    CHECK(window.total.max == Catch::Approx(0.75));
+    REQUIRE(window.cores.size() == 2);
+    CHECK(window.cores[0].min == Catch::Approx(0.5));
+    CHECK(window.cores[0].max == Catch::Approx(0.5));
+    CHECK(window.cores[0].p99 == Catch::Approx(0.5));
+    CHECK(window.cores[1].min == Catch::Approx(1.0));
+
+    // Reads with no tick over the span are left out, not recorded as idle
+    auto later = start + tick / 2 * 200;
+    for(int read = 0; read < 20; ++read)
+        burst.feed(stat(50, 49, 99), later + tick / 2 * read);
+    burst.take_window();            // moving into the pause
+    for(int read = 20; read < 40; ++read)
+        burst.feed(stat(50, 49, 99), later + tick / 2 * read);
+    const auto& paused = burst.take_window();
+    CHECK(paused.samples == 20);
+    CHECK(paused.cores[1].max == 0.0);      // nothing to summarize
+    CHECK(paused.cores[1].min == 0.0);
+}
+
+// windows are published with one entry per core and a bounded sampling cost
+TEST_CASE("BurstSampler windows", "[burst_sampler]") {
+    system_monitor::BurstSampler burst(std::chrono::milliseconds(100));
+    CHECK(!burst.running());
+    burst.start();
+    CHECK(burst.running());
+
+    system_monitor::BurstSampler::Summary summary;
+    uint64_t seen = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while(seen < 3 && std::chrono::steady_clock::now() < deadline) {
+        burst.read(summary, seen);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    burst.stop();
+    CHECK(!burst.running());
+
+    REQUIRE(seen >= 3);
+    CHECK(summary.cores.size() == std::thread::hardware_concurrency());
+    CHECK(summary.samples > 0);
+    CHECK(summary.total.min <= summary.total.p99);
+    CHECK(summary.total.p99 <= summary.total.max);
+    CHECK(summary.total.max <= 1.0);
+    CHECK(summary.interval >= system_monitor::BurstSampler::min_interval);
+    CHECK(summary.interval <= system_monitor::BurstSampler::max_interval);
+    CHECK(summary.overhead < 0.05);         // the budget is 0.5%, loose bound for loaded test machines
+    CHECK(!burst.read(summary, seen));       // nothing new once stopped
+}
@@ -0,0 +1,946 @@
+#include "canvas_renderer.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <numeric>
+#include <wx/font.h>
+#include <wx/dcmemory.h>
+
+namespace system_monitor {
+using std::min;
+
+    std::vector<std::string> CanvasRenderer::probe_names() {
+        return {"on_timer", "render", "paint_jitter",
+                "draw_card", "draw_info_section", "draw_usage_circle", "draw_network_graph",
+                "draw_title", "draw_percentage_text", "draw_show_more_text",
+                "draw_ram_info", "draw_drive_info", "draw_cpu_info", "draw_core_info",
+                "draw_system_infos", "draw_network_infos", "draw_fleet_tile", "draw_heatmap"};
+    }
+
+    // Colour, usage and expanded view of every card kind, indexed by CardKind
+    const CanvasRenderer::CardDescriptor CanvasRenderer::card_descriptors[] = {
+        {76, 175, 80,       // RAM
+         [](const CanvasSnapshot& snapshot, size_t) { return snapshot.ram_usage; },
+         &CanvasRenderer::draw_ram_info},
+        {255, 152, 0,       // Drive
+         [](const CanvasSnapshot& snapshot, size_t index) { return index < snapshot.mounts.size() ? snapshot.mounts[index].usage : 0.0; },
+         &CanvasRenderer::draw_drive_info},
+        {33, 150, 243,      // CPU
+         [](const CanvasSnapshot& snapshot, size_t) { return snapshot.cpu_usage; },
+         &CanvasRenderer::draw_cpu_info},
+        {100, 181, 246,     // single core
+         [](const CanvasSnapshot& snapshot, size_t index) { return index < snapshot.core_usages.size() ? snapshot.core_usages[index] : 0.0; },
+         &CanvasRenderer::draw_core_info},
+    };
+
+    CanvasRenderer::CanvasRenderer(Instrumentation& instrumentation)
+        : instrumentation_(instrumentation) {
+        static_assert(std::size(card_descriptors) == static_cast<size_t>(CardKind::n_kinds));
+
+        cards_.resize(n_cards);
+        cards_[0].kind = CardKind::ram;
+        cards_[0].label = "RAM";
+        cards_[1].kind = CardKind::drive;
+        cards_[1].label = "Drive";
+        cards_[2].kind = CardKind::cpu;
+        cards_[2].label = "CPU";
+
+        fonts_[font_heading] = wxFont(title_font_size, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
+        fonts_[font_percent] = wxFont(percent_font_size, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
+        fonts_[font_subheading] = wxFont(12, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
+        fonts_[font_info] = wxFont(12, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL);
+        fonts_[font_timings] = wxFont(10, wxFONTFAMILY_TELETYPE, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL);
+    }
+
+    // FNV-1a over the characters
+    size_t CanvasRenderer::TextHash::operator()(const wxString& text) const {
+        size_t hash = 14695981039346656037ull;
+        for(auto c : text) {
+            hash ^= static_cast<size_t>(static_cast<wxUint32>(c.GetValue()));
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    wxSize CanvasRenderer::text_extent(wxDC& dc, FontSlot slot, const wxString& text) {
+        auto& cache = text_extents_[slot];
+        auto it = cache.find(text);
+        if(it != cache.end()) return it->second;
+
+        if(cache.size() >= text_extent_cache_limit) cache.clear();     // e.g. ever changing numbers
+        wxSize extent = dc.GetTextExtent(text);
+        cache.emplace(text, extent);
+        return extent;
+    }
+
+    // Creates one card per mount (besides "/") and per core, keeps the expanded state
+    void CanvasRenderer::sync_cards(const CanvasSnapshot& snapshot) {
+        size_t n_mounts = snapshot.mounts.size() > 1 ? snapshot.mounts.size() - 1 : 0;
+        size_t n_cores = snapshot.heatmap_view ? 0 : snapshot.core_usages.size();     // the heatmap replaces the core cards
+
+        bool changed = cards_.size() != n_cards + n_mounts + n_cores;
+        for(size_t i = 0; !changed && i < n_mounts; ++i)
+            changed = mount_paths_[i] != snapshot.mounts[i + 1].path;
+        for(size_t i = 0; !changed && i < n_cores; ++i)
+            changed = core_ids_[i] != snapshot.cpu_id(i);
+        if(!changed) return;
+
+        auto position = [&](const Cards& card) -> size_t {
+            if(card.kind == CardKind::drive && card.index > 0) return n_cards + card.index - 1;
+            if(card.kind == CardKind::core) return n_cards + n_mounts + card.index;
+            return static_cast<size_t>(-1);
+        };
+
+        std::vector<Cards> cards(cards_.begin(), cards_.begin() + n_cards);
+        cards.resize(n_cards + n_mounts + n_cores);
+        mount_paths_.resize(n_mounts);
+        for(size_t i = 0; i < n_mounts; ++i) {
+            mount_paths_[i] = snapshot.mounts[i + 1].path;
+            cards[n_cards + i].kind = CardKind::drive;
+            cards[n_cards + i].index = i + 1;
+            cards[n_cards + i].label = "Drive " + wxString::FromUTF8(mount_paths_[i]);
+        }
+        core_ids_.resize(n_cores);
+        for(size_t i = 0; i < n_cores; ++i) {
+            core_ids_[i] = snapshot.cpu_id(i);
+            cards[n_cards + n_mounts + i].kind = CardKind::core;
+            cards[n_cards + n_mounts + i].index = i;
+            cards[n_cards + n_mounts + i].label = wxString::Format("Core %u", core_ids_[i]);
+        }
+        for(size_t i = n_cards; i < cards_.size(); ++i) {
+            size_t pos = position(cards_[i]);
+            if(pos < cards.size() && cards[pos].kind == cards_[i].kind && cards[pos].index == cards_[i].index)
+                cards[pos].expanded = cards_[i].expanded;
+        }
+
+        cards_ = std::move(cards);
+        layout_.reset(0, 0, 0, 0);
+        hovered_card_ = no_card;
+        layout_dirty_ = true;
+    }
+
+    wxBitmap CanvasRenderer::render_to_bitmap(const wxSize& size, const CanvasSnapshot& snapshot) {
+        wxBitmap bitmap(size.GetWidth(), size.GetHeight());
+        wxMemoryDC dc(bitmap);
+        dc.SetBackground(*wxWHITE_BRUSH);
+        dc.Clear();
+        render(dc, size, snapshot);
+        dc.SelectObject(wxNullBitmap);
+        return bitmap;
+    }
+
+    bool CanvasRenderer::toggle_show_more(int x, int y) {
+        const LayoutTable::Entry* entry = layout_.find(x, y);
+        if(entry == nullptr || entry->action != action_toggle_card) return false;
+
+        cards_[entry->target].expanded = !cards_[entry->target].expanded;
+        layout_dirty_ = true;
+        return true;
+    }
+
+    bool CanvasRenderer::update_hover(int x, int y) {
+        const LayoutTable::Entry* entry = layout_.find(x, y);
+        size_t hovered = entry != nullptr && entry->action == action_toggle_card ? entry->target : no_card;
+        if(hovered == hovered_card_) return false;
+        hovered_card_ = hovered;
+        return true;
+    }
+
+    size_t CanvasRenderer::fleet_host_at(int x, int y) const {
+        const LayoutTable::Entry* entry = layout_.find(x, y);
+        if(entry == nullptr || entry->action != action_select_host) return CanvasSnapshot::no_fleet_host;
+        return entry->target;
+    }
+
+    void CanvasRenderer::expand_all(bool expanded) {
+        for(auto& card : cards_)
+            card.expanded = expanded;
+        layout_dirty_ = true;
+    }
+
+    void CanvasRenderer::draw_alerts_overlay(wxDC& dc, int view_x, int view_y, int view_width, const CanvasSnapshot& snapshot) {
+        if(snapshot.alerts.empty()) return;
+        dc.SetFont(fonts_[font_info]);
+
+        int text_width = 0;
+        int line_height = 0;
+        for(const auto& alert : snapshot.alerts) {
+            wxSize extent = text_extent(dc, font_info, wxString::FromUTF8(alert));
+            text_width = std::max(text_width, extent.GetWidth());
+            line_height = std::max(line_height, extent.GetHeight() + 4);
+        }
+
+        int box_width = text_width + 20;
+        int box_height = static_cast<int>(snapshot.alerts.size()) * line_height + 10;
+        int x = view_x + view_width - box_width - 10;
+        int y = view_y + 10;
+
+        dc.SetBrush(wxBrush(wxColour(198, 40, 40, 230)));
+        dc.SetPen(wxPen(wxColour(150, 20, 20)));
+        dc.DrawRectangle(x, y, box_width, box_height);
+
+        dc.SetTextForeground(*wxWHITE);
+        int line_y = y + 5;
+        for(const auto& alert : snapshot.alerts) {
+            dc.DrawText(wxString::FromUTF8(alert), x + 10, line_y);
+            line_y += line_height;
+        }
+    }
+
+    // draws p50/p99/max of every probe in the top left corner of the visible area
+    int CanvasRenderer::draw_timings_overlay(wxDC& dc, int view_x, int view_y) {
+        dc.SetFont(fonts_[font_timings]);
+
+        wxSize extent = text_extent(dc, font_timings, wxString::Format("%-22s %9s %9s %9s", "", "", "", ""));
+        int tw = extent.GetWidth();
+        int th = extent.GetHeight();
+
+        int x = view_x + 10;
+        int y = view_y + 10;
+        int line_height = th + 2;
+        int box_height = (static_cast<int>(instrumentation_.size()) + 1) * line_height + 10;
+
+        dc.SetBrush(wxBrush(wxColour(35, 35, 45, 220)));
+        dc.SetPen(wxPen(wxColour(50, 50, 60)));
+        dc.DrawRectangle(x, y, tw + 20, box_height);
+
+        dc.SetTextForeground(*wxWHITE);
+        int line_y = y + 5;
+        dc.DrawText(wxString::Format("%-22s %9s %9s %9s", "scope (us)", "p50", "p99", "max"), x + 10, line_y);
+        for(size_t i = 0; i < instrumentation_.size(); ++i) {
+            const auto& h = instrumentation_.histogram(i);
+            line_y += line_height;
+            dc.DrawText(wxString::Format("%-22s %9.1f %9.1f %9.1f", instrumentation_.name(i).c_str(),
+                                         static_cast<double>(h.percentile(50.0)) / 1000.0,
+                                         static_cast<double>(h.percentile(99.0)) / 1000.0,
+                                         static_cast<double>(h.max()) / 1000.0), x + 10, line_y);
+        }
+        return y + box_height;
+    }
+
+    // draws the cost of the sampler thread per collector below y
+    void CanvasRenderer::draw_overhead_overlay(wxDC& dc, int view_x, int view_y, const CanvasSnapshot& snapshot) {
+        dc.SetFont(fonts_[font_timings]);
+
+        const char* row_format = "%-12s %8s %10s %9s %11s %10s";
+        wxSize extent = text_extent(dc, font_timings, wxString::Format(row_format, "", "", "", "", "", ""));
+        int x = view_x + 10;
+        int y = view_y + 10;
+        int line_height = extent.GetHeight() + 2;
+        int box_height = (static_cast<int>(snapshot.overhead_collectors.size()) + 5) * line_height + 10;
+
+        dc.SetBrush(wxBrush(wxColour(35, 35, 45, 220)));
+        dc.SetPen(wxPen(wxColour(50, 50, 60)));
+        dc.DrawRectangle(x, y, extent.GetWidth() + 20, box_height);
+
+        dc.SetTextForeground(*wxWHITE);
+        int line_y = y + 5;
+        dc.DrawText(wxString::Format(row_format, "collector", "cpu %", "us/sample", "faults/s", "syscalls/s", "period ms"), x + 10, line_y);
+        for(const auto& collector : snapshot.overhead_collectors) {
+            line_y += line_height;
+            wxString period = collector.stretch > 1 ? wxString::Format("%lld x%u", collector.period_ms, collector.stretch)
+                                                    : wxString::Format("%lld", collector.period_ms);
+            dc.DrawText(wxString::Format("%-12s %8.3f %10.1f %9.1f %11.1f %10s", collector.name.c_str(), collector.cpu * 100.0,
+                                         collector.sample_us, collector.faults, collector.syscalls, period), x + 10, line_y);
+        }
+        line_y += line_height;
+        dc.DrawText(wxString::Format("%-12s %8.3f %10s %9s %11.1f", "reads", snapshot.overhead_reads_cpu * 100.0, "", "",
+                                     snapshot.overhead_reads_syscalls), x + 10, line_y);
+        line_y += line_height;
+        dc.DrawText(snapshot.overhead_budget > 0.0
+                    ? wxString::Format("sampler %.3f%% of a core, budget %.2f%%", snapshot.overhead_cpu * 100.0, snapshot.overhead_budget * 100.0)
+                    : wxString::Format("sampler %.3f%% of a core", snapshot.overhead_cpu * 100.0), x + 10, line_y);
+        line_y += line_height;
+        dc.DrawText(wxString::Format("syscalls %.0f/s, %.1f/tick", snapshot.overhead_syscalls, snapshot.overhead_syscalls_per_tick), x + 10, line_y);
+        line_y += line_height;
+        dc.DrawText(wxString::Format("RSS %.1f MiB, faults %.1f/s", static_cast<double>(snapshot.overhead_rss) / (1024.0 * 1024),
+                                     snapshot.overhead_faults), x + 10, line_y);
+    }
+
+
+    int CanvasRenderer::render(wxDC& dc, const wxSize& size, const CanvasSnapshot& snapshot) {
+        return render(dc, size, wxRect(0, 0, size.GetWidth(), size.GetHeight()), snapshot);
+    }
+
+    int CanvasRenderer::render(wxDC& dc, const wxSize& size, const wxRect& viewport, const CanvasSnapshot& snapshot) {
+        ScopeTimer timing(instrumentation_, probe_render);
+        int width = size.GetWidth();
+        int height = size.GetHeight();
+
+        layout_.reset(viewport.x, viewport.y, viewport.width, viewport.height);
+        if(snapshot.fleet_view)
+            return render_fleet(dc, width, viewport, snapshot);
+
+        snapshot_ = &snapshot;
+        sync_cards(snapshot);
+
+        int base_cardWidth = (width - (n_cards + 1) * spacing) / n_cards;
+        int base_cardHeight = height / 2 - 2 * spacing;
+
+        // Draw cards
+        int x = spacing;
+        int cards_bottom = 0;
+
+        for(size_t i = 0; i < n_cards; ++i){
+            lay_out_and_draw(dc, viewport, i, x, spacing, base_cardWidth, base_cardHeight);
+            x += base_cardWidth + spacing;
+            if(cards_[i].rect.GetBottom() > cards_bottom)
+                cards_bottom = cards_[i].rect.GetBottom();
+        }
+
+        int info_y = cards_bottom + spacing;
+
+        int section_width = (width - 3 * spacing) / 2;
+        int section_height = (height / 2) - 2 * spacing;
+
+        if(viewport.Intersects(wxRect(spacing, info_y, width - 2 * spacing, section_height + spacing))) {
+            // General info Section
+            draw_info_section(dc, spacing, info_y, section_width, section_height, true);
+
+            // Network Section
+            draw_info_section(dc, 2 * spacing + section_width, info_y, section_width, section_height, false);
+        }
+
+        int detail_y = info_y + section_height + 2 * spacing;
+        int bottom = detail_y - spacing;
+
+        // Per-mount and per-core cards, only the rows in the viewport
+        if(cards_.size() > n_cards) {
+            if(layout_dirty_ || width != layout_width_ || height != layout_height_) {
+                update_detail_layout(width, base_cardHeight);
+                layout_width_ = width;
+                layout_height_ = height;
+            }
+
+            int detail_width = (width - (detail_columns_ + 1) * spacing) / detail_columns_;
+            auto first_row = std::upper_bound(detail_row_top_.begin(), detail_row_top_.end(), viewport.y - detail_y) - detail_row_top_.begin() - 1;
+            size_t n_rows = detail_row_top_.size() - 1;
+
+            for(size_t row = static_cast<size_t>(std::max<ptrdiff_t>(first_row, 0)); row < n_rows; ++row) {
+                int row_y = detail_y + detail_row_top_[row];
+                if(row_y > viewport.GetBottom()) break;
+
+                for(int column = 0; column < detail_columns_; ++column) {
+                    size_t card = n_cards + row * static_cast<size_t>(detail_columns_) + static_cast<size_t>(column);
+                    if(card >= cards_.size()) break;
+                    lay_out_and_draw(dc, viewport, card, spacing + column * (detail_width + spacing), row_y, detail_width, base_cardHeight);
+                }
+            }
+            bottom = detail_y + detail_row_top_.back();
+        }
+
+        if(snapshot.heatmap_view)
+            bottom = draw_heatmap(dc, viewport, bottom + spacing, width - 2 * spacing, height);
+
+        snapshot_ = nullptr;
+        return bottom;
+    }
+
+    // Core rows in a labelled frame; the image itself is one blit
+    int CanvasRenderer::draw_heatmap(wxDC& dc, const wxRect& viewport, int y, int width, int height) {
+        ScopeTimer timing(instrumentation_, probe_draw_heatmap);
+        size_t cores = heatmap_.cores();
+        if(cores == 0) return y;
+
+        constexpr int label_width = 70;
+        int image_height = CoreHeatmap::height_for(cores, std::max(height - 4 * spacing, static_cast<int>(cores)));
+        int box_height = image_height + 60;
+        if(!viewport.Intersects(wxRect(spacing, y, width, box_height))) return y + box_height;
+
+        dc.SetBrush(wxBrush(wxColour(255, 255, 255)));
+        dc.SetPen(wxPen(wxColour(180, 180, 180), 2));
+        dc.DrawRoundedRectangle(spacing, y, width, box_height, 20);
+
+        dc.SetFont(fonts_[font_info]);
+        dc.SetTextForeground(*wxBLACK);
+        int image_x = spacing + label_width;
+        int image_y = y + 30;
+        int image_width = width - label_width - 20;
+        dc.DrawText(wxString::Format("Cores over the last %zu samples", CoreHeatmap::history_length), image_x, y + 6);
+        dc.DrawText(wxString::Format("core %u", snapshot_->cpu_id(0)), spacing + 10, image_y);
+        dc.DrawText(wxString::Format("core %u", snapshot_->cpu_id(cores - 1)), spacing + 10, image_y + image_height - 16);
+
+        heatmap_.draw(dc, image_x, image_y, image_width, image_height);
+        return y + box_height;
+    }
+
+    // One tile per host, only the rows in the viewport are drawn
+    int CanvasRenderer::render_fleet(wxDC& dc, int width, const wxRect& viewport, const CanvasSnapshot& snapshot) {
+        size_t columns = static_cast<size_t>(std::max(1, (width - spacing) / (fleet_tile_width + fleet_tile_spacing)));
+        size_t rows = (snapshot.fleet.size() + columns - 1) / columns;
+        int row_height = fleet_tile_height + fleet_tile_spacing;
+        size_t first_row = static_cast<size_t>(std::max(0, (viewport.y - spacing) / row_height));
+
+        for(size_t row = first_row; row < rows; ++row) {
+            int y = spacing + static_cast<int>(row) * row_height;
+            if(y > viewport.GetBottom()) break;
+            for(size_t column = 0; column < columns; ++column) {
+                size_t host = row * columns + column;
+                if(host >= snapshot.fleet.size()) break;
+                int x = spacing + static_cast<int>(column) * (fleet_tile_width + fleet_tile_spacing);
+                draw_fleet_tile(dc, snapshot.fleet[host], x, y, host == snapshot.fleet_selected);
+                layout_.add({x, y, fleet_tile_width, fleet_tile_height, action_select_host, host});
+            }
+        }
+        return 2 * spacing + static_cast<int>(rows) * row_height;
+    }
+
+    // Host name and CPU/RAM bars in the card colours, greyed out while disconnected
+    void CanvasRenderer::draw_fleet_tile(wxDC& dc, const CanvasSnapshot::FleetHost& host, int x, int y, bool selected) {
+        ScopeTimer timing(instrumentation_, probe_draw_fleet_tile);
+        dc.SetBrush(wxBrush(host.connected ? wxColour(255, 255, 255) : wxColour(235, 235, 235)));
+        dc.SetPen(selected ? wxPen(wxColour(33, 150, 243), 3) : wxPen(wxColour(180, 180, 180), 1));
+        dc.DrawRoundedRectangle(x, y, fleet_tile_width, fleet_tile_height, 8);
+
+        dc.SetFont(fonts_[font_subheading]);
+        dc.SetTextForeground(host.connected ? wxColour(40, 40, 40) : wxColour(140, 140, 140));
+        dc.SetClippingRegion(x + 8, y + 4, fleet_tile_width - 16, 22);
+        dc.DrawText(wxString::FromUTF8(host.name), x + 10, y + 6);
+        dc.DestroyClippingRegion();
+
+        dc.SetFont(fonts_[font_timings]);
+        const CardDescriptor& cpu = card_descriptors[static_cast<size_t>(CardKind::cpu)];
+        const CardDescriptor& ram = card_descriptors[static_cast<size_t>(CardKind::ram)];
+        struct Bar { const char* label; double usage; wxColour colour; };
+        const Bar bars[] = {{"CPU", host.cpu_usage, wxColour(cpu.red, cpu.green, cpu.blue)},
+                            {"RAM", host.ram_usage, wxColour(ram.red, ram.green, ram.blue)}};
+
+        int bar_x = x + 44;
+        int bar_width = fleet_tile_width - 96;
+        int bar_y = y + 32;
+        for(const Bar& bar : bars) {
+            dc.DrawText(bar.label, x + 10, bar_y - 2);
+            dc.SetPen(*wxTRANSPARENT_PEN);
+            dc.SetBrush(wxBrush(wxColour(225, 225, 225)));
+            dc.DrawRectangle(bar_x, bar_y, bar_width, 10);
+            dc.SetBrush(wxBrush(host.connected ? bar.colour : wxColour(170, 170, 170)));
+            dc.DrawRectangle(bar_x, bar_y, static_cast<int>(bar_width * std::clamp(bar.usage, 0.0, 1.0)), 10);
+            dc.DrawText(wxString::Format("%3.0f%%", bar.usage * 100.0), bar_x + bar_width + 6, bar_y - 2);
+            bar_y += 18;
+        }
+    }
+
+    // Row offsets of the detail grid, a row is doubled when one of its cards is expanded
+    void CanvasRenderer::update_detail_layout(int width, int base_cardHeight) {
+        detail_columns_ = std::max(n_cards, (width - spacing) / (detail_card_width + spacing));
+        size_t columns = static_cast<size_t>(detail_columns_);
+        size_t n_detail = cards_.size() - n_cards;
+        size_t n_rows = (n_detail + columns - 1) / columns;
+
+        detail_row_top_.assign(n_rows + 1, 0);
+        for(size_t row = 0; row < n_rows; ++row) {
+            bool expanded = false;
+            for(size_t i = row * columns; i < std::min(n_detail, (row + 1) * columns); ++i)
+                expanded = expanded || cards_[n_cards + i].expanded;
+            detail_row_top_[row + 1] = detail_row_top_[row] + (expanded ? 2 * base_cardHeight : base_cardHeight) + spacing;
+        }
+
+        layout_dirty_ = false;
+    }
+
+    // Places a card and draws it if it is in the viewport
+    void CanvasRenderer::lay_out_and_draw(wxDC& dc, const wxRect& viewport, size_t index, int x, int y, int w, int base_cardHeight) {
+        Cards& card = cards_[index];
+        card.rect = wxRect(x, y, w, card.expanded ? 2 * base_cardHeight : base_cardHeight);
+        if(!viewport.Intersects(card.rect)) return;
+
+        card.usage = card_descriptors[static_cast<size_t>(card.kind)].usage(*snapshot_, card.index);
+        wxRect button = draw_card(dc, card, base_cardHeight, index == hovered_card_);
+        layout_.add({button.x, button.y, button.width, button.height, action_toggle_card, index});
+    }
+
+    // returns the rectangle of the "show more" button
+    wxRect CanvasRenderer::draw_card(wxDC& dc, Cards& card, int base_cardHeight, bool hovered) {
+        ScopeTimer timing(instrumentation_, probe_draw_card);
+        // Draw rounded rectangle (card background)
+        wxColour card_bg(255, 255, 255);
+        wxColour card_border(180, 180, 180);
+        dc.SetBrush(wxBrush(card_bg));
+        dc.SetPen(wxPen(card_border, 2));
+        const int corner_radius = 20;
+        dc.DrawRoundedRectangle(card.rect.x, card.rect.y, card.rect.width, card.rect.height, corner_radius);
+
+        // Draw the usage circle
+        int center_x = card.rect.x + card.rect.width / 2;
+        int center_y = card.rect.y + base_cardHeight / 2 - 10;
+        int circle_size = min(card.rect.width, base_cardHeight) * 0.6;
+        int circle_radius = circle_size / 2;
+
+        const CardDescriptor& descriptor = card_descriptors[static_cast<size_t>(card.kind)];
+        wxColour usage_col(descriptor.red, descriptor.green, descriptor.blue);
+
+        wxString usage_text = wxString::Format("%.1f%%", card.usage * 100.0);
+
+        draw_usage_circle(dc, center_x, center_y, circle_radius, card.usage, usage_col, usage_text);
+
+        draw_title(dc, card.rect.x, card.rect.y, card.label, card.rect.width);
+        int show_more_y = center_y + circle_radius + 18;
+        wxRect button = draw_show_more_text(dc, center_x, show_more_y, card.expanded, hovered);
+
+        if(card.expanded) {
+            int info_y = show_more_y + 80;
+            int info_x = card.rect.x + 30;
+            (this->*descriptor.draw_info)(dc, card, info_x, info_y);
+        }
+        return button;
+    }
+
+    // draws sections at the bottom
+    void CanvasRenderer::draw_info_section(wxDC& dc, int x, int y, int w, int h, bool is_general) {
+        ScopeTimer timing(instrumentation_, probe_draw_info_section);
+        wxColour card_bg(255, 255, 255);
+        wxColour card_border(180, 180, 180);
+        dc.SetBrush(wxBrush(card_bg));
+        dc.SetPen(wxPen(card_border, 2));
+        const int corner_radius = 20;
+        dc.DrawRoundedRectangle(x, y, w, h + spacing, corner_radius);
+
+        if(is_general) {
+            draw_system_infos(dc, x + spacing, y + spacing);
+        } else {
+            draw_network_infos(dc, x + spacing, y + spacing, w);
+        }
+    }
+
+    // draws the usage circles of components
+    void CanvasRenderer::draw_usage_circle(wxDC& dc, int center_x, int center_y, int radius, double usage, const wxColour& color, const wxString& usage_text) {
+        ScopeTimer timing(instrumentation_, probe_draw_usage_circle);
+        wxColour bg_circle(220, 220, 220);
+        dc.SetPen(wxPen(bg_circle, 10));
+        dc.SetBrush(*wxTRANSPARENT_BRUSH);
+        dc.DrawEllipse(center_x - radius, center_y - radius, 2 * radius, 2 * radius);
+
+        dc.SetPen(wxPen(color, 10));
+        double start_angle = -90.0; // top
+        double end_angle = start_angle + usage * 360.0;
+
+        if (usage > 0.0) {
+            if (usage >= 1.0) usage = 0.999; // DrawEllipticArc does not allow values over 0.999
+            dc.DrawEllipticArc(center_x - radius, center_y - radius, 2 * radius, 2 * radius, start_angle, end_angle);
+        }
+        draw_percentage_text(dc, center_x, center_y, usage_text);
+    }
+
+    // draws title of each card
+    void CanvasRenderer::draw_title(wxDC& dc, int x, int y, const wxString& label, int box_width) {
+        ScopeTimer timing(instrumentation_, probe_draw_title);
+        dc.SetFont(fonts_[font_heading]);
+        dc.SetTextForeground(*wxBLACK);
+
+        int tw = text_extent(dc, font_heading, label).GetWidth();
+
+        int label_x = x + (box_width - tw) / 2;
+        int label_y = y +  18;
+
+        dc.DrawText(label, label_x, label_y);
+    }
+
+    // draws percentag text in center of usage circle
+    void CanvasRenderer::draw_percentage_text(wxDC& dc, int center_x, int center_y, const wxString& usage_text) {
+        ScopeTimer timing(instrumentation_, probe_draw_percentage_text);
+        dc.SetFont(fonts_[font_percent]);
+        dc.SetTextForeground(*wxBLACK);
+
+        wxSize extent = text_extent(dc, font_percent, usage_text);
+        dc.DrawText(usage_text, center_x - extent.GetWidth() / 2, center_y - extent.GetHeight() / 2);
+    }
+
+    // draws show more "button"
+    wxRect CanvasRenderer::draw_show_more_text(wxDC& dc, int center_x, int y, bool expanded, bool hovered) {
+        ScopeTimer timing(instrumentation_, probe_draw_show_more_text);
+        dc.SetFont(fonts_[font_subheading]);
+
+        wxString text = expanded ? "show less" : "show more";
+
+        wxSize extent = text_extent(dc, font_subheading, text);
+        int tw = extent.GetWidth();
+        int th = extent.GetHeight();
+
+        int button_width = tw + 20;
+        int button_height = th + 20;
+        int button_x = center_x - button_width / 2;
+
+        dc.SetBrush(wxBrush(hovered ? wxColor(204, 228, 255) : wxColor(230, 242, 255)));
+        dc.SetPen(wxPen(wxColor(33, 150, 242), 2));
+        dc.DrawRoundedRectangle(button_x, y, button_width, button_height, 8);
+
+        dc.SetTextForeground(wxColour(33, 150, 243));
+        dc.DrawText(text, center_x - tw / 2, y + 9);
+        return wxRect(button_x, y, button_width, button_height);
+    }
+
+    void CanvasRenderer::draw_ram_info(wxDC& dc, const Cards&, int info_x, int info_y) {
+        ScopeTimer timing(instrumentation_, probe_draw_ram_info);
+
+        dc.SetFont(fonts_[font_heading]);
+        dc.SetTextForeground(*wxBLACK);
+
+        dc.DrawText("RAM informations:", info_x, info_y);
+
+        const double gib = 1024.0 * 1024 * 1024;
+        const double mib = 1024.0 * 1024;
+        auto in_gib = [&](unsigned long long bytes) { return static_cast<double>(bytes) / gib; };
+
+        int line_y = info_y + 35;
+        dc.SetFont(fonts_[font_info]);
+
+        dc.DrawText(wxString::Format("Total memory: %.2f GiB", in_gib(snapshot_->ram_total)), info_x, line_y);
+        line_y += 25;
+        dc.DrawText(wxString::Format("Used memory: %.2f GiB", in_gib(snapshot_->ram_used)), info_x, line_y);
+        line_y += 25;
+        dc.DrawText(wxString::Format("Available: %.2f GiB", in_gib(snapshot_->ram_available)), info_x, line_y);
+        line_y += 25;
+        dc.DrawText(wxString::Format("Free memory: %.2f GiB", in_gib(snapshot_->ram_free)), info_x, line_y);
+        line_y += 25;
+        dc.DrawText(wxString::Format("Buffers: %.2f GiB", in_gib(snapshot_->ram_buffers)), info_x, line_y);
+        line_y += 25;
+        dc.DrawText(wxString::Format("Cached: %.2f GiB", in_gib(snapshot_->ram_cached)), info_x, line_y);
+        line_y += 25;
+        dc.DrawText(wxString::Format("Shmem: %.2f GiB", in_gib(snapshot_->ram_shmem)), info_x, line_y);
+        line_y += 25;
+        dc.DrawText(wxString::Format("Slab: %.2f GiB", in_gib(snapshot_->ram_slab)), info_x, line_y);
+        line_y += 25;
+        dc.DrawText(wxString::Format("Dirty / Writeback: %.1f / %.1f MiB", static_cast<double>(snapshot_->ram_dirty) / mib,
+                                     static_cast<double>(snapshot_->ram_writeback) / mib), info_x, line_y);
+        line_y += 25;
+        unsigned long long swap_used = snapshot_->swap_total > snapshot_->swap_free ? snapshot_->swap_total - snapshot_->swap_free : 0;
+        dc.DrawText(wxString::Format("Swap: %.2f / %.2f GiB", in_gib(swap_used), in_gib(snapshot_->swap_total)), info_x, line_y);
+        line_y += 25;
+        const auto& ram = snapshot_->ram_percentiles;
+        dc.DrawText(wxString::Format("p99 1m / 5m / 1h: %.0f / %.0f / %.0f%%", ram[0].p99, ram[1].p99, ram[2].p99), info_x, line_y);
+
+        // A node can run out while the total looks fine
+        if(snapshot_->node_memory.size() >= 2) {
+            for(const auto& node : snapshot_->node_memory) {
+                line_y += 25;
+                dc.DrawText(wxString::Format("Node %u: %.0f%% of %.1f GiB (file %.1f, anon %.1f), %.0f misses/s", node.id,
+                                             node.usage * 100.0, in_gib(node.total), in_gib(node.file_pages), in_gib(node.anon_pages),
+                                             node.miss_rate), info_x, line_y);
+            }
+        }
+    }
+
+    void CanvasRenderer::draw_drive_info(wxDC& dc, const Cards& card, int info_x, int info_y) {
+        ScopeTimer timing(instrumentation_, probe_draw_drive_info);
+
+        dc.SetFont(fonts_[font_heading]);
+        dc.SetTextForeground(*wxBLACK);
+
+        dc.DrawText("Drive informations:", info_x, info_y);
+
+        if(card.index >= snapshot_->mounts.size()) return;
+        unsigned long long total = snapshot_->mounts[card.index].total;
+        unsigned long long used = snapshot_->mounts[card.index].used;
+        unsigned long long free = snapshot_->mounts[card.index].free;
+
+        wxCoord line_y = info_y + 35;
+        dc.SetFont(fonts_[font_info]);
+
+        dc.DrawText(wxString::Format("Total memory: %.2f GiB", static_cast<double>(total) / (1024.0 * 1024 * 1024)), info_x, line_y);
+        line_y += 25;
+        dc.DrawText(wxString::Format("Free memory: %.2f GiB", static_cast<double>(used) / (1024.0 * 1024 * 1024)), info_x, line_y);
+        line_y += 25;
+        dc.DrawText(wxString::Format("Used memory: %.2f GiB", static_cast<double>(free) / (1024.0 * 1024 * 1024)), info_x, line_y);
+    }
+
+    // Stacked bar of the CPU time states of a row (0 aggregate, 1 + n core n)
+    // with the busy states above 0.1% listed below it
+    int CanvasRenderer::draw_state_bar(wxDC& dc, int x, int y, int width, size_t row) {
+        struct StateStyle { const char* label; unsigned char red, green, blue; };
+        static const StateStyle styles[CanvasSnapshot::n_cpu_states] = {
+            {"user", 33, 150, 243}, {"nice", 100, 181, 246}, {"sys", 244, 67, 54}, {"idle", 230, 230, 230},
+            {"iowait", 255, 152, 0}, {"irq", 156, 39, 176}, {"softirq", 186, 104, 200}, {"steal", 121, 85, 72},
+            {"guest", 0, 150, 136}, {"guest_nice", 77, 182, 172}};
+        constexpr size_t idle_state = 3;
+        const auto& states = snapshot_->cpu_states;
+        if(row >= states[0].size()) return y;
+
+        constexpr int bar_height = 14;
+        dc.SetPen(*wxTRANSPARENT_PEN);
+        double start = 0.0;
+        for(size_t state = 0; state < CanvasSnapshot::n_cpu_states; ++state) {
+            double share = states[state][row];
+            if(share <= 0.0) continue;
+            int left = x + static_cast<int>(width * start);
+            start = std::min(1.0, start + share);
+            int right = x + static_cast<int>(width * start);
+            if(right <= left) continue;
+            dc.SetBrush(wxBrush(wxColour(styles[state].red, styles[state].green, styles[state].blue)));
+            dc.DrawRectangle(left, y, right - left, bar_height);
+        }
+
+        wxString legend;
+        for(size_t state = 0; state < CanvasSnapshot::n_cpu_states; ++state) {
+            if(state == idle_state || states[state][row] < 0.001) continue;     // idle is the rest of the bar
+            legend += wxString::Format("%s %.1f  ", styles[state].label, states[state][row] * 100.0);
+        }
+        dc.SetFont(fonts_[font_info]);
+        dc.SetTextForeground(*wxBLACK);
+        dc.DrawText(legend.empty() ? wxString("idle") : legend, x, y + bar_height + 4);
+        return y + bar_height + 30;
+    }
+
+    void CanvasRenderer::draw_cpu_info(wxDC& dc, const Cards& card, int info_x, int info_y) {
+        ScopeTimer timing(instrumentation_, probe_draw_cpu_info);
+
+        dc.SetFont(fonts_[font_heading]);
+        dc.SetTextForeground(*wxBLACK);
+
+        dc.DrawText("CPU informations:", info_x, info_y);
+        int line_y = draw_state_bar(dc, info_x, info_y + 35, card.rect.width - 60, 0);
+
+        const auto& cpu = snapshot_->cpu_percentiles;
+        dc.SetFont(fonts_[font_info]);
+        dc.DrawText(wxString::Format("p50 1m / 5m / 1h: %.0f / %.0f / %.0f%%", cpu[0].p50, cpu[1].p50, cpu[2].p50), info_x, line_y);
+        line_y += 25;
+        dc.DrawText(wxString::Format("p99 1m / 5m / 1h: %.0f / %.0f / %.0f%%", cpu[0].p99, cpu[1].p99, cpu[2].p99), info_x, line_y);
+        line_y += 25;
+        dc.DrawText(wxString::Format("Max 1h: %.0f%%", cpu[2].max), info_x, line_y);
+        line_y += 35;
+
+        // Identity, read once at startup
+        for(const std::string* text : {&snapshot_->cpu_caches, &snapshot_->cpu_features, &snapshot_->cpu_revision}) {
+            if(text->empty()) continue;
+            dc.DrawText(wxString::FromUTF8(text->c_str()), info_x, line_y);
+            line_y += 25;
+        }
+
+        // Imbalance between sockets or NUMA nodes, when there are several
+        auto draw_groups = [&](const char* label, const std::vector<double>& usages) {
+            if(usages.size() < 2) return;
+            wxString text = label;
+            for(size_t i = 0; i < usages.size(); ++i)
+                text += wxString::Format(i == 0 ? " %zu: %.0f%%" : ",  %zu: %.0f%%", i, usages[i] * 100.0);
+            dc.DrawText(text, info_x, line_y);
+            line_y += 25;
+        };
+        draw_groups("Sockets", snapshot_->socket_usages);
+        draw_groups("NUMA nodes", snapshot_->node_usages);
+
+        if(!snapshot_->hottest_sensor.empty()) {
+            const wxString degrees = wxString::FromUTF8("\xC2\xB0" "C");
+            dc.DrawText(wxString::Format("Temperature: %.0f", snapshot_->cpu_temperature) + degrees
+                        + wxString::Format("  (hottest: %s %.0f", snapshot_->hottest_sensor.c_str(), snapshot_->hottest_temperature)
+                        + degrees + ")", info_x, line_y);
+            line_y += 25;
+        }
+
+        dc.DrawText(wxString::Format("Context switches: %.0f/s  Interrupts: %.0f/s", snapshot_->context_switch_rate,
+                                     snapshot_->interrupt_rate), info_x, line_y);
+        line_y += 25;
+        dc.DrawText(wxString::Format("Forks: %.0f/s  Running: %lu  Blocked: %lu", snapshot_->fork_rate,
+                                     snapshot_->procs_running, snapshot_->procs_blocked), info_x, line_y);
+        line_y += 25;
+        if(!snapshot_->core_sched_latencies.empty()) {
+            // waiting > 0 before usage reaches 100% means more runnable tasks than cores
+            dc.DrawText(wxString::Format("Run queue: %.0f us wait per timeslice, %.2f tasks waiting, running %.1f%%",
+                                         snapshot_->sched_latency, snapshot_->sched_waiting, snapshot_->sched_running * 100.0),
+                        info_x, line_y);
+            line_y += 25;
+        }
+        if(!snapshot_->net_rx_rates.empty()) {
+            double total = std::accumulate(snapshot_->net_rx_rates.begin(), snapshot_->net_rx_rates.end(), 0.0);
+            dc.DrawText(wxString::Format("NET_RX: %.0f/s, core %u at %.1fx the mean", total, snapshot_->net_rx_busiest,
+                                         snapshot_->net_rx_imbalance), info_x, line_y);
+            line_y += 25;
+        }
+        line_y += 10;
+
+        if(snapshot_->burst_mode) {
+            const auto& burst = snapshot_->cpu_burst;
+            dc.SetFont(fonts_[font_info]);
+            dc.DrawText(wxString::Format("Burst (%.1f ms): min %.0f%%  p99 %.0f%%  max %.0f%%", snapshot_->burst_interval_ms,
+                                         burst.min * 100.0, burst.p99 * 100.0, burst.max * 100.0), info_x, line_y);
+            line_y += 25;
+            dc.DrawText(wxString::Format("Burst sampler: %.2f%% of a core", snapshot_->burst_overhead * 100.0), info_x, line_y);
+            line_y += 35;
+        }
+
+        dc.SetFont(fonts_[font_subheading]);
+        dc.DrawText("Busiest services:", info_x, line_y);
+        line_y += 25;
+
+        dc.SetFont(fonts_[font_info]);
+        if(snapshot_->services.empty()) {
+            dc.DrawText("No cgroup v2 hierarchy found.", info_x, line_y);
+            return;
+        }
+        for(const auto& service : snapshot_->services) {
+            dc.DrawText(wxString::Format("%.1f%%  %.0f MiB  ", service.cpu * 100.0, static_cast<double>(service.memory) / (1024.0 * 1024))
+                        + wxString::FromUTF8(service.name), info_x, line_y);
+            line_y += 25;
+        }
+    }
+
+    void CanvasRenderer::draw_core_info(wxDC& dc, const Cards& card, int info_x, int info_y) {
+        ScopeTimer timing(instrumentation_, probe_draw_core_info);
+
+        dc.SetFont(fonts_[font_heading]);
+        dc.SetTextForeground(*wxBLACK);
+
+        dc.DrawText(wxString::Format("Core %u:", snapshot_->cpu_id(card.index)), info_x, info_y);
+        int line_y = draw_state_bar(dc, info_x, info_y + 35, card.rect.width - 60, card.index + 1);
+
+        dc.SetFont(fonts_[font_info]);
+        dc.DrawText(wxString::Format("Usage: %.1f%%", card.usage * 100.0), info_x, line_y);
+        line_y += 25;
+        dc.DrawText(wxString::Format("Share of total: %.1f%%", snapshot_->cpu_usage > 0.0 && !snapshot_->core_usages.empty()
+                                     ? card.usage / (snapshot_->cpu_usage * static_cast<double>(snapshot_->core_usages.size())) * 100.0 : 0.0),
+                    info_x, line_y);
+
+        if(card.index < snapshot_->core_percentiles.size()) {
+            const auto& percentiles = snapshot_->core_percentiles[card.index];
+            line_y += 25;
+            dc.DrawText(wxString::Format("5m p50 / p99: %.0f / %.0f%%", percentiles.p50, percentiles.p99), info_x, line_y);
+        }
+
+        if(uint32_t id = snapshot_->cpu_id(card.index); id < snapshot_->net_rx_rates.size()) {
+            line_y += 25;
+            dc.DrawText(wxString::Format("NET_RX: %.0f/s", snapshot_->net_rx_rates[id]), info_x, line_y);
+        }
+
+        if(card.index < snapshot_->core_sched_latencies.size()) {
+            line_y += 25;
+            dc.DrawText(wxString::Format("Run queue wait: %.0f us", snapshot_->core_sched_latencies[card.index]), info_x, line_y);
+        }
+
+        if(snapshot_->burst_mode && card.index < snapshot_->core_bursts.size()) {
+            const auto& burst = snapshot_->core_bursts[card.index];
+            line_y += 25;
+            dc.DrawText(wxString::Format("Burst p99: %.0f%%", burst.p99 * 100.0), info_x, line_y);
+            line_y += 25;
+            dc.DrawText(wxString::Format("Burst max: %.0f%%", burst.max * 100.0), info_x, line_y);
+        }
+    }
+
+    void CanvasRenderer::draw_system_infos(wxDC& dc, int info_x, int info_y) {
+        ScopeTimer timing(instrumentation_, probe_draw_system_infos);
+
+        dc.SetFont(fonts_[font_heading]);
+        dc.SetTextForeground(*wxBLACK);
+
+        dc.DrawText("General informations:", info_x, info_y);
+
+        unsigned int core_num = snapshot_->cpu_cores;
+        wxString model_name = snapshot_->cpu_model;
+        wxString product_name = snapshot_->product_name;
+        wxString kde_version = snapshot_->os_version;
+        wxString kernel_version = snapshot_->kernel_version;
+
+        unsigned long uptime = snapshot_->uptime;
+        unsigned long procs_num = snapshot_->procs_num;
+
+        int line_y = info_y + 40;
+
+        dc.SetFont(fonts_[font_info]);
+
+        wxString cpus = wxString::Format("Processors: %u x " + model_name, core_num);
+        if(snapshot_->cpu_physical_cores != 0)
+            cpus += wxString::Format(" (%u sockets, %u cores, %u NUMA nodes)", snapshot_->cpu_sockets,
+                                     snapshot_->cpu_physical_cores, snapshot_->numa_nodes);
+        wxString product_text = wxString::Format("Productname: " + product_name);
+        wxString os_version_text = wxString::Format("KDE-Plasma-Version: " + kde_version);;
+        wxString kernel_text = wxString::Format("Kernel-Version: " + kernel_version);
+        wxString uptime_text = wxString::Format("System uptime since boot (seconds): %llu", uptime);
+        wxString procs_text = wxString::Format("Number of processes running: %llu", procs_num);
+        if(snapshot_->runnable_tasks != 0)
+            procs_text = wxString::Format("Tasks: %lu (%lu runnable), load %.2f / %.2f / %.2f", procs_num, snapshot_->runnable_tasks,
+                                          snapshot_->load_averages[0], snapshot_->load_averages[1], snapshot_->load_averages[2]);
+        dc.SetFont(fonts_[font_subheading]);
+        dc.DrawText("Hardware:", info_x , line_y);
+        dc.SetFont(fonts_[font_info]);
+        line_y += spacing;
+        dc.DrawText(cpus, info_x, line_y);
+        line_y += spacing;
+        dc.DrawText(product_text, info_x, line_y);
+        line_y += spacing + 2;
+        dc.SetFont(fonts_[font_subheading]);
+        dc.DrawText("Software:", info_x, line_y);
+        dc.SetFont(fonts_[font_info]);
+        line_y += spacing;
+        dc.DrawText(os_version_text, info_x, line_y);
+        line_y += spacing;
+        dc.DrawText(kernel_text, info_x, line_y);
+        line_y += spacing + 2;
+        dc.SetFont(fonts_[font_subheading]);
+        dc.DrawText("Other:", info_x, line_y);
+        dc.SetFont(fonts_[font_info]);
+        line_y += spacing;
+        dc.DrawText(uptime_text, info_x, line_y);
+        line_y += spacing;
+        dc.DrawText(procs_text, info_x, line_y);
+    }
+
+    void CanvasRenderer::draw_network_infos(wxDC& dc, int info_x, int info_y, int width) {
+        ScopeTimer timing(instrumentation_, probe_draw_network_infos);
+
+        dc.SetFont(fonts_[font_heading]);
+        dc.SetTextForeground(*wxBLACK);
+
+        double download_rate = snapshot_->download_rate;
+
+        wxString dowload_text = wxString::Format("Download: %.1f KiB/s", download_rate);
+        wxString upload_text = wxString::Format("Upload: under construction");
+
+        dc.DrawText("Network informations:", info_x, info_y);
+        dc.SetFont(fonts_[font_subheading]);
+
+        int line_y = info_y + 40;
+
+        dc.DrawText(dowload_text, info_x, line_y);
+        dc.DrawText(upload_text, info_x + 10 * spacing, line_y);
+        line_y += spacing;
+
+        const auto& download = snapshot_->download_percentiles;
+        const auto& upload = snapshot_->upload_percentiles;
+        dc.SetFont(fonts_[font_info]);
+        dc.DrawText(wxString::Format("p99 5m / 1h: down %.1f / %.1f KiB/s, up %.1f / %.1f KiB/s",
+                                     download[1].p99 / 1024.0, download[2].p99 / 1024.0, upload[1].p99 / 1024.0, upload[2].p99 / 1024.0),
+                    info_x, line_y);
+        line_y += spacing;
+
+        // Network Graph
+        int graph_x = info_x;
+        int graph_y = line_y;
+        int graph_width = width - 2 * spacing;
+        int graph_height = 200;
+        draw_network_graph(dc, graph_x, graph_y, graph_width, graph_height);
+    }
+
+    void CanvasRenderer::draw_network_graph(wxDC& dc, int x, int y, int w, int h){
+        ScopeTimer timing(instrumentation_, probe_draw_network_graph);
+        // Background square
+        dc.SetPen(wxPen(wxColour(50, 50, 60)));
+        dc.SetBrush(wxBrush(wxColour(35, 35, 45)));
+        dc.DrawRectangle(x, y, w, h);
+
+        // Lines
+        dc.SetPen(wxPen(wxColour(60, 60, 80)));
+        for(int i = 1; i < 5; ++i){
+            int yline = y + h * i / 5;
+            dc.DrawLine(x, yline, x + w, yline);
+        }
+
+        double max_val = 0.0;
+        size_t points = snapshot_->network_graph_full ? network_history_length : snapshot_->network_graph_index;
+        for(size_t i = 0; i < points; ++i) {
+            max_val = std::max({max_val, snapshot_->download_history[i], snapshot_->upload_history[i]});
+        }
+        if(max_val < 1e-6) max_val = 1.0;
+
+        // Download Line (green)
+        dc.SetPen(wxPen(wxColour(80, 220, 60), 2));
+        for(size_t i = 1; i < points; ++i) {
+            int idx0 = (snapshot_->network_graph_index + i - 1) % network_history_length;
+            int idx1 = (snapshot_->network_graph_index + i) % network_history_length;
+            int x0 = x + (w * (i - 1)) / (network_history_length - 1);
+            int x1 = x + (w * i) / (network_history_length - 1);
+            int y0 = y + h - int(h * std::min(snapshot_->download_history[idx0] /max_val, 1.0));
+            int y1 = y + h - int(h * std::min(snapshot_->download_history[idx1] /max_val, 1.0));
+            dc.DrawLine(x0, y0, x1, y1);
+        }
+
+        dc.SetTextForeground(*wxWHITE);
+        dc.DrawText(wxString::Format("%.1f MiB/s", max_val), x, y);
+    }
+    } // namespace system_monitor
@@ -0,0 +1,151 @@
+#ifndef CANVAS_RENDERER_HPP
+#define CANVAS_RENDERER_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <wx/wx.h>
+#include "canvas_snapshot.hpp"
+#include "core_heatmap.hpp"
+#include "instrumentation.hpp"
+#include "layout_table.hpp"
+#include <unordered_map>
+
+namespace system_monitor {
+
+    // Draws the monitor onto any wxDC (window, wxMemoryDC, ...) from a snapshot
+    class CanvasRenderer {
+        public:
+            // Instrumented scopes, see probe_names()
+            enum Probe : size_t {
+                probe_timer, probe_render, probe_paint_jitter,
+                probe_draw_card, probe_draw_info_section, probe_draw_usage_circle, probe_draw_network_graph,
+                probe_draw_title, probe_draw_percentage_text, probe_draw_show_more_text,
+                probe_draw_ram_info, probe_draw_drive_info, probe_draw_cpu_info, probe_draw_core_info,
+                probe_draw_system_infos, probe_draw_network_infos, probe_draw_fleet_tile, probe_draw_heatmap,
+                n_probes
+            };
+            static std::vector<std::string> probe_names();
+
+            explicit CanvasRenderer(Instrumentation& instrumentation);
+
+            // Renders a client area of the given size, returns the height needed to show everything.
+            // Only cards intersecting the viewport (unscrolled coordinates) are laid out and drawn.
+            int render(wxDC& dc, const wxSize& size, const wxRect& viewport, const CanvasSnapshot& snapshot);
+            int render(wxDC& dc, const wxSize& size, const CanvasSnapshot& snapshot);
+
+            // Offscreen rendering onto a white bitmap
+            wxBitmap render_to_bitmap(const wxSize& size, const CanvasSnapshot& snapshot);
+
+            // Click and hover handling, looked up in the layout table of the last render()
+            bool toggle_show_more(int x, int y);        // toggles the card whose button contains (x, y)
+            bool update_hover(int x, int y);            // true if the hovered element changed
+            bool hovering() const { return hovered_card_ != no_card; }
+            void expand_all(bool expanded);
+
+            // Fleet grid host whose tile contains (x, y), CanvasSnapshot::no_fleet_host if none
+            size_t fleet_host_at(int x, int y) const;
+
+            int draw_timings_overlay(wxDC& dc, int x, int y);      // bottom of the box
+            void draw_overhead_overlay(wxDC& dc, int x, int y, const CanvasSnapshot& snapshot);
+
+            // Appends a column of core usages to the heatmap, with every CPU
+            // sample whether the heatmap is shown or not
+            void push_heatmap(const std::vector<double>& core_usages) { heatmap_.push(core_usages); }
+            // Drops the heatmap history, e.g. when another host is shown
+            void clear_heatmap() { heatmap_ = CoreHeatmap(); }
+
+            // Firing alerts in the top right corner of the visible area
+            void draw_alerts_overlay(wxDC& dc, int view_x, int view_y, int view_width, const CanvasSnapshot& snapshot);
+
+        private:
+            // Kind of metric a card shows, selects its descriptor
+            enum class CardKind { ram, drive, cpu, core, n_kinds };
+
+            struct Cards {
+                CardKind kind = CardKind::ram;
+                size_t index = 0;           // core or mount index
+                wxString label;
+                wxRect rect;
+                bool expanded = false;
+                double usage = 0.0;
+            };
+
+            struct CardDescriptor {
+                unsigned char red, green, blue;
+                double (*usage)(const CanvasSnapshot& snapshot, size_t index);
+                void (CanvasRenderer::*draw_info)(wxDC& dc, const Cards& card, int info_x, int info_y);
+            };
+            static const CardDescriptor card_descriptors[];
+
+            static constexpr int n_cards = 3;               // number of cards in the first row (RAM, Drive, CPU)
+            static constexpr int spacing = 30;              // spacing between n_cards
+            static constexpr int detail_card_width = 220;   // minimum width of per-core/per-mount cards
+            static constexpr size_t no_card = static_cast<size_t>(-1);
+            static constexpr size_t text_extent_cache_limit = 4096;
+            static constexpr int fleet_tile_width = 190;
+            static constexpr int fleet_tile_height = 74;
+            static constexpr int fleet_tile_spacing = 12;
+
+            // Actions of the entries in layout_
+            enum Action : int { action_toggle_card = 1, action_select_host = 2 };
+
+            // Fonts are created once, text extents are cached per font
+            enum FontSlot : size_t { font_heading, font_percent, font_subheading, font_info, font_timings, n_fonts };
+
+            struct TextHash {
+                size_t operator()(const wxString& text) const;
+            };
+            static constexpr int title_font_size = 14;
+            static constexpr int percent_font_size = 18;
+            static constexpr int network_history_length = static_cast<int>(CanvasSnapshot::network_history_length);
+
+            Instrumentation& instrumentation_;
+            std::vector<Cards> cards_;                      // first row, then mounts and cores
+            LayoutTable layout_;                            // interactive elements of the last render()
+            size_t hovered_card_ = no_card;
+
+            wxFont fonts_[n_fonts];
+            std::unordered_map<wxString, wxSize, TextHash> text_extents_[n_fonts];
+            std::vector<std::string> mount_paths_;          // mounts the detail cards were created for
+            std::vector<uint32_t> core_ids_;                // cpu ids the core cards were labelled with
+            const CanvasSnapshot* snapshot_ = nullptr;      // valid during render()
+
+            CoreHeatmap heatmap_;
+
+            // Layout of the detail grid, rebuilt only when it changes
+            std::vector<int> detail_row_top_;
+            int detail_columns_ = 0;
+            int layout_width_ = -1;
+            int layout_height_ = -1;
+            bool layout_dirty_ = true;
+
+            void sync_cards(const CanvasSnapshot& snapshot);
+            void update_detail_layout(int width, int base_cardHeight);
+            void lay_out_and_draw(wxDC& dc, const wxRect& viewport, size_t card, int x, int y, int w, int base_cardHeight);
+            int draw_heatmap(wxDC& dc, const wxRect& viewport, int y, int width, int height);     // returns its bottom
+            int render_fleet(wxDC& dc, int width, const wxRect& viewport, const CanvasSnapshot& snapshot);
+
+            // Extent of text in the font of slot, which has to be selected into dc
+            wxSize text_extent(wxDC& dc, FontSlot slot, const wxString& text);
+
+            wxRect draw_card(wxDC& dc, Cards& card, int base_cardHeight, bool hovered);
+            void draw_info_section(wxDC& dc, int x, int y, int w, int h, bool is_general);
+            void draw_usage_circle(wxDC& dc, int center_x, int center_y, int radius, double usage, const wxColour& color, const wxString& usage_text);
+            void draw_network_graph(wxDC& dc, int x, int y, int w, int h);
+            void draw_title(wxDC&, int x, int y, const wxString& label, int box_width);
+            void draw_percentage_text(wxDC& dc, int center_x, int center_y, const wxString& usage_text);
+            wxRect draw_show_more_text(wxDC& dc, int center_x, int y, bool expanded, bool hovered);
+
+            void draw_ram_info(wxDC& dc, const Cards& card, int info_x, int info_y);
+            void draw_drive_info(wxDC& dc, const Cards& card, int info_x, int info_y);
+            void draw_cpu_info(wxDC& dc, const Cards& card, int info_x, int info_y);
+            void draw_core_info(wxDC& dc, const Cards& card, int info_x, int info_y);
+            void draw_system_infos(wxDC& dc, int info_x, int info_y);
+            void draw_network_infos(wxDC& dc, int info_x, int info_y, int width);
+            int draw_state_bar(wxDC& dc, int x, int y, int width, size_t row);     // returns the y below it
+            void draw_fleet_tile(wxDC& dc, const CanvasSnapshot::FleetHost& host, int x, int y, bool selected);
+    };
+}
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef CANVAS_SNAPSHOT_HPP
+#define CANVAS_SNAPSHOT_HPP
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace system_monitor {
+
+    // Everything the canvas draws, sampled once per tick so that rendering
+    // never touches the system itself
+    struct CanvasSnapshot {
+        static constexpr size_t network_history_length = 60;
+
+        struct Mount {
+            std::string path;
+            double usage = 0.0;
+            unsigned long long total = 0;
+            unsigned long long used = 0;
+            unsigned long long free = 0;
+        };
+
+        // Cards
+        double ram_usage = 0.0;
+        double cpu_usage = 0.0;
+
+        unsigned long long ram_total = 0;
+        unsigned long long ram_used = 0;       // total - available
+        unsigned long long ram_free = 0;
+
+        // RAM breakdown of the expanded card (bytes)
+        unsigned long long ram_available = 0;
+        unsigned long long ram_buffers = 0;
+        unsigned long long ram_cached = 0;
+        unsigned long long ram_shmem = 0;
+        unsigned long long ram_slab = 0;
+        unsigned long long ram_dirty = 0;
+        unsigned long long ram_writeback = 0;
+
+        // Memory per NUMA node, drawn with two or more nodes; misses are
+        // pages per second that had to be allocated on another node
+        struct NodeMemory {
+            unsigned id = 0;
+            double usage = 0.0;
+            unsigned long long total = 0;
+            unsigned long long free = 0;
+            unsigned long long file_pages = 0;
+            unsigned long long anon_pages = 0;
+            double miss_rate = 0.0;
+        };
+        std::vector<NodeMemory> node_memory;
+        unsigned long long swap_total = 0;
+        unsigned long long swap_free = 0;
+
+        std::vector<double> core_usages;
+        std::vector<uint32_t> cpu_ids;  // cpuN of every core_usages entry, empty for 0..n-1
+        std::vector<Mount> mounts;      // "/" first
+
+        // CPU time states (user, nice, system, idle, iowait, irq, softirq,
+        // steal, guest, guest_nice) as shares of the last interval, struct of
+        // arrays: cpu_states[s][0] is the aggregate, cpu_states[s][1 + n] core n.
+        // Empty when the source does not report them (remote hosts).
+        static constexpr size_t n_cpu_states = 10;
+        std::array<std::vector<double>, n_cpu_states> cpu_states;
+
+        // Kernel activity of the expanded CPU card, per second; running and
+        // blocked are task counts
+        double context_switch_rate = 0.0;
+        double interrupt_rate = 0.0;
+        double fork_rate = 0.0;
+        unsigned long procs_running = 0;
+        unsigned long procs_blocked = 0;
+
+        // NET_RX softirqs per second and core, and the busiest core's rate
+        // over the mean of the cores (1 when even); empty/0 when unknown
+        std::vector<double> net_rx_rates;       // per second, indexed by CPU id
+        double net_rx_imbalance = 0.0;
+        uint32_t net_rx_busiest = 0;            // CPU id
+
+        // Load averages and runnable tasks; mean run-queue wait before a
+        // timeslice in microseconds over all cores and per core (empty
+        // without schedstats), tasks kept waiting on average and the mean
+        // share of time the cores ran tasks
+        std::array<double, 3> load_averages{};
+        unsigned long runnable_tasks = 0;
+        double sched_latency = 0.0;
+        double sched_waiting = 0.0;
+        double sched_running = 0.0;
+        std::vector<double> core_sched_latencies;
+
+        // Mean usage per socket and NUMA node, empty without topology
+        std::vector<double> socket_usages;
+        std::vector<double> node_usages;
+
+        // Hottest CPU sensor and hottest sensor overall in degrees Celsius,
+        // empty name without temperature sensors
+        double cpu_temperature = 0.0;
+        std::string hottest_sensor;
+        double hottest_temperature = 0.0;
+
+        // Heatmap of the core usages (Ctrl+M) in place of the core cards;
+        // its columns are pushed to the renderer with every CPU sample
+        bool heatmap_view = false;
+
+        // cgroups of the expanded CPU card, busiest first
+        static constexpr size_t services_shown = 5;
+        struct Service {
+            std::string name;
+            double cpu = 0.0;               // cores
+            unsigned long long memory = 0;  // bytes
+        };
+        std::vector<Service> services;
+
+        // Burst mode: min/max/p99 of the CPU usages sampled every few ms in the last window
+        struct BurstWindow {
+            double min = 0.0;
+            double max = 0.0;
+            double p99 = 0.0;
+        };
+        bool burst_mode = false;
+        BurstWindow cpu_burst;
+        std::vector<BurstWindow> core_bursts;
+        double burst_interval_ms = 0.0;
+        double burst_overhead = 0.0;        // share of one core
+
+        // Percentiles over the last 1 m, 5 m and 1 h from the metric sketches,
+        // usages in percent and rates in bytes/s
+        static constexpr size_t n_windows = 3;
+        struct Percentiles {
+            double p50 = 0.0;
+            double p90 = 0.0;
+            double p99 = 0.0;
+            double max = 0.0;
+        };
+        std::array<Percentiles, n_windows> cpu_percentiles{};
+        std::array<Percentiles, n_windows> ram_percentiles{};
+        std::array<Percentiles, n_windows> download_percentiles{};
+        std::array<Percentiles, n_windows> upload_percentiles{};
+        std::vector<Percentiles> core_percentiles;      // last 5 m
+
+        // Cost of the monitor's sampler thread over its last window (Ctrl+O
+        // panel); CPU figures are shares of one core, rates per second
+        struct CollectorOverhead {
+            std::string name;
+            double cpu = 0.0;
+            double sample_us = 0.0;         // CPU time of one sample
+            double faults = 0.0;
+            double syscalls = 0.0;
+            long long period_ms = 0;        // stretched by the budget
+            unsigned stretch = 1;
+        };
+        std::vector<CollectorOverhead> overhead_collectors;
+        double overhead_cpu = 0.0;
+        double overhead_reads_cpu = 0.0;    // batched procfs reads
+        double overhead_reads_syscalls = 0.0;
+        double overhead_faults = 0.0;
+        double overhead_syscalls = 0.0;
+        double overhead_syscalls_per_tick = 0.0;
+        unsigned long long overhead_rss = 0;        // bytes, whole process
+        double overhead_budget = 0.0;               // 0 without budget
+
+        // Alert rules currently firing, as written in the rules file
+        std::vector<std::string> alerts;
+
+        // Fleet grid (Ctrl+G) of the hosts reporting to the aggregator,
+        // drawn instead of the cards; hosts in the order they connected
+        struct FleetHost {
+            std::string name;
+            bool connected = false;
+            double cpu_usage = 0.0;
+            double ram_usage = 0.0;
+        };
+        static constexpr size_t no_fleet_host = static_cast<size_t>(-1);
+        bool fleet_view = false;
+        std::vector<FleetHost> fleet;
+        size_t fleet_selected = no_fleet_host;      // host shown with Ctrl+H
+
+        // General (inventory is sampled once)
+        unsigned int cpu_cores = 0;
+        unsigned int cpu_physical_cores = 0;       // 0 when the topology is unknown
+        unsigned int cpu_sockets = 0;
+        unsigned int numa_nodes = 0;
+        std::string cpu_model;
+        std::string cpu_caches;                    // "L1d 48K  L1i 32K  L2 2M  L3 30M"
+        std::string cpu_features;                  // "AVX AVX2 FMA ..."
+        std::string cpu_revision;                  // "family 6 model 106 stepping 6, microcode 0xd0003a5"
+        std::string product_name;
+        std::string os_version;
+        std::string kernel_version;
+        unsigned long uptime = 0;
+        unsigned long procs_num = 0;
+
+        // Network (rates in bytes/s, history in KiB/s)
+        double download_rate = 0.0;
+        double upload_rate = 0.0;
+        std::vector<double> download_history = std::vector<double>(network_history_length, 0.0);
+        std::vector<double> upload_history = std::vector<double>(network_history_length, 0.0);
+        size_t network_graph_index = 0;
+        bool network_graph_full = false;
+
+        // CPU id of a core card, the N of cpuN in /proc/stat and the metric names
+        uint32_t cpu_id(size_t core) const { return core < cpu_ids.size() ? cpu_ids[core] : static_cast<uint32_t>(core); }
+
+        void update_network_history(double download, double upload) {
+            download_history[network_graph_index] = download;
+            upload_history[network_graph_index] = upload;
+            network_graph_index++;
+            if(network_graph_index >= network_history_length) {
+                network_graph_index = 0;
+                network_graph_full = true;
+            }
+        }
+    };
+}
+
+#endif
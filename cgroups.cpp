@@ -0,0 +1,312 @@
+#include "cgroups.hpp"
+#include "procfs_parse.hpp"
+#include "syscall_count.hpp"
+#include <algorithm>
+#include <charconv>
+#include <unordered_map>
+#include <utility>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace system_monitor {
+
+    namespace {
+        const char* const stat_files[] = {"cpu.stat", "memory.current", "memory.stat", "io.stat", "cpu.pressure"};
+
+        constexpr uint32_t watch_events = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+        // Value of the "key value" line of a flat keyed file (cpu.stat, memory.stat)
+        unsigned long long keyed_value(std::string_view text, std::string_view key) {
+            size_t pos = 0;
+            while((pos = text.find(key, pos)) != std::string_view::npos) {
+                size_t end = pos + key.size();
+                if((pos == 0 || text[pos - 1] == '\n') && end < text.size() && text[end] == ' ')
+                    return parse_number(text.substr(end + 1));
+                pos = end;
+            }
+            return 0;
+        }
+
+        // Sum of a "name=value" field over the devices of io.stat
+        unsigned long long io_total(std::string_view text, std::string_view field) {
+            unsigned long long total = 0;
+            size_t pos = 0;
+            while((pos = text.find(field, pos)) != std::string_view::npos) {
+                pos += field.size();
+                total += parse_number(text.substr(pos));
+            }
+            return total;
+        }
+
+        // "some avg10=1.23 ..." of a pressure file
+        double pressure_avg10(std::string_view text) {
+            constexpr std::string_view key = "some avg10=";
+            if(text.compare(0, key.size(), key) != 0) return 0.0;
+            double value = 0.0;
+            std::from_chars(text.data() + key.size(), text.data() + text.size(), value);
+            return value;
+        }
+
+        bool is_service(std::string_view name) {
+            auto ends_with = [&](std::string_view suffix) {
+                return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+            };
+            return ends_with(".service") || ends_with(".scope");
+        }
+
+        // Every group keeps a directory and up to five files open
+        void raise_file_limit() {
+            struct rlimit limit;
+            if(getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur >= limit.rlim_max) return;
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+
+    std::string Cgroups::find_root() {
+        ProcfsFile mounts("/proc/mounts");
+        std::string_view table = mounts.read();
+        std::string_view line;
+        while(next_line(table, line)) {
+            FieldScanner fields(line);
+            std::string_view device, mount_point, type;
+            if(fields.next(device) && fields.next(mount_point) && fields.next(type) && type == "cgroup2")
+                return std::string(mount_point);
+        }
+        return "";
+    }
+
+    Cgroups::Cgroups() : Cgroups(find_root()) {}
+
+    Cgroups::Cgroups(std::string root) : root_(std::move(root)) {
+        raise_file_limit();
+        inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    }
+
+    Cgroups::~Cgroups() {
+        for(Node& node : nodes_)
+            close_node(node);
+        if(inotify_ >= 0) close(inotify_);
+    }
+
+    void Cgroups::attach(ProcfsReader& reader) {
+        for(Node& node : nodes_)
+            close_node(node);
+        nodes_.clear();
+        last_.groups.clear();
+        reader_.attach(reader);
+        tree_changed_ = true;
+    }
+
+    void Cgroups::prefetch() {
+        reader_.prefetch();
+    }
+
+    void Cgroups::sample() {
+        if(root_.empty()) return;
+        if(poll_tree_changes()) rescan();
+        reader_.read();
+
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - last_time_).count();
+        last_time_ = now;
+
+        auto& groups = last_.groups;
+        for(size_t i = 0; i < groups.size(); ++i)
+            read_group(i, seconds);
+
+        // Counters are hierarchical, the own share is what the children do not account for
+        for(Group& group : groups)
+            group.cpu_self = group.cpu_usage;
+        for(const Group& group : groups) {
+            if(group.parent != no_parent)
+                groups[group.parent].cpu_self -= group.cpu_usage;
+        }
+        for(Group& group : groups)
+            group.cpu_self = std::max(group.cpu_self, 0.0);
+    }
+
+    void Cgroups::read_group(size_t index, double seconds) {
+        Group& group = last_.groups[index];
+        Node& node = nodes_[index];
+
+        unsigned long long cpu_usec = group.cpu_usec;
+        unsigned long long io_read = group.io_read_bytes;
+        unsigned long long io_write = group.io_write_bytes;
+        unsigned long long user_usec = node.user_usec;
+        unsigned long long system_usec = node.system_usec;
+
+        std::string_view cpu = reader_.data(node.files[cpu_stat]);
+        group.cpu_usec = keyed_value(cpu, "usage_usec");
+        node.user_usec = keyed_value(cpu, "user_usec");
+        node.system_usec = keyed_value(cpu, "system_usec");
+
+        group.memory_current = parse_number(reader_.data(node.files[memory_current]));
+        std::string_view memory = reader_.data(node.files[memory_stat]);
+        group.memory_anon = keyed_value(memory, "anon");
+        group.memory_file = keyed_value(memory, "file");
+
+        std::string_view io = reader_.data(node.files[io_stat]);
+        group.io_read_bytes = io_total(io, "rbytes=");
+        group.io_write_bytes = io_total(io, "wbytes=");
+
+        group.cpu_pressure = pressure_avg10(reader_.data(node.files[cpu_pressure]));
+
+        if(!node.primed || seconds <= 0.0) {
+            node.primed = true;
+            return;
+        }
+        auto rate = [seconds](unsigned long long now, unsigned long long before) {
+            return now > before ? static_cast<double>(now - before) / seconds : 0.0;
+        };
+        group.cpu_usage = rate(group.cpu_usec, cpu_usec) / 1e6;
+        group.cpu_user = rate(node.user_usec, user_usec) / 1e6;
+        group.cpu_system = rate(node.system_usec, system_usec) / 1e6;
+        group.io_read_rate = rate(group.io_read_bytes, io_read);
+        group.io_write_rate = rate(group.io_write_bytes, io_write);
+    }
+
+    // True when groups were created or removed since the last call
+    bool Cgroups::poll_tree_changes() {
+        ++samples_;
+        bool changed = std::exchange(tree_changed_, false);
+
+        if(inotify_ >= 0) {
+            alignas(inotify_event) char buffer[4096];
+            ssize_t n;
+            while((n = read(inotify_, buffer, sizeof(buffer))) > 0) {
+                count_syscalls();
+                for(ssize_t offset = 0; offset < n;) {
+                    const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                    if(event->mask & (IN_ISDIR | IN_Q_OVERFLOW)) changed = true;
+                    offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                }
+            }
+            count_syscalls();          // the read that found the queue empty
+        }
+        if(!watches_complete_ && samples_ % unwatched_rescan_interval == 0)
+            changed = true;
+        return changed;
+    }
+
+    // Walks the hierarchy; groups still present keep their descriptors and counters
+    void Cgroups::rescan() {
+        std::vector<Group> old_groups = std::move(last_.groups);
+        std::vector<Node> old_nodes = std::move(nodes_);
+        std::unordered_map<std::string_view, size_t> previous;
+        previous.reserve(old_groups.size());
+        for(size_t i = 0; i < old_groups.size(); ++i)
+            previous.emplace(old_groups[i].path, i);
+
+        last_.groups.clear();
+        nodes_.clear();
+        watches_complete_ = inotify_ >= 0;
+
+        // Iterative preorder walk, children are pushed in reverse to keep the order
+        struct Pending {
+            std::string path;
+            uint32_t parent;
+            uint16_t depth;
+            int parent_dirfd;
+        };
+        std::vector<Pending> pending{{"", no_parent, 0, AT_FDCWD}};
+        std::vector<uint32_t> open_subtrees;
+
+        while(!pending.empty() && last_.groups.size() < max_groups) {
+            Pending entry = std::move(pending.back());
+            pending.pop_back();
+
+            std::string full_path = entry.path.empty() ? root_ : root_ + "/" + entry.path;
+            const char* name = entry.parent == no_parent ? full_path.c_str()
+                             : entry.path.c_str() + (entry.path.rfind('/') == std::string::npos ? 0 : entry.path.rfind('/') + 1);
+            struct stat st;
+            count_syscalls();
+            if(fstatat(entry.parent_dirfd, name, &st, 0) != 0 || !S_ISDIR(st.st_mode)) continue;
+
+            Node node;
+            Group group;
+            auto old = previous.find(entry.path);
+            if(old != previous.end() && old_nodes[old->second].inode == static_cast<unsigned long>(st.st_ino)) {
+                node = std::exchange(old_nodes[old->second], Node{});
+                group = old_groups[old->second];        // copy, the map still points at the old paths
+            } else {
+                node.inode = static_cast<unsigned long>(st.st_ino);
+                node.dirfd = openat(entry.parent_dirfd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+                count_syscalls();
+                if(node.dirfd < 0) continue;
+                for(int i = 0; i < n_stats; ++i)
+                    node.files[i] = reader_.open(stat_files[i], node.dirfd);
+                if(inotify_ >= 0) {
+                    node.watch = inotify_add_watch(inotify_, full_path.c_str(), watch_events);
+                    count_syscalls();
+                }
+                group.path = entry.path;
+                size_t slash = entry.path.rfind('/');
+                group.service = is_service(slash == std::string::npos ? std::string_view(entry.path)
+                                                                      : std::string_view(entry.path).substr(slash + 1));
+            }
+            if(node.watch < 0) watches_complete_ = false;       // e.g. max_user_watches reached
+            group.parent = entry.parent;
+            group.depth = entry.depth;
+            group.descendants = 0;
+
+            // Ancestors on the path get this group counted in their subtree
+            while(!open_subtrees.empty() && last_.groups[open_subtrees.back()].depth >= entry.depth)
+                open_subtrees.pop_back();
+            for(uint32_t ancestor : open_subtrees)
+                ++last_.groups[ancestor].descendants;
+
+            auto index = static_cast<uint32_t>(last_.groups.size());
+            int dirfd = node.dirfd;
+            last_.groups.push_back(std::move(group));
+            nodes_.push_back(node);
+            open_subtrees.push_back(index);
+
+            // Child directories
+            int listing = dup(dirfd);
+            count_syscalls();
+            DIR* dir = listing >= 0 ? fdopendir(listing) : nullptr;
+            if(!dir) {
+                if(listing >= 0) close(listing);
+                continue;
+            }
+            rewinddir(dir);
+            count_syscalls(4);         // lseek, two getdents, close
+            size_t first_child = pending.size();
+            while(dirent* child = readdir(dir)) {
+                if(child->d_type != DT_DIR || child->d_name[0] == '.') continue;
+                std::string path = entry.path.empty() ? std::string(child->d_name) : entry.path + "/" + child->d_name;
+                pending.push_back({std::move(path), index, static_cast<uint16_t>(entry.depth + 1), dirfd});
+            }
+            closedir(dir);
+            std::sort(pending.begin() + static_cast<ptrdiff_t>(first_child), pending.end(),
+                      [](const Pending& a, const Pending& b) { return a.path > b.path; });
+        }
+
+        for(Node& node : old_nodes)
+            close_node(node);
+        ++last_.rescans;
+    }
+
+    void Cgroups::close_node(Node& node) {
+        for(int& file : node.files) {
+            reader_.close(file);
+            file = -1;
+        }
+        if(node.watch >= 0 && inotify_ >= 0) {
+            inotify_rm_watch(inotify_, node.watch);
+            count_syscalls();
+        }
+        if(node.dirfd >= 0) {
+            close(node.dirfd);
+            count_syscalls();
+        }
+        node.watch = -1;
+        node.dirfd = -1;
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef CGROUPS_HPP
+#define CGROUPS_HPP
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "procfs_reader.hpp"
+
+namespace system_monitor {
+
+    class Cgroups {         // cgroup v2 hierarchy, CPU/memory/IO per group
+        public:
+            static constexpr std::chrono::milliseconds period{1000};
+            static constexpr const char* name = "cgroups";
+            static constexpr size_t max_groups = 4096;
+            static constexpr uint32_t no_parent = ~uint32_t(0);
+
+            struct Group {
+                std::string path;                   // relative to the cgroup root, "" for the root
+                uint32_t parent = no_parent;
+                uint32_t descendants = 0;           // size of the subtree below
+                uint16_t depth = 0;
+                bool service = false;               // *.service or *.scope (units and containers)
+
+                // Counters, hierarchical like in the kernel
+                unsigned long long cpu_usec = 0;
+                unsigned long long memory_current = 0;      // bytes
+                unsigned long long memory_anon = 0;
+                unsigned long long memory_file = 0;
+                unsigned long long io_read_bytes = 0;
+                unsigned long long io_write_bytes = 0;
+
+                // Rates since the previous sample
+                double cpu_usage = 0.0;             // in cores, subtree included
+                double cpu_user = 0.0;
+                double cpu_system = 0.0;
+                double cpu_self = 0.0;              // without the child groups
+                double io_read_rate = 0.0;          // bytes/s
+                double io_write_rate = 0.0;
+                double cpu_pressure = 0.0;          // "some" avg10, percent
+            };
+
+            struct Sample {
+                std::vector<Group> groups;          // preorder, root first
+                size_t rescans = 0;
+            };
+
+            Cgroups();                              // root from /proc/mounts
+            explicit Cgroups(std::string root);
+            ~Cgroups();
+
+            Cgroups(const Cgroups&) = delete;
+            Cgroups& operator=(const Cgroups&) = delete;
+
+            void sample();
+            const Sample& last() const { return last_; }
+
+            void attach(ProcfsReader& reader);
+            void prefetch();
+
+            const std::string& root() const { return root_; }
+
+            // Mount point of the cgroup2 filesystem, empty if there is none
+            static std::string find_root();
+
+        private:
+            enum Stat { cpu_stat, memory_current, memory_stat, io_stat, cpu_pressure, n_stats };
+
+            static constexpr size_t unwatched_rescan_interval = 10;     // samples, without inotify
+
+            // Descriptors of a group, kept across samples and rescans
+            struct Node {
+                int dirfd = -1;
+                int watch = -1;
+                unsigned long inode = 0;
+                int files[n_stats] = {-1, -1, -1, -1, -1};
+                unsigned long long user_usec = 0;
+                unsigned long long system_usec = 0;
+                bool primed = false;                // counters read once, rates are valid
+            };
+
+            std::string root_;
+            Sample last_;
+            std::vector<Node> nodes_;           // parallel to last_.groups
+
+            ProcfsFileSet reader_;
+
+            int inotify_ = -1;                  // directory creations and removals
+            bool watches_complete_ = false;     // every directory is watched
+            bool tree_changed_ = true;
+            size_t samples_ = 0;
+            std::chrono::steady_clock::time_point last_time_{};
+
+            bool poll_tree_changes();
+            void rescan();
+            void close_node(Node& node);
+            void read_group(size_t index, double seconds);
+    };
+}
+
+#endif
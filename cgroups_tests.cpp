@@ -0,0 +1,136 @@
+#include "catch_amalgamated.hpp"
+#include "cgroups.hpp"
+#include "temp_tree_tests.hpp"
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+    // cgroup-like tree of regular files in a temporary directory
+    struct FakeHierarchy : system_monitor::testing::TempTree {
+        FakeHierarchy() : TempTree("cgroups_test") {}
+
+        void group(const std::string& path, unsigned long long usage_usec, unsigned long long memory, unsigned long long rbytes) {
+            auto dir = path.empty() ? root : root / path;
+            std::filesystem::create_directories(dir);
+            std::ofstream(dir / "cpu.stat") << "usage_usec " << usage_usec << "\nuser_usec " << usage_usec / 2
+                                            << "\nsystem_usec " << usage_usec / 2 << "\nnr_periods 0\n";
+            std::ofstream(dir / "memory.current") << memory << "\n";
+            std::ofstream(dir / "memory.stat") << "anon " << memory / 2 << "\nfile " << memory / 4 << "\nkernel 0\n";
+            std::ofstream(dir / "io.stat") << "8:0 rbytes=" << rbytes << " wbytes=10 rios=1 wios=1 dbytes=0 dios=0\n"
+                                           << "8:16 rbytes=" << rbytes << " wbytes=20 rios=1 wios=1 dbytes=0 dios=0\n";
+            std::ofstream(dir / "cpu.pressure") << "some avg10=1.50 avg60=0.00 avg300=0.00 total=0\n"
+                                                << "full avg10=0.00 avg60=0.00 avg300=0.00 total=0\n";
+        }
+    };
+
+    const system_monitor::Cgroups::Group* find(const system_monitor::Cgroups::Sample& sample, const std::string& path) {
+        for(const auto& group : sample.groups) {
+            if(group.path == path) return &group;
+        }
+        return nullptr;
+    }
+}
+
+// Cgroups Tests
+// preorder tree with subtree sizes and the counters of every group
+TEST_CASE("Cgroups scan and read", "[cgroups]") {
+    FakeHierarchy tree;
+    tree.group("", 1000, 0, 0);
+    tree.group("system.slice", 600, 1 << 20, 100);
+    tree.group("system.slice/a.service", 400, 1 << 19, 50);
+    tree.group("system.slice/b.service", 100, 1 << 18, 25);
+    tree.group("user.slice", 300, 1 << 20, 0);
+
+    system_monitor::Cgroups cgroups(tree.root.string());
+    cgroups.sample();
+    const auto& sample = cgroups.last();
+
+    REQUIRE(sample.groups.size() == 5);
+    CHECK(sample.groups[0].path.empty());
+    CHECK(sample.groups[0].descendants == 4);
+    CHECK(sample.groups[1].path == "system.slice");
+    CHECK(sample.groups[1].descendants == 2);
+    CHECK(sample.groups[2].path == "system.slice/a.service");
+    CHECK(sample.groups[2].parent == 1);
+    CHECK(sample.groups[2].depth == 2);
+    CHECK(sample.groups[2].service);
+    CHECK(!sample.groups[1].service);
+    CHECK(sample.groups[4].path == "user.slice");
+
+    const auto* a = find(sample, "system.slice/a.service");
+    REQUIRE(a != nullptr);
+    CHECK(a->cpu_usec == 400);
+    CHECK(a->memory_current == 1 << 19);
+    CHECK(a->memory_anon == 1 << 18);
+    CHECK(a->memory_file == 1 << 17);
+    CHECK(a->io_read_bytes == 100);
+    CHECK(a->io_write_bytes == 30);
+    CHECK(a->cpu_pressure == Catch::Approx(1.5));
+    CHECK(a->cpu_usage == 0.0);         // no rate on the first sample
+}
+
+// CPU rates from the deltas, own share without the children
+TEST_CASE("Cgroups rates", "[cgroups]") {
+    FakeHierarchy tree;
+    tree.group("", 0, 0, 0);
+    tree.group("parent", 0, 0, 0);
+    tree.group("parent/child", 0, 0, 0);
+
+    system_monitor::Cgroups cgroups(tree.root.string());
+    cgroups.sample();
+
+    tree.group("", 4000000, 0, 0);
+    tree.group("parent", 3000000, 0, 0);
+    tree.group("parent/child", 1000000, 0, 0);
+    cgroups.sample();
+
+    const auto& groups = cgroups.last().groups;
+    REQUIRE(groups.size() == 3);
+    CHECK(groups[1].cpu_usage > 0.0);
+    CHECK(groups[1].cpu_usage == Catch::Approx(3.0 * groups[2].cpu_usage));
+    CHECK(groups[1].cpu_self == Catch::Approx(2.0 * groups[2].cpu_usage));
+    CHECK(groups[0].cpu_self == Catch::Approx(groups[2].cpu_usage));
+    CHECK(groups[2].cpu_self == Catch::Approx(groups[2].cpu_usage));
+    CHECK(groups[1].cpu_user == Catch::Approx(groups[1].cpu_usage / 2));
+}
+
+// groups are added and removed on tree changes only, the others keep their counters
+TEST_CASE("Cgroups rescan", "[cgroups]") {
+    FakeHierarchy tree;
+    tree.group("", 0, 0, 0);
+    tree.group("a", 0, 0, 0);
+    tree.group("b", 0, 0, 0);
+
+    system_monitor::Cgroups cgroups(tree.root.string());
+    cgroups.sample();
+    cgroups.sample();
+    size_t rescans = cgroups.last().rescans;
+    CHECK(rescans == 1);
+
+    tree.group("c", 0, 0, 0);
+    std::filesystem::remove_all(tree.root / "a");
+    tree.group("b", 2000000, 0, 0);
+    cgroups.sample();
+
+    const auto& sample = cgroups.last();
+    CHECK(sample.rescans == rescans + 1);
+    REQUIRE(sample.groups.size() == 3);
+    CHECK(sample.groups[0].descendants == 2);
+    CHECK(find(sample, "a") == nullptr);
+    REQUIRE(find(sample, "b") != nullptr);
+    REQUIRE(find(sample, "c") != nullptr);
+    CHECK(find(sample, "b")->cpu_usage > 0.0);      // counters survived the rescan
+    CHECK(find(sample, "c")->cpu_usage == 0.0);
+}
+
+TEST_CASE("Cgroups system hierarchy", "[cgroups]") {
+    system_monitor::Cgroups cgroups;
+    cgroups.sample();
+    if(cgroups.root().empty()) {
+        CHECK(cgroups.last().groups.empty());      // no cgroup2 mount
+        return;
+    }
+    REQUIRE(!cgroups.last().groups.empty());
+    CHECK(cgroups.last().groups[0].descendants == cgroups.last().groups.size() - 1);
+}
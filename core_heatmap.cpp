@@ -0,0 +1,128 @@
+#include "core_heatmap.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <wx/rawbmp.h>
+
+namespace system_monitor {
+
+    namespace {
+        constexpr size_t pixel_size = wxNativePixelFormat::SizePixel;
+
+        std::array<std::array<unsigned char, 3>, 256> make_palette() {
+            // Piecewise linear through blue, cyan, green, yellow and red
+            constexpr double stops[5][3] = {{30, 60, 160}, {0, 170, 210}, {60, 190, 70}, {250, 210, 40}, {220, 40, 30}};
+            std::array<std::array<unsigned char, 3>, 256> palette{};
+            for(size_t level = 0; level < 256; ++level) {
+                double position = static_cast<double>(level) / 255.0 * 4.0;
+                size_t stop = std::min<size_t>(3, static_cast<size_t>(position));
+                double t = position - static_cast<double>(stop);
+                for(size_t channel = 0; channel < 3; ++channel) {
+                    double value = stops[stop][channel] + (stops[stop + 1][channel] - stops[stop][channel]) * t;
+                    palette[level][channel] = static_cast<unsigned char>(std::lround(value));
+                }
+            }
+            return palette;
+        }
+    }
+
+    const std::array<unsigned char, 3>& CoreHeatmap::colour(uint8_t level) {
+        static const auto palette = make_palette();
+        return palette[level];
+    }
+
+    void CoreHeatmap::push(const std::vector<double>& usages) {
+        if(usages.empty()) return;
+        if(usages.size() != cores_) {
+            cores_ = usages.size();
+            levels_.assign(history_length * cores_, 0);
+            next_ = 0;
+            size_ = 0;
+            width_ = 0;         // rebuild the image on the next draw
+        }
+        uint8_t* column = levels_.data() + next_ * cores_;
+        for(size_t core = 0; core < cores_; ++core)
+            column[core] = static_cast<uint8_t>(std::lround(std::clamp(usages[core], 0.0, 1.0) * 255.0));
+        next_ = (next_ + 1) % history_length;
+        size_ = std::min(size_ + 1, history_length);
+        ++pending_;
+    }
+
+    int CoreHeatmap::height_for(size_t cores, int budget) {
+        if(cores == 0) return 0;
+        int row_height = std::clamp(budget / static_cast<int>(cores), 1, max_row_height);
+        return row_height * static_cast<int>(cores);
+    }
+
+    void CoreHeatmap::draw(wxDC& dc, int x, int y, int width, int height) {
+        if(cores_ == 0 || width <= 0 || height <= 0) return;
+        if(width != width_ || height != height_ || !bitmap_.IsOk() || pending_ >= static_cast<size_t>(columns_))
+            rebuild(width, height);
+        else if(pending_ > 0)
+            shift_in(pending_);
+        pending_ = 0;
+        dc.DrawBitmap(bitmap_, x, y);
+    }
+
+    // Whole image from the ring, for a new size or core count
+    void CoreHeatmap::rebuild(int width, int height) {
+        width_ = width;
+        height_ = height;
+        row_height_ = std::clamp(height / static_cast<int>(cores_), 1, max_row_height);
+        column_width_ = std::clamp(width / static_cast<int>(history_length), 1, max_column_width);
+        columns_ = std::min(static_cast<int>(history_length), width / column_width_);
+        bitmap_ = wxBitmap(columns_ * column_width_, row_height_ * static_cast<int>(cores_), 24);
+        pending_ = 0;
+
+        wxNativePixelData data(bitmap_);
+        if(!data) return;
+        unsigned char* pixels = data.GetPixels().m_ptr;
+        int stride = data.GetRowStride();
+        size_t columns = static_cast<size_t>(columns_);
+        for(size_t column = 0; column < columns; ++column) {
+            // Rightmost column is the newest sample, columns before the history are blank
+            size_t age = columns - 1 - column;
+            size_t index = age < size_ ? (next_ + history_length - 1 - age) % history_length : history_length;
+            write_column(pixels, stride, static_cast<int>(column), index);
+        }
+    }
+
+    // Moves the image left by `columns` and writes the newest columns on the right
+    void CoreHeatmap::shift_in(size_t columns) {
+        wxNativePixelData data(bitmap_);
+        if(!data) return;
+        unsigned char* pixels = data.GetPixels().m_ptr;
+        int stride = data.GetRowStride();
+
+        size_t row_bytes = static_cast<size_t>(columns_ * column_width_) * pixel_size;
+        size_t shift = columns * static_cast<size_t>(column_width_) * pixel_size;
+        int rows = row_height_ * static_cast<int>(cores_);
+        for(int row = 0; row < rows; ++row) {
+            unsigned char* line = pixels + static_cast<ptrdiff_t>(row) * stride;
+            std::memmove(line, line + shift, row_bytes - shift);
+        }
+        for(size_t age = 0; age < columns; ++age) {
+            size_t index = (next_ + history_length - 1 - age) % history_length;
+            write_column(pixels, stride, columns_ - 1 - static_cast<int>(age), index);
+        }
+    }
+
+    // One sample column; history_index == history_length draws an empty column
+    void CoreHeatmap::write_column(unsigned char* pixels, int stride, int column, size_t history_index) {
+        static const std::array<unsigned char, 3> blank = {235, 235, 235};
+        const uint8_t* levels = history_index < history_length ? levels_.data() + history_index * cores_ : nullptr;
+        for(size_t core = 0; core < cores_; ++core) {
+            const auto& rgb = levels ? colour(levels[core]) : blank;
+            for(int dy = 0; dy < row_height_; ++dy) {
+                int row = static_cast<int>(core) * row_height_ + dy;
+                unsigned char* pixel = pixels + static_cast<ptrdiff_t>(row) * stride
+                                     + static_cast<ptrdiff_t>(column * column_width_) * static_cast<ptrdiff_t>(pixel_size);
+                for(int dx = 0; dx < column_width_; ++dx, pixel += pixel_size) {
+                    pixel[wxNativePixelFormat::RED] = rgb[0];
+                    pixel[wxNativePixelFormat::GREEN] = rgb[1];
+                    pixel[wxNativePixelFormat::BLUE] = rgb[2];
+                }
+            }
+        }
+    }
+}
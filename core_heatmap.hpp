@@ -0,0 +1,58 @@
+#ifndef CORE_HEATMAP_HPP
+#define CORE_HEATMAP_HPP
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <wx/wx.h>
+
+namespace system_monitor {
+
+    // Per-core usage over time as an image: one row per core, one column per
+    // sample, newest on the right. A new sample shifts the pixels left by
+    // one column and writes the new column through wxNativePixelData, so
+    // drawing is a single DrawBitmap whatever the number of cores. The
+    // usages are also kept in a ring of bytes to rebuild the image when
+    // the area it is drawn into changes size.
+    class CoreHeatmap {
+        public:
+            static constexpr size_t history_length = 600;         // columns, 5 min at the 500 ms frame rate
+            static constexpr int max_row_height = 12;
+            static constexpr int max_column_width = 4;
+
+            // Appends a column of usages (0..1); another core count restarts the history
+            void push(const std::vector<double>& usages);
+
+            // Height the image needs for a given width and height budget
+            static int height_for(size_t cores, int budget);
+
+            // Draws the image at (x, y), sized for width × height
+            void draw(wxDC& dc, int x, int y, int width, int height);
+
+            size_t cores() const { return cores_; }
+            size_t size() const { return size_; }
+
+            // Colour of a usage level (0..255): blue, green, yellow, red
+            static const std::array<unsigned char, 3>& colour(uint8_t level);
+
+        private:
+            std::vector<uint8_t> levels_;       // history_length columns of cores_ levels
+            size_t cores_ = 0;
+            size_t next_ = 0;                   // column written by the next push()
+            size_t size_ = 0;
+            size_t pending_ = 0;                // columns pushed since the image was updated
+
+            wxBitmap bitmap_;
+            int width_ = 0;                     // size the image was built for
+            int height_ = 0;
+            int columns_ = 0;                   // columns shown
+            int column_width_ = 1;
+            int row_height_ = 1;
+
+            void rebuild(int width, int height);
+            void shift_in(size_t columns);
+            void write_column(unsigned char* pixels, int stride, int column, size_t history_index);
+    };
+}
+
+#endif
@@ -0,0 +1,171 @@
+#include "cpu_identity.hpp"
+#include "cpu_topology.hpp"
+#include "procfs_parse.hpp"
+#include "sysfs.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <fstream>
+
+namespace system_monitor {
+
+    namespace {
+        struct FeatureNames {
+            const char* name;
+            const char* label;
+        };
+        constexpr FeatureNames feature_names[] = {
+            {"sse4_2", "SSE4.2"}, {"avx", "AVX"}, {"avx2", "AVX2"}, {"fma", "FMA"}, {"bmi2", "BMI2"},
+            {"avx512f", "AVX-512F"}, {"avx512bw", "AVX-512BW"}, {"avx512vl", "AVX-512VL"},
+            {"avx512_vnni", "AVX-512 VNNI"}, {"avx512_bf16", "AVX-512 BF16"}, {"amx_tile", "AMX"},
+            {"aes", "AES"}, {"vaes", "VAES"}, {"sha_ni", "SHA"}, {"rdrand", "RDRAND"}, {"ht", "HT"},
+            {"hypervisor", "VM"}, {"asimd", "NEON"}, {"sve", "SVE"}, {"sve2", "SVE2"}, {"sha2", "SHA2"}
+        };
+        static_assert(std::size(feature_names) == CpuIdentity::n_features);
+
+        std::string_view trim(std::string_view text) {
+            size_t start = text.find_first_not_of(" \t");
+            if(start == std::string_view::npos) return {};
+            size_t end = text.find_last_not_of(" \t");
+            return text.substr(start, end - start + 1);
+        }
+
+        unsigned number(std::string_view text) {
+            // decimal, or hexadecimal with 0x (ARM implementer and part)
+            unsigned long long value = 0;
+            if(text.starts_with("0x")) {
+                std::from_chars(text.data() + 2, text.data() + text.size(), value, 16);
+                return static_cast<unsigned>(value);
+            }
+            return static_cast<unsigned>(parse_number(text));
+        }
+
+        // Lines of the first processor block, up to the first empty line
+        std::string first_block(const std::string& path) {
+            std::ifstream file(path);
+            std::string block, line;
+            while(std::getline(file, line) && !line.empty()) {
+                block += line;
+                block += '\n';
+            }
+            return block;
+        }
+    }
+
+    const char* CpuIdentity::feature_name(Feature feature) {
+        return feature < n_features ? feature_names[feature].name : "";
+    }
+
+    const char* CpuIdentity::feature_label(Feature feature) {
+        return feature < n_features ? feature_names[feature].label : "";
+    }
+
+    unsigned long long CpuIdentity::parse_size(std::string_view size) {
+        unsigned long long value = 0;
+        const char* end = size.data() + size.size();
+        const char* unit = parse_number(size.data(), end, value);
+        if(unit == size.data()) return 0;
+        if(unit == end || *unit == '\n') return value;
+        switch(*unit) {
+            case 'K': return value << 10;
+            case 'M': return value << 20;
+            case 'G': return value << 30;
+            default: return 0;
+        }
+    }
+
+    CpuIdentity CpuIdentity::parse(std::string_view cpuinfo) {
+        CpuIdentity identity;
+        unsigned implementer = 0, part = 0;
+        bool arm = false;
+        std::string_view line;
+        while(next_line(cpuinfo, line)) {
+            if(trim(line).empty()) break;           // end of the first processor
+            size_t colon = line.find(':');
+            if(colon == std::string_view::npos) continue;
+            std::string_view key = trim(line.substr(0, colon));
+            std::string_view value = trim(line.substr(colon + 1));
+
+            if(key == "vendor_id") identity.vendor = value;
+            else if(key == "model name") identity.model_name = value;
+            else if(key == "cpu family") identity.family = number(value);
+            else if(key == "model") identity.model = number(value);
+            else if(key == "stepping" || key == "CPU revision") identity.stepping = number(value);
+            else if(key == "microcode") identity.microcode = value;
+            else if(key == "CPU implementer") { implementer = number(value); arm = true; }
+            else if(key == "CPU part") part = number(value);
+            else if(key == "CPU architecture") identity.family = number(value);
+            else if(key == "flags" || key == "Features") {
+                FieldScanner flags(value);
+                std::string_view flag;
+                while(flags.next(flag)) {
+                    for(size_t feature = 0; feature < n_features; ++feature) {
+                        if(flag == feature_names[feature].name) identity.features.set(feature);
+                    }
+                }
+            }
+        }
+
+        // ARM reports codes instead of names
+        if(arm) {
+            char code[16];
+            std::snprintf(code, sizeof(code), "0x%02x", implementer);
+            if(identity.vendor.empty()) identity.vendor = code;
+            identity.model = part;
+            if(identity.model_name.empty()) {
+                char name[48];
+                std::snprintf(name, sizeof(name), "ARM implementer 0x%02x part 0x%03x", implementer, part);
+                identity.model_name = name;
+            }
+        }
+        return identity;
+    }
+
+    CpuIdentity CpuIdentity::read(const std::string& cpuinfo, const std::string& cache_root) {
+        CpuIdentity identity = parse(first_block(cpuinfo));
+
+        for(uint32_t index : numbered_entries(cache_root, "index")) {
+            std::string dir = cache_root + "/index" + std::to_string(index) + "/";
+            Cache cache;
+            cache.level = static_cast<unsigned>(parse_number(read_line(dir + "level")));
+            cache.type = read_line(dir + "type");
+            cache.size = parse_size(read_line(dir + "size"));
+            cache.shared_cpus = static_cast<unsigned>(CpuTopology::parse_cpu_list(read_line(dir + "shared_cpu_list")).size());
+            if(cache.level != 0 && cache.size != 0) identity.caches.push_back(std::move(cache));
+        }
+        std::sort(identity.caches.begin(), identity.caches.end(), [](const Cache& a, const Cache& b) {
+            return a.level != b.level ? a.level < b.level : a.type < b.type;
+        });
+        return identity;
+    }
+
+    const CpuIdentity& CpuIdentity::system() {
+        static const CpuIdentity identity = read();
+        return identity;
+    }
+
+    std::string CpuIdentity::cache_summary() const {
+        std::string summary;
+        for(const Cache& cache : caches) {
+            char text[32];
+            const char* suffix = cache.type == "Data" ? "d" : cache.type == "Instruction" ? "i" : "";
+            if(cache.size >= (1ull << 20))
+                std::snprintf(text, sizeof(text), "L%u%s %gM", cache.level, suffix, static_cast<double>(cache.size) / (1 << 20));
+            else
+                std::snprintf(text, sizeof(text), "L%u%s %lluK", cache.level, suffix, cache.size >> 10);
+            if(!summary.empty()) summary += "  ";
+            summary += text;
+        }
+        return summary;
+    }
+
+    std::string CpuIdentity::feature_summary() const {
+        std::string summary;
+        for(size_t feature = 0; feature < n_features; ++feature) {
+            if(!features.test(feature)) continue;
+            if(!summary.empty()) summary += ' ';
+            summary += feature_names[feature].label;
+        }
+        return summary;
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef CPU_IDENTITY_HPP
+#define CPU_IDENTITY_HPP
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace system_monitor {
+
+    // What the processor is: model, revision, caches and instruction set
+    // extensions. Read once; only the first processor block of /proc/cpuinfo
+    // is parsed, the others repeat it on every machine we care about.
+    struct CpuIdentity {
+        // Extensions of interest, named as in the flags (x86) or Features (ARM) line
+        enum Feature : size_t {
+            sse4_2, avx, avx2, fma, bmi2, avx512f, avx512bw, avx512vl, avx512_vnni, avx512_bf16, amx_tile,
+            aes, vaes, sha_ni, rdrand, ht, hypervisor, asimd, sve, sve2, sha2, n_features
+        };
+        static const char* feature_name(Feature feature);           // "avx512f"
+        static const char* feature_label(Feature feature);          // "AVX-512F"
+
+        struct Cache {
+            unsigned level = 0;
+            std::string type;                   // "Data", "Instruction" or "Unified"
+            unsigned long long size = 0;        // bytes
+            unsigned shared_cpus = 0;           // logical CPUs sharing it, 0 if unknown
+        };
+
+        std::string vendor;                     // "GenuineIntel", "AuthenticAMD", ARM implementer code
+        std::string model_name;
+        unsigned family = 0;
+        unsigned model = 0;
+        unsigned stepping = 0;                  // CPU revision on ARM
+        std::string microcode;                  // "0x2b000461", empty if not reported
+        std::bitset<n_features> features;
+        std::vector<Cache> caches;              // of cpu0, by level then type
+
+        bool has(Feature feature) const { return features.test(feature); }
+
+        // "L1d 48K  L1i 32K  L2 1.25M  L3 30M", empty without cache information
+        std::string cache_summary() const;
+        // Labels of the present features, "AVX AVX2 FMA AVX-512F ..."
+        std::string feature_summary() const;
+
+        // From the first processor block of a cpuinfo file and the cache
+        // directories (index0, index1, ...) of one CPU
+        static CpuIdentity read(const std::string& cpuinfo = "/proc/cpuinfo",
+                                const std::string& cache_root = "/sys/devices/system/cpu/cpu0/cache");
+
+        // Identity of this machine, read on first use
+        static const CpuIdentity& system();
+
+        // Fills the cpuinfo fields from the first block of text
+        static CpuIdentity parse(std::string_view cpuinfo);
+
+        // "32K", "1024K", "30M" as bytes, 0 if malformed
+        static unsigned long long parse_size(std::string_view size);
+    };
+}
+
+#endif
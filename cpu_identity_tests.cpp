@@ -0,0 +1,120 @@
+#include "catch_amalgamated.hpp"
+#include "cpu_identity.hpp"
+#include "temp_tree_tests.hpp"
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+    using system_monitor::CpuIdentity;
+
+    const char* const x86_cpuinfo =
+        "processor\t: 0\n"
+        "vendor_id\t: GenuineIntel\n"
+        "cpu family\t: 6\n"
+        "model\t\t: 106\n"
+        "model name\t: Intel(R) Xeon(R) Gold 6338 CPU @ 2.00GHz\n"
+        "stepping\t: 6\n"
+        "microcode\t: 0xd0003a5\n"
+        "cpu MHz\t\t: 2000.000\n"
+        "flags\t\t: fpu vme de pse tsc msr ht sse4_1 sse4_2 aes avx avx2 fma bmi2 avx512f avx512bw avx512vl avx512_vnni sha_ni rdrand\n"
+        "bugs\t\t: spectre_v1 spectre_v2\n"
+        "\n"
+        "processor\t: 1\n"
+        "vendor_id\t: GenuineIntel\n"
+        "model name\t: not the first block\n"
+        "flags\t\t: hypervisor amx_tile\n"
+        "\n";
+
+    // cpuN/cache-like directory in a temporary directory
+    struct FakeCache : system_monitor::testing::TempTree {
+        FakeCache() : TempTree("identity_test") {
+            std::filesystem::create_directories(root / "cache");
+            std::ofstream(root / "cache" / "uevent");           // not an index
+        }
+
+        void index(unsigned id, unsigned level, const std::string& type, const std::string& size, const std::string& shared) {
+            auto dir = root / "cache" / ("index" + std::to_string(id));
+            std::filesystem::create_directories(dir);
+            std::ofstream(dir / "level") << level << "\n";
+            std::ofstream(dir / "type") << type << "\n";
+            std::ofstream(dir / "size") << size << "\n";
+            std::ofstream(dir / "shared_cpu_list") << shared << "\n";
+        }
+
+        void cpuinfo(const std::string& text) { std::ofstream(root / "cpuinfo") << text; }
+    };
+}
+
+// CpuIdentity Tests
+TEST_CASE("CpuIdentity parse x86", "[cpu_identity]") {
+    CpuIdentity identity = CpuIdentity::parse(x86_cpuinfo);
+    CHECK(identity.vendor == "GenuineIntel");
+    CHECK(identity.model_name == "Intel(R) Xeon(R) Gold 6338 CPU @ 2.00GHz");
+    CHECK(identity.family == 6);
+    CHECK(identity.model == 106);
+    CHECK(identity.stepping == 6);
+    CHECK(identity.microcode == "0xd0003a5");
+    CHECK(identity.has(CpuIdentity::avx2));
+    CHECK(identity.has(CpuIdentity::avx512f));
+    CHECK(identity.has(CpuIdentity::sha_ni));
+    CHECK_FALSE(identity.has(CpuIdentity::hypervisor));     // second block only
+    CHECK_FALSE(identity.has(CpuIdentity::amx_tile));
+    CHECK(identity.has(CpuIdentity::sse4_2));
+    CHECK(identity.feature_summary() == "SSE4.2 AVX AVX2 FMA BMI2 AVX-512F AVX-512BW AVX-512VL AVX-512 VNNI AES SHA RDRAND HT");
+    CHECK(std::string(CpuIdentity::feature_name(CpuIdentity::avx512_vnni)) == "avx512_vnni");
+}
+
+TEST_CASE("CpuIdentity parse ARM", "[cpu_identity]") {
+    CpuIdentity identity = CpuIdentity::parse(
+        "processor\t: 0\n"
+        "BogoMIPS\t: 243.75\n"
+        "Features\t: fp asimd evtstrm aes pmull sha1 sha2 crc32 atomics sve sve2\n"
+        "CPU implementer\t: 0x41\n"
+        "CPU architecture: 8\n"
+        "CPU variant\t: 0x1\n"
+        "CPU part\t: 0xd40\n"
+        "CPU revision\t: 1\n");
+    CHECK(identity.vendor == "0x41");
+    CHECK(identity.model_name == "ARM implementer 0x41 part 0xd40");
+    CHECK(identity.family == 8);
+    CHECK(identity.model == 0xd40);
+    CHECK(identity.stepping == 1);
+    CHECK(identity.microcode.empty());
+    CHECK(identity.feature_summary() == "AES NEON SVE SVE2 SHA2");
+}
+
+TEST_CASE("CpuIdentity caches", "[cpu_identity]") {
+    CHECK(CpuIdentity::parse_size("48K\n") == 48 * 1024);
+    CHECK(CpuIdentity::parse_size("30M") == 30ull << 20);
+    CHECK(CpuIdentity::parse_size("512") == 512);
+    CHECK(CpuIdentity::parse_size("") == 0);
+    CHECK(CpuIdentity::parse_size("4X") == 0);
+
+    FakeCache sysfs;
+    sysfs.cpuinfo(x86_cpuinfo);
+    sysfs.index(3, 3, "Unified", "49152K", "0-63");
+    sysfs.index(0, 1, "Data", "48K", "0,32");
+    sysfs.index(1, 1, "Instruction", "32K", "0,32");
+    sysfs.index(2, 2, "Unified", "1280K", "0,32");
+
+    CpuIdentity identity = CpuIdentity::read((sysfs.root / "cpuinfo").string(), (sysfs.root / "cache").string());
+    CHECK(identity.model == 106);
+    REQUIRE(identity.caches.size() == 4);
+    CHECK(identity.caches[0].type == "Data");
+    CHECK(identity.caches[0].shared_cpus == 2);
+    CHECK(identity.caches[3].size == 48ull << 20);
+    CHECK(identity.caches[3].shared_cpus == 64);
+    CHECK(identity.cache_summary() == "L1d 48K  L1i 32K  L2 1.25M  L3 48M");
+
+    CpuIdentity missing = CpuIdentity::read((sysfs.root / "missing").string(), (sysfs.root / "missing").string());
+    CHECK(missing.model_name.empty());
+    CHECK(missing.caches.empty());
+    CHECK(missing.cache_summary().empty());
+}
+
+TEST_CASE("CpuIdentity system", "[cpu_identity]") {
+    const CpuIdentity& identity = CpuIdentity::system();
+    CHECK(&identity == &CpuIdentity::system());         // read once
+    CHECK_FALSE(identity.model_name.empty());
+}
@@ -0,0 +1,85 @@
+#include "cpu_topology.hpp"
+#include "sysfs.hpp"
+#include <algorithm>
+#include <charconv>
+#include <map>
+
+namespace system_monitor {
+
+    std::vector<uint32_t> CpuTopology::parse_cpu_list(std::string_view list) {
+        std::vector<uint32_t> cpus;
+        const char* p = list.data();
+        const char* end = list.data() + list.size();
+        while(p < end && *p != '\n') {
+            uint32_t first = 0, last = 0;
+            auto parsed = std::from_chars(p, end, first);
+            if(parsed.ec != std::errc()) return {};
+            p = parsed.ptr;
+            last = first;
+            if(p < end && *p == '-') {
+                parsed = std::from_chars(p + 1, end, last);
+                if(parsed.ec != std::errc() || last < first) return {};
+                p = parsed.ptr;
+            }
+            for(uint32_t cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+            if(p < end && *p == ',') ++p;
+        }
+        return cpus;
+    }
+
+    CpuTopology CpuTopology::read(const std::string& root) {
+        CpuTopology topology;
+        std::vector<uint32_t> ids = numbered_entries(root + "/cpu", "cpu");
+        if(ids.empty()) return topology;
+
+        size_t size = ids.back() + 1;
+        topology.core_of.assign(size, unknown);
+        topology.socket_of.assign(size, unknown);
+        topology.node_of.assign(size, unknown);
+        topology.cpus = static_cast<uint32_t>(ids.size());
+
+        // A physical core is identified by its first SMT sibling, a socket by its package id
+        std::map<uint32_t, uint32_t> packages;
+        for(uint32_t cpu : ids) {
+            std::string dir = root + "/cpu/cpu" + std::to_string(cpu) + "/topology/";
+            std::vector<uint32_t> siblings = parse_cpu_list(read_line(dir + "thread_siblings_list"));
+            uint32_t first = siblings.empty() ? cpu : std::min(cpu, siblings.front());
+            if(first < size && topology.core_of[first] != unknown)
+                topology.core_of[cpu] = topology.core_of[first];
+            else
+                topology.core_of[cpu] = topology.cores++;
+
+            std::string package = read_line(dir + "physical_package_id");
+            uint32_t package_id = 0;
+            std::from_chars(package.data(), package.data() + package.size(), package_id);
+            auto [it, added] = packages.try_emplace(package_id, topology.sockets);
+            if(added) ++topology.sockets;
+            topology.socket_of[cpu] = it->second;
+        }
+
+        for(uint32_t node : numbered_entries(root + "/node", "node")) {
+            std::vector<uint32_t> cpus = parse_cpu_list(read_line(root + "/node/node" + std::to_string(node) + "/cpulist"));
+            bool used = false;
+            for(uint32_t cpu : cpus) {
+                if(cpu >= size || topology.core_of[cpu] == unknown) continue;
+                topology.node_of[cpu] = topology.nodes;
+                used = true;
+            }
+            topology.nodes += used;         // memory-only nodes get no group
+        }
+        bool unplaced = false;
+        for(uint32_t cpu : ids) unplaced = unplaced || topology.node_of[cpu] == unknown;
+        if(unplaced) {
+            uint32_t fallback = topology.nodes == 0 ? topology.nodes++ : 0;
+            for(uint32_t cpu : ids) {
+                if(topology.node_of[cpu] == unknown) topology.node_of[cpu] = fallback;
+            }
+        }
+        return topology;
+    }
+
+    const CpuTopology& CpuTopology::system() {
+        static const CpuTopology topology = read();
+        return topology;
+    }
+}
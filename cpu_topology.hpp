@@ -0,0 +1,39 @@
+#ifndef CPU_TOPOLOGY_HPP
+#define CPU_TOPOLOGY_HPP
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace system_monitor {
+
+    // Placement of the logical CPUs: physical cores (SMT siblings), sockets
+    // and NUMA nodes. Cores and sockets are numbered densely in the order of
+    // their first CPU, nodes in the order of their ids; the maps are indexed
+    // by CPU id, the N of cpuN.
+    struct CpuTopology {
+        static constexpr uint32_t unknown = ~uint32_t(0);
+
+        std::vector<uint32_t> core_of;          // physical core of every CPU id, unknown for absent ids
+        std::vector<uint32_t> socket_of;
+        std::vector<uint32_t> node_of;
+        uint32_t cpus = 0;                      // logical CPUs present
+        uint32_t cores = 0;
+        uint32_t sockets = 0;
+        uint32_t nodes = 0;
+
+        bool empty() const { return cpus == 0; }
+
+        // From cpu/cpuN/topology and node/nodeN/cpulist below root. Without
+        // node directories (no NUMA support) every CPU is in node 0.
+        static CpuTopology read(const std::string& root = "/sys/devices/system");
+
+        // Topology of this machine, read on first use
+        static const CpuTopology& system();
+
+        // CPU ids of a list such as "0-3,8-11", empty if malformed
+        static std::vector<uint32_t> parse_cpu_list(std::string_view list);
+    };
+}
+
+#endif
@@ -0,0 +1,92 @@
+#include "catch_amalgamated.hpp"
+#include "cpu_topology.hpp"
+#include "temp_tree_tests.hpp"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+    using system_monitor::CpuTopology;
+
+    // sysfs-like tree of cpuN/topology and nodeN directories in a temporary directory
+    struct FakeSysfs : system_monitor::testing::TempTree {
+        FakeSysfs() : TempTree("topology_test") {
+            std::filesystem::create_directories(root / "cpu" / "cpufreq");      // not a CPU
+        }
+
+        void cpu(unsigned id, unsigned package, const std::string& siblings) {
+            auto dir = root / "cpu" / ("cpu" + std::to_string(id)) / "topology";
+            std::filesystem::create_directories(dir);
+            std::ofstream(dir / "physical_package_id") << package << "\n";
+            std::ofstream(dir / "thread_siblings_list") << siblings << "\n";
+        }
+
+        void node(unsigned id, const std::string& cpulist) {
+            auto dir = root / "node" / ("node" + std::to_string(id));
+            std::filesystem::create_directories(dir);
+            std::ofstream(dir / "cpulist") << cpulist << "\n";
+        }
+    };
+}
+
+// CpuTopology Tests
+TEST_CASE("CpuTopology parse_cpu_list", "[cpu_topology]") {
+    CHECK(CpuTopology::parse_cpu_list("0-3,8-9,12\n") == std::vector<uint32_t>{0, 1, 2, 3, 8, 9, 12});
+    CHECK(CpuTopology::parse_cpu_list("5") == std::vector<uint32_t>{5});
+    CHECK(CpuTopology::parse_cpu_list("").empty());
+    CHECK(CpuTopology::parse_cpu_list("3-1").empty());
+    CHECK(CpuTopology::parse_cpu_list("x").empty());
+}
+
+// dual socket, two SMT threads per core, one node per socket; cpu ids
+// interleave the siblings like most x86 servers (cpu0 and cpu4 share a core)
+TEST_CASE("CpuTopology read", "[cpu_topology]") {
+    FakeSysfs sysfs;
+    sysfs.cpu(0, 0, "0,4");
+    sysfs.cpu(1, 0, "1,5");
+    sysfs.cpu(2, 1, "2,6");
+    sysfs.cpu(3, 1, "3,7");
+    sysfs.cpu(4, 0, "0,4");
+    sysfs.cpu(5, 0, "1,5");
+    sysfs.cpu(6, 1, "2,6");
+    sysfs.cpu(7, 1, "3,7");
+    sysfs.node(0, "0-1,4-5");
+    sysfs.node(1, "2-3,6-7");
+    sysfs.node(2, "");              // memory only
+
+    CpuTopology topology = CpuTopology::read(sysfs.root.string());
+    CHECK(topology.cpus == 8);
+    CHECK(topology.cores == 4);
+    CHECK(topology.sockets == 2);
+    CHECK(topology.nodes == 2);
+    CHECK(topology.core_of == std::vector<uint32_t>{0, 1, 2, 3, 0, 1, 2, 3});
+    CHECK(topology.socket_of == std::vector<uint32_t>{0, 0, 1, 1, 0, 0, 1, 1});
+    CHECK(topology.node_of == std::vector<uint32_t>{0, 0, 1, 1, 0, 0, 1, 1});
+}
+
+// gaps in the ids, no node directories
+TEST_CASE("CpuTopology without NUMA", "[cpu_topology]") {
+    FakeSysfs sysfs;
+    sysfs.cpu(0, 0, "0");
+    sysfs.cpu(2, 0, "2");
+
+    CpuTopology topology = CpuTopology::read(sysfs.root.string());
+    CHECK(topology.cpus == 2);
+    CHECK(topology.cores == 2);
+    CHECK(topology.nodes == 1);
+    REQUIRE(topology.core_of.size() == 3);
+    CHECK(topology.core_of[1] == CpuTopology::unknown);
+    CHECK(topology.node_of[2] == 0);
+
+    CHECK(CpuTopology::read((sysfs.root / "missing").string()).empty());
+}
+
+TEST_CASE("CpuTopology system", "[cpu_topology]") {
+    const CpuTopology& topology = CpuTopology::system();
+    CHECK(topology.cpus >= 1);
+    CHECK(topology.cores >= 1);
+    CHECK(topology.cores <= topology.cpus);
+    CHECK(topology.sockets >= 1);
+    CHECK(topology.nodes >= 1);
+}
@@ -0,0 +1,64 @@
+#include "instrumentation.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace system_monitor {
+
+    // Values below 32 get their own bucket, above that the 6 most significant
+    // bits select the bucket
+    size_t LatencyHistogram::bucket_index(uint64_t value) {
+        return Buckets::index(value);
+    }
+
+    uint64_t LatencyHistogram::bucket_value(size_t index) {
+        return Buckets::value(index);
+    }
+
+    uint64_t LatencyHistogram::percentile(double p) const {
+        if(count_ == 0) return 0;
+        if(p >= 100.0) return max_;
+
+        auto rank = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(count_)));
+        if(rank == 0) rank = 1;
+
+        uint64_t seen = 0;
+        for(size_t i = 0; i < n_buckets; ++i) {
+            seen += counts_[i];
+            if(seen >= rank)
+                return std::min(bucket_value(i), max_);
+        }
+        return max_;
+    }
+
+    void LatencyHistogram::reset() {
+        counts_.fill(0);
+        count_ = 0;
+        max_ = 0;
+    }
+
+
+    Instrumentation::Instrumentation(std::vector<std::string> names)
+        : names_(std::move(names)), histograms_(names_.size()) {}
+
+    void Instrumentation::reset() {
+        for(auto& histogram : histograms_)
+            histogram.reset();
+    }
+
+    // { "render": { "count": 10, "p50_ns": 1234, "p99_ns": 2345, "max_ns": 3456 }, ... }
+    void Instrumentation::write_json(std::ostream& out) const {
+        out << "{\n";
+        for(size_t i = 0; i < names_.size(); ++i) {
+            const auto& h = histograms_[i];
+            out << "  \"" << names_[i] << "\": { "
+                << "\"count\": " << h.count() << ", "
+                << "\"p50_ns\": " << h.percentile(50.0) << ", "
+                << "\"p90_ns\": " << h.percentile(90.0) << ", "
+                << "\"p99_ns\": " << h.percentile(99.0) << ", "
+                << "\"max_ns\": " << h.max() << " }"
+                << (i + 1 < names_.size() ? ",\n" : "\n");
+        }
+        out << "}\n";
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef INSTRUMENTATION_HPP
+#define INSTRUMENTATION_HPP
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace system_monitor {
+
+    // Log-linear bucketing of 64-bit values: values below 2^SubBucketBits get
+    // their own bucket, above that the SubBucketBits + 1 most significant bits
+    // select the bucket
+    template <int SubBucketBits>
+    struct LogLinearBuckets {
+        static constexpr size_t sub_buckets = size_t(1) << SubBucketBits;
+        static constexpr size_t n_buckets = (64 - SubBucketBits + 1) * sub_buckets;
+
+        static constexpr size_t index(uint64_t value) {
+            if(value < sub_buckets) return static_cast<size_t>(value);
+            int msb = 63 - std::countl_zero(value);
+            int shift = msb - SubBucketBits;
+            size_t sub = static_cast<size_t>(value >> shift) - sub_buckets;
+            return static_cast<size_t>(shift + 1) * sub_buckets + sub;
+        }
+
+        // Upper bound of a bucket
+        static constexpr uint64_t value(size_t index) {
+            if(index < sub_buckets) return index;
+            size_t shift = index / sub_buckets - 1;
+            uint64_t sub = index % sub_buckets + sub_buckets;
+            return ((sub + 1) << shift) - 1;
+        }
+    };
+
+    // Fixed-size log-linear histogram with nanosecond resolution.
+    // Values are grouped in 32 sub-buckets per power of two (~3% precision).
+    class LatencyHistogram {
+        public:
+            void record(uint64_t ns) {
+                ++counts_[bucket_index(ns)];
+                ++count_;
+                if(ns > max_) max_ = ns;
+            }
+
+            uint64_t percentile(double p) const;       // p in [0, 100]
+            uint64_t max() const { return max_; }
+            uint64_t count() const { return count_; }
+            void reset();
+
+            static size_t bucket_index(uint64_t value);
+            static uint64_t bucket_value(size_t index);     // upper bound of a bucket
+
+        private:
+            using Buckets = LogLinearBuckets<5>;
+            static constexpr size_t n_buckets = Buckets::n_buckets;
+
+            std::array<uint32_t, n_buckets> counts_{};
+            uint64_t count_ = 0;
+            uint64_t max_ = 0;
+    };
+
+    // Set of named histograms, e.g. one per instrumented scope
+    class Instrumentation {
+        public:
+            explicit Instrumentation(std::vector<std::string> names);
+
+            void record(size_t probe, uint64_t ns) { histograms_[probe].record(ns); }
+            void reset();
+
+            size_t size() const { return names_.size(); }
+            const std::string& name(size_t probe) const { return names_[probe]; }
+            const LatencyHistogram& histogram(size_t probe) const { return histograms_[probe]; }
+
+            void write_json(std::ostream& out) const;
+
+        private:
+            std::vector<std::string> names_;
+            std::vector<LatencyHistogram> histograms_;
+    };
+
+    // Records the lifetime of the scope into a probe of an Instrumentation
+    class ScopeTimer {
+        public:
+            ScopeTimer(Instrumentation& instrumentation, size_t probe)
+                : instrumentation_(instrumentation), probe_(probe), start_(std::chrono::steady_clock::now()) {}
+
+            ~ScopeTimer() {
+                auto elapsed = std::chrono::steady_clock::now() - start_;
+                instrumentation_.record(probe_, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            }
+
+            ScopeTimer(const ScopeTimer&) = delete;
+            ScopeTimer& operator=(const ScopeTimer&) = delete;
+
+        private:
+            Instrumentation& instrumentation_;
+            size_t probe_;
+            std::chrono::steady_clock::time_point start_;
+    };
+}
+
+#endif
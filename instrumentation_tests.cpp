@@ -0,0 +1,70 @@
+#include "catch_amalgamated.hpp"
+#include "instrumentation.hpp"
+#include <chrono>
+#include <sstream>
+
+// Histogram Tests
+// bucket mapping
+TEST_CASE("LatencyHistogram bucket_index/bucket_value", "[instrumentation][LatencyHistogram]") {
+    using system_monitor::LatencyHistogram;
+
+    for(uint64_t v : {0ull, 1ull, 31ull, 32ull, 33ull, 1000ull, 123456789ull, 1ull << 40, ~0ull}) {
+        size_t index = LatencyHistogram::bucket_index(v);
+        CHECK(LatencyHistogram::bucket_value(index) >= v);          // upper bound of bucket contains value
+        if(v >= 32)
+            CHECK(LatencyHistogram::bucket_value(index) - v <= v / 32);     // ~3% precision
+    }
+    CHECK(LatencyHistogram::bucket_index(1000) < LatencyHistogram::bucket_index(2000));  // monotonic
+}
+
+// percentiles
+TEST_CASE("LatencyHistogram percentile/max/count", "[instrumentation][LatencyHistogram]") {
+    system_monitor::LatencyHistogram histogram;
+
+    CHECK(histogram.percentile(50.0) == 0);     // empty histogram
+
+    for(uint64_t i = 1; i <= 1000; ++i)
+        histogram.record(i * 1000);
+
+    CHECK(histogram.count() == 1000);
+    CHECK(histogram.max() == 1000000);
+    CHECK(static_cast<double>(histogram.percentile(50.0)) == Catch::Approx(500000).epsilon(0.04));
+    CHECK(static_cast<double>(histogram.percentile(99.0)) == Catch::Approx(990000).epsilon(0.04));
+    CHECK(histogram.percentile(100.0) == 1000000);
+
+    histogram.reset();
+    CHECK(histogram.count() == 0);
+    CHECK(histogram.max() == 0);
+}
+
+// json dump
+TEST_CASE("Instrumentation write_json", "[instrumentation]") {
+    system_monitor::Instrumentation instrumentation({"render", "on_timer"});
+    instrumentation.record(0, 1500);
+    instrumentation.record(1, 250);
+
+    std::ostringstream out;
+    instrumentation.write_json(out);
+    std::string json = out.str();
+
+    CHECK(json.front() == '{');
+    CHECK(json.find("\"render\"") != std::string::npos);
+    CHECK(json.find("\"on_timer\"") != std::string::npos);
+    CHECK(json.find("\"max_ns\": 1500") != std::string::npos);
+}
+
+// cost of a scope has to stay well below a microsecond
+TEST_CASE("ScopeTimer overhead", "[instrumentation]") {
+    system_monitor::Instrumentation instrumentation({"scope"});
+    constexpr int iterations = 100000;
+
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i) {
+        system_monitor::ScopeTimer timer(instrumentation, 0);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    auto ns_per_scope = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / iterations;
+
+    CHECK(instrumentation.histogram(0).count() == iterations);
+    CHECK(ns_per_scope < 1000);
+}
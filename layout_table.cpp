@@ -0,0 +1,49 @@
+#include "layout_table.hpp"
+#include <algorithm>
+
+namespace system_monitor {
+
+    void LayoutTable::reset(int x, int y, int width, int height) {
+        entries_.clear();
+        origin_x_ = x;
+        origin_y_ = y;
+        columns_ = std::max(1, (width + cell_size - 1) / cell_size);
+        rows_ = std::max(1, (height + cell_size - 1) / cell_size);
+
+        size_t n_cells = static_cast<size_t>(columns_) * static_cast<size_t>(rows_);
+        if(cells_.size() < n_cells) cells_.resize(n_cells);
+        for(auto& cell : cells_)
+            cell.clear();
+    }
+
+    int LayoutTable::cell_column(int x) const {
+        return std::clamp((x - origin_x_) / cell_size, 0, columns_ - 1);
+    }
+
+    int LayoutTable::cell_row(int y) const {
+        return std::clamp((y - origin_y_) / cell_size, 0, rows_ - 1);
+    }
+
+    void LayoutTable::add(const Entry& entry) {
+        if(entry.width <= 0 || entry.height <= 0) return;
+        auto index = static_cast<uint32_t>(entries_.size());
+        entries_.push_back(entry);
+
+        // Entries outside of the covered area end up in the border cells
+        int first_column = cell_column(entry.x), last_column = cell_column(entry.x + entry.width - 1);
+        int first_row = cell_row(entry.y), last_row = cell_row(entry.y + entry.height - 1);
+        for(int row = first_row; row <= last_row; ++row) {
+            for(int column = first_column; column <= last_column; ++column)
+                cells_[static_cast<size_t>(row * columns_ + column)].push_back(index);
+        }
+    }
+
+    const LayoutTable::Entry* LayoutTable::find(int x, int y) const {
+        if(entries_.empty()) return nullptr;
+        const auto& cell = cells_[static_cast<size_t>(cell_row(y) * columns_ + cell_column(x))];
+        for(auto it = cell.rbegin(); it != cell.rend(); ++it) {
+            if(entries_[*it].contains(x, y)) return &entries_[*it];
+        }
+        return nullptr;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef LAYOUT_TABLE_HPP
+#define LAYOUT_TABLE_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace system_monitor {
+
+    // Interactive rectangles emitted by a render pass. Entries are bucketed in a
+    // uniform grid so that a hit test only looks at the entries of one cell.
+    class LayoutTable {
+        public:
+            struct Entry {
+                int x = 0, y = 0, width = 0, height = 0;
+                int action = 0;         // what a click does, defined by the renderer
+                size_t target = 0;      // e.g. index of the card
+
+                bool contains(int px, int py) const {
+                    return px >= x && py >= y && px < x + width && py < y + height;
+                }
+            };
+
+            // Starts a new pass covering the given area, keeps the allocated buckets
+            void reset(int x, int y, int width, int height);
+            void add(const Entry& entry);
+
+            // Last added entry containing (x, y), nullptr if there is none
+            const Entry* find(int x, int y) const;
+
+            size_t size() const { return entries_.size(); }
+
+        private:
+            static constexpr int cell_size = 64;
+
+            std::vector<Entry> entries_;
+            std::vector<std::vector<uint32_t>> cells_;
+            int origin_x_ = 0;
+            int origin_y_ = 0;
+            int columns_ = 0;
+            int rows_ = 0;
+
+            int cell_column(int x) const;
+            int cell_row(int y) const;
+    };
+}
+
+#endif
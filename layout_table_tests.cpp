@@ -0,0 +1,52 @@
+#include "catch_amalgamated.hpp"
+#include "layout_table.hpp"
+
+// LayoutTable Tests
+// find
+TEST_CASE("LayoutTable add/find", "[layout_table]") {
+    system_monitor::LayoutTable table;
+    table.reset(0, 100, 1000, 800);
+
+    table.add({10, 110, 80, 30, 1, 0});
+    table.add({500, 600, 200, 40, 1, 1});
+    table.add({520, 610, 20, 20, 2, 2});         // on top of the previous one
+
+    CHECK(table.size() == 3);
+    REQUIRE(table.find(15, 115) != nullptr);
+    CHECK(table.find(15, 115)->target == 0);
+    CHECK(table.find(600, 630)->target == 1);
+    CHECK(table.find(525, 615)->target == 2);   // last added wins
+    CHECK(table.find(90, 115) == nullptr);      // right edge is exclusive
+    CHECK(table.find(300, 300) == nullptr);
+}
+
+// reset and entries outside of the covered area
+TEST_CASE("LayoutTable reset/out of area", "[layout_table]") {
+    system_monitor::LayoutTable table;
+    table.reset(0, 0, 100, 100);
+    CHECK(table.find(10, 10) == nullptr);       // empty table
+
+    table.add({-50, -50, 60, 60, 1, 7});
+    table.add({90, 90, 100, 100, 1, 8});
+    CHECK(table.find(-40, -40)->target == 7);
+    CHECK(table.find(150, 150)->target == 8);
+
+    table.reset(0, 0, 100, 100);
+    CHECK(table.size() == 0);
+    CHECK(table.find(-40, -40) == nullptr);
+}
+
+// many entries
+TEST_CASE("LayoutTable many entries", "[layout_table]") {
+    system_monitor::LayoutTable table;
+    table.reset(0, 0, 1920, 20000);
+
+    for(int i = 0; i < 1000; ++i)
+        table.add({(i % 8) * 240, (i / 8) * 160, 100, 40, 1, static_cast<size_t>(i)});
+
+    for(int i = 0; i < 1000; ++i) {
+        auto entry = table.find((i % 8) * 240 + 50, (i / 8) * 160 + 20);
+        REQUIRE(entry != nullptr);
+        CHECK(entry->target == static_cast<size_t>(i));
+    }
+}
@@ -0,0 +1,147 @@
+#include "metrics.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace system_monitor {
+
+    void QuantileSketch::merge(const QuantileSketch& other) {
+        for(size_t i = 0; i < n_buckets; ++i)
+            counts_[i] = static_cast<uint16_t>(std::min<uint32_t>(uint32_t(counts_[i]) + other.counts_[i], UINT16_MAX));
+        count_ += other.count_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    // Ranks are taken on the bucket counts, which only differ from count()
+    // once a bucket saturated
+    double QuantileSketch::quantile(double q) const {
+        if(count_ == 0) return 0.0;
+        if(q >= 1.0) return max_;
+
+        uint64_t total = 0;
+        for(uint16_t count : counts_)
+            total += count;
+        auto rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(total)));
+        if(rank == 0) rank = 1;
+
+        uint64_t seen = 0;
+        for(size_t i = 0; i < n_buckets; ++i) {
+            seen += counts_[i];
+            if(seen >= rank)
+                return std::min(bucket_value(i), max_);
+        }
+        return max_;
+    }
+
+    void QuantileSketch::reset() {
+        counts_.fill(0);
+        count_ = 0;
+        max_ = 0.0;
+    }
+
+
+    size_t SlidingSketch::first_slice(size_t window) {
+        size_t first = 0;
+        for(size_t i = 0; i < window; ++i)
+            first += slice_counts[i];
+        return first;
+    }
+
+    uint64_t SlidingSketch::epoch_of(size_t window, Clock::time_point now) {
+        return static_cast<uint64_t>(now.time_since_epoch() / slice_lengths[window]);
+    }
+
+    void SlidingSketch::record(double value, Clock::time_point now) {
+        for(size_t window = 0; window < n_windows; ++window) {
+            uint64_t epoch = epoch_of(window, now);
+            Slice& slice = slices_[first_slice(window) + epoch % slice_counts[window]];
+            if(slice.epoch != epoch) {
+                slice.sketch.reset();
+                slice.epoch = epoch;
+            }
+            slice.sketch.record(value);
+        }
+    }
+
+    // Merges the live slices of the window bucket by bucket, without a temporary sketch
+    Quantiles SlidingSketch::quantiles(MetricWindow window, Clock::time_point now) const {
+        auto w = static_cast<size_t>(window);
+        uint64_t epoch = epoch_of(w, now);
+        const Slice* first = slices_.data() + first_slice(w);
+        const Slice* live[n_slices];
+        size_t n_live = 0;
+
+        Quantiles result;
+        uint64_t total = 0;
+        for(const Slice* slice = first; slice != first + slice_counts[w]; ++slice) {
+            if(slice->epoch == no_epoch || slice->epoch > epoch || epoch - slice->epoch >= slice_counts[w]) continue;
+            live[n_live++] = slice;
+            result.count += slice->sketch.count_;
+            result.max = std::max(result.max, slice->sketch.max_);
+            for(uint16_t count : slice->sketch.counts_)
+                total += count;
+        }
+        if(total == 0) return result;
+
+        auto rank = [total](double q) {
+            return std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(total))));
+        };
+        const uint64_t ranks[] = {rank(0.50), rank(0.90), rank(0.99)};
+        double* values[] = {&result.p50, &result.p90, &result.p99};
+        size_t next = 0;
+
+        uint64_t seen = 0;
+        for(size_t i = 0; i < QuantileSketch::n_buckets && next < 3; ++i) {
+            for(size_t s = 0; s < n_live; ++s)
+                seen += live[s]->sketch.counts_[i];
+            while(next < 3 && seen >= ranks[next])
+                *values[next++] = std::min(QuantileSketch::bucket_value(i), result.max);
+        }
+        return result;
+    }
+
+    const char* SlidingSketch::window_name(MetricWindow window) {
+        switch(window) {
+            case MetricWindow::minute: return "1m";
+            case MetricWindow::five_minutes: return "5m";
+            case MetricWindow::hour: return "1h";
+            default: return "";
+        }
+    }
+
+
+    MetricTable::Id MetricTable::add(std::string_view name) {
+        Id id = find(name);
+        if(id != no_metric) return id;
+        names_.emplace_back(name);
+        sketches_.emplace_back();
+        last_values_.push_back(0.0);
+        last_times_.emplace_back();
+        sources_.push_back(no_source);
+        return static_cast<Id>(names_.size() - 1);
+    }
+
+    MetricTable::Id MetricTable::find(std::string_view name) const {
+        auto it = std::find(names_.begin(), names_.end(), name);
+        return it == names_.end() ? no_metric : static_cast<Id>(it - names_.begin());
+    }
+
+    void MetricTable::write_json(std::ostream& out, SlidingSketch::Clock::time_point now) const {
+        out << "{\n";
+        for(size_t i = 0; i < names_.size(); ++i) {
+            out << "  \"" << names_[i] << "\": { ";
+            for(size_t w = 0; w < SlidingSketch::n_windows; ++w) {
+                auto window = static_cast<MetricWindow>(w);
+                Quantiles q = sketches_[i].quantiles(window, now);
+                out << "\"" << SlidingSketch::window_name(window) << "\": { "
+                    << "\"count\": " << q.count << ", "
+                    << "\"p50\": " << q.p50 << ", "
+                    << "\"p90\": " << q.p90 << ", "
+                    << "\"p99\": " << q.p99 << ", "
+                    << "\"max\": " << q.max << " }"
+                    << (w + 1 < SlidingSketch::n_windows ? ", " : "");
+            }
+            out << " }" << (i + 1 < names_.size() ? ",\n" : "\n");
+        }
+        out << "}\n";
+    }
+}
@@ -0,0 +1,151 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "instrumentation.hpp"
+
+namespace system_monitor {
+
+    // Fixed-size quantile sketch of non-negative values. Values are kept in
+    // milli-units in log-linear buckets, 16 sub-buckets per power of two
+    // (~6% precision, exact below 0.016). Inserting is O(1) and never
+    // allocates; two sketches merge by adding their buckets.
+    class QuantileSketch {
+        public:
+            static constexpr double scale = 1000.0;         // units per bucket value
+            static constexpr uint64_t max_value = (uint64_t(1) << 48) - 1;     // larger values are clamped
+
+            void record(double value) {
+                uint64_t units = to_units(value);
+                size_t index = Buckets::index(units);
+                if(counts_[index] != UINT16_MAX) ++counts_[index];
+                ++count_;
+                if(value > max_) max_ = value;
+            }
+
+            void merge(const QuantileSketch& other);
+            double quantile(double q) const;        // q in [0, 1]
+            double max() const { return max_; }
+            uint64_t count() const { return count_; }
+            void reset();
+
+            static size_t bucket_index(double value) { return Buckets::index(to_units(value)); }
+            static double bucket_value(size_t index) { return static_cast<double>(Buckets::value(index)) / scale; }
+
+        private:
+            friend class SlidingSketch;
+
+            using Buckets = LogLinearBuckets<4>;
+            static constexpr size_t n_buckets = Buckets::index(max_value) + 1;
+
+            static uint64_t to_units(double value) {
+                if(!(value > 0.0)) return 0;        // negative and NaN
+                double units = value * scale;
+                return units >= static_cast<double>(max_value) ? max_value : static_cast<uint64_t>(units);
+            }
+
+            std::array<uint16_t, n_buckets> counts_{};      // saturating
+            uint64_t count_ = 0;
+            double max_ = 0.0;
+    };
+
+    // Quantiles of a metric over one window
+    struct Quantiles {
+        double p50 = 0.0;
+        double p90 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+        uint64_t count = 0;
+    };
+
+    enum class MetricWindow : size_t { minute, five_minutes, hour, n_windows };
+
+    // Quantiles over the last 1 m, 5 m and 1 h. Every window is a ring of
+    // time slices holding one sketch each; a slice is cleared when the ring
+    // comes back to it, a query merges the live slices. The windows slide
+    // by one slice, so they cover between n - 1 and n slices.
+    class SlidingSketch {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            static constexpr size_t n_windows = static_cast<size_t>(MetricWindow::n_windows);
+            static constexpr std::array<std::chrono::seconds, n_windows> slice_lengths{
+                std::chrono::seconds(15), std::chrono::seconds(60), std::chrono::seconds(600)};
+            static constexpr std::array<size_t, n_windows> slice_counts{4, 5, 6};
+
+            void record(double value, Clock::time_point now);
+            Quantiles quantiles(MetricWindow window, Clock::time_point now) const;
+
+            static const char* window_name(MetricWindow window);
+
+        private:
+            static constexpr uint64_t no_epoch = ~uint64_t(0);
+            static constexpr size_t n_slices = slice_counts[0] + slice_counts[1] + slice_counts[2];
+
+            struct Slice {
+                QuantileSketch sketch;
+                uint64_t epoch = no_epoch;      // time / slice length when it was filled
+            };
+
+            std::array<Slice, n_slices> slices_;    // windows one after another
+
+            static size_t first_slice(size_t window);
+            static uint64_t epoch_of(size_t window, Clock::time_point now);
+    };
+
+    // Named metrics with a sliding sketch and the last value each.
+    // Registration is the only operation allocating; record() is O(1) per window.
+    class MetricTable {
+        public:
+            using Id = uint32_t;
+            static constexpr Id no_metric = ~Id(0);
+            static constexpr uint8_t no_source = 0xff;
+
+            // Id of the metric, registered on first use
+            Id add(std::string_view name);
+            Id find(std::string_view name) const;
+
+            void record(Id id, double value, SlidingSketch::Clock::time_point now) {
+                sketches_[id].record(value, now);
+                last_values_[id] = value;
+                last_times_[id] = now;
+                sources_[id] = source_;
+            }
+            Quantiles quantiles(Id id, MetricWindow window, SlidingSketch::Clock::time_point now) const {
+                return sketches_[id].quantiles(window, now);
+            }
+
+            // Last recorded value and when, a default time point if there is none yet
+            double last(Id id) const { return last_values_[id]; }
+            SlidingSketch::Clock::time_point updated(Id id) const { return last_times_[id]; }
+
+            // Tags the values recorded from now on, e.g. with the index of the
+            // collector recording them; source() is the tag of the last value,
+            // no_source if there is none
+            void set_source(uint8_t source) { source_ = source; }
+            uint8_t source(Id id) const { return sources_[id]; }
+
+            size_t size() const { return names_.size(); }
+            const std::string& name(Id id) const { return names_[id]; }
+
+            // { "cpu.usage": { "1m": { "count": 600, "p50": 12.5, ... }, "5m": ..., "1h": ... }, ... }
+            void write_json(std::ostream& out, SlidingSketch::Clock::time_point now) const;
+
+        private:
+            std::vector<std::string> names_;
+            std::deque<SlidingSketch> sketches_;        // stable, sketches are large
+            std::vector<double> last_values_;
+            std::vector<SlidingSketch::Clock::time_point> last_times_;
+            std::vector<uint8_t> sources_;
+            uint8_t source_ = no_source;
+    };
+}
+
+#endif
@@ -0,0 +1,116 @@
+#include "catch_amalgamated.hpp"
+#include "metrics.hpp"
+#include <chrono>
+#include <sstream>
+
+using system_monitor::MetricTable;
+using system_monitor::MetricWindow;
+using system_monitor::QuantileSketch;
+using system_monitor::SlidingSketch;
+
+// Sketch Tests
+// bucket mapping
+TEST_CASE("QuantileSketch buckets", "[metrics][QuantileSketch]") {
+    for(double v : {0.0, 0.001, 0.015, 0.5, 12.5, 99.9, 1e6, 1e11}) {
+        size_t index = QuantileSketch::bucket_index(v);
+        CHECK(QuantileSketch::bucket_value(index) >= v - 0.001);               // upper bound, milli-units
+        if(v >= 0.016)
+            CHECK(QuantileSketch::bucket_value(index) - v <= v / 16 + 0.001);   // ~6% precision
+    }
+    CHECK(QuantileSketch::bucket_index(-1.0) == 0);
+    CHECK(QuantileSketch::bucket_index(1e30) == QuantileSketch::bucket_index(static_cast<double>(QuantileSketch::max_value) / 1000.0));
+}
+
+// quantiles and merge
+TEST_CASE("QuantileSketch quantile/merge", "[metrics][QuantileSketch]") {
+    QuantileSketch low, high;
+    CHECK(low.quantile(0.5) == 0.0);
+
+    for(int i = 1; i <= 500; ++i)
+        low.record(i * 0.1);
+    for(int i = 501; i <= 1000; ++i)
+        high.record(i * 0.1);
+
+    CHECK(low.quantile(0.99) == Catch::Approx(49.5).epsilon(0.07));
+    low.merge(high);
+    CHECK(low.count() == 1000);
+    CHECK(low.max() == Catch::Approx(100.0));
+    CHECK(low.quantile(0.5) == Catch::Approx(50.0).epsilon(0.07));
+    CHECK(low.quantile(0.9) == Catch::Approx(90.0).epsilon(0.07));
+    CHECK(low.quantile(1.0) == Catch::Approx(100.0));
+
+    low.reset();
+    CHECK(low.count() == 0);
+    CHECK(low.max() == 0.0);
+}
+
+// Windows expire slice by slice
+TEST_CASE("SlidingSketch windows", "[metrics][SlidingSketch]") {
+    using namespace std::chrono_literals;
+    SlidingSketch sketch;
+    SlidingSketch::Clock::time_point start{1h};
+
+    for(int i = 1; i <= 100; ++i)
+        sketch.record(i, start);
+    auto minute = sketch.quantiles(MetricWindow::minute, start);
+    CHECK(minute.count == 100);
+    CHECK(minute.max == 100.0);
+    CHECK(minute.p50 == Catch::Approx(50.0).epsilon(0.07));
+    CHECK(minute.p99 == Catch::Approx(99.0).epsilon(0.07));
+
+    // Two minutes later only the longer windows still hold the values
+    auto later = start + 2min;
+    sketch.record(1.0, later);
+    CHECK(sketch.quantiles(MetricWindow::minute, later).count == 1);
+    CHECK(sketch.quantiles(MetricWindow::minute, later).max == 1.0);
+    CHECK(sketch.quantiles(MetricWindow::five_minutes, later).count == 101);
+    CHECK(sketch.quantiles(MetricWindow::hour, later).count == 101);
+
+    // A slice reused by the ring starts empty
+    auto much_later = start + 2h;
+    CHECK(sketch.quantiles(MetricWindow::hour, much_later).count == 0);
+    sketch.record(5.0, much_later);
+    CHECK(sketch.quantiles(MetricWindow::hour, much_later).count == 1);
+    CHECK(sketch.quantiles(MetricWindow::hour, much_later).p50 == Catch::Approx(5.0).epsilon(0.07));
+}
+
+// Table Tests
+TEST_CASE("MetricTable add/record/write_json", "[metrics][MetricTable]") {
+    MetricTable metrics;
+    auto now = SlidingSketch::Clock::now();
+
+    MetricTable::Id cpu = metrics.add("cpu.usage");
+    MetricTable::Id ram = metrics.add("ram.usage");
+    CHECK(metrics.add("cpu.usage") == cpu);
+    CHECK(metrics.find("ram.usage") == ram);
+    CHECK(metrics.find("missing") == MetricTable::no_metric);
+    CHECK(metrics.size() == 2);
+
+    metrics.record(cpu, 42.0, now);
+    CHECK(metrics.quantiles(cpu, MetricWindow::five_minutes, now).max == 42.0);
+    CHECK(metrics.quantiles(ram, MetricWindow::five_minutes, now).count == 0);
+
+    std::ostringstream out;
+    metrics.write_json(out, now);
+    std::string json = out.str();
+    CHECK(json.front() == '{');
+    CHECK(json.find("\"cpu.usage\": { \"1m\": { \"count\": 1") != std::string::npos);
+    CHECK(json.find("\"1h\"") != std::string::npos);
+    CHECK(json.find("\"ram.usage\"") != std::string::npos);
+}
+
+// cost of an insert into the three windows has to stay well below a microsecond
+TEST_CASE("SlidingSketch record overhead", "[metrics][SlidingSketch]") {
+    SlidingSketch sketch;
+    constexpr int iterations = 100000;
+    auto now = SlidingSketch::Clock::now();
+
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i)
+        sketch.record(i % 100, now);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / iterations;
+    CHECK(ns < 1000.0);
+    CHECK(sketch.quantiles(MetricWindow::minute, now).count == iterations);
+}
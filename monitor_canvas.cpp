@@ -1,18 +1,39 @@
 #include "monitor_canvas.hpp"
-#include "catch_amalgamated.hpp"
 #include <unistd.h>
 #include <algorithm>
+#include <cstdlib>
 #include <wx/font.h>
 #include <wx/gtk/bitmap.h>
 #include <wx/dcgraph.h>
+#include <fstream>
+#include <sstream>
 
 namespace system_monitor {
 using std::min;
 
+static const char* const timings_file = "system_monitor_timings.json";
+static const char* const metrics_file = "system_monitor_metrics.json";
+static const char* const alerts_file = "system_monitor_alerts.conf";
+
+namespace {
+    // Percentiles of the last `samples` values of a remote history, which
+    // holds one value per agent interval (1 s by default)
+    CanvasSnapshot::Percentiles history_percentiles(const std::vector<float>& history, size_t samples,
+                                                    double scale, std::vector<float>& scratch) {
+        size_t n = std::min(samples, history.size());
+        if(n == 0) return {};
+        scratch.assign(history.end() - static_cast<ptrdiff_t>(n), history.end());
+        std::sort(scratch.begin(), scratch.end());
+        auto at = [&](double q) { return scale * scratch[static_cast<size_t>(q * static_cast<double>(n - 1))]; };
+        return {at(0.50), at(0.90), at(0.99), scale * scratch.back()};
+    }
+}
+
 MonitorCanvas::MonitorCanvas(const wxString &title)
     : wxFrame(nullptr, wxID_ANY, title, wxDefaultPosition, wxSize(1400, 800)),
-      download_history_(network_history_length, 0.0),
-      upload_history_(network_history_length, 0.0) {
+      title_(title),
+      instrumentation_(CanvasRenderer::probe_names()),
+      renderer_(instrumentation_) {
   SetBackgroundStyle(wxBG_STYLE_PAINT);
 
   scroll_panel_ = new wxScrolledWindow(this);
@@ -22,420 +43,648 @@ MonitorCanvas::MonitorCanvas(const wxString &title)
 
   scroll_panel_->Bind(wxEVT_PAINT, &MonitorCanvas::on_paint, this);
   scroll_panel_->Bind(wxEVT_LEFT_DOWN, &MonitorCanvas::on_click, this);
+  scroll_panel_->Bind(wxEVT_MOTION, &MonitorCanvas::on_motion, this);
+  scroll_panel_->Bind(wxEVT_LEAVE_WINDOW, &MonitorCanvas::on_leave, this);
 
   timer_ = new wxTimer(this);
   Bind(wxEVT_TIMER, &MonitorCanvas::on_timer, this);
-  timer_->Start(500);
+  timer_->Start(foreground_interval_ms);
 
-  cards_[0].label = "RAM";
-  cards_[1].label = "Drive";
-  cards_[2].label = "CPU";
-  cards_[0].usage = monitor_.ram.get_usage();
-  cards_[1].usage = monitor_.drive.get_usage();
-  cards_[2].usage = monitor_.cpu.get_usage();
-        }
+  Bind(wxEVT_ICONIZE, &MonitorCanvas::on_iconize, this);
+  Bind(wxEVT_SHOW, &MonitorCanvas::on_show, this);
+  Bind(wxEVT_ACTIVATE, &MonitorCanvas::on_activate, this);
+  Bind(wxEVT_CHAR_HOOK, &MonitorCanvas::on_key, this);
 
-    void MonitorCanvas::on_timer(wxTimerEvent&) {
-        cards_[0].usage = monitor_.ram.get_usage();
-        cards_[1].usage = monitor_.drive.get_usage();
-        cards_[2].usage = monitor_.cpu.get_usage();
-
-        double download = monitor_.network.get_download_rate() / 1024.0;
-        double upload = monitor_.network.get_upload_rate() / 1024.0;
-        update_network_histroy(download, upload);
+  // The network history is recorded for every sample, including in background
+  sampler_.set_listener([this] { CallAfter(&MonitorCanvas::sample_history); });
+  load_alert_rules();
+  sample_cards();
+        }
 
-        scroll_panel_->Refresh();
+    void MonitorCanvas::set_background_interval(int interval_ms) {
+        background_interval_ms_ = interval_ms;
+        if(in_background_) {
+            in_background_ = false;     // force the timer to be restarted
+            update_power_mode();
+        }
     }
 
-    void MonitorCanvas::update_network_histroy(double download, double upload){
-        download_history_[network_graph_index_] = download;
-        upload_history_[network_graph_index_] = upload;
-        network_graph_index_++;
-        if(network_graph_index_ >= network_history_length) {
-            network_graph_index_ = 0;
-            network_graph_full_ = true;
+    void MonitorCanvas::set_background_history(bool record) {
+        background_history_ = record;
+        if(in_background_) {
+            in_background_ = false;
+            update_power_mode();
         }
     }
 
-    void MonitorCanvas::on_paint(wxPaintEvent&) {
-        wxPaintDC dc(scroll_panel_);
-        scroll_panel_->DoPrepareDC(dc);
-        render(dc);
+    bool MonitorCanvas::listen(uint16_t port) {
+        auto aggregator = std::make_unique<Aggregator>(port);
+        if(!aggregator->listening()) return false;
+        aggregator_ = std::move(aggregator);
+        return true;
     }
 
-    void MonitorCanvas::on_click(wxMouseEvent& event) {
-        int x, y;
-        scroll_panel_->CalcUnscrolledPosition(event.GetX(), event.GetY(), &x, &y);
-
-        wxClientDC dc(scroll_panel_);
-        scroll_panel_->DoPrepareDC(dc);
+    bool MonitorCanvas::connect(const std::string& address, uint16_t port) {
+        if(!aggregator_) aggregator_ = std::make_unique<Aggregator>();
+        remote_address_ = address;
+        remote_port_ = port;
+        follow_remote_ = true;
+        redial_at_ = std::chrono::steady_clock::now() + redial_interval;
+        return aggregator_->connect(address, port);
+    }
 
-        for(int i = 0; i < n_cards; ++i){
-            if(get_show_more_rect(cards_[i], dc).Contains(x, y)){
-                cards_[i].expanded = !cards_[i].expanded;
-                scroll_panel_->Refresh();
-                break;
-            }
-        }
+    // Dials the agent of the remote view again once its connection is gone
+    void MonitorCanvas::redial() {
+        if(remote_port_ == 0 || aggregator_->dialed_connections() != 0) return;
+        auto now = std::chrono::steady_clock::now();
+        if(now < redial_at_) return;
+        redial_at_ = now + redial_interval;
+        aggregator_->connect(remote_address_, remote_port_);
     }
 
-    wxRect MonitorCanvas::get_show_more_rect(const Cards& card, wxDC& dc) const {
-        wxFont font(title_font_size, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL);
-        dc.SetFont(font);
-        dc.SetTextForeground(wxColour(33, 150, 243));
+    // The timer only runs in foreground, sampling happens on the sampler thread
+    void MonitorCanvas::on_timer(wxTimerEvent&) {
+        ScopeTimer timing(instrumentation_, CanvasRenderer::probe_timer);
 
-        wxString text = card.expanded ? "show less" : "show more";
+        sample_cards();
+        update_remote();
+        scroll_panel_->Refresh();
+    }
 
-        int tw, th;
-        dc.GetTextExtent(text, &tw, &th);
+    // Cards and general informations from the samples published since the
+    // last call; collectors missing from Monitor are skipped
+    void MonitorCanvas::sample_cards() {
+        if constexpr (Monitor::has<Cpu>) {
+            if(sampler_.read<Cpu>(cpu_sample_, cpu_seen_)) {
+                snapshot_.cpu_usage = cpu_sample_.usage;
+                snapshot_.core_usages = cpu_sample_.core_usages;
+                snapshot_.cpu_ids = cpu_sample_.cpu_ids;
+                if(host_ == local_host) renderer_.push_heatmap(cpu_sample_.core_usages);
+                static_assert(CanvasSnapshot::n_cpu_states == Cpu::n_states);
+                for(size_t state = 0; state < Cpu::n_states; ++state)
+                    snapshot_.cpu_states[state] = cpu_sample_.states[state];
+                snapshot_.context_switch_rate = cpu_sample_.context_switch_rate;
+                snapshot_.interrupt_rate = cpu_sample_.interrupt_rate;
+                snapshot_.fork_rate = cpu_sample_.fork_rate;
+                snapshot_.procs_running = cpu_sample_.procs_running;
+                snapshot_.procs_blocked = cpu_sample_.procs_blocked;
+                snapshot_.socket_usages = cpu_sample_.socket_usages;
+                snapshot_.node_usages = cpu_sample_.node_usages;
+            }
+        }
 
-        int base_cardHeight = card.rect.height / (card.expanded ? 2 : 1);
-        int center_x = card.rect.x + card.rect.width / 2;
-        int center_y = card.rect.y + base_cardHeight / 2 - 10;
-        int circle_size = min(card.rect.width, base_cardHeight) * 0.6;
-        int circle_radius = circle_size / 2;
-        int show_more_y = center_y + circle_radius + 18;
+        if constexpr (Monitor::has<Softirqs>) {
+            if(sampler_.read<Softirqs>(softirqs_sample_, softirqs_seen_)) {
+                const auto& last = softirqs_sample_;
+                size_t net_rx = last.find("NET_RX");
+                // The columns are every possible CPU, the core cards the online ones: by id
+                snapshot_.net_rx_rates.clear();
+                if(net_rx < last.types.size() && last.cpus != 0) {
+                    snapshot_.net_rx_rates.assign(*std::max_element(last.cpu_ids.begin(), last.cpu_ids.end()) + size_t(1), 0.0);
+                    for(size_t cpu = 0; cpu < last.cpus; ++cpu)
+                        snapshot_.net_rx_rates[last.cpu_ids[cpu]] = last.rate(net_rx, cpu);
+                }
+                snapshot_.net_rx_imbalance = last.net_rx_imbalance;
+                snapshot_.net_rx_busiest = last.net_rx_busiest;
+            }
+        }
 
-        return wxRect(center_x - tw / 2 - 4, show_more_y - 2, tw + 8, th + 4);
-    }
+        if constexpr (Monitor::has<Scheduler>) {
+            if(sampler_.read<Scheduler>(scheduler_sample_, scheduler_seen_)) {
+                snapshot_.load_averages = scheduler_sample_.load_averages;
+                snapshot_.runnable_tasks = scheduler_sample_.runnable;
+                snapshot_.sched_latency = scheduler_sample_.latency;
+                snapshot_.sched_waiting = scheduler_sample_.waiting;
+                snapshot_.sched_running = scheduler_sample_.running;
+                snapshot_.core_sched_latencies = scheduler_sample_.core_latencies;
+            }
+        }
 
-    void MonitorCanvas::render(wxDC& dc) {
-        int width, height;
-        scroll_panel_->GetClientSize(&width, &height);
+        if constexpr (Monitor::has<NumaMemory>) {
+            if(sampler_.read<NumaMemory>(numa_sample_, numa_seen_)) {
+                snapshot_.node_memory.clear();
+                for(const NumaMemory::Node& node : numa_sample_.nodes) {
+                    if(node.total != 0)         // CPU-only nodes
+                        snapshot_.node_memory.push_back({node.id, node.usage, node.total, node.free,
+                                                                   node.file_pages, node.anon_pages, node.miss_rate});
+                }
+            }
+        }
 
-        int base_cardWidth = (width - (n_cards + 1) * spacing) / n_cards;
-        int base_cardHeight = height / 2 - 2 * spacing;
+        if constexpr (Monitor::has<Thermal>) {
+            if(sampler_.read<Thermal>(thermal_sample_, thermal_seen_)) {
+                const auto& sensors = thermal_sample_.sensors;
+                auto hottest = std::max_element(sensors.begin(), sensors.end(), [](const Thermal::Sensor& a, const Thermal::Sensor& b) {
+                    return !a.valid || (b.valid && a.celsius < b.celsius);
+                });
+                bool valid = hottest != sensors.end() && hottest->valid;
+                snapshot_.cpu_temperature = thermal_sample_.cpu_celsius;
+                snapshot_.hottest_sensor = valid ? hottest->name : std::string();
+                snapshot_.hottest_temperature = valid ? hottest->celsius : 0.0;
+            }
+        }
 
-        // Draw cards
-        int x = spacing;
-        int cards_bottom = 0;
+        if constexpr (Monitor::has<Ram>) {
+            if(sampler_.read<Ram>(ram_sample_, ram_seen_)) {
+                snapshot_.ram_usage = ram_sample_.usage;
+                snapshot_.ram_total = ram_sample_.total;
+                snapshot_.ram_used = ram_sample_.used;
+                snapshot_.ram_free = ram_sample_.free;
+                snapshot_.ram_available = ram_sample_.available;
+                snapshot_.ram_buffers = ram_sample_.buffers;
+                snapshot_.ram_cached = ram_sample_.cached;
+                snapshot_.ram_shmem = ram_sample_.shmem;
+                snapshot_.ram_slab = ram_sample_.slab;
+                snapshot_.ram_dirty = ram_sample_.dirty;
+                snapshot_.ram_writeback = ram_sample_.writeback;
+                snapshot_.swap_total = ram_sample_.swap_total;
+                snapshot_.swap_free = ram_sample_.swap_free;
+            }
+        }
 
-        for(int i = 0; i < n_cards; ++i){
-            cards_[i].rect = wxRect(x, spacing, base_cardWidth, cards_[i].expanded ? 2 * base_cardHeight : base_cardHeight);
-            draw_card(dc, cards_[i], base_cardHeight);
-            x += base_cardWidth + spacing;
-            if(cards_[i].rect.GetBottom() > cards_bottom)
-                cards_bottom = cards_[i].rect.GetBottom();
+        if constexpr (Monitor::has<Drive>) {
+            if(sampler_.read<Drive>(drive_sample_, drive_seen_)) {
+                const auto& mounts = drive_sample_.mounts;
+                snapshot_.mounts.resize(mounts.size());
+                for(size_t i = 0; i < mounts.size(); ++i) {
+                    auto& mount = snapshot_.mounts[i];
+                    mount.path = mounts[i].path;
+                    mount.usage = mounts[i].usage;
+                    mount.total = mounts[i].total;
+                    mount.used = mounts[i].used;
+                    mount.free = mounts[i].free;
+                }
+            }
         }
 
-        int info_y = cards_bottom + spacing;
+        if constexpr (Monitor::has<General>) {
+            if(sampler_.read<General>(general_sample_, general_seen_)) {
+                const auto& last = general_sample_;
+                snapshot_.uptime = last.uptime;
+                snapshot_.procs_num = last.procs_num;
+                snapshot_.cpu_cores = last.cpu_cores;
+                snapshot_.cpu_physical_cores = last.cpu_physical_cores;
+                snapshot_.cpu_sockets = last.cpu_sockets;
+                snapshot_.numa_nodes = last.numa_nodes;
+                if(snapshot_.cpu_model.empty()) {
+                    const CpuIdentity& identity = last.cpu_identity;
+                    snapshot_.cpu_model = last.cpu_model;
+                    snapshot_.cpu_caches = identity.cache_summary();
+                    snapshot_.cpu_features = identity.feature_summary();
+                    snapshot_.cpu_revision = "family " + std::to_string(identity.family) + " model " + std::to_string(identity.model)
+                                           + " stepping " + std::to_string(identity.stepping);
+                    if(!identity.microcode.empty()) snapshot_.cpu_revision += ", microcode " + identity.microcode;
+                    snapshot_.product_name = last.product_name;
+                    snapshot_.os_version = last.os_version;
+                    snapshot_.kernel_version = last.kernel_version;
+                }
+            }
+        }
 
-        int section_width = (width - 3 * spacing) / 2;
-        int section_height = (height / 2) - 2 * spacing;
+        if constexpr (Monitor::has<Cgroups>) {
+            if(sampler_.read<Cgroups>(cgroups_sample_, cgroups_seen_))
+                update_services();
+        }
 
-        // General info Section
-        draw_info_section(dc, spacing, info_y, section_width, section_height, true);
+        if(burst_mode_ && burst_.read(burst_summary_, burst_seen_))
+            update_burst();
 
-        // Network Section
-        draw_info_section(dc, 2 * spacing + section_width, info_y, section_width, section_height, false);
+        if(sampler_.read_overhead(overhead_, overhead_seen_))
+            update_overhead();
 
-        int scroll_height = info_y + section_height + spacing;
-        scroll_panel_->SetVirtualSize(wxSize(width, scroll_height));
+        update_percentiles();
     }
 
-    void MonitorCanvas::draw_card(wxDC& dc, Cards& card, int base_cardHeight) {
-        // Draw rounded rectangle (card background)
-        wxColour card_bg(255, 255, 255);
-        wxColour card_border(180, 180, 180);
-        dc.SetBrush(wxBrush(card_bg));
-        dc.SetPen(wxPen(card_border, 2));
-        const int corner_radius = 20;
-        dc.DrawRoundedRectangle(card.rect.x, card.rect.y, card.rect.width, card.rect.height, corner_radius);
-
-        // Draw the usage circle
-        int center_x = card.rect.x + card.rect.width / 2;
-        int center_y = card.rect.y + base_cardHeight / 2 - 10;
-        int circle_size = min(card.rect.width, base_cardHeight) * 0.6;
-        int circle_radius = circle_size / 2;
-
-        wxColour usage_col(76, 175, 80); // RAM
-        if (card.label == "CPU") usage_col = wxColour(33, 150, 243); // CPU
-        else if (card.label == "Drive") usage_col = wxColour(255, 152, 0); // Drive
-
-        wxString usage_text = wxString::Format("%.1f%%", card.usage * 100.0);
-
-        draw_usage_circle(dc, center_x, center_y, circle_radius, card.usage, usage_col, usage_text);
-
-        draw_title(dc, card.rect.x, card.rect.y, card.label, card.rect.width);
-        int show_more_y = center_y + circle_radius + 18;
-        draw_show_more_text(dc, center_x, show_more_y, card.expanded);
-
-        if(card.expanded) {
-            int info_y = show_more_y + 80;
-            int info_x = card.rect.x + 30;
-            if(card.label == "RAM")
-                draw_ram_info(dc, card, info_x, info_y);
-            if(card.label == "Drive")
-                draw_drive_info(dc, card, info_x, info_y);
-            if(card.label == "CPU")
-                draw_cpu_info(dc, card, info_x, info_y);
-        }
-    }
-
-    // draws sections at the bottom
-    void MonitorCanvas::draw_info_section(wxDC& dc, int x, int y, int w, int h, bool is_general) {
-        wxColour card_bg(255, 255, 255);
-        wxColour card_border(180, 180, 180);
-        dc.SetBrush(wxBrush(card_bg));
-        dc.SetPen(wxPen(card_border, 2));
-        const int corner_radius = 20;
-        dc.DrawRoundedRectangle(x, y, w, h + spacing, corner_radius);
-
-        if(is_general) {
-            draw_system_infos(dc, x + spacing, y + spacing);
-        } else {
-            draw_network_infos(dc, x + spacing, y + spacing, w);
+    void MonitorCanvas::update_overhead() {
+        snapshot_.overhead_collectors.resize(overhead_.collectors.size());
+        for(size_t i = 0; i < overhead_.collectors.size(); ++i) {
+            const auto& collector = overhead_.collectors[i];
+            auto& shown = snapshot_.overhead_collectors[i];
+            shown.name = collector.name;
+            shown.cpu = collector.cpu;
+            shown.sample_us = collector.sample_us;
+            shown.faults = collector.faults;
+            shown.syscalls = collector.syscalls;
+            shown.period_ms = collector.period.count();
+            shown.stretch = collector.stretch;
         }
+        snapshot_.overhead_cpu = overhead_.cpu;
+        snapshot_.overhead_reads_cpu = overhead_.reads_cpu;
+        snapshot_.overhead_reads_syscalls = overhead_.reads_syscalls;
+        snapshot_.overhead_faults = overhead_.faults;
+        snapshot_.overhead_syscalls = overhead_.syscalls;
+        snapshot_.overhead_syscalls_per_tick = overhead_.syscalls_per_tick;
+        snapshot_.overhead_rss = overhead_.rss;
+        snapshot_.overhead_budget = overhead_.budget;
     }
 
-    // draws the usage circles of components
-    void MonitorCanvas::draw_usage_circle(wxDC& dc, int center_x, int center_y, int radius, double usage, const wxColour& color, const wxString& usage_text) {
-        wxColour bg_circle(220, 220, 220);
-        dc.SetPen(wxPen(bg_circle, 10));
-        dc.SetBrush(*wxTRANSPARENT_BRUSH);
-        dc.DrawEllipse(center_x - radius, center_y - radius, 2 * radius, 2 * radius);
+    // Percentiles of the cards, read from the sketches in one short lock
+    void MonitorCanvas::update_percentiles() {
+        sampler_.with_metrics([this](const MetricTable& metrics, auto now) {
+            auto resolve = [&](MetricTable::Id& id, std::string_view name) {
+                if(id == MetricTable::no_metric) id = metrics.find(name);
+                return id != MetricTable::no_metric;
+            };
+            auto fill = [&](MetricTable::Id id, std::array<CanvasSnapshot::Percentiles, CanvasSnapshot::n_windows>& out) {
+                for(size_t w = 0; w < CanvasSnapshot::n_windows; ++w) {
+                    Quantiles q = metrics.quantiles(id, static_cast<MetricWindow>(w), now);
+                    out[w] = {q.p50, q.p90, q.p99, q.max};
+                }
+            };
+            if(resolve(cpu_metric_, "cpu.usage")) fill(cpu_metric_, snapshot_.cpu_percentiles);
+            if(resolve(ram_metric_, "ram.usage")) fill(ram_metric_, snapshot_.ram_percentiles);
+            if(resolve(download_metric_, "net.download")) fill(download_metric_, snapshot_.download_percentiles);
+            if(resolve(upload_metric_, "net.upload")) fill(upload_metric_, snapshot_.upload_percentiles);
+
+            // Per-core metrics are named by CPU id, looked up again after a hotplug
+            size_t cores = snapshot_.core_usages.size();
+            bool missing = std::find(core_metrics_.begin(), core_metrics_.end(), MetricTable::no_metric) != core_metrics_.end();
+            if(core_metrics_.size() != cores || core_metric_cpu_ids_ != snapshot_.cpu_ids || missing) {
+                core_metrics_.resize(cores);
+                core_metric_cpu_ids_ = snapshot_.cpu_ids;
+                for(size_t core = 0; core < cores; ++core)
+                    core_metrics_[core] = metrics.find("cpu.core" + std::to_string(snapshot_.cpu_id(core)) + ".usage");
+            }
+            snapshot_.core_percentiles.resize(cores);
+            for(size_t core = 0; core < cores; ++core) {
+                if(core_metrics_[core] == MetricTable::no_metric) {
+                    snapshot_.core_percentiles[core] = {};
+                    continue;
+                }
+                Quantiles q = metrics.quantiles(core_metrics_[core], MetricWindow::five_minutes, now);
+                snapshot_.core_percentiles[core] = {q.p50, q.p90, q.p99, q.max};
+            }
+        });
+    }
 
-        dc.SetPen(wxPen(color, 10));
-        double start_angle = -90.0; // top
-        double end_angle = start_angle + usage * 360.0;
+    void MonitorCanvas::update_burst() {
+        auto to_snapshot = [](const BurstSampler::Window& window) {
+            return CanvasSnapshot::BurstWindow{window.min, window.max, window.p99};
+        };
+        snapshot_.cpu_burst = to_snapshot(burst_summary_.total);
+        snapshot_.core_bursts.resize(burst_summary_.cores.size());
+        for(size_t i = 0; i < burst_summary_.cores.size(); ++i)
+            snapshot_.core_bursts[i] = to_snapshot(burst_summary_.cores[i]);
+        snapshot_.burst_interval_ms = static_cast<double>(burst_summary_.interval.count()) / 1000.0;
+        snapshot_.burst_overhead = burst_summary_.overhead;
+    }
 
-        if (usage > 0.0) {
-            if (usage >= 1.0) usage = 0.999; // DrawEllipticArc does not allow values over 0.999
-            dc.DrawEllipticArc(center_x - radius, center_y - radius, 2 * radius, 2 * radius, start_angle, end_angle);
+    void MonitorCanvas::toggle_burst_mode() {
+        burst_mode_ = !burst_mode_;
+        snapshot_.burst_mode = burst_mode_;
+        if(burst_mode_) {
+            burst_seen_ = 0;
+            snapshot_.cpu_burst = {};
+            snapshot_.core_bursts.clear();
+            if(!in_background_) burst_.start();
+        } else {
+            burst_.stop();
         }
-        draw_percentage_text(dc, center_x, center_y, usage_text);
+        scroll_panel_->Refresh();
     }
 
-    // draws title of each card
-    void MonitorCanvas::draw_title(wxDC& dc, int x, int y, const wxString& label, int box_width) {
-        wxFont font(title_font_size, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
-        dc.SetFont(font);
-        dc.SetTextForeground(*wxBLACK);
-
-        int tw, th;
-        dc.GetTextExtent(label, &tw, &th);
+    // Units and containers (*.service, *.scope) using the most CPU; top level groups
+    // on hosts without systemd
+    void MonitorCanvas::update_services() {
+        const auto& groups = cgroups_sample_.groups;
+        bool has_services = std::any_of(groups.begin(), groups.end(), [](const Cgroups::Group& group) { return group.service; });
 
-        int label_x = x + (box_width - tw) / 2;
-        int label_y = y +  18;
+        std::vector<const Cgroups::Group*> candidates;
+        for(const auto& group : groups) {
+            if(has_services ? group.service : group.depth == 1)
+                candidates.push_back(&group);
+        }
+        size_t shown = std::min(candidates.size(), CanvasSnapshot::services_shown);
+        std::partial_sort(candidates.begin(), candidates.begin() + static_cast<ptrdiff_t>(shown), candidates.end(),
+                          [](const Cgroups::Group* a, const Cgroups::Group* b) { return a->cpu_usage > b->cpu_usage; });
+
+        snapshot_.services.resize(shown);
+        for(size_t i = 0; i < shown; ++i) {
+            const std::string& path = candidates[i]->path;
+            size_t slash = path.rfind('/');
+            snapshot_.services[i].name = slash == std::string::npos ? path : path.substr(slash + 1);
+            snapshot_.services[i].cpu = candidates[i]->cpu_usage;
+            snapshot_.services[i].memory = candidates[i]->memory_current;
+        }
+    }
 
-        dc.DrawText(label, label_x, label_y);
+    // Rules and hooks from the alerts file in the working directory, if there is one
+    void MonitorCanvas::load_alert_rules() {
+        std::ifstream file(alerts_file);
+        if(!file.is_open()) return;
+        std::stringstream source;
+        source << file.rdbuf();
+
+        alert_hook_.configure(source.str());
+        sampler_.set_alert_listener([this](const AlertRules& rules, std::span<const AlertEvent> events) { on_alerts(rules, events); });
+
+        // Misspelt metrics only show once every collector recorded its own
+        sampler_.set_alert_warning_listener([this](std::span<const AlertRules::Error> errors) {
+            std::vector<AlertRules::Error> warnings(errors.begin(), errors.end());
+            CallAfter([warnings = std::move(warnings)] {
+                for(const auto& warning : warnings)
+                    wxLogWarning("%s:%zu: %s", alerts_file, warning.line, warning.message);
+            });
+        });
+        for(const auto& error : sampler_.set_alert_rules(source.str()))
+            wxLogWarning("%s:%zu: %s", alerts_file, error.line, error.message);
     }
 
-    // draws percentag text in center of usage circle
-    void MonitorCanvas::draw_percentage_text(wxDC& dc, int center_x, int center_y, const wxString& usage_text) {
-        wxFont font(percent_font_size, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
-        dc.SetFont(font);
-        dc.SetTextForeground(*wxBLACK);
+    // On the sampler thread: lines for the hook, the firing rules for the GUI
+    void MonitorCanvas::on_alerts(const AlertRules& rules, std::span<const AlertEvent> events) {
+        for(const auto& event : events)
+            alert_hook_.deliver(AlertHook::format(rules, event));
 
-        int tw, th;
-        dc.GetTextExtent(usage_text, &tw, &th);
-        dc.DrawText(usage_text, center_x - tw / 2, center_y - th / 2);
+        std::vector<std::string> firing;
+        for(uint32_t rule = 0; rule < rules.size(); ++rule) {
+            if(rules.firing(rule))
+                firing.push_back(rules.text(rule) + wxString::Format(" (%g)", rules.value(rule)).ToStdString());
+        }
+        CallAfter([this, firing = std::move(firing)]() mutable {
+            snapshot_.alerts = std::move(firing);
+            scroll_panel_->Refresh();
+        });
     }
 
-    // draws show more "button"
-    void MonitorCanvas::draw_show_more_text(wxDC& dc, int center_x, int y, bool expanded) {
-        wxFont font(12, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
-        dc.SetFont(font);
+    // Fleet grid and the remote host shown, only when the aggregator processed something
+    void MonitorCanvas::update_remote(bool force) {
+        if(!aggregator_) return;
+        redial();
+        uint64_t generation = aggregator_->generation();
+        if(generation == aggregator_seen_ && !force) return;
+        aggregator_seen_ = generation;
+
+        if(follow_remote_) {
+            for(size_t host = 0; host < aggregator_->host_count(); ++host) {
+                if(!aggregator_->read_host(host, remote_host_) || !remote_host_.dialed) continue;
+                follow_remote_ = false;
+                show_host(host);        // calls back in with force
+                return;
+            }
+        }
 
-        wxString text = expanded ? "show less" : "show more";
+        if(snapshot_.fleet_view) {
+            aggregator_->read_hosts(fleet_hosts_);
+            snapshot_.fleet.resize(fleet_hosts_.size());
+            for(size_t i = 0; i < fleet_hosts_.size(); ++i) {
+                auto& tile = snapshot_.fleet[i];
+                tile.name = fleet_hosts_[i].name;
+                tile.connected = fleet_hosts_[i].connected;
+                tile.cpu_usage = fleet_hosts_[i].last.cpu_usage;
+                tile.ram_usage = fleet_hosts_[i].last.ram_usage;
+            }
+            snapshot_.fleet_selected = host_;
+            return;
+        }
+        if(host_ != local_host && aggregator_->read_host(host_, remote_host_) && aggregator_->read_history(host_, remote_history_))
+            update_remote_snapshot();
+    }
 
-        int tw, th;
-        dc.GetTextExtent(text, &tw, &th);
+    // The cards of a remote host from its last sample and history; what the
+    // wire format does not carry (RAM breakdown, services, ...) stays empty
+    void MonitorCanvas::update_remote_snapshot() {
+        const HostSample& last = remote_host_.last;
+        CanvasSnapshot& remote = remote_snapshot_;
+        remote.cpu_usage = last.cpu_usage;
+        remote.core_usages = last.core_usages;
+        remote.cpu_ids.clear();                 // the wire format numbers the cores 0..n-1
+        remote.cpu_cores = static_cast<unsigned int>(last.core_usages.size());
+        remote.heatmap_view = snapshot_.heatmap_view;
+        if(remote_host_.samples != remote_heatmap_samples_) {
+            remote_heatmap_samples_ = remote_host_.samples;
+            renderer_.push_heatmap(last.core_usages);
+        }
+        remote.ram_usage = last.ram_usage;
+        remote.ram_total = last.ram_total;
+        remote.ram_used = last.ram_used;
+        remote.ram_free = last.ram_total - std::min(last.ram_used, last.ram_total);
+        remote.ram_available = remote.ram_free;
+        remote.mounts.resize(1);
+        remote.mounts[0].path = "/";
+        remote.mounts[0].usage = last.root_usage;
+        remote.uptime = last.uptime;
+        remote.procs_num = last.procs_num;
+        remote.product_name = remote_host_.connected ? remote_host_.name : remote_host_.name + " (disconnected)";
+        remote.download_rate = last.download_rate;
+        remote.upload_rate = last.upload_rate;
+
+        // The graph shows the tail of the history, the percentile windows
+        // count samples; the hour holds what the history has (10 min at 1 s)
+        const auto& download = remote_history_.download_rate;
+        const auto& upload = remote_history_.upload_rate;
+        remote.download_history.assign(CanvasSnapshot::network_history_length, 0.0);
+        remote.upload_history.assign(CanvasSnapshot::network_history_length, 0.0);
+        remote.network_graph_index = 0;
+        remote.network_graph_full = false;
+        for(size_t i = download.size() - std::min(download.size(), CanvasSnapshot::network_history_length); i < download.size(); ++i)
+            remote.update_network_history(download[i] / 1024.0, upload[i] / 1024.0);
+
+        const size_t windows[CanvasSnapshot::n_windows] = {60, 300, Aggregator::history_length};
+        for(size_t w = 0; w < CanvasSnapshot::n_windows; ++w) {
+            remote.cpu_percentiles[w] = history_percentiles(remote_history_.cpu_usage, windows[w], 100.0, percentile_scratch_);
+            remote.ram_percentiles[w] = history_percentiles(remote_history_.ram_usage, windows[w], 100.0, percentile_scratch_);
+            remote.download_percentiles[w] = history_percentiles(download, windows[w], 1.0, percentile_scratch_);
+            remote.upload_percentiles[w] = history_percentiles(upload, windows[w], 1.0, percentile_scratch_);
+        }
+        remote.core_percentiles.clear();
+    }
 
-        int button_width = tw + 20;
-        int button_height = th + 20;
-        int button_x = center_x - button_width / 2;
+    // Switches the cards to a remote host, or back to this one (local_host)
+    void MonitorCanvas::show_host(size_t host) {
+        host_ = host;
+        snapshot_.fleet_view = false;
+        renderer_.clear_heatmap();
+        remote_heatmap_samples_ = 0;
+        if(host_ != local_host && aggregator_->read_host(host_, remote_host_))
+            SetTitle(title_ + " - " + wxString::FromUTF8(remote_host_.name));
+        else {
+            host_ = local_host;
+            SetTitle(title_);
+        }
+        update_remote(true);
+        scroll_panel_->Scroll(0, 0);
+        scroll_panel_->Refresh();
+    }
 
-        dc.SetBrush(wxBrush(wxColor(230, 242, 255)));
-        dc.SetPen(wxPen(wxColor(33, 150, 242), 2));
-        dc.DrawRoundedRectangle(button_x, y, button_width, button_height, 8);
+    void MonitorCanvas::toggle_fleet_view() {
+        snapshot_.fleet_view = !snapshot_.fleet_view;
+        SetTitle(snapshot_.fleet_view ? title_ + " - fleet" : title_);
+        update_remote(true);
+        scroll_panel_->Scroll(0, 0);
+        scroll_panel_->Refresh();
+    }
 
-        dc.SetTextForeground(wxColour(33, 150, 243));
-        dc.DrawText(text, center_x - tw / 2, y + 9);
+    const CanvasSnapshot& MonitorCanvas::shown_snapshot() const {
+        return snapshot_.fleet_view || host_ == local_host ? snapshot_ : remote_snapshot_;
     }
 
-    void MonitorCanvas::draw_ram_info(wxDC& dc, const Cards&, int info_x, int info_y) {
-        wxFont heading_font(title_font_size, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
-        wxFont info_font(12, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL);
+    // Called through CallAfter for every network sample, one history point each
+    void MonitorCanvas::sample_history() {
+        if constexpr (Monitor::has<Network>) {
+            if(sampler_.read<Network>(network_sample_, network_seen_)) {
+                snapshot_.download_rate = network_sample_.download_rate;
+                snapshot_.upload_rate = network_sample_.upload_rate;
+                snapshot_.update_network_history(snapshot_.download_rate / 1024.0, snapshot_.upload_rate / 1024.0);
+            }
+        }
+    }
 
-        dc.SetFont(heading_font);
-        dc.SetTextForeground(*wxBLACK);
+    void MonitorCanvas::on_iconize(wxIconizeEvent& event) {
+        update_power_mode();
+        event.Skip();
+    }
 
-        dc.DrawText("RAM informations:", info_x, info_y);
+    void MonitorCanvas::on_show(wxShowEvent& event) {
+        update_power_mode();
+        event.Skip();
+    }
 
-        unsigned long long total = monitor_.ram.total();
-        unsigned long long used = monitor_.ram.used();
-        unsigned long long free = monitor_.ram.free();
+    // Window managers usually (de)activate the frame on virtual desktop switches,
+    // so activation is used as an additional hint to re-check visibility
+    void MonitorCanvas::on_activate(wxActivateEvent& event) {
+        update_power_mode();
+        event.Skip();
+    }
 
-        int line_y = info_y + 35;
-        dc.SetFont(info_font);
+    // Switches between normal cadence and low-power mode
+    void MonitorCanvas::update_power_mode() {
+        bool background = IsIconized() || !IsShownOnScreen();
+        if(background == in_background_) return;
+        in_background_ = background;
+
+        // In background nothing is painted, only the network keeps being sampled
+        if(in_background_) {
+            timer_->Stop();
+            burst_.stop();
+            sampler_.set_background(true, std::chrono::milliseconds(background_history_ ? background_interval_ms_ : 0));
+            return;
+        }
 
-        dc.DrawText(wxString::Format("Total memory: %.2f GiB", static_cast<double>(total) / (1024.0 * 1024 * 1024)), info_x, line_y);
-        line_y += 25;
-        dc.DrawText(wxString::Format("Free memory: %.2f GiB", static_cast<double>(used) / (1024.0 * 1024 * 1024)), info_x, line_y);
-        line_y += 25;
-        dc.DrawText(wxString::Format("Used memory: %.2f GiB", static_cast<double>(free) / (1024.0 * 1024 * 1024)), info_x, line_y);
+        // Back in foreground: every collector is sampled again at once
+        sampler_.set_background(false);
+        if(burst_mode_) burst_.start();
+        sample_cards();
+        timer_->Start(foreground_interval_ms);
+        scroll_panel_->Refresh();
     }
 
-    void MonitorCanvas::draw_drive_info(wxDC& dc, const Cards&, int info_x, int info_y) {
-        wxFont heading_font(title_font_size, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
-        wxFont info_font(12, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL);
 
-        dc.SetFont(heading_font);
-        dc.SetTextForeground(*wxBLACK);
-
-        dc.DrawText("Drive informations:", info_x, info_y);
+    void MonitorCanvas::on_paint(wxPaintEvent&) {
+        // Paint-to-paint jitter against the timer cadence
+        auto now = std::chrono::steady_clock::now();
+        if(!in_background_ && last_paint_.time_since_epoch().count() != 0) {
+            auto interval = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_paint_).count();
+            auto expected = std::chrono::nanoseconds(std::chrono::milliseconds(foreground_interval_ms)).count();
+            instrumentation_.record(CanvasRenderer::probe_paint_jitter, static_cast<uint64_t>(std::abs(interval - expected)));
+        }
+        last_paint_ = now;
 
-        unsigned long long total = monitor_.drive.total();
-        unsigned long long used = monitor_.drive.used();
-        unsigned long long free = monitor_.drive.free();
+        wxPaintDC dc(scroll_panel_);
+        scroll_panel_->DoPrepareDC(dc);
 
-        wxCoord line_y = info_y + 35;
-        dc.SetFont(info_font);
+        int width, height;
+        scroll_panel_->GetClientSize(&width, &height);
+        int view_x, view_y;
+        scroll_panel_->CalcUnscrolledPosition(0, 0, &view_x, &view_y);
+        int scroll_height = renderer_.render(dc, wxSize(width, height), wxRect(view_x, view_y, width, height), shown_snapshot());
+        scroll_panel_->SetVirtualSize(wxSize(width, scroll_height));
 
-        dc.DrawText(wxString::Format("Total memory: %.2f GiB", static_cast<double>(total) / (1024.0 * 1024 * 1024)), info_x, line_y);
-        line_y += 25;
-        dc.DrawText(wxString::Format("Free memory: %.2f GiB", static_cast<double>(used) / (1024.0 * 1024 * 1024)), info_x, line_y);
-        line_y += 25;
-        dc.DrawText(wxString::Format("Used memory: %.2f GiB", static_cast<double>(free) / (1024.0 * 1024 * 1024)), info_x, line_y);
+        renderer_.draw_alerts_overlay(dc, view_x, view_y, width, snapshot_);
+        int overlay_y = view_y;
+        if(show_timings_)
+            overlay_y = renderer_.draw_timings_overlay(dc, view_x, view_y);
+        if(show_overhead_)
+            renderer_.draw_overhead_overlay(dc, view_x, overlay_y, snapshot_);
     }
 
-    void MonitorCanvas::draw_cpu_info(wxDC& dc, const Cards&, int info_x, int info_y) {
-        wxFont heading_font(title_font_size, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
-        wxFont info_font(12, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL);
-
-        dc.SetFont(heading_font);
-        dc.SetTextForeground(*wxBLACK);
-
-        dc.DrawText("CPU informations:", info_x, info_y);
-        int line_y = info_y + 28;
-
-        dc.SetFont(info_font);
-        wxString info_text = wxString::Format("Further Informations about CPU need to \nbe implemented.");
-        dc.DrawText(info_text, info_x, line_y);
+    // F12 toggles the timings overlay, Ctrl+O the monitor overhead panel, Ctrl+D dumps the
+    // timings and metric percentiles as JSON, Ctrl+B toggles burst mode, Ctrl+M the core
+    // heatmap, Ctrl+H and Ctrl+G switch hosts when listening for agents
+    void MonitorCanvas::on_key(wxKeyEvent& event) {
+        if(event.GetKeyCode() == WXK_F12) {
+            show_timings_ = !show_timings_;
+            scroll_panel_->Refresh();
+            return;
+        }
+        if(event.ControlDown() && event.GetKeyCode() == 'O') {
+            show_overhead_ = !show_overhead_;
+            scroll_panel_->Refresh();
+            return;
+        }
+        if(event.ControlDown() && event.GetKeyCode() == 'D') {
+            dump_timings();
+            dump_metrics();
+            return;
+        }
+        if(event.ControlDown() && event.GetKeyCode() == 'B') {
+            toggle_burst_mode();
+            return;
+        }
+        if(event.ControlDown() && event.GetKeyCode() == 'M') {
+            snapshot_.heatmap_view = !snapshot_.heatmap_view;
+            remote_snapshot_.heatmap_view = snapshot_.heatmap_view;
+            scroll_panel_->Refresh();
+            return;
+        }
+        if(aggregator_ && event.ControlDown() && event.GetKeyCode() == 'H') {
+            size_t next = host_ == local_host ? 0 : host_ + 1;
+            show_host(next < aggregator_->host_count() ? next : local_host);
+            return;
+        }
+        if(aggregator_ && event.ControlDown() && event.GetKeyCode() == 'G') {
+            toggle_fleet_view();
+            return;
+        }
+        event.Skip();
     }
 
-    void MonitorCanvas::draw_system_infos(wxDC& dc, int info_x, int info_y) {
-        wxFont heading_font(title_font_size, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
-        wxFont subheading_font(12, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
-        wxFont info_font(12, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL);
-
-        dc.SetFont(heading_font);
-        dc.SetTextForeground(*wxBLACK);
+    void MonitorCanvas::dump_timings() {
+        std::ofstream file(timings_file);
+        if(!file.is_open()) {
+            wxLogError("Could not write %s", timings_file);
+            return;
+        }
+        instrumentation_.write_json(file);
+    }
 
-        dc.DrawText("General informations:", info_x, info_y);
+    void MonitorCanvas::dump_metrics() {
+        std::ofstream file(metrics_file);
+        if(!file.is_open()) {
+            wxLogError("Could not write %s", metrics_file);
+            return;
+        }
+        sampler_.with_metrics([&](const MetricTable& metrics, auto now) { metrics.write_json(file, now); });
+    }
 
-        unsigned int core_num = monitor_.general.get_cpu_cores();
-        wxString model_name = monitor_.general.get_cpu_model();
-        wxString product_name = monitor_.general.get_product_name();
-        wxString kde_version = monitor_.general.get_os_version();
-        wxString kernel_version = monitor_.general.get_kernel_version();
+    void MonitorCanvas::on_click(wxMouseEvent& event) {
+        int x, y;
+        scroll_panel_->CalcUnscrolledPosition(event.GetX(), event.GetY(), &x, &y);
 
-        unsigned long uptime = monitor_.general.get_uptime();
-        unsigned long procs_num = monitor_.general.get_procs_num();
+        if(snapshot_.fleet_view) {
+            size_t host = renderer_.fleet_host_at(x, y);
+            if(host != CanvasSnapshot::no_fleet_host) show_host(host);
+            return;
+        }
+        if(renderer_.toggle_show_more(x, y))
+            scroll_panel_->Refresh();
+    }
 
-        int line_y = info_y + 40;
+    void MonitorCanvas::on_motion(wxMouseEvent& event) {
+        int x, y;
+        scroll_panel_->CalcUnscrolledPosition(event.GetX(), event.GetY(), &x, &y);
 
-        dc.SetFont(info_font);
+        if(renderer_.update_hover(x, y)) {
+            scroll_panel_->SetCursor(renderer_.hovering() ? wxCursor(wxCURSOR_HAND) : wxNullCursor);
+            scroll_panel_->Refresh();
+        }
+        event.Skip();
+    }
 
-        wxString cpus = wxString::Format("Processors: %u x " + model_name, core_num);
-        wxString product_text = wxString::Format("Productname: " + product_name);
-        wxString os_version_text = wxString::Format("KDE-Plasma-Version: " + kde_version);;
-        wxString kernel_text = wxString::Format("Kernel-Version: " + kernel_version);
-        wxString uptime_text = wxString::Format("System uptime since boot (seconds): %llu", uptime);
-        wxString procs_text = wxString::Format("Number of processes running: %llu", procs_num);
-        dc.SetFont(subheading_font);
-        dc.DrawText("Hardware:", info_x , line_y);
-        dc.SetFont(info_font);
-        line_y += spacing;
-        dc.DrawText(cpus, info_x, line_y);
-        line_y += spacing;
-        dc.DrawText(product_text, info_x, line_y);
-        line_y += spacing + 2;
-        dc.SetFont(subheading_font);
-        dc.DrawText("Software:", info_x, line_y);
-        dc.SetFont(info_font);
-        line_y += spacing;
-        dc.DrawText(os_version_text, info_x, line_y);
-        line_y += spacing;
-        dc.DrawText(kernel_text, info_x, line_y);
-        line_y += spacing + 2;
-        dc.SetFont(subheading_font);
-        dc.DrawText("Other:", info_x, line_y);
-        dc.SetFont(info_font);
-        line_y += spacing;
-        dc.DrawText(uptime_text, info_x, line_y);
-        line_y += spacing;
-        dc.DrawText(procs_text, info_x, line_y);
-    }
-
-    void MonitorCanvas::draw_network_infos(wxDC& dc, int info_x, int info_y, int width) {
-        wxFont heading_font(title_font_size, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
-        wxFont subheading_font(12, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
-        wxFont info_font(12, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL);
-
-        dc.SetFont(heading_font);
-        dc.SetTextForeground(*wxBLACK);
-
-        double download_rate = monitor_.network.get_download_rate();
-        double upload_rate = monitor_.network.get_upload_rate();
-
-        wxString dowload_text = wxString::Format("Download: %.1f KiB/s", download_rate);
-        wxString upload_text = wxString::Format("Upload: under construction");
-
-        int download_text_width, download_text_height;
-        dc.GetTextExtent(dowload_text, &download_text_width, &download_text_height);
-
-        dc.DrawText("Network informations:", info_x, info_y);
-        dc.SetFont(subheading_font);
-
-        int line_y = info_y + 40;
-
-        dc.DrawText(dowload_text, info_x, line_y);
-        dc.DrawText(upload_text, info_x + 10 * spacing, line_y);
-        line_y += spacing;
-
-        // Network Graph
-        int graph_x = info_x;
-        int graph_y = line_y;
-        int graph_width = width - 2 * spacing;
-        int graph_height = 200;
-        draw_network_graph(dc, graph_x, graph_y, graph_width, graph_height);
-    }
-
-    void MonitorCanvas::draw_network_graph(wxDC& dc, int x, int y, int w, int h){
-        // Background square
-        dc.SetPen(wxPen(wxColour(50, 50, 60)));
-        dc.SetBrush(wxBrush(wxColour(35, 35, 45)));
-        dc.DrawRectangle(x, y, w, h);
-
-        // Lines
-        dc.SetPen(wxPen(wxColour(60, 60, 80)));
-        for(int i = 1; i < 5; ++i){
-            int yline = y + h * i / 5;
-            dc.DrawLine(x, yline, x + w, yline);
-        }
-
-        double max_val = 0.0;
-        size_t points = network_graph_full_ ? network_history_length :network_graph_index_;
-        for(size_t i = 0; i < points; ++i) {
-            max_val = std::max({max_val, download_history_[i], upload_history_[i]});
-        }
-        if(max_val < 1e-6) max_val = 1.0;
-
-        // Download Line (green)
-        dc.SetPen(wxPen(wxColour(80, 220, 60), 2));
-        for(size_t i = 1; i < points; ++i) {
-            int idx0 = (network_graph_index_ + i - 1) % network_history_length;
-            int idx1 = (network_graph_index_ + i) % network_history_length;
-            int x0 = x + (w * (i - 1)) / (network_history_length - 1);
-            int x1 = x + (w * i) / (network_history_length - 1);
-            int y0 = y + h - int(h * std::min(download_history_[idx0] /max_val, 1.0));
-            int y1 = y + h - int(h * std::min(download_history_[idx1] /max_val, 1.0));
-            dc.DrawLine(x0, y0, x1, y1);
-        }
-
-        dc.SetTextForeground(*wxWHITE);
-        dc.DrawText(wxString::Format("%.1f MiB/s", max_val), x, y);
+    void MonitorCanvas::on_leave(wxMouseEvent& event) {
+        if(renderer_.update_hover(-1, -1)) {
+            scroll_panel_->SetCursor(wxNullCursor);
+            scroll_panel_->Refresh();
+        }
+        event.Skip();
     }
     } // namespace system_monitor
@@ -1,65 +1,150 @@
 #ifndef MONITOR_CANVAS_HPP
 #define MONITOR_CANVAS_HPP
 
+#include <chrono>
 #include <cstddef>
+#include <memory>
 #include <wx/wx.h>
-#include <vector>
 #include "system_monitor.hpp"
+#include "sampler.hpp"
+#include "aggregator.hpp"
+#include "alert_hook.hpp"
+#include "burst_sampler.hpp"
+#include "instrumentation.hpp"
+#include "canvas_snapshot.hpp"
+#include "canvas_renderer.hpp"
 
 namespace system_monitor {
     class MonitorCanvas : public wxFrame {
         public:
             MonitorCanvas(const wxString& title);
 
+            // Low-power mode while the window is iconized or hidden: the network is
+            // sampled every interval_ms (--background-interval), its history is
+            // recorded unless record is false (--background-history off)
+            void set_background_interval(int interval_ms);
+            void set_background_history(bool record);
+
+            // Share of one core the sampler may use before it stretches the
+            // periods of its costliest collectors, 0 for no limit
+            void set_overhead_budget(double share) { sampler_.set_overhead_budget(share); }
+
+            // Receives agents on port (--listen); Ctrl+H cycles through their
+            // hosts, Ctrl+G shows the fleet grid. False if the port is taken.
+            bool listen(uint16_t port);
+
+            // Remote view (--connect): shows an agent started with --listen,
+            // redialing while it is unreachable. False if address does not resolve.
+            bool connect(const std::string& address, uint16_t port);
+
         private:
-            struct Cards {
-                wxString label;
-                wxRect rect;
-                bool expanded = false;
-                double usage = 0.0;
-            };
-
-            static constexpr int n_cards = 3;               // number of n_cards
-            static constexpr int spacing = 30;              // spacing between n_cards
-            static constexpr int title_font_size = 14;
-            static constexpr int percent_font_size = 18;
-            static constexpr int network_history_length = 60;
-
-            Monitor monitor_;
+            static constexpr int foreground_interval_ms = 500;
+
+            AlertHook alert_hook_;          // before the sampler, whose thread delivers to it
+            Sampler<Monitor> sampler_;
             wxScrolledWindow* scroll_panel_;
             wxTimer* timer_;
-            Cards cards_[n_cards];
 
-            std::vector<double> download_history_;
-            std::vector<double> upload_history_;
-            size_t network_graph_index_ = 0;
-            bool network_graph_full_ = false;
+            CanvasSnapshot snapshot_;
+
+            // Last sample read from the sampler and its generation, per collector
+            Cpu::Sample cpu_sample_;
+            Ram::Sample ram_sample_;
+            Drive::Sample drive_sample_;
+            General::Sample general_sample_;
+            Network::Sample network_sample_;
+            Cgroups::Sample cgroups_sample_;
+            Softirqs::Sample softirqs_sample_;
+            Scheduler::Sample scheduler_sample_;
+            NumaMemory::Sample numa_sample_;
+            Thermal::Sample thermal_sample_;
+            uint64_t cpu_seen_ = 0;
+            uint64_t ram_seen_ = 0;
+            uint64_t drive_seen_ = 0;
+            uint64_t general_seen_ = 0;
+            uint64_t network_seen_ = 0;
+            uint64_t cgroups_seen_ = 0;
+            uint64_t softirqs_seen_ = 0;
+            uint64_t scheduler_seen_ = 0;
+            uint64_t numa_seen_ = 0;
+            uint64_t thermal_seen_ = 0;
+            Overhead overhead_;
+            uint64_t overhead_seen_ = 0;
 
-            bool is_expanded_ = true;
+            // Burst capture of the CPU usage, toggled with Ctrl+B, paused in background
+            BurstSampler burst_;
+            BurstSampler::Summary burst_summary_;
+            uint64_t burst_seen_ = 0;
+            bool burst_mode_ = false;
 
-            wxRect get_show_more_rect(const Cards& card, wxDC& dc) const;
+            // Metrics shown with percentiles, looked up once in the sampler's table
+            MetricTable::Id cpu_metric_ = MetricTable::no_metric;
+            MetricTable::Id ram_metric_ = MetricTable::no_metric;
+            MetricTable::Id download_metric_ = MetricTable::no_metric;
+            MetricTable::Id upload_metric_ = MetricTable::no_metric;
+            std::vector<MetricTable::Id> core_metrics_;
+            std::vector<uint32_t> core_metric_cpu_ids_;     // cpu ids core_metrics_ were looked up for
+
+            // Remote hosts, re-read when the aggregator's generation changes
+            static constexpr size_t local_host = CanvasSnapshot::no_fleet_host;
+            std::unique_ptr<Aggregator> aggregator_;
+            size_t host_ = local_host;              // host shown, index in the aggregator
+            uint64_t aggregator_seen_ = 0;
+            CanvasSnapshot remote_snapshot_;
+            Aggregator::Host remote_host_;
+            Aggregator::History remote_history_;
+            uint64_t remote_heatmap_samples_ = 0;       // samples of the host when its last heatmap column was pushed
+            std::vector<Aggregator::Host> fleet_hosts_;
+            std::vector<float> percentile_scratch_;
+            wxString title_;
+
+            // Agent dialed by connect(), shown as soon as its hello arrives
+            static constexpr std::chrono::seconds redial_interval{5};
+            std::string remote_address_;
+            uint16_t remote_port_ = 0;
+            bool follow_remote_ = false;
+            std::chrono::steady_clock::time_point redial_at_{};
+
+            bool in_background_ = false;
+            int background_interval_ms_ = 5000;    // network sampling cadence while in background
+            bool background_history_ = true;       // keep recording network history in background
+
+            Instrumentation instrumentation_;
+            CanvasRenderer renderer_;
+            bool show_timings_ = false;
+            bool show_overhead_ = false;
+            std::chrono::steady_clock::time_point last_paint_{};
 
             void on_paint(wxPaintEvent& event);
             void on_timer(wxTimerEvent& event);
             void on_click(wxMouseEvent& event);
+            void on_motion(wxMouseEvent& event);
+            void on_leave(wxMouseEvent& event);
+            void on_iconize(wxIconizeEvent& event);
+            void on_show(wxShowEvent& event);
+            void on_activate(wxActivateEvent& event);
+            void on_key(wxKeyEvent& event);
 
-            void render (wxDC& dc);
-
-            void draw_card(wxDC& dc, Cards& card, int base_cardHeight);
-            void draw_info_section(wxDC& dc, int x, int y, int w, int h, bool is_general);
-            void draw_usage_circle(wxDC& dc, int center_x, int center_y, int radius, double usage, const wxColour& color, const wxString& usage_text);
-            void draw_network_graph(wxDC& dc, int x, int y, int w, int h);
-            void draw_title(wxDC&, int x, int y, const wxString& label, int box_width);
-            void draw_percentage_text(wxDC& dc, int center_x, int center_y, const wxString& usage_text);
-            void draw_show_more_text(wxDC& dc, int center_x, int y, bool expanded);
+            void load_alert_rules();
+            void on_alerts(const AlertRules& rules, std::span<const AlertEvent> events);
 
-            void draw_ram_info(wxDC& dc, const Cards& card, int info_x, int info_y);
-            void draw_drive_info(wxDC& dc, const Cards& card, int info_x, int info_y);
-            void draw_cpu_info(wxDC& dc, const Cards& card, int info_x, int info_y);
-            void draw_system_infos(wxDC& dc, int info_x, int info_y);
-            void draw_network_infos(wxDC& dc, int info_x, int info_y, int width);
+            void update_power_mode();
+            void sample_cards();
+            void sample_history();
+            void update_services();
+            void update_burst();
+            void update_percentiles();
+            void update_overhead();
+            void toggle_burst_mode();
+            void update_remote(bool force = false);
+            void redial();
+            void update_remote_snapshot();
+            void show_host(size_t host);
+            void toggle_fleet_view();
+            const CanvasSnapshot& shown_snapshot() const;
 
-            void update_network_histroy(double  download, double upload);
+            void dump_timings();
+            void dump_metrics();
     };
 }
 
@@ -0,0 +1,119 @@
+#include "numa_memory.hpp"
+#include "procfs_parse.hpp"
+#include "sysfs.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace system_monitor {
+
+    namespace {
+        // Value of a "key value" line of numastat
+        unsigned long long numastat_value(std::string_view text, std::string_view key) {
+            std::string_view line;
+            while(next_line(text, line)) {
+                if(line.size() > key.size() && line.starts_with(key) && line[key.size()] == ' ')
+                    return parse_number(line.substr(key.size()));
+            }
+            return 0;
+        }
+    }
+
+    NumaMemory::NumaMemory(std::string root) : root_(std::move(root)) {}
+
+    void NumaMemory::attach(ProcfsReader& reader) {
+        reader_.attach(reader);
+        files_.clear();
+        last_.nodes.clear();
+        discovered_ = false;
+        counters_seen_ = false;
+    }
+
+    void NumaMemory::prefetch() {
+        reader_.prefetch();
+    }
+
+    void NumaMemory::sample() {
+        // Nodes only change with memory hotplug, they are listed once
+        if(!discovered_) discover();
+        reader_.read();
+
+        auto now = std::chrono::steady_clock::now();
+        double seconds = counters_seen_ ? std::chrono::duration<double>(now - last_time_).count() : 0.0;
+        last_time_ = now;
+        for(size_t i = 0; i < files_.size(); ++i)
+            read_node(i, seconds);
+        counters_seen_ = true;
+    }
+
+    // "Node 0 MemTotal:       32734356 kB" lines and numastat counters
+    void NumaMemory::read_node(size_t index, double seconds) {
+        Node& node = last_.nodes[index];
+        Files& files = files_[index];
+
+        std::string_view meminfo = reader_.data(files.meminfo);
+        std::string_view line;
+        while(next_line(meminfo, line)) {
+            FieldScanner fields(line);
+            std::string_view key;
+            unsigned long long kib = 0;
+            if(!fields.skip(2) || !fields.next(key) || !fields.next(kib)) continue;
+            if(key == "MemTotal:") node.total = kib * 1024;
+            else if(key == "MemFree:") node.free = kib * 1024;
+            else if(key == "FilePages:") node.file_pages = kib * 1024;
+            else if(key == "AnonPages:") node.anon_pages = kib * 1024;
+            else if(key == "Shmem:") node.shmem = kib * 1024;
+        }
+        unsigned long long droppable = node.file_pages > node.shmem ? node.file_pages - node.shmem : 0;
+        node.available = std::min(node.total, node.free + droppable);
+        node.usage = node.total != 0 ? static_cast<double>(node.total - node.available) / static_cast<double>(node.total) : 0.0;
+
+        std::string_view numastat = reader_.data(files.numastat);
+        unsigned long long counters[n_counters] = {numastat_value(numastat, "numa_hit"), numastat_value(numastat, "numa_miss"),
+                                                   numastat_value(numastat, "numa_foreign")};
+        double* rates[n_counters] = {&node.hit_rate, &node.miss_rate, &node.foreign_rate};
+        for(size_t counter = 0; counter < n_counters; ++counter) {
+            bool valid = seconds > 0.0 && counters[counter] >= files.counters[counter];
+            *rates[counter] = valid ? static_cast<double>(counters[counter] - files.counters[counter]) / seconds : 0.0;
+            files.counters[counter] = counters[counter];
+        }
+    }
+
+    void NumaMemory::record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now) {
+        const auto& nodes = last_.nodes;
+        if(metric_ids_.size() != nodes.size() * 2) {
+            metric_ids_.resize(nodes.size() * 2);
+            for(size_t i = 0; i < nodes.size(); ++i) {
+                std::string prefix = "mem.node" + std::to_string(nodes[i].id);
+                metric_ids_[i * 2] = metrics.add(prefix + ".usage");
+                metric_ids_[i * 2 + 1] = metrics.add(prefix + ".misses");
+            }
+        }
+        for(size_t i = 0; i < nodes.size(); ++i) {
+            metrics.record(metric_ids_[i * 2], nodes[i].usage * 100.0, now);
+            metrics.record(metric_ids_[i * 2 + 1], nodes[i].miss_rate, now);
+        }
+    }
+
+    // Opens meminfo and numastat of every node; nodes without memory (CPU-only) report zeros
+    void NumaMemory::discover() {
+        reader_.close_all();
+        files_.clear();
+        last_.nodes.clear();
+        for(uint32_t id : numbered_entries(root_, "node")) {
+            std::string dir = root_ + "/node" + std::to_string(id) + "/";
+            Files files;
+            files.meminfo = reader_.open((dir + "meminfo").c_str());
+            files.numastat = reader_.open((dir + "numastat").c_str());
+            if(files.meminfo < 0) {
+                reader_.close(files.numastat);
+                continue;
+            }
+            Node node;
+            node.id = id;
+            last_.nodes.push_back(node);
+            files_.push_back(files);
+        }
+        discovered_ = true;
+        counters_seen_ = false;
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef NUMA_MEMORY_HPP
+#define NUMA_MEMORY_HPP
+#include <chrono>
+#include <string>
+#include <vector>
+#include "metrics.hpp"
+#include "procfs_reader.hpp"
+
+namespace system_monitor {
+
+    class NumaMemory {      // memory and NUMA allocation counters per node
+        public:
+            static constexpr std::chrono::milliseconds period{1000};
+            static constexpr const char* name = "numa";
+
+            struct Node {
+                unsigned id = 0;                    // the N of nodeN
+                unsigned long long total = 0;       // bytes
+                unsigned long long free = 0;
+                unsigned long long file_pages = 0;  // page cache
+                unsigned long long anon_pages = 0;
+                unsigned long long shmem = 0;       // part of file_pages that cannot be dropped
+                // free plus the droppable page cache: node meminfo has no
+                // MemAvailable, and like Ram::usage the cache is not "used",
+                // otherwise every node of a cache-heavy host reads ~100%
+                unsigned long long available = 0;
+                double usage = 0.0;                 // (total - available) / total
+
+                // Pages per second over the last interval, from numastat:
+                // hits were allocated here as intended, misses were meant for
+                // another node but landed here, foreign ones were meant for
+                // this node but landed elsewhere
+                double hit_rate = 0.0;
+                double miss_rate = 0.0;
+                double foreign_rate = 0.0;
+            };
+
+            struct Sample {
+                std::vector<Node> nodes;            // in id order, one on non-NUMA machines
+            };
+
+            NumaMemory() : NumaMemory("/sys/devices/system/node") {}
+            explicit NumaMemory(std::string root);        // e.g. a test tree
+
+            NumaMemory(const NumaMemory&) = delete;
+            NumaMemory& operator=(const NumaMemory&) = delete;
+
+            void sample();
+            const Sample& last() const { return last_; }
+
+            void attach(ProcfsReader& reader);
+            void prefetch();
+
+            void record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now);     // percent, pages/s
+
+        private:
+            enum Counter { hits, misses, foreign, n_counters };
+
+            struct Files {
+                int meminfo = -1;
+                int numastat = -1;
+                unsigned long long counters[n_counters] = {};
+            };
+
+            std::string root_;
+            Sample last_;
+            std::vector<Files> files_;          // parallel to last_.nodes
+            bool discovered_ = false;
+            bool counters_seen_ = false;
+            std::chrono::steady_clock::time_point last_time_{};
+
+            ProcfsFileSet reader_;
+
+            std::vector<MetricTable::Id> metric_ids_;       // usage and misses per node
+
+            void discover();
+            void read_node(size_t index, double seconds);
+    };
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include "catch_amalgamated.hpp"
+#include "numa_memory.hpp"
+#include "temp_tree_tests.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace {
+    using system_monitor::MetricTable;
+    using system_monitor::NumaMemory;
+    using system_monitor::ProcfsReader;
+    using namespace std::chrono_literals;
+
+    // /sys/devices/system/node-like tree in a temporary directory
+    struct FakeNodes : system_monitor::testing::TempTree {
+        FakeNodes() : TempTree("numa_test") {
+            std::filesystem::create_directories(root / "power");        // not a node
+            std::ofstream(root / "possible") << "0-1\n";
+        }
+
+        void meminfo(unsigned id, unsigned long long total_kib, unsigned long long free_kib, unsigned long long file_kib = 0,
+                     unsigned long long anon_kib = 0, unsigned long long shmem_kib = 0) {
+            auto dir = root / ("node" + std::to_string(id));
+            std::filesystem::create_directories(dir);
+            std::string node = "Node " + std::to_string(id) + " ";
+            std::ofstream(dir / "meminfo") << node << "MemTotal:       " << total_kib << " kB\n"
+                                           << node << "MemFree:        " << free_kib << " kB\n"
+                                           << node << "MemUsed:        " << total_kib - free_kib << " kB\n"
+                                           << node << "FilePages:      " << file_kib << " kB\n"
+                                           << node << "AnonPages:      " << anon_kib << " kB\n"
+                                           << node << "Shmem:          " << shmem_kib << " kB\n"
+                                           << node << "HugePages_Total:     0\n";
+        }
+
+        void numastat(unsigned id, unsigned long long hit, unsigned long long miss, unsigned long long foreign) {
+            std::ofstream(root / ("node" + std::to_string(id)) / "numastat")
+                << "numa_hit " << hit << "\nnuma_miss " << miss << "\nnuma_foreign " << foreign
+                << "\ninterleave_hit 0\nlocal_node " << hit << "\nother_node " << miss << "\n";
+        }
+    };
+}
+
+// NumaMemory Tests
+TEST_CASE("NumaMemory nodes", "[numa]") {
+    FakeNodes sysfs;
+    sysfs.meminfo(1, 8 * 1024 * 1024, 2 * 1024 * 1024, 1024 * 1024, 4 * 1024 * 1024, 256 * 1024);
+    sysfs.numastat(1, 5000, 100, 0);
+    sysfs.meminfo(0, 16 * 1024 * 1024, 12 * 1024 * 1024, 1024 * 1024, 2048);
+    sysfs.numastat(0, 9000, 0, 100);
+
+    ProcfsReader reader(ProcfsReader::Backend::pread);
+    NumaMemory numa(sysfs.root.string());
+    numa.attach(reader);
+    numa.sample();
+    const auto& nodes = numa.last().nodes;
+    REQUIRE(nodes.size() == 2);
+    CHECK(nodes[0].id == 0);
+    CHECK(nodes[0].total == 16ull << 30);
+    CHECK(nodes[0].free == 12ull << 30);
+    CHECK(nodes[0].file_pages == 1ull << 30);
+    CHECK(nodes[0].anon_pages == 2048ull << 10);
+    CHECK(nodes[0].available == 13ull << 30);
+    CHECK(nodes[0].usage == Catch::Approx(0.1875));        // the page cache is not used memory
+    CHECK(nodes[1].id == 1);
+    CHECK(nodes[1].shmem == 256ull << 20);
+    CHECK(nodes[1].usage == Catch::Approx(5.25 / 8));       // shmem cannot be dropped
+    CHECK(nodes[1].miss_rate == 0.0);           // no interval yet
+    size_t files = reader.size();
+
+    // Counters become rates, the files are re-read through the open descriptors
+    std::this_thread::sleep_for(20ms);
+    sysfs.meminfo(1, 8 * 1024 * 1024, 1024 * 1024);
+    sysfs.numastat(1, 6000, 600, 0);
+    sysfs.numastat(0, 9500, 0, 600);
+    numa.prefetch();
+    reader.read_queued();
+    numa.sample();
+    CHECK(reader.size() == files);
+    CHECK(nodes[1].free == 1ull << 30);
+    CHECK(nodes[1].usage == Catch::Approx(0.875));
+    CHECK(nodes[1].hit_rate > 0.0);
+    CHECK(nodes[1].miss_rate == Catch::Approx(nodes[1].hit_rate / 2));
+    CHECK(nodes[0].foreign_rate == Catch::Approx(nodes[1].miss_rate));
+    CHECK(nodes[0].miss_rate == 0.0);
+
+    // A node full of page cache is not exhausted
+    sysfs.meminfo(0, 16 * 1024 * 1024, 512 * 1024, 14 * 1024 * 1024, 1024 * 1024);
+    numa.sample();
+    CHECK(nodes[0].usage == Catch::Approx(1.5 / 16));
+
+    MetricTable metrics;
+    numa.record_metrics(metrics, std::chrono::steady_clock::now());
+    REQUIRE(metrics.find("mem.node1.usage") != MetricTable::no_metric);
+    CHECK(metrics.last(metrics.find("mem.node1.usage")) == Catch::Approx(87.5));
+    REQUIRE(metrics.find("mem.node0.misses") != MetricTable::no_metric);
+    CHECK(metrics.last(metrics.find("mem.node0.misses")) == 0.0);
+}
+
+// CPU-only nodes, missing numastat files and a missing tree
+TEST_CASE("NumaMemory partial", "[numa]") {
+    FakeNodes sysfs;
+    sysfs.meminfo(0, 4 * 1024 * 1024, 1024 * 1024);
+    sysfs.meminfo(2, 0, 0);
+
+    NumaMemory numa(sysfs.root.string());
+    numa.sample();
+    numa.sample();
+    const auto& nodes = numa.last().nodes;
+    REQUIRE(nodes.size() == 2);
+    CHECK(nodes[0].usage == Catch::Approx(0.75));
+    CHECK(nodes[0].hit_rate == 0.0);
+    CHECK(nodes[1].id == 2);
+    CHECK(nodes[1].total == 0);
+    CHECK(nodes[1].usage == 0.0);
+
+    NumaMemory missing((sysfs.root / "missing").string());
+    missing.sample();
+    CHECK(missing.last().nodes.empty());
+}
+
+// The system's nodes, at least node0 where sysfs has them
+TEST_CASE("NumaMemory system", "[numa]") {
+    NumaMemory numa;
+    numa.sample();
+    for(const auto& node : numa.last().nodes) {
+        CHECK(node.free <= node.total);
+        CHECK(node.usage >= 0.0);
+        CHECK(node.usage <= 1.0);
+    }
+}
@@ -0,0 +1,144 @@
+#ifndef PROCFS_PARSE_HPP
+#define PROCFS_PARSE_HPP
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace system_monitor {
+
+    // Allocation-free scanning of procfs and sysfs text. Lines and fields are
+    // views into the buffer the file was read into (usually a ProcfsReader's),
+    // numbers are parsed eight digits at a time.
+
+    // Splits the next line off text, like std::getline
+    inline bool next_line(std::string_view& text, std::string_view& line) {
+        if(text.empty()) return false;
+        size_t end = text.find('\n');
+        line = text.substr(0, end);
+        text = end == std::string_view::npos ? std::string_view{} : text.substr(end + 1);
+        return true;
+    }
+
+    namespace detail {
+        // Number of leading ASCII digits of eight bytes loaded little-endian.
+        // A byte is a digit if its high nibble is 3 and adding 6 keeps it 3;
+        // carries out of a byte only reach the bytes after a non-digit.
+        inline unsigned leading_digits(uint64_t chunk) {
+            uint64_t high = chunk & 0xF0F0F0F0F0F0F0F0;
+            uint64_t carried = (chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0;
+            uint64_t non_digits = (high | carried >> 4) ^ 0x3333333333333333;
+            return non_digits == 0 ? 8 : static_cast<unsigned>(std::countr_zero(non_digits)) / 8;
+        }
+
+        // Value of the first count (1 to 8) digits of a chunk: the digits are
+        // moved to the top with zeros before them, then pairs, quads and
+        // octets are combined with three multiplications
+        inline uint64_t digits_value(uint64_t chunk, unsigned count) {
+            chunk = (chunk & 0x0F0F0F0F0F0F0F0F) << (8 * (8 - count));
+            chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FF;
+            chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFF;
+            return (chunk * 10000 + (chunk >> 32)) & 0xFFFFFFFF;
+        }
+
+        inline constexpr uint64_t powers_of_ten[9] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+    }
+
+    // Parses the unsigned decimal number starting at p, like std::from_chars.
+    // Returns the position after it, p itself if there is none; value is
+    // left alone then and on overflow.
+    inline const char* parse_number(const char* p, const char* end, unsigned long long& value) {
+        if constexpr (std::endian::native != std::endian::little) {
+            return std::from_chars(p, end, value).ptr;
+        } else {
+            const char* start = p;
+            unsigned long long result = 0;
+            while(end - p >= 8) {
+                uint64_t chunk;
+                std::memcpy(&chunk, p, 8);
+                unsigned count = detail::leading_digits(chunk);
+                if(count == 0) break;
+                result = result * detail::powers_of_ten[count] + detail::digits_value(chunk, count);
+                p += count;
+                if(count < 8) break;
+            }
+            if(end - p < 8) {           // the last bytes of the buffer
+                for(; p < end && *p >= '0' && *p <= '9'; ++p)
+                    result = result * 10 + static_cast<unsigned long long>(*p - '0');
+            }
+            if(p == start) return start;
+            if(p - start > 19) return std::from_chars(start, end, value).ptr;     // may not fit, checked the slow way
+            value = result;
+            return p;
+        }
+    }
+
+    // Skips the blanks before a number and parses it; returns the position
+    // after the number, p itself if there is none
+    inline const char* scan_number(const char* p, const char* end, unsigned long long& value) {
+        const char* start = p;
+        while(p < end && (*p == ' ' || *p == '\t')) ++p;
+        const char* after = parse_number(p, end, value);
+        return after == p ? start : after;
+    }
+
+    // The number at the start of text after any blanks, 0 if there is none
+    inline unsigned long long parse_number(std::string_view text) {
+        unsigned long long value = 0;
+        scan_number(text.data(), text.data() + text.size(), value);
+        return value;
+    }
+
+    // Blank-separated fields of a line, e.g. the columns of /proc/net/dev or /proc/mounts
+    class FieldScanner {
+        public:
+            explicit FieldScanner(std::string_view line) : p_(line.data()), end_(line.data() + line.size()) {}
+
+            // Next field, false at the end of the line
+            bool next(std::string_view& field) {
+                skip_blanks();
+                if(p_ == end_) return false;
+                const char* start = p_;
+                while(p_ < end_ && *p_ != ' ' && *p_ != '\t') ++p_;
+                field = std::string_view(start, static_cast<size_t>(p_ - start));
+                return true;
+            }
+
+            // Next field as a number; false, and the field is left unread, if it is not one
+            bool next(unsigned long long& value) {
+                const char* after = scan_number(p_, end_, value);
+                if(after == p_) return false;
+                p_ = after;
+                return true;
+            }
+
+            // Skips fields, false if the line has fewer
+            bool skip(size_t fields) {
+                std::string_view field;
+                for(size_t i = 0; i < fields; ++i) {
+                    if(!next(field)) return false;
+                }
+                return true;
+            }
+
+            // Moves past the next c, e.g. the colon after a key; false, and at the end, without one
+            bool skip_past(char c) {
+                const void* found = p_ < end_ ? std::memchr(p_, c, static_cast<size_t>(end_ - p_)) : nullptr;
+                p_ = found ? static_cast<const char*>(found) + 1 : end_;
+                return found != nullptr;
+            }
+
+            std::string_view rest() const { return std::string_view(p_, static_cast<size_t>(end_ - p_)); }
+
+        private:
+            const char* p_;
+            const char* end_;
+
+            void skip_blanks() {
+                while(p_ < end_ && (*p_ == ' ' || *p_ == '\t')) ++p_;
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,194 @@
+#include "catch_amalgamated.hpp"
+#include "procfs_parse.hpp"
+#include "system_monitor.hpp"
+#include <charconv>
+#include <chrono>
+#include <random>
+#include <string>
+#include <string_view>
+
+namespace {
+    using system_monitor::FieldScanner;
+    using namespace std::chrono_literals;
+
+    // /proc/stat of a machine with this many CPUs
+    std::string large_stat(size_t cpus, unsigned long long base) {
+        std::string stat = "cpu  " + std::to_string(base * cpus) + " 1234 987654 " + std::to_string(base * cpus * 8)
+                           + " 5432 0 4321 0 0 0\n";
+        for(size_t cpu = 0; cpu < cpus; ++cpu)
+            stat += "cpu" + std::to_string(cpu) + " " + std::to_string(base + cpu) + " 12 9876 " + std::to_string(base * 8)
+                    + " 54 0 43 0 0 0\n";
+        stat += "intr 1234567890";
+        for(size_t i = 0; i < 1024; ++i)
+            stat += i % 7 == 0 ? " 123456" : " 0";
+        stat += "\nctxt 9876543210\nbtime 1700000000\nprocesses 4567890\nprocs_running 3\nprocs_blocked 0\n"
+                "softirq 123456789 1 2 3 4 5 6 7 8 9 10\n";
+        return stat;
+    }
+
+    // /proc/interrupts layout: a CPU header, then one counter per CPU and a description
+    std::string large_interrupts(size_t cpus, size_t lines) {
+        std::string text = "     ";
+        for(size_t cpu = 0; cpu < cpus; ++cpu)
+            text += "      CPU" + std::to_string(cpu);
+        text += "\n";
+        for(size_t line = 0; line < lines; ++line) {
+            text += std::to_string(line) + ":";
+            for(size_t cpu = 0; cpu < cpus; ++cpu)
+                text += " " + std::to_string((line * 7919 + cpu * 104729) % 100000000);
+            text += "  IR-PCI-MSI 1048576-edge      nvme0q" + std::to_string(line) + "\n";
+        }
+        return text;
+    }
+
+    std::string large_net_dev(size_t interfaces) {
+        std::string text = "Inter-|   Receive                                                |  Transmit\n"
+                           " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n";
+        for(size_t i = 0; i < interfaces; ++i)
+            text += "veth" + std::to_string(i) + ": " + std::to_string(123456789012ull + i) + " 4567890 0 0 0 0 0 0 "
+                    + std::to_string(98765432109ull + i) + " 3456789 0 0 0 0 0 0\n";
+        return text;
+    }
+}
+
+// parse_number Tests
+// same results as std::from_chars at every length and buffer position
+TEST_CASE("parse_number matches from_chars", "[procfs_parse]") {
+    std::mt19937_64 random(42);
+    for(int i = 0; i < 20000; ++i) {
+        unsigned long long expected = random() >> (random() % 64);
+        std::string digits = std::to_string(expected);
+        // the number at the end of the buffer, or followed by a separator and padding
+        std::string text = std::string(random() % 9, ' ') + digits;
+        if(random() % 2) text += (random() % 2 ? " 42" : ":x") + std::string(random() % 9, '7');
+        const char* start = text.data() + text.find_first_not_of(' ');
+        const char* end = text.data() + text.size();
+
+        unsigned long long parsed = 0, reference = 0;
+        const char* after = system_monitor::parse_number(start, end, parsed);
+        auto result = std::from_chars(start, end, reference);
+        REQUIRE(parsed == reference);
+        REQUIRE(after == result.ptr);
+    }
+}
+
+TEST_CASE("parse_number edge cases", "[procfs_parse]") {
+    auto parse = [](std::string_view text, unsigned long long& value) {
+        return system_monitor::parse_number(text.data(), text.data() + text.size(), value) - text.data();
+    };
+    unsigned long long value = 7;
+    CHECK(parse("", value) == 0);
+    CHECK(parse("kB", value) == 0);
+    CHECK(parse("-12", value) == 0);
+    CHECK(value == 7);                  // left alone without a number
+
+    CHECK(parse("0", value) == 1);
+    CHECK(value == 0);
+    CHECK(parse("12345678", value) == 8);
+    CHECK(value == 12345678);
+    CHECK(parse("123456789:", value) == 9);
+    CHECK(value == 123456789);
+    CHECK(parse("18446744073709551615 x", value) == 20);
+    CHECK(value == 18446744073709551615ull);
+    CHECK(parse("00000000000000000000000000042", value) == 29);
+    CHECK(value == 42);
+
+    value = 7;
+    CHECK(parse("18446744073709551616 too large", value) == 20);
+    CHECK(value == 7);
+
+    // bytes that are digits only in a nibble, or that carry when 6 is added
+    CHECK(parse("12\x3a" "45678", value) == 2);
+    CHECK(parse("1\xfa\xff" "2345678", value) == 1);
+    CHECK(value == 1);
+    CHECK(parse("12/45678", value) == 2);
+    CHECK(value == 12);
+
+    CHECK(system_monitor::parse_number(std::string_view("  \t 1024 kB")) == 1024);
+    CHECK(system_monitor::parse_number(std::string_view("none")) == 0);
+}
+
+// FieldScanner Tests
+TEST_CASE("FieldScanner", "[procfs_parse]") {
+    FieldScanner mounts("/dev/sda1 /boot ext4 rw,relatime 0 0");
+    std::string_view device, mount_point, type;
+    CHECK(mounts.next(device));
+    CHECK(mounts.next(mount_point));
+    CHECK(mounts.next(type));
+    CHECK(device == "/dev/sda1");
+    CHECK(mount_point == "/boot");
+    CHECK(type == "ext4");
+    CHECK(mounts.skip(3));
+    CHECK_FALSE(mounts.next(type));
+
+    FieldScanner netdev("  eth0:1234 5 0 0 0 0 0 0 678 9");
+    unsigned long long rx = 0, tx = 0;
+    CHECK_FALSE(netdev.next(rx));       // the name is no number and stays unread
+    CHECK(netdev.skip_past(':'));
+    CHECK(netdev.next(rx));
+    CHECK(netdev.skip(7));
+    CHECK(netdev.next(tx));
+    CHECK(rx == 1234);
+    CHECK(tx == 678);
+    CHECK(netdev.rest() == " 9");
+    CHECK_FALSE(netdev.skip(2));
+    CHECK_FALSE(netdev.skip_past(':'));
+    CHECK(netdev.rest().empty());
+
+    FieldScanner empty("");
+    std::string_view field;
+    CHECK_FALSE(empty.next(field));
+    CHECK_FALSE(empty.skip_past(':'));
+}
+
+// Parsing large captures of 256-CPU machines must take a small share of a
+// core; the bounds are loose, the rates (shown with -s) are what to compare
+TEST_CASE("procfs parse throughput", "[procfs_parse][benchmark]") {
+    constexpr size_t cpus = 256;
+    constexpr int rounds = 200;
+
+    std::string stats[2] = {large_stat(cpus, 100000000), large_stat(cpus, 100001000)};
+    system_monitor::Cpu cpu;
+    auto now = std::chrono::steady_clock::now();
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < rounds; ++i)
+        cpu.parse(stats[i % 2], now + (i + 1) * 100ms);
+    auto stat_time = std::chrono::steady_clock::now() - start;
+    CHECK(cpu.last().core_usages.size() == cpus);
+    CHECK(cpu.last().procs_running == 3);
+
+    std::string interrupts = large_interrupts(cpus, 300);
+    unsigned long long sum = 0;
+    start = std::chrono::steady_clock::now();
+    for(int i = 0; i < rounds; ++i) {
+        std::string_view text = interrupts, line;
+        system_monitor::next_line(text, line);
+        while(system_monitor::next_line(text, line)) {
+            FieldScanner fields(line);
+            fields.skip_past(':');
+            unsigned long long count = 0;
+            for(size_t n = 0; n < cpus && fields.next(count); ++n)
+                sum += count;
+        }
+    }
+    auto interrupts_time = std::chrono::steady_clock::now() - start;
+    CHECK(sum > 0);
+
+    std::string netdev = large_net_dev(2000);
+    std::string wireless = "h\nh\nveth1999: 0000 54. -56. -256 0 0 0 0 0 0\n";
+    system_monitor::Network network;
+    start = std::chrono::steady_clock::now();
+    for(int i = 0; i < rounds; ++i)
+        network.parse(wireless, netdev, now + (i + 1) * 1s);
+    auto netdev_time = std::chrono::steady_clock::now() - start;
+    CHECK(network.last().download_rate == 0.0);     // same counters every round
+
+    auto rate = [](size_t bytes, std::chrono::steady_clock::duration time) {
+        return static_cast<double>(bytes) * rounds / std::chrono::duration<double>(time).count() / 1e6;
+    };
+    INFO("MB/s: /proc/stat " << rate(stats[0].size(), stat_time) << ", /proc/interrupts "
+         << rate(interrupts.size(), interrupts_time) << ", /proc/net/dev " << rate(netdev.size(), netdev_time));
+    CHECK(stat_time < 2s);
+    CHECK(interrupts_time < 2s);
+    CHECK(netdev_time < 2s);
+}
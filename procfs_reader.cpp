@@ -0,0 +1,429 @@
+#include "procfs_reader.hpp"
+#include "syscall_count.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(SYSTEM_MONITOR_IO_URING) && __has_include(<linux/io_uring.h>)
+#define SYSTEM_MONITOR_HAS_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace system_monitor {
+
+#if SYSTEM_MONITOR_HAS_IO_URING
+    // Minimal io_uring ring through the raw system calls (no liburing)
+    struct ProcfsReader::Ring {
+        static constexpr unsigned entries = 256;
+
+        int fd = -1;
+        void* sq_ring = MAP_FAILED;
+        size_t sq_ring_size = 0;
+        void* cq_ring = MAP_FAILED;
+        size_t cq_ring_size = 0;
+        io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+        size_t sqes_size = 0;
+
+        unsigned* sq_tail = nullptr;
+        unsigned* sq_mask = nullptr;
+        unsigned* sq_array = nullptr;
+        unsigned* cq_head = nullptr;
+        unsigned* cq_tail = nullptr;
+        unsigned* cq_mask = nullptr;
+        io_uring_cqe* cqes = nullptr;
+
+        bool registered = false;        // files and buffers match files_
+        bool fixed_buffers = false;     // buffers registered too (they count against RLIMIT_MEMLOCK)
+
+        bool setup() {
+            io_uring_params params{};
+            fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if(fd < 0) return false;
+
+            sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            if(params.features & IORING_FEAT_SINGLE_MMAP) {
+                if(cq_ring_size > sq_ring_size) sq_ring_size = cq_ring_size;
+                cq_ring_size = sq_ring_size;
+            }
+
+            sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+            if(sq_ring == MAP_FAILED) return false;
+            if(params.features & IORING_FEAT_SINGLE_MMAP) {
+                cq_ring = sq_ring;
+            } else {
+                cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+                if(cq_ring == MAP_FAILED) return false;
+            }
+            sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+            if(sqes == MAP_FAILED) return false;
+
+            auto* sq = static_cast<char*>(sq_ring);
+            auto* cq = static_cast<char*>(cq_ring);
+            sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            return true;
+        }
+
+        int enter(unsigned to_submit, unsigned min_complete) {
+            count_syscalls();
+            return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, IORING_ENTER_GETEVENTS, nullptr, 0));
+        }
+
+        int register_op(unsigned opcode, const void* arg, unsigned n) {
+            count_syscalls();
+            return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, n));
+        }
+
+        ~Ring() {
+            if(sqes != MAP_FAILED) munmap(sqes, sqes_size);
+            if(cq_ring != MAP_FAILED && cq_ring != sq_ring) munmap(cq_ring, cq_ring_size);
+            if(sq_ring != MAP_FAILED) munmap(sq_ring, sq_ring_size);
+            if(fd >= 0) ::close(fd);
+        }
+    };
+#else
+    struct ProcfsReader::Ring {};
+#endif
+
+    ProcfsReader::ProcfsReader(Backend preferred) {
+#if SYSTEM_MONITOR_HAS_IO_URING
+        if(preferred == Backend::io_uring) {
+            auto ring = std::make_unique<Ring>();
+            if(ring->setup()) {          // fails with ENOSYS/EPERM when disabled or filtered
+                ring_ = std::move(ring);
+                backend_ = Backend::io_uring;
+            }
+        }
+#else
+        (void)preferred;
+#endif
+    }
+
+    ProcfsReader::~ProcfsReader() {
+        ring_.reset();
+        for(File& file : files_) {
+            if(file.fd >= 0) ::close(file.fd);
+        }
+    }
+
+    int ProcfsReader::open(const char* path, int dirfd) {
+        int fd = ::openat(dirfd, path, O_RDONLY | O_CLOEXEC);
+        count_syscalls();
+        if(fd < 0) return -1;
+
+        int index = static_cast<int>(files_.size());
+        if(!free_.empty()) {
+            index = free_.back();
+            free_.pop_back();
+        } else {
+            files_.emplace_back();
+        }
+        File& file = files_[static_cast<size_t>(index)];
+        file.fd = fd;
+        file.length = 0;
+        file.sized = false;
+        if(file.buffer.empty()) file.buffer.resize(min_buffer_size);       // a placeholder until the first read
+#if SYSTEM_MONITOR_HAS_IO_URING
+        if(ring_) ring_->registered = false;
+#endif
+        return index;
+    }
+
+    void ProcfsReader::close(int file) {
+        if(file < 0 || static_cast<size_t>(file) >= files_.size()) return;
+        File& entry = files_[static_cast<size_t>(file)];
+        if(entry.fd < 0) return;
+
+        ::close(entry.fd);
+        count_syscalls();
+        entry.fd = -1;
+        entry.length = 0;
+        if(entry.buffer.size() > min_buffer_size) std::vector<char>(min_buffer_size).swap(entry.buffer);
+        free_.push_back(file);
+#if SYSTEM_MONITOR_HAS_IO_URING
+        if(ring_) ring_->registered = false;       // -1 leaves a hole in the registered table
+#endif
+    }
+
+    void ProcfsReader::queue(int file) {
+        if(file < 0 || static_cast<size_t>(file) >= files_.size()) return;
+        File& entry = files_[static_cast<size_t>(file)];
+        if(entry.queued || entry.fd < 0) return;
+        entry.queued = true;
+        queued_.push_back(file);
+    }
+
+    void ProcfsReader::read_queued() {
+        size_t kept = 0;
+        for(int index : queued_) {
+            File& file = files_[static_cast<size_t>(index)];
+            if(file.sized) {
+                queued_[kept++] = index;
+                continue;
+            }
+            read_first(file);
+            file.queued = false;
+        }
+        queued_.resize(kept);
+        if(queued_.empty()) return;
+
+        if(!ring_ || !read_io_uring()) {
+            for(int index : queued_)
+                read_pread(files_[static_cast<size_t>(index)], 0);
+        }
+        for(int index : queued_)
+            files_[static_cast<size_t>(index)].queued = false;
+        queued_.clear();
+    }
+
+    std::string_view ProcfsReader::data(int file) const {
+        if(file < 0 || static_cast<size_t>(file) >= files_.size()) return {};
+        const File& entry = files_[static_cast<size_t>(file)];
+        return std::string_view(entry.buffer.data(), entry.length);
+    }
+
+    // Reads from `offset` to the end of the file, growing the buffer as needed
+    void ProcfsReader::read_pread(File& file, size_t offset) {
+        for(;;) {
+            if(offset == file.buffer.size()) {
+                file.buffer.resize(file.buffer.size() * 2);
+#if SYSTEM_MONITOR_HAS_IO_URING
+                if(ring_) ring_->registered = false;       // the buffer moved
+#endif
+            }
+            ssize_t n = pread(file.fd, file.buffer.data() + offset, file.buffer.size() - offset, static_cast<off_t>(offset));
+            count_syscalls();
+            if(n < 0) {
+                if(errno == EINTR) continue;
+                offset = 0;
+                break;
+            }
+            if(n == 0) break;
+            offset += static_cast<size_t>(n);
+        }
+        file.length = offset;
+    }
+
+    // Reads a file into the scratch buffer, then gives it a buffer with room
+    // to spare for its length; later reads still grow it when it fills up
+    void ProcfsReader::read_first(File& file) {
+        if(scratch_.empty()) scratch_.resize(initial_buffer_size);
+        file.buffer.swap(scratch_);
+        read_pread(file, 0);
+        file.buffer.swap(scratch_);         // the scratch keeps what it grew to
+        file.buffer.assign(scratch_.begin(), scratch_.begin() + static_cast<ptrdiff_t>(file.length));
+        file.buffer.resize(std::max(min_buffer_size, std::bit_ceil(file.length + 1)));
+        file.buffer.shrink_to_fit();
+        file.sized = true;
+#if SYSTEM_MONITOR_HAS_IO_URING
+        if(ring_) ring_->registered = false;       // the buffer moved
+#endif
+    }
+
+    size_t ProcfsReader::buffer_bytes() const {
+        size_t bytes = scratch_.capacity();
+        for(const File& file : files_)
+            bytes += file.buffer.capacity();
+        return bytes;
+    }
+
+    // False when the ring cannot be used any more; the caller then reads with pread
+    bool ProcfsReader::read_io_uring() {
+#if SYSTEM_MONITOR_HAS_IO_URING
+        Ring& ring = *ring_;
+
+        if(!ring.registered) {
+            ring.register_op(IORING_UNREGISTER_FILES, nullptr, 0);
+            if(ring.fixed_buffers)
+                ring.register_op(IORING_UNREGISTER_BUFFERS, nullptr, 0);
+
+            std::vector<int> fds(files_.size());
+            std::vector<iovec> buffers(files_.size());
+            for(size_t i = 0; i < files_.size(); ++i) {
+                fds[i] = files_[i].fd;
+                buffers[i] = {files_[i].buffer.data(), files_[i].buffer.size()};
+            }
+            if(ring.register_op(IORING_REGISTER_FILES, fds.data(), static_cast<unsigned>(fds.size())) < 0) {
+                ring_.reset();
+                backend_ = Backend::pread;
+                return false;
+            }
+            ring.fixed_buffers = ring.register_op(IORING_REGISTER_BUFFERS, buffers.data(), static_cast<unsigned>(buffers.size())) >= 0;
+            ring.registered = true;
+        }
+
+        // More queued files than ring entries are submitted in several rounds
+        for(size_t first = 0; first < queued_.size(); first += Ring::entries) {
+            size_t count = std::min<size_t>(Ring::entries, queued_.size() - first);
+
+            unsigned tail = *ring.sq_tail;
+            for(size_t i = 0; i < count; ++i) {
+                auto index = static_cast<unsigned>(queued_[first + i]);
+                File& file = files_[index];
+                unsigned slot = tail & *ring.sq_mask;
+
+                io_uring_sqe& sqe = ring.sqes[slot];
+                sqe = {};
+                sqe.opcode = ring.fixed_buffers ? IORING_OP_READ_FIXED : IORING_OP_READ;
+                sqe.flags = IOSQE_FIXED_FILE;
+                sqe.fd = static_cast<int>(index);
+                sqe.off = 0;
+                sqe.addr = reinterpret_cast<uint64_t>(file.buffer.data());
+                sqe.len = static_cast<uint32_t>(file.buffer.size());
+                if(ring.fixed_buffers)
+                    sqe.buf_index = static_cast<uint16_t>(index);
+                sqe.user_data = index;
+
+                ring.sq_array[slot] = slot;
+                ++tail;
+            }
+            std::atomic_ref<unsigned>(*ring.sq_tail).store(tail, std::memory_order_release);
+
+            // One io_uring_enter submits the round and waits for all of it
+            auto pending = static_cast<unsigned>(count);
+            unsigned to_submit = pending;
+            while(pending > 0) {
+                int ret = ring.enter(to_submit, pending);
+                if(ret < 0) {
+                    if(errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+                    if(to_submit == 0) {        // cannot wait for what is in flight, give up on the ring
+                        ring_.reset();
+                        backend_ = Backend::pread;
+                        return false;
+                    }
+
+                    // Withdraw what the kernel did not take (the last entries) and read it directly
+                    tail -= to_submit;
+                    std::atomic_ref<unsigned>(*ring.sq_tail).store(tail, std::memory_order_release);
+                    for(size_t i = count - to_submit; i < count; ++i)
+                        read_pread(files_[static_cast<size_t>(queued_[first + i])], 0);
+                    pending -= to_submit;
+                    to_submit = 0;
+                    continue;
+                }
+                to_submit -= std::min(to_submit, static_cast<unsigned>(ret));
+
+                unsigned head = *ring.cq_head;
+                unsigned cq_tail = std::atomic_ref<unsigned>(*ring.cq_tail).load(std::memory_order_acquire);
+                for(; head != cq_tail; ++head) {
+                    const io_uring_cqe& cqe = ring.cqes[head & *ring.cq_mask];
+                    File& file = files_[static_cast<size_t>(cqe.user_data)];
+                    if(cqe.res < 0)
+                        read_pread(file, 0);            // e.g. file without async read support
+                    else if(static_cast<size_t>(cqe.res) == file.buffer.size())
+                        read_pread(file, file.buffer.size());      // buffer full, read the rest
+                    else
+                        file.length = static_cast<size_t>(cqe.res);
+                    --pending;
+                }
+                std::atomic_ref<unsigned>(*ring.cq_head).store(head, std::memory_order_release);
+            }
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+
+    void ProcfsFile::attach(ProcfsReader& reader) {
+        own_reader_.reset();
+        reader_ = &reader;
+        file_ = reader.open(path_);
+        prefetched_ = false;
+    }
+
+    void ProcfsFile::prefetch() {
+        if(!reader_) return;
+        reader_->queue(file_);
+        prefetched_ = true;
+    }
+
+    std::string_view ProcfsFile::read() {
+        if(!reader_) {              // standalone, the file gets its own reader
+            own_reader_ = std::make_unique<ProcfsReader>(ProcfsReader::Backend::pread);
+            reader_ = own_reader_.get();
+            file_ = reader_->open(path_);
+        }
+        if(!prefetched_) {
+            reader_->queue(file_);
+            reader_->read_queued();
+        }
+        prefetched_ = false;
+        return reader_->data(file_);
+    }
+
+    void ProcfsFileSet::attach(ProcfsReader& reader) {
+        close_all();
+        own_reader_.reset();
+        reader_ = &reader;
+        prefetched_ = false;
+    }
+
+    void ProcfsFileSet::prefetch() {
+        if(!reader_) return;
+        for(int file : files_)
+            reader_->queue(file);
+        prefetched_ = true;
+    }
+
+    int ProcfsFileSet::open(const char* path, int dirfd) {
+        int file = reader().open(path, dirfd);
+        if(file < 0) return -1;
+        if(positions_.size() <= static_cast<size_t>(file)) positions_.resize(static_cast<size_t>(file) + 1);
+        positions_[static_cast<size_t>(file)] = files_.size();
+        files_.push_back(file);
+        prefetched_ = false;        // the new file was not in the batch
+        return file;
+    }
+
+    // Swaps the last file into the slot of the closed one
+    void ProcfsFileSet::close(int file) {
+        if(file < 0 || !reader_ || static_cast<size_t>(file) >= positions_.size()) return;
+        size_t position = positions_[static_cast<size_t>(file)];
+        if(position >= files_.size() || files_[position] != file) return;
+        files_[position] = files_.back();
+        positions_[static_cast<size_t>(files_[position])] = position;
+        files_.pop_back();
+        reader_->close(file);
+    }
+
+    void ProcfsFileSet::close_all() {
+        if(reader_) {
+            for(int file : files_)
+                reader_->close(file);
+        }
+        files_.clear();
+    }
+
+    void ProcfsFileSet::read() {
+        if(!prefetched_) {
+            for(int file : files_)
+                reader().queue(file);
+            reader().read_queued();
+        }
+        prefetched_ = false;
+    }
+
+    // The attached reader, else one of the set's own
+    ProcfsReader& ProcfsFileSet::reader() {
+        if(!reader_) {
+            own_reader_ = std::make_unique<ProcfsReader>(ProcfsReader::Backend::pread);
+            reader_ = own_reader_.get();
+        }
+        return *reader_;
+    }
+}
@@ -0,0 +1,126 @@
+#ifndef PROCFS_READER_HPP
+#define PROCFS_READER_HPP
+#include <cstddef>
+#include <fcntl.h>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace system_monitor {
+
+    // Reads a set of procfs/sysfs files in batches. Files are opened once and
+    // keep their descriptor and buffer; every batch re-reads them from
+    // offset 0. The first read goes through a shared scratch buffer and sizes
+    // the file's own buffer to the next power of two above its length, so
+    // thousands of small files (cgroups) do not cost a page each. With the io_uring backend the descriptors and buffers are
+    // registered with the ring and all reads of a batch go out with a single
+    // io_uring_enter, otherwise every file costs one pread.
+    class ProcfsReader {
+        public:
+            enum class Backend { pread, io_uring };
+
+            static constexpr size_t initial_buffer_size = 4096;     // of the scratch buffer
+            static constexpr size_t min_buffer_size = 64;
+
+            // io_uring is used when compiled in (SYSTEM_MONITOR_IO_URING) and the kernel allows it
+            explicit ProcfsReader(Backend preferred = Backend::io_uring);
+            ~ProcfsReader();
+
+            ProcfsReader(const ProcfsReader&) = delete;
+            ProcfsReader& operator=(const ProcfsReader&) = delete;
+
+            // Opens a file until close() or the end of the reader, -1 if it cannot be
+            // opened; relative paths are resolved against dirfd
+            int open(const char* path, int dirfd = AT_FDCWD);
+            void close(int file);
+
+            // Queues the read of a file for the next read_queued()
+            void queue(int file);
+
+            // Reads every queued file
+            void read_queued();
+
+            // Contents of a file as of its last read, empty if the read failed
+            std::string_view data(int file) const;
+
+            Backend backend() const { return backend_; }
+            size_t size() const { return files_.size() - free_.size(); }
+            size_t buffer_bytes() const;        // file buffers and scratch
+
+        private:
+            struct File {
+                int fd = -1;
+                std::vector<char> buffer;
+                size_t length = 0;
+                bool queued = false;
+                bool sized = false;         // buffer sized by a first read
+            };
+
+            struct Ring;
+
+            Backend backend_ = Backend::pread;
+            std::vector<File> files_;
+            std::vector<int> queued_;
+            std::vector<int> free_;         // closed slots, reused by open()
+            std::vector<char> scratch_;     // first reads
+            std::unique_ptr<Ring> ring_;
+
+            void read_pread(File& file, size_t offset);
+            void read_first(File& file);
+            bool read_io_uring();
+    };
+
+    // One file of a collector. Standalone it reads itself on every read();
+    // attached to a shared reader the sampler batches the reads: prefetch()
+    // queues the file and read() then returns the batched contents.
+    class ProcfsFile {
+        public:
+            explicit ProcfsFile(const char* path) : path_(path) {}
+
+            void attach(ProcfsReader& reader);
+            void prefetch();
+            std::string_view read();
+
+        private:
+            const char* path_;
+            ProcfsReader* reader_ = nullptr;
+            std::unique_ptr<ProcfsReader> own_reader_;
+            int file_ = -1;
+            bool prefetched_ = false;
+    };
+
+    // A changing set of files of a collector (cgroups, sensors, nodes), the
+    // ProcfsFile fallback for many files: standalone the set opens them on a
+    // reader of its own, attached prefetch() queues them into the batch.
+    class ProcfsFileSet {
+        public:
+            ProcfsFileSet() = default;
+            ~ProcfsFileSet() { close_all(); }
+
+            ProcfsFileSet(const ProcfsFileSet&) = delete;
+            ProcfsFileSet& operator=(const ProcfsFileSet&) = delete;
+
+            // Closes the files, they are opened again on the reader
+            void attach(ProcfsReader& reader);
+            void prefetch();
+
+            int open(const char* path, int dirfd = AT_FDCWD);
+            void close(int file);
+            void close_all();
+
+            // Reads the files unless they were prefetched since the last open()
+            void read();
+            std::string_view data(int file) const { return reader_ ? reader_->data(file) : std::string_view{}; }
+
+        private:
+            ProcfsReader* reader_ = nullptr;
+            std::unique_ptr<ProcfsReader> own_reader_;
+            std::vector<int> files_;
+            std::vector<size_t> positions_;     // index in files_ per reader slot
+            bool prefetched_ = false;
+
+            ProcfsReader& reader();
+    };
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include "catch_amalgamated.hpp"
+#include "procfs_reader.hpp"
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+    // Temporary file removed at the end of the test
+    struct TempFile {
+        std::string path;
+
+        explicit TempFile(const std::string& contents) {
+            char name[] = "/tmp/procfs_reader_testXXXXXX";
+            int fd = mkstemp(name);
+            close(fd);
+            path = name;
+            write(contents);
+        }
+        ~TempFile() { std::remove(path.c_str()); }
+
+        void write(const std::string& contents) {
+            std::ofstream(path, std::ios::trunc) << contents;
+        }
+    };
+
+    using Backend = system_monitor::ProcfsReader::Backend;
+}
+
+// ProcfsReader Tests
+// same contents through both backends, re-read from the start on every batch
+TEST_CASE("ProcfsReader read_queued", "[procfs_reader]") {
+    auto backend = GENERATE(Backend::pread, Backend::io_uring);
+    system_monitor::ProcfsReader reader(backend);
+    if(backend == Backend::pread)
+        CHECK(reader.backend() == Backend::pread);      // io_uring may be unavailable, pread always is
+
+    TempFile small("cpu  1 2 3\n");
+    TempFile large(std::string(3 * system_monitor::ProcfsReader::initial_buffer_size + 17, 'x'));
+
+    int a = reader.open(small.path.c_str());
+    int b = reader.open(large.path.c_str());
+    CHECK(reader.open("/nonexistent/file") == -1);
+    REQUIRE(a >= 0);
+    REQUIRE(b >= 0);
+    CHECK(reader.size() == 2);
+
+    reader.queue(a);
+    reader.queue(b);
+    reader.queue(a);        // queued once
+    reader.read_queued();
+    CHECK(reader.data(a) == "cpu  1 2 3\n");
+    CHECK(reader.data(b).size() == 3 * system_monitor::ProcfsReader::initial_buffer_size + 17);
+
+    small.write("cpu  4 5 6 7\n");
+    reader.queue(a);
+    reader.read_queued();
+    CHECK(reader.data(a) == "cpu  4 5 6 7\n");
+    CHECK(reader.data(-1).empty());
+}
+
+// small files get small buffers, a file that outgrows its buffer still reads whole
+TEST_CASE("ProcfsReader buffer sizes", "[procfs_reader]") {
+    auto backend = GENERATE(Backend::pread, Backend::io_uring);
+    system_monitor::ProcfsReader reader(backend);
+    std::vector<std::unique_ptr<TempFile>> files;
+    std::vector<int> ids;
+    for(int i = 0; i < 100; ++i) {
+        files.push_back(std::make_unique<TempFile>(std::to_string(i * 1000) + "\n"));
+        ids.push_back(reader.open(files.back()->path.c_str()));
+        reader.queue(ids.back());
+    }
+    reader.read_queued();
+    CHECK(reader.data(ids[42]) == "42000\n");
+    CHECK(reader.buffer_bytes() <= 100 * system_monitor::ProcfsReader::min_buffer_size + system_monitor::ProcfsReader::initial_buffer_size);
+
+    std::string grown(1000, 'y');
+    files[7]->write(grown);
+    for(int id : ids)
+        reader.queue(id);
+    reader.read_queued();
+    CHECK(reader.data(ids[7]) == grown);
+    CHECK(reader.data(ids[8]) == "8000\n");
+}
+
+TEST_CASE("ProcfsReader /proc/stat", "[procfs_reader]") {
+    system_monitor::ProcfsReader reader;
+    int stat = reader.open("/proc/stat");
+    REQUIRE(stat >= 0);
+    for(int i = 0; i < 3; ++i) {
+        reader.queue(stat);
+        reader.read_queued();
+        CHECK(reader.data(stat).substr(0, 4) == "cpu ");
+        CHECK(reader.data(stat).back() == '\n');
+    }
+}
+
+// standalone files read themselves, attached ones read in the batch
+TEST_CASE("ProcfsFile attach/prefetch", "[procfs_reader]") {
+    TempFile file("first\n");
+    system_monitor::ProcfsFile standalone(file.path.c_str());
+    CHECK(standalone.read() == "first\n");
+
+    system_monitor::ProcfsReader reader;
+    system_monitor::ProcfsFile attached(file.path.c_str());
+    attached.attach(reader);
+    attached.prefetch();
+    reader.read_queued();
+    file.write("second\n");
+    CHECK(attached.read() == "first\n");        // contents of the batch
+    CHECK(attached.read() == "second\n");       // not prefetched, read now
+}
+
+// files opened and closed between batches, closed with the set
+TEST_CASE("ProcfsFileSet open/close", "[procfs_reader]") {
+    TempFile a("a\n"), b("b\n"), c("c\n");
+    system_monitor::ProcfsFileSet standalone;
+    int own = standalone.open(a.path.c_str());
+    standalone.read();
+    CHECK(standalone.data(own) == "a\n");
+
+    system_monitor::ProcfsReader reader;
+    {
+        system_monitor::ProcfsFileSet set;
+        set.attach(reader);
+        int first = set.open(a.path.c_str());
+        int second = set.open(b.path.c_str());
+        CHECK(set.open("/nonexistent/file") == -1);
+        set.prefetch();
+        reader.read_queued();
+        b.write("b2\n");
+        set.read();
+        CHECK(set.data(second) == "b\n");       // contents of the batch
+
+        set.close(first);
+        set.close(first);                       // closed once
+        int third = set.open(c.path.c_str());
+        CHECK(reader.size() == 2);
+        set.prefetch();
+        reader.read_queued();
+        set.read();
+        CHECK(set.data(second) == "b2\n");
+        CHECK(set.data(third) == "c\n");
+    }
+    CHECK(reader.size() == 0);
+}
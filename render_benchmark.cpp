@@ -0,0 +1,246 @@
+// Renders the canvas offscreen from a synthetic snapshot and reports ns per frame.
+//
+//   ./render_benchmark [--frames N] [--size WxH] [--expanded] [--cores N] [--mounts N] [--scroll Y]
+//                      [--fleet HOSTS] [--heatmap] [--write-golden file.png] [--golden file.png] [--tolerance 0.01]
+//
+// GTK needs a display connection, run it with xvfb-run on machines without one.
+#include <wx/wx.h>
+#include <wx/image.h>
+#include <wx/dcmemory.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "canvas_renderer.hpp"
+#include "canvas_snapshot.hpp"
+#include "instrumentation.hpp"
+
+using namespace system_monitor;
+
+namespace {
+    struct Options {
+        int frames = 2000;
+        wxSize size{1400, 800};
+        bool expanded = false;
+        size_t cores = 16;
+        size_t mounts = 1;
+        int scroll = 0;                 // y offset of the viewport
+        size_t fleet = 0;               // hosts of the fleet grid, 0 draws the cards
+        bool heatmap = false;           // core heatmap, one new column per frame
+        std::string golden;
+        std::string write_golden;
+        double tolerance = 0.01;        // fraction of pixels allowed to differ
+    };
+
+    // Deterministic snapshot so that the frames (and golden images) are reproducible
+    CanvasSnapshot synthetic_snapshot(const Options& options) {
+        CanvasSnapshot snapshot;
+        snapshot.ram_usage = 0.42;
+        snapshot.cpu_usage = 0.18;
+        snapshot.ram_total = 32ull << 30;
+        snapshot.ram_used = 13ull << 30;
+        snapshot.ram_free = 19ull << 30;
+        snapshot.ram_available = 19ull << 30;
+        snapshot.ram_buffers = 1ull << 29;
+        snapshot.ram_cached = 8ull << 30;
+        snapshot.ram_shmem = 1ull << 28;
+        snapshot.ram_slab = 1ull << 29;
+        snapshot.ram_dirty = 12ull << 20;
+        snapshot.ram_writeback = 0;
+        snapshot.swap_total = 8ull << 30;
+        snapshot.swap_free = 7ull << 30;
+        snapshot.services = {{"postgresql.service", 1.8, 6ull << 30}, {"nginx.service", 0.4, 300ull << 20},
+                             {"docker-1f2e3d.scope", 0.25, 1ull << 30}, {"sshd.service", 0.01, 8ull << 20},
+                             {"cron.service", 0.0, 2ull << 20}};
+        for(size_t i = 0; i < options.cores; ++i)
+            snapshot.core_usages.push_back(static_cast<double>(i % 10) / 10.0);
+        const double state_shares[CanvasSnapshot::n_cpu_states] = {0.10, 0.01, 0.04, 0.78, 0.02, 0.002, 0.008, 0.03, 0.01, 0.0};
+        for(size_t state = 0; state < CanvasSnapshot::n_cpu_states; ++state)
+            snapshot.cpu_states[state].assign(options.cores + 1, state_shares[state]);
+        snapshot.context_switch_rate = 48000.0;
+        snapshot.interrupt_rate = 21000.0;
+        snapshot.fork_rate = 12.0;
+        snapshot.procs_running = 4;
+        snapshot.procs_blocked = 1;
+        for(size_t i = 0; i < options.cores; ++i)
+            snapshot.net_rx_rates.push_back(i == 0 ? 9000.0 : 600.0);
+        snapshot.net_rx_imbalance = 3.5;
+        snapshot.load_averages = {3.2, 2.9, 2.4};
+        snapshot.runnable_tasks = 5;
+        snapshot.sched_latency = 42.0;
+        snapshot.sched_waiting = 0.35;
+        snapshot.sched_running = 0.82;
+        for(size_t i = 0; i < options.cores; ++i)
+            snapshot.core_sched_latencies.push_back(static_cast<double>(i % 5) * 20.0);
+        snapshot.burst_mode = true;
+        snapshot.cpu_burst = {0.05, 0.97, 0.91};
+        for(size_t i = 0; i < options.cores; ++i)
+            snapshot.core_bursts.push_back({0.0, 1.0, static_cast<double>(i % 10) / 10.0 + 0.05});
+        snapshot.burst_interval_ms = 10.0;
+        snapshot.burst_overhead = 0.002;
+        snapshot.cpu_percentiles = {{{15.0, 31.0, 62.0, 88.0}, {17.0, 35.0, 71.0, 94.0}, {12.0, 40.0, 83.0, 100.0}}};
+        snapshot.ram_percentiles = {{{41.0, 42.0, 43.0, 43.0}, {40.0, 42.0, 44.0, 45.0}, {35.0, 41.0, 52.0, 58.0}}};
+        snapshot.download_percentiles = {{{2e4, 2e5, 1.2e6, 3e6}, {1e4, 1.5e5, 2.4e6, 8e6}, {8e3, 1e5, 4e6, 1.1e7}}};
+        snapshot.upload_percentiles = {{{5e3, 2e4, 1e5, 4e5}, {4e3, 3e4, 2e5, 9e5}, {3e3, 2e4, 6e5, 2e6}}};
+        for(size_t i = 0; i < options.cores; ++i)
+            snapshot.core_percentiles.push_back({static_cast<double>(i % 10) * 8.0, 70.0, 95.0, 100.0});
+        for(size_t i = 0; i < options.mounts; ++i) {
+            CanvasSnapshot::Mount mount;
+            mount.path = i == 0 ? "/" : "/mnt/disk" + std::to_string(i);
+            mount.total = 512ull << 30;
+            mount.used = 374ull << 30;
+            mount.free = 138ull << 30;
+            mount.usage = 0.73;
+            snapshot.mounts.push_back(mount);
+        }
+        snapshot.heatmap_view = options.heatmap;
+        snapshot.fleet_view = options.fleet > 0;
+        for(size_t i = 0; i < options.fleet; ++i)
+            snapshot.fleet.push_back({"host-" + std::to_string(i), i % 17 != 0,
+                                      static_cast<double>(i % 10) / 10.0, static_cast<double>(i % 7) / 7.0});
+        snapshot.cpu_cores = static_cast<unsigned int>(options.cores);
+        snapshot.cpu_physical_cores = static_cast<unsigned int>(options.cores / 2);
+        snapshot.cpu_sockets = 2;
+        snapshot.numa_nodes = 2;
+        snapshot.socket_usages = {0.62, 0.18};
+        snapshot.node_usages = {0.62, 0.18};
+        snapshot.node_memory = {{0, 0.93, 64ull << 30, 4ull << 30, 21ull << 30, 36ull << 30, 1200.0},
+                                {1, 0.41, 64ull << 30, 38ull << 30, 9ull << 30, 15ull << 30, 0.0}};
+        snapshot.cpu_temperature = 61.0;
+        snapshot.hottest_sensor = "nvme Composite";
+        snapshot.hottest_temperature = 64.0;
+        snapshot.cpu_model = "Synthetic CPU @ 3.00GHz";
+        snapshot.cpu_caches = "L1d 48K  L1i 32K  L2 2M  L3 30M";
+        snapshot.cpu_features = "SSE4.2 AVX AVX2 FMA BMI2 AVX-512F AVX-512BW AVX-512VL AES SHA RDRAND HT";
+        snapshot.cpu_revision = "family 6 model 106 stepping 6, microcode 0xd0003a5";
+        snapshot.product_name = "Benchmark Machine";
+        snapshot.os_version = "6.0.0";
+        snapshot.kernel_version = "6.1.0-synthetic";
+        snapshot.uptime = 123456;
+        snapshot.procs_num = 789;
+        snapshot.download_rate = 1536.0 * 1024.0;
+        snapshot.upload_rate = 256.0 * 1024.0;
+        for(size_t i = 0; i < CanvasSnapshot::network_history_length; ++i) {
+            double t = static_cast<double>(i);
+            snapshot.update_network_history(1000.0 + 800.0 * std::sin(t / 5.0), 200.0 + 150.0 * std::cos(t / 7.0));
+        }
+        return snapshot;
+    }
+
+    bool parse_options(int argc, char** argv, Options& options) {
+        for(int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if(arg == "--frames" && has_value) options.frames = std::atoi(argv[++i]);
+            else if(arg == "--size" && has_value) {
+                int w = 0, h = 0;
+                if(std::sscanf(argv[++i], "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0) return false;
+                options.size = wxSize(w, h);
+            }
+            else if(arg == "--expanded") options.expanded = true;
+            else if(arg == "--cores" && has_value) options.cores = std::strtoul(argv[++i], nullptr, 10);
+            else if(arg == "--mounts" && has_value) options.mounts = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+            else if(arg == "--scroll" && has_value) options.scroll = std::atoi(argv[++i]);
+            else if(arg == "--heatmap") options.heatmap = true;
+            else if(arg == "--fleet" && has_value) options.fleet = std::strtoul(argv[++i], nullptr, 10);
+            else if(arg == "--golden" && has_value) options.golden = argv[++i];
+            else if(arg == "--write-golden" && has_value) options.write_golden = argv[++i];
+            else if(arg == "--tolerance" && has_value) options.tolerance = std::atof(argv[++i]);
+            else return false;
+        }
+        return options.frames > 0;
+    }
+
+    // Fraction of pixels that differ between both images
+    double image_difference(const wxImage& a, const wxImage& b) {
+        if(a.GetWidth() != b.GetWidth() || a.GetHeight() != b.GetHeight()) return 1.0;
+        const unsigned char* pa = a.GetData();
+        const unsigned char* pb = b.GetData();
+        size_t pixels = static_cast<size_t>(a.GetWidth()) * static_cast<size_t>(a.GetHeight());
+        size_t different = 0;
+        for(size_t i = 0; i < pixels; ++i) {
+            if(std::memcmp(pa + 3 * i, pb + 3 * i, 3) != 0) ++different;
+        }
+        return static_cast<double>(different) / static_cast<double>(pixels);
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if(!parse_options(argc, argv, options)) {
+        std::cerr << "usage: " << argv[0] << " [--frames N] [--size WxH] [--expanded] [--cores N] [--mounts N] [--scroll Y]"
+                  << " [--fleet HOSTS] [--heatmap] [--write-golden file.png] [--golden file.png] [--tolerance 0.01]\n";
+        return 2;
+    }
+
+    wxApp::SetInstance(new wxApp());
+    if(!wxEntryStart(argc, argv)) {
+        std::cerr << "could not initialize wxWidgets (no display?)\n";
+        return 1;
+    }
+    wxInitAllImageHandlers();
+
+    int result = 0;
+    {
+        Instrumentation instrumentation(CanvasRenderer::probe_names());
+        CanvasRenderer renderer(instrumentation);
+        CanvasSnapshot snapshot = synthetic_snapshot(options);
+        wxRect viewport(0, options.scroll, options.size.GetWidth(), options.size.GetHeight());
+
+        wxBitmap bitmap(options.size.GetWidth(), options.size.GetHeight());
+        wxMemoryDC dc(bitmap);
+
+        if(options.expanded) {
+            // Render once to lay the cards out, then open all of them
+            dc.SetBackground(*wxWHITE_BRUSH);
+            dc.Clear();
+            renderer.render(dc, options.size, viewport, snapshot);
+            renderer.expand_all(true);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < options.frames; ++i) {
+            dc.SetBackground(*wxWHITE_BRUSH);
+            dc.Clear();
+            dc.SetDeviceOrigin(0, -options.scroll);
+            if(options.heatmap && !snapshot.core_usages.empty()) {
+                // A new sample per frame, rotated so that the columns differ
+                std::rotate(snapshot.core_usages.begin(), snapshot.core_usages.begin() + 1, snapshot.core_usages.end());
+                renderer.push_heatmap(snapshot.core_usages);
+            }
+            renderer.render(dc, options.size, viewport, snapshot);
+            dc.SetDeviceOrigin(0, 0);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        dc.SelectObject(wxNullBitmap);
+
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        std::cout << options.frames << " frames at " << options.size.GetWidth() << "x" << options.size.GetHeight()
+                  << ": " << ns / options.frames << " ns/frame\n";
+        instrumentation.write_json(std::cout);
+
+        wxImage image = bitmap.ConvertToImage();
+        if(!options.write_golden.empty() && !image.SaveFile(options.write_golden, wxBITMAP_TYPE_PNG)) {
+            std::cerr << "could not write " << options.write_golden << "\n";
+            result = 1;
+        }
+        if(!options.golden.empty()) {
+            wxImage golden;
+            if(!golden.LoadFile(options.golden, wxBITMAP_TYPE_PNG)) {
+                std::cerr << "could not read " << options.golden << "\n";
+                result = 1;
+            } else {
+                double difference = image_difference(image, golden);
+                std::cout << "golden difference: " << difference * 100.0 << "% of pixels\n";
+                if(difference > options.tolerance) result = 1;
+            }
+        }
+    }
+
+    wxEntryCleanup();
+    return result;
+}
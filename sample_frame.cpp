@@ -0,0 +1,260 @@
+#include "sample_frame.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace system_monitor {
+
+    namespace {
+        template <typename T>
+        void put(std::string& out, T value) {
+            for(size_t i = 0; i < sizeof(T); ++i)
+                out.push_back(static_cast<char>(static_cast<uint64_t>(value) >> (8 * i) & 0xff));
+        }
+
+        uint16_t to_usage(double usage) {
+            return static_cast<uint16_t>(std::lround(std::clamp(usage, 0.0, 1.0) * 10000.0));
+        }
+
+        uint32_t to_float(double value) {
+            return std::bit_cast<uint32_t>(static_cast<float>(value));
+        }
+
+        void put_usage(std::string& out, double usage) {
+            put<uint16_t>(out, to_usage(usage));
+        }
+
+        void put_float(std::string& out, double value) {
+            put<uint32_t>(out, to_float(value));
+        }
+
+        // Reads little endian values off the front of a payload
+        class Cursor {
+            public:
+                explicit Cursor(std::string_view data) : data_(data) {}
+
+                template <typename T>
+                T get() {
+                    if(data_.size() < sizeof(T)) {
+                        failed_ = true;
+                        return T{};
+                    }
+                    uint64_t value = 0;
+                    for(size_t i = 0; i < sizeof(T); ++i)
+                        value |= static_cast<uint64_t>(static_cast<unsigned char>(data_[i])) << (8 * i);
+                    data_.remove_prefix(sizeof(T));
+                    return static_cast<T>(value);
+                }
+
+                std::string_view bytes(size_t size) {
+                    if(data_.size() < size) {
+                        failed_ = true;
+                        return {};
+                    }
+                    std::string_view bytes = data_.substr(0, size);
+                    data_.remove_prefix(size);
+                    return bytes;
+                }
+
+                double usage() { return get<uint16_t>() / 10000.0; }
+                double float_value() { return std::bit_cast<float>(get<uint32_t>()); }
+
+                bool ok() const { return !failed_; }
+                bool done() const { return !failed_ && data_.empty(); }
+                size_t remaining() const { return data_.size(); }
+
+            private:
+                std::string_view data_;
+                bool failed_ = false;
+        };
+
+        void append_frame(std::string& out, uint8_t type, size_t header_at) {
+            size_t length = out.size() - header_at - frame::header_size;
+            out[header_at] = 'S';
+            out[header_at + 1] = 'M';
+            out[header_at + 2] = static_cast<char>(frame::version);
+            out[header_at + 3] = static_cast<char>(type);
+            for(size_t i = 0; i < 4; ++i)
+                out[header_at + 4 + i] = static_cast<char>(length >> (8 * i) & 0xff);
+        }
+    }
+
+    namespace frame {
+        void append_hello(std::string& out, std::string_view host) {
+            size_t header_at = out.size();
+            out.append(header_size, '\0');
+            out.append(host.substr(0, 255));
+            append_frame(out, hello, header_at);
+        }
+
+        void append_sample(std::string& out, const HostSample& sample) {
+            size_t header_at = out.size();
+            out.append(header_size, '\0');
+            put<uint64_t>(out, sample.time_ms);
+            put_usage(out, sample.cpu_usage);
+            put_usage(out, sample.ram_usage);
+            put<uint64_t>(out, sample.ram_total);
+            put<uint64_t>(out, sample.ram_used);
+            put_float(out, sample.download_rate);
+            put_float(out, sample.upload_rate);
+            put_usage(out, sample.root_usage);
+            put<uint32_t>(out, static_cast<uint32_t>(sample.uptime));
+            put<uint32_t>(out, static_cast<uint32_t>(sample.procs_num));
+            auto cores = static_cast<uint16_t>(std::min<size_t>(sample.core_usages.size(), UINT16_MAX));
+            put<uint16_t>(out, cores);
+            for(size_t core = 0; core < cores; ++core)
+                put_usage(out, sample.core_usages[core]);
+            append_frame(out, frame::sample, header_at);
+        }
+
+        bool decode_hello(std::string_view payload, std::string& host) {
+            if(payload.empty() || payload.size() > 255) return false;
+            host.assign(payload);
+            return true;
+        }
+
+        bool decode_sample(std::string_view payload, HostSample& sample) {
+            Cursor cursor(payload);
+            sample.time_ms = cursor.get<uint64_t>();
+            sample.cpu_usage = cursor.usage();
+            sample.ram_usage = cursor.usage();
+            sample.ram_total = cursor.get<uint64_t>();
+            sample.ram_used = cursor.get<uint64_t>();
+            sample.download_rate = cursor.float_value();
+            sample.upload_rate = cursor.float_value();
+            sample.root_usage = cursor.usage();
+            sample.uptime = cursor.get<uint32_t>();
+            sample.procs_num = cursor.get<uint32_t>();
+            auto cores = cursor.get<uint16_t>();
+            if(!cursor.ok() || cursor.remaining() != size_t(cores) * 2) return false;
+            sample.core_usages.resize(cores);
+            for(auto& usage : sample.core_usages)
+                usage = cursor.usage();
+            return cursor.done();
+        }
+
+        bool decode_delta(std::string_view payload, HostSample& sample) {
+            Cursor cursor(payload);
+            HostSample next = sample;
+            next.time_ms = cursor.get<uint64_t>();
+            auto mask = cursor.get<uint16_t>();
+            if(mask & delta_cpu) next.cpu_usage = cursor.usage();
+            if(mask & delta_ram) next.ram_usage = cursor.usage();
+            if(mask & delta_ram_total) next.ram_total = cursor.get<uint64_t>();
+            if(mask & delta_ram_used) next.ram_used = cursor.get<uint64_t>();
+            if(mask & delta_download) next.download_rate = cursor.float_value();
+            if(mask & delta_upload) next.upload_rate = cursor.float_value();
+            if(mask & delta_root) next.root_usage = cursor.usage();
+            if(mask & delta_uptime) next.uptime = cursor.get<uint32_t>();
+            if(mask & delta_procs) next.procs_num = cursor.get<uint32_t>();
+            if(mask & delta_cores) {
+                auto cores = cursor.get<uint16_t>();
+                std::string_view bitmap = cursor.bytes((size_t(cores) + 7) / 8);
+                if(!cursor.ok() || cores != next.core_usages.size()) return false;
+                for(size_t core = 0; core < cores; ++core) {
+                    if(static_cast<unsigned char>(bitmap[core / 8]) >> (core % 8) & 1)
+                        next.core_usages[core] = cursor.usage();
+                }
+            }
+            if(!cursor.done()) return false;
+            sample = std::move(next);
+            return true;
+        }
+    }
+
+    void DeltaEncoder::quantise(const HostSample& sample, Wire& wire) {
+        wire.cpu = to_usage(sample.cpu_usage);
+        wire.ram = to_usage(sample.ram_usage);
+        wire.root = to_usage(sample.root_usage);
+        wire.ram_total = sample.ram_total;
+        wire.ram_used = sample.ram_used;
+        wire.download = to_float(sample.download_rate);
+        wire.upload = to_float(sample.upload_rate);
+        wire.uptime = static_cast<uint32_t>(sample.uptime);
+        wire.procs = static_cast<uint32_t>(sample.procs_num);
+        wire.cores.resize(std::min<size_t>(sample.core_usages.size(), UINT16_MAX));
+        for(size_t core = 0; core < wire.cores.size(); ++core)
+            wire.cores[core] = to_usage(sample.core_usages[core]);
+    }
+
+    void DeltaEncoder::append(std::string& out, const HostSample& sample) {
+        quantise(sample, current_);
+        if(!has_previous_ || current_.cores.size() != previous_.cores.size()) {
+            frame::append_sample(out, sample);
+            std::swap(previous_, current_);
+            has_previous_ = true;
+            return;
+        }
+
+        size_t header_at = out.size();
+        out.append(frame::header_size, '\0');
+        put<uint64_t>(out, sample.time_ms);
+        size_t mask_at = out.size();
+        put<uint16_t>(out, 0);
+
+        uint16_t mask = 0;
+        auto field = [&](frame::DeltaField bit, auto now, auto before) {
+            if(now == before) return;
+            mask = static_cast<uint16_t>(mask | bit);
+            put<decltype(now)>(out, now);
+        };
+        field(frame::delta_cpu, current_.cpu, previous_.cpu);
+        field(frame::delta_ram, current_.ram, previous_.ram);
+        field(frame::delta_ram_total, current_.ram_total, previous_.ram_total);
+        field(frame::delta_ram_used, current_.ram_used, previous_.ram_used);
+        field(frame::delta_download, current_.download, previous_.download);
+        field(frame::delta_upload, current_.upload, previous_.upload);
+        field(frame::delta_root, current_.root, previous_.root);
+        field(frame::delta_uptime, current_.uptime, previous_.uptime);
+        field(frame::delta_procs, current_.procs, previous_.procs);
+
+        if(current_.cores != previous_.cores) {
+            mask = static_cast<uint16_t>(mask | frame::delta_cores);
+            size_t cores = current_.cores.size();
+            put<uint16_t>(out, static_cast<uint16_t>(cores));
+            size_t bitmap_at = out.size();
+            out.append((cores + 7) / 8, '\0');
+            for(size_t core = 0; core < cores; ++core) {
+                if(current_.cores[core] == previous_.cores[core]) continue;
+                out[bitmap_at + core / 8] = static_cast<char>(out[bitmap_at + core / 8] | 1 << (core % 8));
+                put<uint16_t>(out, current_.cores[core]);
+            }
+        }
+        out[mask_at] = static_cast<char>(mask & 0xff);
+        out[mask_at + 1] = static_cast<char>(mask >> 8);
+        append_frame(out, frame::delta, header_at);
+        std::swap(previous_, current_);
+    }
+
+    void FrameReader::append(const char* data, size_t size) {
+        // Drop the frames read so far before growing
+        if(offset_ != 0) {
+            buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<ptrdiff_t>(offset_));
+            offset_ = 0;
+        }
+        buffer_.insert(buffer_.end(), data, data + size);
+    }
+
+    bool FrameReader::next(Frame& frame) {
+        if(failed_ || buffer_.size() - offset_ < frame::header_size) return false;
+        const char* header = buffer_.data() + offset_;
+        if(header[0] != 'S' || header[1] != 'M' || static_cast<uint8_t>(header[2]) != frame::version) {
+            failed_ = true;
+            return false;
+        }
+        size_t length = 0;
+        for(size_t i = 0; i < 4; ++i)
+            length |= static_cast<size_t>(static_cast<unsigned char>(header[4 + i])) << (8 * i);
+        if(length > frame::max_payload) {
+            failed_ = true;
+            return false;
+        }
+        if(buffer_.size() - offset_ < frame::header_size + length) return false;
+
+        frame.type = static_cast<uint8_t>(header[3]);
+        frame.payload = std::string_view(header + frame::header_size, length);
+        offset_ += frame::header_size + length;
+        return true;
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef SAMPLE_FRAME_HPP
+#define SAMPLE_FRAME_HPP
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace system_monitor {
+
+    // What an agent reports about its host once per interval
+    struct HostSample {
+        uint64_t time_ms = 0;               // agent wall clock, ms since the epoch
+        double cpu_usage = 0.0;             // 0..1
+        std::vector<double> core_usages;
+        double ram_usage = 0.0;
+        unsigned long long ram_total = 0;   // bytes
+        unsigned long long ram_used = 0;
+        double download_rate = 0.0;         // bytes/s
+        double upload_rate = 0.0;
+        double root_usage = 0.0;            // usage of "/"
+        unsigned long uptime = 0;           // seconds
+        unsigned long procs_num = 0;
+    };
+
+    // Binary frames between agents and the aggregator. Every frame starts
+    // with an 8-byte header: magic "SM", version, type and the payload
+    // length (little endian u32). Integers are little endian, usages are
+    // u16 in 1/10000, so a sample of a 64-core host is about 180 bytes.
+    // A connection sends one full sample, then deltas (see DeltaEncoder).
+    namespace frame {
+        constexpr uint8_t version = 1;
+        constexpr size_t header_size = 8;
+        constexpr size_t max_payload = 64 * 1024;
+
+        enum Type : uint8_t {
+            hello = 1,          // payload: host name
+            sample = 2,         // payload: HostSample
+            delta = 3,          // payload: fields changed since the previous sample
+        };
+
+        // Fields of a delta frame, in payload order after the time
+        enum DeltaField : uint16_t {
+            delta_cpu = 1 << 0, delta_ram = 1 << 1, delta_ram_total = 1 << 2, delta_ram_used = 1 << 3,
+            delta_download = 1 << 4, delta_upload = 1 << 5, delta_root = 1 << 6, delta_uptime = 1 << 7,
+            delta_procs = 1 << 8, delta_cores = 1 << 9,
+        };
+
+        void append_hello(std::string& out, std::string_view host);
+        void append_sample(std::string& out, const HostSample& sample);
+
+        bool decode_hello(std::string_view payload, std::string& host);
+        bool decode_sample(std::string_view payload, HostSample& sample);
+        // Applies a delta to the previous sample of the connection
+        bool decode_delta(std::string_view payload, HostSample& sample);
+    }
+
+    // Encodes the successive samples of one connection: a full sample frame
+    // first (and whenever the number of cores changes), then delta frames
+    // holding the time, a u16 field mask and the fields whose wire value
+    // changed. Cores are sent as a bitmap of the changed ones followed by
+    // their values. Changes are found on the quantised values, so noise
+    // below the wire resolution costs nothing.
+    class DeltaEncoder {
+        public:
+            void append(std::string& out, const HostSample& sample);
+            void reset() { has_previous_ = false; }      // on a new connection
+
+        private:
+            // What went on the wire last time
+            struct Wire {
+                uint16_t cpu = 0, ram = 0, root = 0;
+                uint64_t ram_total = 0, ram_used = 0;
+                uint32_t download = 0, upload = 0, uptime = 0, procs = 0;
+                std::vector<uint16_t> cores;
+            };
+            Wire previous_;
+            Wire current_;
+            bool has_previous_ = false;
+
+            static void quantise(const HostSample& sample, Wire& wire);
+    };
+
+    // Splits a byte stream into frames. Bytes are appended as they arrive,
+    // next() returns the complete frames one after another; the payload
+    // stays valid until the next call to append().
+    class FrameReader {
+        public:
+            struct Frame {
+                uint8_t type = 0;
+                std::string_view payload;
+            };
+
+            void append(const char* data, size_t size);
+            bool next(Frame& frame);
+
+            // Bad magic, version or length; the stream cannot be resynchronised
+            bool failed() const { return failed_; }
+            size_t buffered() const { return buffer_.size() - offset_; }
+
+        private:
+            std::vector<char> buffer_;
+            size_t offset_ = 0;             // start of the first unread frame
+            bool failed_ = false;
+    };
+}
+
+#endif
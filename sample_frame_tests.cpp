@@ -0,0 +1,207 @@
+#include "catch_amalgamated.hpp"
+#include "sample_frame.hpp"
+#include <string>
+
+using system_monitor::FrameReader;
+using system_monitor::HostSample;
+namespace frame = system_monitor::frame;
+
+namespace {
+    HostSample make_sample(size_t cores) {
+        HostSample sample;
+        sample.time_ms = 1700000000123;
+        sample.cpu_usage = 0.4321;
+        for(size_t core = 0; core < cores; ++core)
+            sample.core_usages.push_back(static_cast<double>(core) / static_cast<double>(cores));
+        sample.ram_usage = 0.75;
+        sample.ram_total = 64ull << 30;
+        sample.ram_used = 48ull << 30;
+        sample.download_rate = 1536.0 * 1024.0;
+        sample.upload_rate = 12.5;
+        sample.root_usage = 0.5;
+        sample.uptime = 123456;
+        sample.procs_num = 789;
+        return sample;
+    }
+}
+
+// Frames Tests
+// encoding
+TEST_CASE("Sample frame round trip", "[frame]") {
+    HostSample sample = make_sample(64);
+    std::string out;
+    frame::append_sample(out, sample);
+    CHECK(out.size() == 184);
+
+    FrameReader reader;
+    reader.append(out.data(), out.size());
+    FrameReader::Frame next;
+    REQUIRE(reader.next(next));
+    CHECK(next.type == frame::sample);
+
+    HostSample decoded;
+    REQUIRE(frame::decode_sample(next.payload, decoded));
+    CHECK(decoded.time_ms == sample.time_ms);
+    CHECK(decoded.cpu_usage == Catch::Approx(0.4321).margin(1e-4));
+    REQUIRE(decoded.core_usages.size() == 64);
+    for(size_t core = 0; core < 64; ++core)
+        CHECK(decoded.core_usages[core] == Catch::Approx(sample.core_usages[core]).margin(1e-4));
+    CHECK(decoded.ram_usage == Catch::Approx(0.75));
+    CHECK(decoded.ram_total == sample.ram_total);
+    CHECK(decoded.ram_used == sample.ram_used);
+    CHECK(decoded.download_rate == Catch::Approx(sample.download_rate));
+    CHECK(decoded.upload_rate == Catch::Approx(12.5));
+    CHECK(decoded.root_usage == Catch::Approx(0.5));
+    CHECK(decoded.uptime == 123456);
+    CHECK(decoded.procs_num == 789);
+
+    CHECK_FALSE(reader.next(next));
+    CHECK(reader.buffered() == 0);
+}
+
+TEST_CASE("Sample frame truncated payload", "[frame]") {
+    std::string out;
+    frame::append_sample(out, make_sample(4));
+    std::string_view payload(out.data() + frame::header_size, out.size() - frame::header_size);
+
+    HostSample decoded;
+    CHECK_FALSE(frame::decode_sample(payload.substr(0, payload.size() - 1), decoded));
+    CHECK_FALSE(frame::decode_sample(payload.substr(0, 10), decoded));
+    CHECK(frame::decode_sample(payload, decoded));
+}
+
+// stream splitting
+TEST_CASE("FrameReader partial reads", "[frame][FrameReader]") {
+    std::string out;
+    frame::append_hello(out, "host-1");
+    for(size_t i = 0; i < 10; ++i)
+        frame::append_sample(out, make_sample(i));
+
+    // One byte at a time, every frame comes out once it is complete
+    FrameReader reader;
+    FrameReader::Frame next;
+    size_t frames = 0;
+    std::string host;
+    for(char byte : out) {
+        reader.append(&byte, 1);
+        while(reader.next(next)) {
+            if(frames == 0) {
+                CHECK(next.type == frame::hello);
+                CHECK(frame::decode_hello(next.payload, host));
+            } else {
+                HostSample decoded;
+                CHECK(next.type == frame::sample);
+                CHECK(frame::decode_sample(next.payload, decoded));
+                CHECK(decoded.core_usages.size() == frames - 1);
+            }
+            ++frames;
+        }
+    }
+    CHECK(frames == 11);
+    CHECK(host == "host-1");
+    CHECK_FALSE(reader.failed());
+    CHECK(reader.buffered() == 0);
+}
+
+TEST_CASE("FrameReader rejects bad streams", "[frame][FrameReader]") {
+    FrameReader::Frame next;
+
+    SECTION("bad magic") {
+        FrameReader reader;
+        std::string data = "XX\x01\x02\0\0\0\0";
+        reader.append(data.data(), 8);
+        CHECK_FALSE(reader.next(next));
+        CHECK(reader.failed());
+    }
+
+    SECTION("newer version") {
+        std::string out;
+        frame::append_hello(out, "host");
+        out[2] = static_cast<char>(frame::version + 1);
+        FrameReader reader;
+        reader.append(out.data(), out.size());
+        CHECK_FALSE(reader.next(next));
+        CHECK(reader.failed());
+    }
+
+    SECTION("oversized payload") {
+        std::string data = "SM";
+        data += static_cast<char>(frame::version);
+        data += static_cast<char>(frame::sample);
+        data += std::string("\xff\xff\xff\x7f", 4);
+        FrameReader reader;
+        reader.append(data.data(), data.size());
+        CHECK_FALSE(reader.next(next));
+        CHECK(reader.failed());
+    }
+}
+
+// deltas
+TEST_CASE("DeltaEncoder round trip", "[frame][DeltaEncoder]") {
+    system_monitor::DeltaEncoder encoder;
+    HostSample sample = make_sample(64);
+    std::string out;
+    encoder.append(out, sample);
+    CHECK(out.size() == 184);           // full sample first
+
+    FrameReader reader;
+    FrameReader::Frame next;
+    HostSample decoded;
+    reader.append(out.data(), out.size());
+    REQUIRE(reader.next(next));
+    REQUIRE(next.type == frame::sample);
+    REQUIRE(frame::decode_sample(next.payload, decoded));
+
+    SECTION("unchanged sample") {
+        out.clear();
+        sample.time_ms += 1000;
+        encoder.append(out, sample);
+        CHECK(out.size() == frame::header_size + 10);      // time and mask only
+        reader.append(out.data(), out.size());
+        REQUIRE(reader.next(next));
+        CHECK(next.type == frame::delta);
+        REQUIRE(frame::decode_delta(next.payload, decoded));
+        CHECK(decoded.time_ms == sample.time_ms);
+    }
+
+    SECTION("some fields and cores change") {
+        // Changes below the wire resolution are not sent
+        sample.ram_usage += 1e-6;
+        sample.cpu_usage = 0.9;
+        sample.uptime += 1;
+        sample.core_usages[3] = 0.25;
+        sample.core_usages[60] = 0.75;
+        out.clear();
+        encoder.append(out, sample);
+        CHECK(out.size() == frame::header_size + 10 + 2 + 4 + 2 + 8 + 2 * 2);
+        reader.append(out.data(), out.size());
+        REQUIRE(reader.next(next));
+        REQUIRE(frame::decode_delta(next.payload, decoded));
+        CHECK(decoded.cpu_usage == Catch::Approx(0.9).margin(1e-4));
+        CHECK(decoded.uptime == sample.uptime);
+        CHECK(decoded.ram_usage == Catch::Approx(0.75).margin(1e-4));
+        for(size_t core = 0; core < 64; ++core)
+            CHECK(decoded.core_usages[core] == Catch::Approx(sample.core_usages[core]).margin(1e-4));
+    }
+
+    SECTION("core count changes") {
+        sample.core_usages.push_back(0.5);
+        out.clear();
+        encoder.append(out, sample);
+        reader.append(out.data(), out.size());
+        REQUIRE(reader.next(next));
+        CHECK(next.type == frame::sample);
+    }
+
+    SECTION("delta against another core count") {
+        sample.cpu_usage = 0.1;
+        sample.core_usages[0] = 0.9;
+        out.clear();
+        encoder.append(out, sample);
+        std::string_view payload(out.data() + frame::header_size, out.size() - frame::header_size);
+        HostSample other = make_sample(8);
+        CHECK_FALSE(frame::decode_delta(payload, other));
+        CHECK(other.cpu_usage == Catch::Approx(0.4321));        // left untouched
+        CHECK_FALSE(frame::decode_delta(payload.substr(0, payload.size() - 1), decoded));
+    }
+}
@@ -0,0 +1,376 @@
+#ifndef SAMPLER_HPP
+#define SAMPLER_HPP
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "alerts.hpp"
+#include "self_overhead.hpp"
+#include "system_monitor.hpp"
+#include "timer_wheel.hpp"
+
+namespace system_monitor {
+
+    template <typename M>
+    class Sampler;
+
+    // Samples each collector of a BasicMonitor on its own period from a
+    // dedicated thread. A timer wheel tells which collectors are due, the
+    // ones due on the same tick are sampled as one batch and published
+    // together. The procfs reads of a batch are issued at once through a
+    // shared ProcfsReader. Readers copy the published samples under a short lock.
+    // Published samples of MetricCollectors also go into a MetricTable of
+    // sliding quantile sketches, and the alert rules are evaluated on it
+    // after every publish. The thread accounts its own cost per collector
+    // (see OverheadMeter); with a budget the periods of the costliest
+    // collectors are stretched until it fits.
+    template <Collector... Collectors>
+    class Sampler<BasicMonitor<Collectors...>> {
+        public:
+            using Monitor = BasicMonitor<Collectors...>;
+            using Clock = std::chrono::steady_clock;
+
+            static constexpr std::chrono::milliseconds tick{10};
+
+            Sampler() : thread_([this] { run(); }) {}
+
+            ~Sampler() {
+                {
+                    std::lock_guard lock(mutex_);
+                    stop_ = true;
+                }
+                wake_.notify_one();
+                thread_.join();
+            }
+
+            Sampler(const Sampler&) = delete;
+            Sampler& operator=(const Sampler&) = delete;
+
+            // Copies the last sample of C into out if it is newer than `seen`
+            // and updates `seen`; false when nothing new was published
+            template <typename C> requires Monitor::template has<C>
+            bool read(typename C::Sample& out, uint64_t& seen) const {
+                std::lock_guard lock(mutex_);
+                uint64_t generation = generations_[index_of<C>()];
+                if(generation == seen) return false;
+                out = std::get<typename C::Sample>(published_);
+                seen = generation;
+                return true;
+            }
+
+            // Number of samples of C published so far
+            template <typename C> requires Monitor::template has<C>
+            uint64_t generation() const {
+                std::lock_guard lock(mutex_);
+                return generations_[index_of<C>()];
+            }
+
+            // Calls f(const MetricTable&, Clock::time_point now) under the lock;
+            // queries should stay short, they hold up the next publish
+            template <typename F>
+            void with_metrics(F&& f) const {
+                std::lock_guard lock(mutex_);
+                f(std::as_const(metrics_), Clock::now());
+            }
+
+            // Replaces the alert rules (see AlertRules), returns the lines that did not compile
+            std::vector<AlertRules::Error> set_alert_rules(std::string_view source) {
+                std::vector<AlertRules::Error> errors;
+                {
+                    std::lock_guard lock(mutex_);
+                    errors = alerts_.compile(source, metrics_);
+                    rule_sources_pending_ = true;
+                    rules_checked_ = false;
+                    update_rule_collectors();
+                }
+                wake_.notify_one();
+                return errors;
+            }
+
+            // Called on the sampler thread, with the lock held, once every
+            // collector and the overhead meter recorded their metrics after
+            // set_alert_rules(), with the rules on metrics nobody recorded
+            // (see AlertRules::unrecorded); it must not call back into the sampler
+            void set_alert_warning_listener(std::function<void(std::span<const AlertRules::Error>)> listener) {
+                std::lock_guard lock(mutex_);
+                alert_warning_listener_ = std::move(listener);
+            }
+
+            // Called on the sampler thread, with the lock held, when rules
+            // fired or resolved; it must not call back into the sampler
+            void set_alert_listener(std::function<void(const AlertRules&, std::span<const AlertEvent>)> listener) {
+                std::lock_guard lock(mutex_);
+                alert_listener_ = std::move(listener);
+            }
+
+            // Cost of the sampler over the last OverheadMeter::window, like read()
+            bool read_overhead(Overhead& out, uint64_t& seen) const {
+                std::lock_guard lock(mutex_);
+                if(overhead_generation_ == seen) return false;
+                out = overhead_;
+                seen = overhead_generation_;
+                return true;
+            }
+
+            // Share of one core the sampler thread may use (0.01 for 1%), 0 for
+            // no limit; applied at the end of every overhead window
+            void set_overhead_budget(double share) {
+                std::lock_guard lock(mutex_);
+                overhead_budget_ = share;
+            }
+
+            // In background only the collectors declaring keep_in_background
+            // are sampled, every `interval` (zero suspends them), and the ones
+            // recording a metric of an alert rule keep their own period so
+            // that the rules still see current values. Going back to
+            // foreground samples every collector at once.
+            void set_background(bool background, std::chrono::milliseconds interval = {}) {
+                {
+                    std::lock_guard lock(mutex_);
+                    background_ = background;
+                    background_interval_ = interval;
+                    mode_changed_ = true;
+                }
+                wake_.notify_one();
+            }
+
+            // Called on the sampler thread after a batch containing a
+            // keep_in_background collector was published
+            void set_listener(std::function<void()> listener) {
+                std::lock_guard lock(mutex_);
+                listener_ = std::move(listener);
+            }
+
+        private:
+            static constexpr size_t n_collectors = sizeof...(Collectors);
+            static constexpr std::array<std::chrono::milliseconds, n_collectors> periods{sampling_period<Collectors>()...};
+            static constexpr std::array<bool, n_collectors> background_collectors{keeps_in_background<Collectors>()...};
+
+            template <typename C>
+            static constexpr size_t index_of() {
+                constexpr std::array<bool, n_collectors> matches{std::same_as<C, Collectors>...};
+                for(size_t i = 0; i < n_collectors; ++i) {
+                    if(matches[i]) return i;
+                }
+                return n_collectors;
+            }
+
+            static uint64_t to_ticks(std::chrono::milliseconds duration) {
+                return static_cast<uint64_t>((duration + tick - std::chrono::milliseconds(1)) / tick);
+            }
+
+            Monitor monitor_;       // only touched by the sampler thread
+            TimerWheel wheel_;
+            ProcfsReader reader_;
+            OverheadMeter meter_{{collector_name<Collectors>()...}, {sampling_period<Collectors>()...}};
+
+            mutable std::mutex mutex_;
+            std::condition_variable wake_;
+            std::tuple<typename Collectors::Sample...> published_;
+            std::array<uint64_t, n_collectors> generations_{};
+            MetricTable metrics_;
+            AlertRules alerts_;
+            std::array<AlertEvent, 64> alert_events_{};
+            std::function<void(const AlertRules&, std::span<const AlertEvent>)> alert_listener_;
+            std::function<void(std::span<const AlertRules::Error>)> alert_warning_listener_;
+            std::function<void()> listener_;
+            Overhead overhead_;
+            uint64_t overhead_generation_ = 0;
+            double overhead_budget_ = 0.0;
+            bool stop_ = false;
+            bool background_ = false;
+            bool mode_changed_ = false;
+            std::chrono::milliseconds background_interval_{};
+            uint32_t rule_collectors_ = 0;          // mask of the collectors recording metrics of the rules
+            bool rule_sources_pending_ = false;     // a rule metric not recorded yet
+            bool rules_checked_ = true;             // unrecorded rule metrics were reported
+
+            std::thread thread_;    // last, starts once everything above is constructed
+
+            void run() {
+                const auto start = Clock::now();
+                std::vector<uint32_t> due;
+                bool background = false;
+                uint64_t background_ticks = 0;
+                uint32_t rule_collectors = 0;
+
+                attach(std::index_sequence_for<Collectors...>{});
+                meter_.attach(reader_);
+                meter_.start(Clock::now(), ThreadUsage::now());
+                for(size_t i = 0; i < n_collectors; ++i)
+                    wheel_.schedule(static_cast<uint32_t>(i), 0);
+
+                std::unique_lock lock(mutex_);
+                while(!stop_) {
+                    if(mode_changed_) {
+                        mode_changed_ = false;
+                        background = background_;
+                        background_ticks = to_ticks(background_interval_);
+                        rule_collectors = rule_collectors_;
+                        reschedule(background, background_ticks, rule_collectors);
+                    }
+
+                    uint64_t next = wheel_.next_expiry();
+                    if(next == TimerWheel::no_expiry) {
+                        wake_.wait(lock, [this] { return stop_ || mode_changed_; });
+                        continue;
+                    }
+                    if(wake_.wait_until(lock, start + next * tick, [this] { return stop_ || mode_changed_; }))
+                        continue;
+                    lock.unlock();
+
+                    uint64_t now = static_cast<uint64_t>((Clock::now() - start) / tick);
+                    due.clear();
+                    wheel_.advance(now, due);
+
+                    uint32_t mask = 0;
+                    for(uint32_t id : due) {
+                        mask |= uint32_t(1) << id;
+                        bool own_period = !background || (rule_collectors >> id & 1);
+                        uint64_t delay = own_period ? to_ticks(periods[id]) * meter_.stretch(id) : background_ticks;
+                        if(delay != 0)
+                            wheel_.schedule(id, delay);
+                    }
+                    bool close_window = meter_.due(Clock::now());
+                    sample(mask, close_window, std::index_sequence_for<Collectors...>{});
+
+                    lock.lock();
+                    publish(mask, close_window, std::index_sequence_for<Collectors...>{});
+                    bool notify = false;
+                    for(size_t i = 0; i < n_collectors; ++i)
+                        notify |= (mask >> i & 1) && background_collectors[i];
+                    if(notify && listener_) {
+                        auto listener = listener_;
+                        lock.unlock();
+                        listener();
+                        lock.lock();
+                    }
+                }
+            }
+
+            // Called with the lock held, only the sampler thread touches the wheel
+            void reschedule(bool background, uint64_t background_ticks, uint32_t rule_collectors) {
+                wheel_.clear();
+                for(size_t i = 0; i < n_collectors; ++i) {
+                    auto id = static_cast<uint32_t>(i);
+                    if(background) {
+                        if(rule_collectors >> i & 1) {
+                            if(periods[i].count() != 0)
+                                wheel_.schedule(id, to_ticks(periods[i]) * meter_.stretch(id));
+                        } else if(background_collectors[i] && background_ticks != 0) {
+                            wheel_.schedule(id, background_ticks);
+                        }
+                    } else if(periods[i].count() != 0 || generations_[i] == 0) {
+                        wheel_.schedule(id, 0);
+                    }
+                }
+            }
+
+            template <size_t... I>
+            void attach(std::index_sequence<I...>) {
+                (attach(monitor_.template at<I>()), ...);
+            }
+
+            template <typename C>
+            void attach(C& collector) {
+                if constexpr (ProcfsCollector<C>) collector.attach(reader_);
+            }
+
+            template <typename C>
+            static void prefetch(C& collector) {
+                if constexpr (ProcfsCollector<C>) collector.prefetch();
+            }
+
+            // The thread usage is taken between the steps, so that each
+            // measurement ends where the next one starts
+            template <size_t... I>
+            void sample(uint32_t mask, bool close_window, std::index_sequence<I...>) {
+                ((mask >> I & 1 ? prefetch(monitor_.template at<I>()) : void()), ...);
+                if(close_window) meter_.prefetch();
+                ThreadUsage usage = ThreadUsage::now();
+                reader_.read_queued();
+                ThreadUsage after = ThreadUsage::now();
+                meter_.add_reads(usage, after);
+                usage = after;
+                ((mask >> I & 1 ? sample_one<I>(usage) : void()), ...);
+                meter_.count_tick();
+            }
+
+            template <size_t I>
+            void sample_one(ThreadUsage& usage) {
+                monitor_.template at<I>().sample();
+                ThreadUsage after = ThreadUsage::now();
+                meter_.add(I, usage, after);
+                usage = after;
+            }
+
+            template <size_t... I>
+            void publish(uint32_t mask, bool close_window, std::index_sequence<I...>) {
+                ((mask >> I & 1 ? (std::get<I>(published_) = monitor_.template at<I>().last(), ++generations_[I], void()) : void()), ...);
+                auto now = Clock::now();
+                ((mask >> I & 1 ? record_metrics<I>(now) : void()), ...);
+                metrics_.set_source(MetricTable::no_source);
+                update_rule_collectors();
+                if(close_window) {
+                    meter_.close(now, ThreadUsage::now(), overhead_budget_);
+                    meter_.record_metrics(metrics_, now);
+                    overhead_ = meter_.last();
+                    ++overhead_generation_;
+                }
+
+                if(!rules_checked_ && overhead_generation_ != 0 &&
+                   std::all_of(generations_.begin(), generations_.end(), [](uint64_t generation) { return generation != 0; })) {
+                    rules_checked_ = true;
+                    auto errors = alerts_.unrecorded(metrics_);
+                    if(!errors.empty() && alert_warning_listener_)
+                        alert_warning_listener_(errors);
+                }
+
+                size_t n_events = alerts_.evaluate(metrics_, now, alert_events_.data(), alert_events_.size());
+                if(n_events != 0 && alert_listener_)
+                    alert_listener_(alerts_, std::span<const AlertEvent>(alert_events_.data(), n_events));
+            }
+
+            template <size_t I>
+            void record_metrics(Clock::time_point now) {
+                using C = std::tuple_element_t<I, std::tuple<Collectors...>>;
+                if constexpr (MetricCollector<C>) {
+                    metrics_.set_source(static_cast<uint8_t>(I));
+                    monitor_.template at<I>().record_metrics(metrics_, now);
+                }
+            }
+
+            // Called with the lock held; until every rule metric was recorded
+            // once, looks for the collectors recording them. A change in
+            // background reschedules at the next wake up.
+            void update_rule_collectors() {
+                if(!rule_sources_pending_) return;
+                uint32_t collectors = 0;
+                bool pending = false;
+                for(uint32_t rule = 0; rule < alerts_.size(); ++rule) {
+                    uint8_t source = metrics_.source(alerts_.metric(rule));
+                    if(source < n_collectors)
+                        collectors |= uint32_t(1) << source;
+                    else
+                        pending = true;
+                }
+                rule_sources_pending_ = pending;
+                if(collectors != rule_collectors_) {
+                    rule_collectors_ = collectors;
+                    if(background_) mode_changed_ = true;
+                }
+            }
+
+            static_assert(n_collectors <= 32, "collector ids are kept in a 32-bit mask");
+    };
+}
+
+#endif
@@ -0,0 +1,198 @@
+#include "catch_amalgamated.hpp"
+#include "sampler.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Collectors counting their own samples
+    template <int Period, bool Background = false>
+    class Counter {
+        public:
+            static constexpr std::chrono::milliseconds period{Period};
+            static constexpr bool keep_in_background = Background;
+
+            struct Sample {
+                int count = 0;
+            };
+
+            void sample() { ++last_.count; }
+            const Sample& last() const { return last_; }
+
+        private:
+            Sample last_;
+    };
+
+    // Counter recording its count as a metric, for alert rules
+    class Recorded : public Counter<10> {
+        public:
+            void record_metrics(system_monitor::MetricTable& metrics, std::chrono::steady_clock::time_point now) {
+                if(metric_ == system_monitor::MetricTable::no_metric) metric_ = metrics.add("recorded.count");
+                metrics.record(metric_, last().count, now);
+            }
+
+        private:
+            system_monitor::MetricTable::Id metric_ = system_monitor::MetricTable::no_metric;
+    };
+
+    using Fast = Counter<10>;
+    using Once = Counter<0>;
+    using Slow = Counter<3600000>;
+    using History = Counter<10, true>;
+
+    template <typename S>
+    bool wait_for(S condition) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while(!condition()) {
+            if(std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+}
+
+// Sampler Tests
+// every collector is sampled once at start, then on its own period
+TEST_CASE("Sampler periods", "[sampler]") {
+    system_monitor::Sampler<system_monitor::BasicMonitor<Fast, Once, Slow>> sampler;
+
+    CHECK(wait_for([&] { return sampler.generation<Fast>() >= 5; }));
+    CHECK(sampler.generation<Once>() == 1);
+    CHECK(sampler.generation<Slow>() == 1);
+
+    Fast::Sample sample;
+    uint64_t seen = 0;
+    CHECK(sampler.read<Fast>(sample, seen));
+    CHECK(seen >= 5);
+    CHECK(sample.count == static_cast<int>(seen));
+}
+
+// only keep_in_background collectors run in background, all of them resume in foreground
+TEST_CASE("Sampler background", "[sampler]") {
+    system_monitor::Sampler<system_monitor::BasicMonitor<Fast, Once, History>> sampler;
+    CHECK(wait_for([&] { return sampler.generation<Fast>() >= 2; }));
+
+    sampler.set_background(true, std::chrono::milliseconds(10));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    uint64_t fast = sampler.generation<Fast>();
+    uint64_t history = sampler.generation<History>();
+    CHECK(wait_for([&] { return sampler.generation<History>() >= history + 3; }));
+    CHECK(sampler.generation<Fast>() == fast);
+
+    sampler.set_background(true, std::chrono::milliseconds(0));     // suspended
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    history = sampler.generation<History>();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(sampler.generation<History>() == history);
+
+    sampler.set_background(false);
+    CHECK(wait_for([&] { return sampler.generation<Fast>() > fast; }));
+    CHECK(sampler.generation<Once>() == 1);
+}
+
+// collectors feeding alert rules keep their period in background
+TEST_CASE("Sampler background alert rules", "[sampler]") {
+    system_monitor::Sampler<system_monitor::BasicMonitor<Fast, Recorded, History>> sampler;
+    REQUIRE(sampler.set_alert_rules("recorded.count < 0").empty());
+    CHECK(wait_for([&] { return sampler.generation<Recorded>() >= 2; }));
+
+    sampler.set_background(true, std::chrono::milliseconds(0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    uint64_t fast = sampler.generation<Fast>();
+    uint64_t recorded = sampler.generation<Recorded>();
+    CHECK(wait_for([&] { return sampler.generation<Recorded>() >= recorded + 3; }));
+    CHECK(sampler.generation<Fast>() == fast);
+
+    // Without the rules it is suspended like the others
+    sampler.set_alert_rules("");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    recorded = sampler.generation<Recorded>();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(sampler.generation<Recorded>() == recorded);
+}
+
+// rules on metrics no collector recorded are reported after the first round
+TEST_CASE("Sampler alert warnings", "[sampler]") {
+    std::mutex mutex;
+    std::vector<system_monitor::AlertRules::Error> warnings;
+    system_monitor::Sampler<system_monitor::BasicMonitor<Fast, Recorded>> sampler;
+    sampler.set_alert_warning_listener([&](std::span<const system_monitor::AlertRules::Error> errors) {
+        std::lock_guard lock(mutex);
+        warnings.assign(errors.begin(), errors.end());
+    });
+    REQUIRE(sampler.set_alert_rules("recorded.count < 0\nrecorded.cuont < 0\nmonitor.cpu > 50").empty());
+
+    CHECK(wait_for([&] {
+        std::lock_guard lock(mutex);
+        return !warnings.empty();
+    }));
+    std::lock_guard lock(mutex);
+    REQUIRE(warnings.size() == 1);
+    CHECK(warnings[0].line == 2);
+}
+
+// the listener is called for batches containing a background collector
+TEST_CASE("Sampler listener", "[sampler]") {
+    std::atomic<int> calls = 0;
+    system_monitor::Sampler<system_monitor::BasicMonitor<Fast, History>> sampler;
+    sampler.set_listener([&] { ++calls; });
+    CHECK(wait_for([&] { return calls >= 3; }));
+}
+
+// procfs collectors read through the sampler's shared reader
+TEST_CASE("Sampler procfs batch", "[sampler]") {
+    system_monitor::Sampler<system_monitor::BasicMonitor<system_monitor::Cpu, system_monitor::Network>> sampler;
+    CHECK(wait_for([&] { return sampler.generation<system_monitor::Cpu>() >= 3; }));
+
+    system_monitor::Cpu::Sample cpu;
+    uint64_t seen = 0;
+    CHECK(sampler.read<system_monitor::Cpu>(cpu, seen));
+    CHECK(!cpu.core_usages.empty());
+    CHECK(cpu.usage >= 0.0);
+    CHECK(cpu.usage <= 1.0);
+}
+
+// published samples of metric collectors land in the sketches
+TEST_CASE("Sampler metrics", "[sampler]") {
+    using system_monitor::MetricTable;
+    system_monitor::Sampler<system_monitor::BasicMonitor<system_monitor::Cpu, system_monitor::Ram>> sampler;
+    CHECK(wait_for([&] { return sampler.generation<system_monitor::Cpu>() >= 3; }));
+
+    sampler.with_metrics([](const MetricTable& metrics, auto now) {
+        MetricTable::Id cpu = metrics.find("cpu.usage");
+        REQUIRE(cpu != MetricTable::no_metric);
+        CHECK(metrics.find("cpu.core0.usage") != MetricTable::no_metric);
+        CHECK(metrics.find("ram.usage") != MetricTable::no_metric);
+
+        auto quantiles = metrics.quantiles(cpu, system_monitor::MetricWindow::minute, now);
+        CHECK(quantiles.count >= 3);
+        CHECK(quantiles.p50 <= quantiles.p99);
+        CHECK(quantiles.max <= 100.0);
+    });
+}
+
+// the sampler accounts its own cost per collector once per window
+TEST_CASE("Sampler overhead", "[sampler]") {
+    system_monitor::Sampler<system_monitor::BasicMonitor<system_monitor::Cpu, Fast>> sampler;
+    sampler.set_overhead_budget(0.5);
+
+    system_monitor::Overhead overhead;
+    uint64_t seen = 0;
+    CHECK(wait_for([&] { return sampler.read_overhead(overhead, seen); }));
+    REQUIRE(overhead.collectors.size() == 2);
+    CHECK(overhead.collectors[0].name == "cpu");
+    CHECK(overhead.collectors[1].name == "collector");
+    CHECK(overhead.collectors[0].samples > 0);
+    CHECK(overhead.cpu >= overhead.collectors[0].cpu);
+    CHECK(overhead.budget == 0.5);
+    CHECK(overhead.rss > 0);
+    CHECK(overhead.syscalls > 0.0);
+
+    sampler.with_metrics([](const system_monitor::MetricTable& metrics, auto) {
+        CHECK(metrics.find("monitor.cpu") != system_monitor::MetricTable::no_metric);
+        CHECK(metrics.find("monitor.cpu.cpu") != system_monitor::MetricTable::no_metric);
+        CHECK(metrics.find("monitor.cpu.syscalls") != system_monitor::MetricTable::no_metric);
+    });
+}
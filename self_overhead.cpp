@@ -0,0 +1,154 @@
+#include "self_overhead.hpp"
+#include "procfs_parse.hpp"
+#include <algorithm>
+#include <string_view>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+namespace system_monitor {
+
+    ThreadUsage ThreadUsage::now() {
+        ThreadUsage usage;
+        usage.syscalls = thread_syscalls;
+        timespec cpu{};
+        if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu) == 0)
+            usage.cpu_ns = static_cast<uint64_t>(cpu.tv_sec) * 1000000000ull + static_cast<uint64_t>(cpu.tv_nsec);
+        rusage faults{};
+        if(getrusage(RUSAGE_THREAD, &faults) == 0) {
+            usage.minor_faults = static_cast<uint64_t>(faults.ru_minflt);
+            usage.major_faults = static_cast<uint64_t>(faults.ru_majflt);
+        }
+        count_syscalls(2);
+        return usage;
+    }
+
+    OverheadMeter::OverheadMeter(std::vector<std::string> names, std::vector<std::chrono::milliseconds> periods)
+        : periods_(std::move(periods)), stretches_(periods_.size(), 1), windows_(periods_.size()) {
+        last_.collectors.resize(names.size());
+        for(size_t i = 0; i < names.size(); ++i) {
+            last_.collectors[i].name = std::move(names[i]);
+            last_.collectors[i].period = i < periods_.size() ? periods_[i] : std::chrono::milliseconds{};
+        }
+    }
+
+    void OverheadMeter::attach(ProcfsReader& reader) {
+        statm_.attach(reader);
+    }
+
+    void OverheadMeter::start(Clock::time_point now, const ThreadUsage& thread) {
+        window_start_ = now;
+        window_end_ = now + window;
+        thread_start_ = thread;
+    }
+
+    void OverheadMeter::prefetch() {
+        statm_.prefetch();
+    }
+
+    void OverheadMeter::add_reads(const ThreadUsage& before, const ThreadUsage& after) {
+        reads_.cpu_ns += after.cpu_ns - before.cpu_ns;
+        reads_.faults += (after.minor_faults - before.minor_faults) + (after.major_faults - before.major_faults);
+        reads_.syscalls += after.syscalls - before.syscalls;
+    }
+
+    void OverheadMeter::add(size_t collector, const ThreadUsage& before, const ThreadUsage& after) {
+        Window& w = windows_[collector];
+        w.cpu_ns += after.cpu_ns - before.cpu_ns;
+        w.faults += (after.minor_faults - before.minor_faults) + (after.major_faults - before.major_faults);
+        w.syscalls += after.syscalls - before.syscalls;
+        ++w.samples;
+    }
+
+    void OverheadMeter::close(Clock::time_point now, const ThreadUsage& thread, double budget) {
+        double seconds = std::chrono::duration<double>(now - window_start_).count();
+        auto per_second = [&](uint64_t count) { return seconds > 0.0 ? static_cast<double>(count) / seconds : 0.0; };
+        auto share = [&](uint64_t cpu_ns) { return per_second(cpu_ns) / 1e9; };
+
+        last_.cpu = share(thread.cpu_ns - thread_start_.cpu_ns);
+        last_.faults = per_second((thread.minor_faults - thread_start_.minor_faults) + (thread.major_faults - thread_start_.major_faults));
+        last_.reads_cpu = share(reads_.cpu_ns);
+        last_.reads_syscalls = per_second(reads_.syscalls);
+        for(size_t i = 0; i < windows_.size(); ++i) {
+            const Window& w = windows_[i];
+            auto& collector = last_.collectors[i];
+            collector.cpu = share(w.cpu_ns);
+            collector.sample_us = w.samples != 0 ? static_cast<double>(w.cpu_ns) / 1000.0 / static_cast<double>(w.samples) : 0.0;
+            collector.faults = per_second(w.faults);
+            collector.syscalls = per_second(w.syscalls);
+            collector.samples = w.samples;
+        }
+
+        uint64_t syscalls = thread.syscalls - thread_start_.syscalls;
+        last_.syscalls = per_second(syscalls);
+        last_.syscalls_per_tick = ticks_ != 0 ? static_cast<double>(syscalls) / static_cast<double>(ticks_) : 0.0;
+
+        // statm: size resident shared ..., in pages
+        std::string_view statm = statm_.read();
+        unsigned long long resident = 0;
+        FieldScanner fields(statm);
+        if(fields.skip(1)) fields.next(resident);
+        last_.rss = resident * static_cast<unsigned long long>(sysconf(_SC_PAGESIZE));
+
+        last_.budget = budget;
+        apply_budget(budget);
+        for(size_t i = 0; i < stretches_.size(); ++i) {
+            last_.collectors[i].stretch = stretches_[i];
+            last_.collectors[i].period = periods_[i] * stretches_[i];
+        }
+
+        std::fill(windows_.begin(), windows_.end(), Window{});
+        reads_ = {};
+        ticks_ = 0;
+        window_start_ = now;
+        window_end_ = now + window;
+        thread_start_ = thread;
+    }
+
+    // Halving a stretch at most doubles the cost of that collector, so a
+    // stretch is only undone when the window plus that cost fits the budget
+    void OverheadMeter::apply_budget(double budget) {
+        size_t n = stretches_.size();
+        if(budget <= 0.0) {
+            std::fill(stretches_.begin(), stretches_.end(), 1u);
+            return;
+        }
+        if(last_.cpu > budget) {
+            size_t costliest = n;
+            for(size_t i = 0; i < n; ++i) {
+                if(periods_[i].count() == 0 || stretches_[i] >= max_stretch) continue;       // sampled once, or at the limit
+                if(costliest == n || last_.collectors[i].cpu > last_.collectors[costliest].cpu) costliest = i;
+            }
+            if(costliest != n && last_.collectors[costliest].cpu > 0.0) stretches_[costliest] *= 2;
+            return;
+        }
+        size_t stretched = n;
+        for(size_t i = 0; i < n; ++i) {
+            if(stretches_[i] > 1 && (stretched == n || stretches_[i] > stretches_[stretched])) stretched = i;
+        }
+        if(stretched != n && last_.cpu + last_.collectors[stretched].cpu < budget) stretches_[stretched] /= 2;
+    }
+
+    void OverheadMeter::record_metrics(MetricTable& metrics, Clock::time_point now) {
+        enum : size_t { cpu, rss, faults, syscalls, n_thread_metrics };
+        if(metric_ids_.empty()) {
+            metric_ids_.resize(n_thread_metrics + 2 * last_.collectors.size());
+            metric_ids_[cpu] = metrics.add("monitor.cpu");
+            metric_ids_[rss] = metrics.add("monitor.rss");
+            metric_ids_[faults] = metrics.add("monitor.faults");
+            metric_ids_[syscalls] = metrics.add("monitor.syscalls");
+            for(size_t i = 0; i < last_.collectors.size(); ++i) {
+                metric_ids_[n_thread_metrics + 2 * i] = metrics.add("monitor." + last_.collectors[i].name + ".cpu");
+                metric_ids_[n_thread_metrics + 2 * i + 1] = metrics.add("monitor." + last_.collectors[i].name + ".syscalls");
+            }
+        }
+        metrics.record(metric_ids_[cpu], last_.cpu * 100.0, now);
+        metrics.record(metric_ids_[rss], static_cast<double>(last_.rss), now);
+        metrics.record(metric_ids_[faults], last_.faults, now);
+        metrics.record(metric_ids_[syscalls], last_.syscalls, now);
+        for(size_t i = 0; i < last_.collectors.size(); ++i) {
+            metrics.record(metric_ids_[n_thread_metrics + 2 * i], last_.collectors[i].cpu * 100.0, now);
+            metrics.record(metric_ids_[n_thread_metrics + 2 * i + 1], last_.collectors[i].syscalls, now);
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef SELF_OVERHEAD_HPP
+#define SELF_OVERHEAD_HPP
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "metrics.hpp"
+#include "procfs_reader.hpp"
+#include "syscall_count.hpp"
+
+namespace system_monitor {
+
+    // Resources used by the calling thread so far
+    struct ThreadUsage {
+        uint64_t cpu_ns = 0;            // CLOCK_THREAD_CPUTIME_ID
+        uint64_t minor_faults = 0;      // getrusage(RUSAGE_THREAD)
+        uint64_t major_faults = 0;
+        uint64_t syscalls = 0;          // thread_syscalls, see syscall_count.hpp
+
+        static ThreadUsage now();
+    };
+
+    // What the monitor costs over the last window of an OverheadMeter
+    struct Overhead {
+        struct Collector {
+            std::string name;
+            double cpu = 0.0;                       // share of one core spent in sample()
+            double sample_us = 0.0;                 // mean CPU time of one sample()
+            double faults = 0.0;                    // page faults per second
+            double syscalls = 0.0;                  // per second, see syscall_count.hpp
+            uint64_t samples = 0;
+            std::chrono::milliseconds period{};     // stretched by the budget
+            unsigned stretch = 1;
+        };
+
+        std::vector<Collector> collectors;          // in the order of the composition
+        double cpu = 0.0;               // sampler thread, share of one core
+        double reads_cpu = 0.0;         // batched procfs reads, share of one core
+        double reads_syscalls = 0.0;    // batched procfs reads, per second
+        double faults = 0.0;            // sampler thread, page faults per second
+        double syscalls = 0.0;          // sampler thread, counted ones per second
+        double syscalls_per_tick = 0.0;
+        unsigned long long rss = 0;     // whole process, bytes
+        double budget = 0.0;            // share of one core, 0 without budget
+    };
+
+    // Accounts the CPU time, page faults and syscalls of a sampler thread
+    // per collector, and once per window the process RSS.
+    // With a budget, a window over it doubles the period stretch of the
+    // collector that cost the most; a window far enough under it halves the
+    // largest stretch again. Only the sampler thread calls it, besides
+    // construction. Time spent by io_uring workers on the batched reads is
+    // not part of the thread's CPU time.
+    class OverheadMeter {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            static constexpr std::chrono::milliseconds window{2000};
+            static constexpr unsigned max_stretch = 16;
+
+            OverheadMeter(std::vector<std::string> names, std::vector<std::chrono::milliseconds> periods);
+
+            // Batches the read of /proc/self/statm
+            void attach(ProcfsReader& reader);
+            void start(Clock::time_point now, const ThreadUsage& thread);
+
+            // True once the window is over; prefetch() then queues the file
+            // read by close() into the same batch
+            bool due(Clock::time_point now) const { return now >= window_end_; }
+            void prefetch();
+
+            void add_reads(const ThreadUsage& before, const ThreadUsage& after);
+            void add(size_t collector, const ThreadUsage& before, const ThreadUsage& after);
+            void count_tick() { ++ticks_; }
+
+            // Fills last() from the window, adjusts the stretches to budget
+            // (share of one core, 0 for none) and starts the next window
+            void close(Clock::time_point now, const ThreadUsage& thread, double budget);
+            const Overhead& last() const { return last_; }
+
+            // Period multiplier of a collector, 1 unless the budget was exceeded
+            unsigned stretch(size_t collector) const { return stretches_[collector]; }
+
+            // monitor.cpu/.rss/.faults/.syscalls and monitor.<collector>.cpu/.syscalls
+            void record_metrics(MetricTable& metrics, Clock::time_point now);
+
+        private:
+            struct Window {
+                uint64_t cpu_ns = 0;
+                uint64_t faults = 0;
+                uint64_t syscalls = 0;
+                uint64_t samples = 0;
+            };
+
+            std::vector<std::chrono::milliseconds> periods_;
+            std::vector<unsigned> stretches_;
+            std::vector<Window> windows_;       // per collector
+            Window reads_;
+            uint64_t ticks_ = 0;
+
+            Clock::time_point window_start_{};
+            Clock::time_point window_end_ = Clock::time_point::max();
+            ThreadUsage thread_start_;
+
+            Overhead last_;
+            ProcfsFile statm_{"/proc/self/statm"};
+            std::vector<MetricTable::Id> metric_ids_;      // whole thread figures, then cpu and syscalls per collector
+
+            void apply_budget(double budget);
+    };
+}
+
+#endif
@@ -0,0 +1,114 @@
+#include "catch_amalgamated.hpp"
+#include "self_overhead.hpp"
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+    using system_monitor::OverheadMeter;
+    using system_monitor::ThreadUsage;
+    using namespace std::chrono_literals;
+
+    ThreadUsage usage(uint64_t cpu_ms, uint64_t faults = 0, uint64_t syscalls = 0) {
+        ThreadUsage u;
+        u.cpu_ns = cpu_ms * 1000000;
+        u.minor_faults = faults;
+        u.syscalls = syscalls;
+        return u;
+    }
+}
+
+// OverheadMeter Tests
+// CPU time, faults and syscalls per collector, shares of one core over the window
+TEST_CASE("OverheadMeter window", "[self_overhead]") {
+    OverheadMeter meter({"cpu", "ram"}, {100ms, 500ms});
+    auto start = OverheadMeter::Clock::now();
+    meter.start(start, usage(1000));
+    CHECK_FALSE(meter.due(start + 1s));
+    CHECK(meter.due(start + OverheadMeter::window));
+
+    for(int i = 0; i < 20; ++i) meter.add(0, usage(0), usage(1, 1));        // 20 ms, 20 faults
+    meter.add(1, usage(0, 0, 5), usage(4, 0, 15));
+    meter.add_reads(usage(0, 0, 15), usage(2, 0, 21));
+    meter.count_tick();
+    meter.count_tick();
+    meter.close(start + 2s, usage(1040, 30, 40), 0.0);
+
+    const auto& last = meter.last();
+    REQUIRE(last.collectors.size() == 2);
+    CHECK(last.collectors[0].name == "cpu");
+    CHECK(last.cpu == Catch::Approx(0.02));
+    CHECK(last.reads_cpu == Catch::Approx(0.001));
+    CHECK(last.faults == Catch::Approx(15.0));
+    CHECK(last.syscalls == Catch::Approx(20.0));
+    CHECK(last.syscalls_per_tick == Catch::Approx(20.0));
+    CHECK(last.reads_syscalls == Catch::Approx(3.0));
+    CHECK(last.collectors[0].cpu == Catch::Approx(0.01));
+    CHECK(last.collectors[0].sample_us == Catch::Approx(1000.0));
+    CHECK(last.collectors[0].faults == Catch::Approx(10.0));
+    CHECK(last.collectors[0].samples == 20);
+    CHECK(last.collectors[1].cpu == Catch::Approx(0.002));
+    CHECK(last.collectors[1].syscalls == Catch::Approx(5.0));
+    CHECK(last.collectors[0].syscalls == 0.0);
+    CHECK(last.rss > 0);                // this process
+    CHECK(meter.stretch(0) == 1);
+    CHECK(last.collectors[0].period == 100ms);
+}
+
+// Over budget the costliest collector is stretched, under it stretches are undone
+TEST_CASE("OverheadMeter budget", "[self_overhead]") {
+    OverheadMeter meter({"cpu", "ram", "general"}, {100ms, 500ms, 0ms});
+    auto now = OverheadMeter::Clock::now();
+    uint64_t total = 0;
+    meter.start(now, usage(total));
+
+    // One window of 1 s: cpu collector costs `cpu` ms, ram 5 ms, general 50 ms
+    auto window = [&](uint64_t cpu_ms, double budget) {
+        meter.add(0, usage(0), usage(cpu_ms));
+        meter.add(1, usage(0), usage(5));
+        meter.add(2, usage(0), usage(50));
+        total += cpu_ms + 5 + 50;
+        now += 1s;
+        meter.close(now, usage(total), budget);
+    };
+
+    window(40, 0.05);       // 9.5% of a core
+    CHECK(meter.stretch(0) == 2);
+    CHECK(meter.stretch(1) == 1);
+    CHECK(meter.stretch(2) == 1);           // sampled once, never stretched
+    CHECK(meter.last().collectors[0].period == 200ms);
+
+    window(20, 0.05);       // still 7.5%
+    CHECK(meter.stretch(0) == 4);
+    window(10, 0.05);       // 6.5%, cpu still costs more than ram
+    CHECK(meter.stretch(0) == 8);
+    window(5, 0.05);        // 6%: cpu and ram tie, the first one wins
+    CHECK(meter.stretch(0) == 16);
+    window(3, 0.05);        // cpu is at the limit, ram is next
+    CHECK(meter.stretch(0) == OverheadMeter::max_stretch);
+    CHECK(meter.stretch(1) == 2);
+
+    // Undoing cpu's stretch would double its 3 ms: only when that fits
+    window(3, 0.06);        // 5.8% + 0.3% > 6%
+    CHECK(meter.stretch(0) == 16);
+    window(3, 0.07);
+    CHECK(meter.stretch(0) == 8);
+
+    window(3, 0.0);         // no budget, no stretch
+    CHECK(meter.stretch(0) == 1);
+    CHECK(meter.stretch(1) == 1);
+}
+
+// the calling thread's CPU time only grows; its counted syscalls include
+// the procfs reads and the two of ThreadUsage::now()
+TEST_CASE("ThreadUsage", "[self_overhead]") {
+    ThreadUsage before = ThreadUsage::now();
+    volatile uint64_t sum = 0;
+    for(uint64_t i = 0; i < 10000000; ++i) sum = sum + i;
+    system_monitor::ProcfsFile stat("/proc/self/stat");
+    CHECK_FALSE(stat.read().empty());
+    ThreadUsage after = ThreadUsage::now();
+    CHECK(after.cpu_ns > before.cpu_ns);
+    CHECK(after.minor_faults >= before.minor_faults);
+    CHECK(after.syscalls >= before.syscalls + 2 + 3);       // open, pread until EOF
+}
@@ -0,0 +1,18 @@
+#ifndef SYSCALL_COUNT_HPP
+#define SYSCALL_COUNT_HPP
+#include <cstdint>
+
+namespace system_monitor {
+
+    // Syscalls issued by the calling thread at the monitor's own call sites
+    // (procfs reads and opens, io_uring_enter, statvfs, sysinfo, inotify and
+    // uevent reads, cgroup and sysfs walks), read by ThreadUsage so the
+    // overhead meter can charge them to the collector that issued them.
+    // Calls libc makes on its own, e.g. for allocation, are not counted; a
+    // directory listing counts as two getdents.
+    inline thread_local uint64_t thread_syscalls = 0;
+
+    inline void count_syscalls(uint64_t n = 1) { thread_syscalls += n; }
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef SYSFS_HPP
+#define SYSFS_HPP
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <dirent.h>
+#include "syscall_count.hpp"
+
+namespace system_monitor {
+
+    // Listing of sysfs directories (cpuN, nodeN, thermal_zoneN, tempN_input)
+    // and one-line attribute files, read once at discovery
+
+    // Ids of the entries named prefix + number + suffix in a directory, ascending
+    inline std::vector<uint32_t> numbered_entries(const std::string& path, std::string_view prefix, std::string_view suffix = {}) {
+        std::vector<uint32_t> ids;
+        DIR* dir = opendir(path.c_str());
+        count_syscalls();
+        if(!dir) return ids;
+        while(dirent* entry = readdir(dir)) {
+            std::string_view name = entry->d_name;
+            if(name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix) != 0) continue;
+            if(name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) continue;
+            const char* end = name.data() + name.size() - suffix.size();
+            uint32_t id = 0;
+            auto [last, error] = std::from_chars(name.data() + prefix.size(), end, id);
+            if(error == std::errc() && last == end) ids.push_back(id);
+        }
+        closedir(dir);
+        count_syscalls(3);             // two getdents, close
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+    // First line of a file without its newline, empty if it cannot be read
+    inline std::string read_line(const std::string& path) {
+        std::ifstream file(path);
+        std::string line;
+        std::getline(file, line);
+        count_syscalls(file.is_open() ? 3 : 1);     // open, read, close
+        return line;
+    }
+}
+
+#endif
@@ -4,6 +4,41 @@
 namespace system_monitor {
     bool SystemApp::OnInit() {
         MonitorCanvas* mainframe = new MonitorCanvas("System Monitor");
+
+        // --listen PORT: also show the hosts of agents streaming to this port
+        // --connect HOST:PORT: show the agent serving viewers there (remote view)
+        // --overhead-budget PERCENT: share of one core the sampler may use
+        // --background-interval MS: network sampling period while minimised or hidden
+        // --background-history on|off: keep sampling the network and recording its history then
+        for(int i = 1; i + 1 < argc; ++i) {
+            unsigned long port = 0, interval = 0;
+            double percent = 0.0;
+            wxString option = argv[i], value = argv[i + 1];
+            if(option == "--listen") {
+                if(!value.ToULong(&port) || port == 0 || port > 65535 || !mainframe->listen(static_cast<uint16_t>(port)))
+                    wxLogError("Could not listen for agents on port %s", value);
+            } else if(option == "--connect") {
+                wxString host = value.BeforeLast(':');
+                if(host.empty() || !value.AfterLast(':').ToULong(&port) || port == 0 || port > 65535
+                   || !mainframe->connect(host.ToStdString(), static_cast<uint16_t>(port)))
+                    wxLogError("Could not connect to the agent at %s", value);
+            } else if(option == "--overhead-budget") {
+                if(value.ToDouble(&percent) && percent >= 0.0)
+                    mainframe->set_overhead_budget(percent / 100.0);
+                else
+                    wxLogError("Invalid overhead budget %s", value);
+            } else if(option == "--background-interval") {
+                if(value.ToULong(&interval) && interval > 0 && interval <= 3600000)
+                    mainframe->set_background_interval(static_cast<int>(interval));
+                else
+                    wxLogError("Invalid background interval %s", value);
+            } else if(option == "--background-history") {
+                if(value == "on" || value == "off")
+                    mainframe->set_background_history(value == "on");
+                else
+                    wxLogError("Invalid background history %s, expected on or off", value);
+            }
+        }
         mainframe->Center();
         mainframe->Show();
         return true;
@@ -1,12 +1,15 @@
 #include "system_monitor.hpp"
+#include "procfs_parse.hpp"
+#include "syscall_count.hpp"
 #include <fstream>
-#include <sstream>
 #include <string>
 #include <thread>
 #include <cstdio>
 #include <array>
 #include <chrono>
-#include <regex>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
 
 // See: https://man7.org/linux/man-pages/man2/sysinfo.2.html
 #include <sys/sysinfo.h>
@@ -23,43 +26,30 @@ namespace system_monitor {
 
     // General informations
     // uptime
-    unsigned long Monitor::General::get_uptime() {
+    unsigned long General::get_uptime() {
         struct sysinfo info;
         if(sysinfo(&info) != 0) return 0.0;
         return static_cast<unsigned long>(info.uptime);
     }
     // number of processes
-    unsigned long Monitor::General::get_procs_num() {
+    unsigned long General::get_procs_num() {
         struct sysinfo info;
         if(sysinfo(&info) != 0) return 0.0;
         return static_cast<unsigned long>(info.procs);
     }
 
     // number of cpu cores
-    unsigned int Monitor::General::get_cpu_cores() {
+    unsigned int General::get_cpu_cores() {
         return std::thread::hardware_concurrency();
     }
 
     // cpu model name
-    string Monitor::General::get_cpu_model() {
-        std::ifstream cpuinfo("/proc/cpuinfo");
-        string line, model;
-        if(!cpuinfo.is_open()) return "";
-
-        while(std::getline(cpuinfo, line)) {
-            if(line.find("model name") !=string::npos) {
-                size_t pos = line.find(":");
-                if(pos != string::npos) {
-                    model = line.substr(pos + 2);
-                    break;
-                }
-            }
-        }
-        return model;
+    string General::get_cpu_model() {
+        return CpuIdentity::system().model_name;
     }
 
     // name of product
-    string Monitor::General::get_product_name() {
+    string General::get_product_name() {
         std::ifstream file("/sys/devices/virtual/dmi/id/product_name");
         string name;
         if(!file.is_open()) return "Name of product is unknown.";
@@ -68,7 +58,7 @@ namespace system_monitor {
     }
 
     // version of os
-    string Monitor::General::get_os_version() {
+    string General::get_os_version() {
         FILE* pipe = popen("plasmashell --version 2>/dev/null", "r");
         if(!pipe)
             return "Version of OS is unknown, probably not on kde plasma.";
@@ -90,8 +80,37 @@ namespace system_monitor {
         return result;
     }
 
+    // uptime and processes on every sample, inventory only once
+    void General::sample() {
+        struct sysinfo info;
+        count_syscalls();
+        if(sysinfo(&info) == 0) {
+            last_.uptime = static_cast<unsigned long>(info.uptime);
+            last_.procs_num = static_cast<unsigned long>(info.procs);
+        }
+        if(inventory_read_) return;
+
+        last_.cpu_cores = get_cpu_cores();
+        const CpuTopology& topology = CpuTopology::system();
+        last_.cpu_physical_cores = topology.cores;
+        last_.cpu_sockets = topology.sockets;
+        last_.numa_nodes = topology.nodes;
+        last_.cpu_identity = CpuIdentity::system();
+        last_.cpu_model = last_.cpu_identity.model_name;
+        last_.product_name = get_product_name();
+        last_.os_version = get_os_version();
+        last_.kernel_version = get_kernel_version();
+        inventory_read_ = true;
+    }
+
+    void General::record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now) {
+        if(procs_metric_ == MetricTable::no_metric)
+            procs_metric_ = metrics.add("general.procs");
+        metrics.record(procs_metric_, static_cast<double>(last_.procs_num), now);
+    }
+
     // version of kernel
-    string Monitor::General::get_kernel_version() {
+    string General::get_kernel_version() {
         struct utsname buffer;
         if(uname(&buffer) != 0)
             return "Kernel version unknown";
@@ -100,151 +119,706 @@ namespace system_monitor {
 
 
     // Network
-    // Helper funtion which returns the primary wirles interface e.g. wlan...
-    string Monitor::Network::get_primary_interface() {
-        std::ifstream wireless("/proc/net/wireless");
-        string line;
-        while(std::getline(wireless, line)) {
-            std::smatch m;
-            if(std::regex_search(line, m, std::regex(R"((\w+):)"))) {
-                return m[1];
-            }
+    // Primary wireless interface, e.g. wlan0: the first "name:" line of
+    // /proc/net/wireless, after the two header lines without colons
+    std::string_view Network::primary_interface(std::string_view wireless) {
+        std::string_view line;
+        while(next_line(wireless, line)) {
+            size_t colon = line.find(':');
+            if(colon == std::string_view::npos) continue;
+            size_t start = line.find_first_not_of(' ');
+            return line.substr(start, colon - start);
         }
-        return "";
+        return {};
+    }
+
+    void Network::attach(ProcfsReader& reader) {
+        wireless_.attach(reader);
+        net_dev_.attach(reader);
+    }
+
+    void Network::prefetch() {
+        wireless_.prefetch();
+        net_dev_.prefetch();
     }
 
     // Function to update download and upload
-    void Monitor::Network::update_counter() {
-        string intf = get_primary_interface();
+    void Network::update_counter() {
+        std::string_view wireless = wireless_.read();
+        parse(wireless, net_dev_.read());
+    }
+
+    void Network::parse(std::string_view wireless, std::string_view netdev, std::chrono::steady_clock::time_point now) {
+        std::string_view intf = primary_interface(wireless);
         if(intf.empty()) return;
 
-        std::ifstream netdev("/proc/net/dev");
-        std::string line;
+        // "  wlan0: rx_bytes packets errs drop fifo frame compressed multicast tx_bytes ..."
         unsigned long long rx_bytes = 0, tx_bytes = 0;
-        while(std::getline(netdev, line)) {
-            if(line.find(intf) != std::string::npos) {
-                std::istringstream iss(line.substr(line.find(":") + 1));
-                iss >> rx_bytes;
-                for(int i = 0; i < 8; ++i){
-                    iss >> tx_bytes;
-                    break;
-                }
-            }
+        std::string_view line;
+        while(next_line(netdev, line)) {
+            size_t colon = line.find(':');
+            if(colon == std::string_view::npos) continue;
+            size_t start = line.find_first_not_of(' ');
+            if(line.substr(start, colon - start) != intf) continue;
+            FieldScanner fields(line.substr(colon + 1));
+            fields.next(rx_bytes);
+            if(fields.skip(7)) fields.next(tx_bytes);
+            break;
         }
 
-        auto now = std::chrono::steady_clock::now();
         double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(now - last_time_).count();
 
         if(last_rx_bytes_ != 0 && last_tx_bytes_ != 0 && seconds > 0) {
-            last_download_rate_ = (rx_bytes - last_rx_bytes_) / seconds;
-            last_upload_rate_ = (tx_bytes - last_tx_bytes_) / seconds;
+            // counters restart when the interface comes back
+            last_download_rate_ = rx_bytes >= last_rx_bytes_ ? static_cast<double>(rx_bytes - last_rx_bytes_) / seconds : 0.0;
+            last_upload_rate_ = tx_bytes >= last_tx_bytes_ ? static_cast<double>(tx_bytes - last_tx_bytes_) / seconds : 0.0;
         }
         last_rx_bytes_ = rx_bytes;
         last_tx_bytes_ = tx_bytes;
         last_time_ = now;
+        last_.download_rate = last_download_rate_;
+        last_.upload_rate = last_upload_rate_;
+    }
+
+    // one counter update for both directions
+    void Network::sample() {
+        update_counter();
+    }
+
+    void Network::record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now) {
+        if(download_metric_ == MetricTable::no_metric) {
+            download_metric_ = metrics.add("net.download");
+            upload_metric_ = metrics.add("net.upload");
+        }
+        metrics.record(download_metric_, last_.download_rate, now);
+        metrics.record(upload_metric_, last_.upload_rate, now);
     }
 
     // get + update last_download_rate_
-    double Monitor::Network::get_download_rate() {
+    double Network::get_download_rate() {
         update_counter();
         return last_download_rate_;
     }
 
     // get + update last_upload_rate_
-    double Monitor::Network::get_upload_rate() {
+    double Network::get_upload_rate() {
         update_counter();
         return last_upload_rate_;
     }
 
     // CPU
-    double Monitor::Cpu::get_usage() {
-        std::ifstream stat_file("/proc/stat");
-        string line;
-        if(!stat_file.is_open()) return 0.0;
-
-        std::getline(stat_file, line);
-        std::istringstream ss(line);
-
-        string cpu_label;
-        unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
-        ss >> cpu_label >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal;
-        unsigned long long idle_time = idle + iowait;
-        unsigned long long total_time = user + nice + system + idle + iowait + irq + softirq + steal;
-
-        double usage = 0.0;
-
-        if(first_call_){
-            last_total_ = total_time;
-            last_idle_ = idle_time;
-            first_call_ = false;
+    double Cpu::get_usage() {
+        std::string_view stat = stat_.read();
+        std::string_view line;
+        if(!next_line(stat, line)) return 0.0;
+        return update_usage(line);
+    }
+
+    // Usage of every core since the last call, 0.0 on the first call
+    std::vector<double> Cpu::get_core_usages() {
+        std::string_view stat = stat_.read();
+        std::string_view line;
+        std::vector<double> usages;
+
+        size_t core = 0;
+        while(next_line(stat, line)) {
+            if(line.compare(0, 3, "cpu") != 0) break;          // cpu lines come first
+            if(line.size() < 4 || line[3] < '0' || line[3] > '9') continue;     // aggregate line
+            unsigned long long id = 0;
+            parse_number(line.data() + 3, line.data() + line.size(), id);
+            usages.push_back(update_core_usage(core++, static_cast<uint32_t>(id), line));
+        }
+        return usages;
+    }
+
+    const char* Cpu::state_name(State state) {
+        static const char* const names[n_states] = {"user", "nice", "system", "idle", "iowait",
+                                                     "irq", "softirq", "steal", "guest", "guest_nice"};
+        return state < n_states ? names[state] : "";
+    }
+
+    void Cpu::set_topology(CpuTopology topology) {
+        topology_ = std::move(topology);
+        topology_set_ = true;
+        cpus_changed_ = true;
+    }
+
+    void Cpu::sample() {
+        if(!topology_set_) set_topology(CpuTopology::system());
+        std::string_view stat = stat_.read();
+        if(stat.empty()) return;
+        parse(stat);
+    }
+
+    void Cpu::parse(std::string_view stat, std::chrono::steady_clock::time_point now) {
+        size_t core = 0;
+        std::array<unsigned long long, n_counters> counters{};
+        std::string_view line;
+        while(next_line(stat, line)) {
+            if(line.compare(0, 3, "cpu") == 0) {
+                if(line.size() < 4 || line[3] < '0' || line[3] > '9') {
+                    last_.usage = update_usage(line);
+                    continue;
+                }
+                unsigned long long number = 0;
+                parse_number(line.data() + 3, line.data() + line.size(), number);
+                auto id = static_cast<uint32_t>(number);
+                if(core < last_.core_usages.size())
+                    last_.core_usages[core] = update_core_usage(core, id, line);
+                else
+                    last_.core_usages.push_back(update_core_usage(core, id, line));
+
+                if(core == last_.cpu_ids.size()) {
+                    last_.cpu_ids.push_back(id);
+                    cpus_changed_ = true;
+                } else if(last_.cpu_ids[core] != id) {
+                    last_.cpu_ids[core] = id;
+                    cpus_changed_ = true;
+                }
+                ++core;
+                continue;
+            }
+
+            // Only the first number of the other lines is used: intr and
+            // softirq continue with one column per source (thousands of
+            // interrupt lines on large machines), next_line() skips those
+            // with a single find
+            size_t space = std::min(line.size(), line.find(' '));
+            std::string_view key = line.substr(0, space);
+            unsigned long long value = 0;
+            scan_number(line.data() + space, line.data() + line.size(), value);
+            if(key == "ctxt") counters[context_switches] = value;
+            else if(key == "intr") counters[interrupts] = value;
+            else if(key == "processes") counters[forks] = value;
+            else if(key == "procs_running") last_.procs_running = static_cast<unsigned long>(value);
+            else if(key == "procs_blocked") last_.procs_blocked = static_cast<unsigned long>(value);
+        }
+        last_.core_usages.resize(core);
+        for(auto& shares : last_.states)
+            shares.resize(core + 1);
+        if(last_.cpu_ids.size() != core) {
+            last_.cpu_ids.resize(core);
+            cpus_changed_ = true;
+        }
+        if(cpus_changed_) build_groupings();
+        aggregate_groups();
+        update_counters(counters, now);
+    }
+
+    void Cpu::build_groupings() {
+        const std::vector<uint32_t>* maps[n_levels] = {&topology_.core_of, &topology_.socket_of, &topology_.node_of};
+        const uint32_t groups[n_levels] = {topology_.cores, topology_.sockets, topology_.nodes};
+        for(size_t level = 0; level < n_levels; ++level) {
+            Grouping& grouping = groupings_[level];
+            const std::vector<uint32_t>& group_by_id = *maps[level];
+            grouping.group_of.assign(last_.cpu_ids.size(), CpuTopology::unknown);
+            grouping.sizes.assign(groups[level], 0.0);
+            for(size_t core = 0; core < last_.cpu_ids.size(); ++core) {
+                uint32_t id = last_.cpu_ids[core];
+                if(id >= group_by_id.size() || group_by_id[id] >= groups[level]) continue;
+                grouping.group_of[core] = group_by_id[id];
+                grouping.sizes[group_by_id[id]] += 1.0;
+            }
+        }
+        cpus_changed_ = false;
+    }
+
+    void Cpu::aggregate_groups() {
+        std::vector<double>* usages[n_levels] = {&last_.physical_core_usages, &last_.socket_usages, &last_.node_usages};
+        for(size_t level = 0; level < n_levels; ++level) {
+            const Grouping& grouping = groupings_[level];
+            std::vector<double>& out = *usages[level];
+            out.assign(grouping.sizes.size(), 0.0);
+            for(size_t core = 0; core < grouping.group_of.size(); ++core) {
+                if(grouping.group_of[core] != CpuTopology::unknown)
+                    out[grouping.group_of[core]] += last_.core_usages[core];
+            }
+            for(size_t group = 0; group < out.size(); ++group) {
+                if(grouping.sizes[group] > 0.0) out[group] /= grouping.sizes[group];
+            }
+        }
+    }
+
+    // Rates of the ctxt, intr and processes counters since the previous parse, 0 the first time
+    void Cpu::update_counters(const std::array<unsigned long long, n_counters>& counters, std::chrono::steady_clock::time_point now) {
+        double seconds = std::chrono::duration<double>(now - last_counter_time_).count();
+        double* rates[n_counters] = {&last_.context_switch_rate, &last_.interrupt_rate, &last_.fork_rate};
+        for(size_t counter = 0; counter < n_counters; ++counter) {
+            bool valid = counters_seen_ && seconds > 0.0 && counters[counter] >= last_counters_[counter];
+            *rates[counter] = valid ? static_cast<double>(counters[counter] - last_counters_[counter]) / seconds : 0.0;
+        }
+        last_counters_ = counters;
+        last_counter_time_ = now;
+        counters_seen_ = true;
+    }
+
+    void Cpu::record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now) {
+        size_t n = last_.core_usages.size() + 1;
+        if(metric_ids_.size() != n || metric_cpu_ids_ != last_.cpu_ids) {       // first call or CPU hotplug
+            // cpu.coreN follows cpuN, not the line the CPU is on
+            metric_cpu_ids_ = last_.cpu_ids;
+            metric_ids_.resize(n);
+            metric_ids_[0] = metrics.add("cpu.usage");
+            for(size_t core = 1; core < n; ++core)
+                metric_ids_[core] = metrics.add("cpu.core" + std::to_string(last_.cpu_ids[core - 1]) + ".usage");
+            for(size_t state = 0; state < n_states; ++state)
+                state_metric_ids_[state] = metrics.add(std::string("cpu.") + state_name(static_cast<State>(state)));
+            counter_metric_ids_[context_switches] = metrics.add("cpu.context_switches");
+            counter_metric_ids_[interrupts] = metrics.add("cpu.interrupts");
+            counter_metric_ids_[forks] = metrics.add("cpu.forks");
+        }
+        metrics.record(metric_ids_[0], last_.usage * 100.0, now);
+        for(size_t core = 1; core < n; ++core)
+            metrics.record(metric_ids_[core], last_.core_usages[core - 1] * 100.0, now);
+        for(size_t state = 0; state < n_states; ++state) {
+            if(!last_.states[state].empty())
+                metrics.record(state_metric_ids_[state], last_.states[state][0] * 100.0, now);
+        }
+        metrics.record(counter_metric_ids_[context_switches], last_.context_switch_rate, now);
+        metrics.record(counter_metric_ids_[interrupts], last_.interrupt_rate, now);
+        metrics.record(counter_metric_ids_[forks], last_.fork_rate, now);
+
+        size_t sockets = last_.socket_usages.size();
+        if(group_metric_ids_.size() != sockets + last_.node_usages.size()) {
+            group_metric_ids_.resize(sockets + last_.node_usages.size());
+            for(size_t socket = 0; socket < sockets; ++socket)
+                group_metric_ids_[socket] = metrics.add("cpu.socket" + std::to_string(socket) + ".usage");
+            for(size_t node = 0; node < last_.node_usages.size(); ++node)
+                group_metric_ids_[sockets + node] = metrics.add("cpu.node" + std::to_string(node) + ".usage");
+        }
+        for(size_t socket = 0; socket < sockets; ++socket)
+            metrics.record(group_metric_ids_[socket], last_.socket_usages[socket] * 100.0, now);
+        for(size_t node = 0; node < last_.node_usages.size(); ++node)
+            metrics.record(group_metric_ids_[sockets + node], last_.node_usages[node] * 100.0, now);
+    }
+
+    // Busy ratio since the previous aggregate line, 0.0 the first time
+    double Cpu::update_usage(std::string_view line) {
+        return update_row(0, 0, line);
+    }
+
+    // Same for the "cpuN" line of CPU `id`, the core-th of the cpuN lines;
+    // the previous ticks are those of the same CPU wherever its line was
+    double Cpu::update_core_usage(size_t core, uint32_t id, std::string_view line) {
+        return update_row(size_t(id) + 1, core + 1, line);
+    }
+
+    // One pass over the numbers of the line; kernels older than 2.6.33 have
+    // fewer columns, the missing ones stay 0
+    double Cpu::update_row(size_t slot, size_t row, std::string_view line) {
+        std::array<unsigned long long, n_states> ticks{};
+        const char* p = line.data() + std::min(line.size(), line.find(' '));
+        const char* end = line.data() + line.size();
+        for(size_t state = 0; state < n_states && p < end; ++state)
+            p = scan_number(p, end, ticks[state]);
+
+        if(slot >= seen_.size()) {
+            seen_.resize(slot + 1, 0);
+            for(size_t state = 0; state < n_states; ++state)
+                last_ticks_[state].resize(slot + 1, 0);
+        }
+        if(row >= last_.states[0].size()) {
+            for(size_t state = 0; state < n_states; ++state)
+                last_.states[state].resize(row + 1, 0.0);
+        }
+
+        // Guest time is already part of user/nice
+        ticks[user] -= std::min(ticks[user], ticks[guest]);
+        ticks[nice] -= std::min(ticks[nice], ticks[guest_nice]);
+
+        std::array<unsigned long long, n_states> diff{};
+        unsigned long long total = 0;
+        for(size_t state = 0; state < n_states; ++state) {
+            unsigned long long previous = last_ticks_[state][slot];
+            diff[state] = ticks[state] >= previous ? ticks[state] - previous : 0;    // counters went backwards
+            total += diff[state];
+            last_ticks_[state][slot] = ticks[state];
+        }
+
+        bool first = !seen_[slot];
+        seen_[slot] = 1;
+        if(first || total == 0) {
+            for(size_t state = 0; state < n_states; ++state)
+                last_.states[state][row] = 0.0;
             return 0.0;
-        } else {
-            unsigned long long total_diff = total_time - last_total_;
-            unsigned long long idle_diff = idle_time - last_idle_;
-
-            if(total_diff > 0){
-                usage = 1.0 - (double(idle_diff) / double(total_diff));
-                if(usage < 0.0) usage = 0.0;
-                if(usage > 1.0) usage = 1.0;
+        }
+        for(size_t state = 0; state < n_states; ++state)
+            last_.states[state][row] = static_cast<double>(diff[state]) / static_cast<double>(total);
+        double idle_share = static_cast<double>(diff[idle] + diff[iowait]) / static_cast<double>(total);
+        return std::clamp(1.0 - idle_share, 0.0, 1.0);
+    }
+
+
+    // Softirqs
+    size_t Softirqs::Sample::find(std::string_view type) const {
+        return static_cast<size_t>(std::find(types.begin(), types.end(), type) - types.begin());
+    }
+
+    void Softirqs::sample() {
+        std::string_view softirqs = softirqs_.read();
+        if(softirqs.empty()) return;
+        parse(softirqs);
+    }
+
+    // A header naming the CPUs, then "TYPE:" and one counter per CPU on every line
+    void Softirqs::parse(std::string_view softirqs, std::chrono::steady_clock::time_point now) {
+        std::string_view line;
+        if(!next_line(softirqs, line)) return;
+        size_t cpus = 0;
+        bool comparable = seen_;
+        for(size_t at = line.find("CPU"); at != std::string_view::npos; at = line.find("CPU", at + 3)) {
+            unsigned long long number = 0;
+            scan_number(line.data() + at + 3, line.data() + line.size(), number);
+            auto id = static_cast<uint32_t>(number);
+            if(cpus == last_.cpu_ids.size()) {
+                last_.cpu_ids.push_back(id);
+                comparable = false;
+            } else if(last_.cpu_ids[cpus] != id) {
+                last_.cpu_ids[cpus] = id;
+                comparable = false;
+            }
+            ++cpus;
+        }
+        if(last_.cpu_ids.size() != cpus) {
+            last_.cpu_ids.resize(cpus);
+            comparable = false;
+        }
+
+        size_t types = 0;
+        while(next_line(softirqs, line)) {
+            size_t colon = line.find(':');
+            if(colon == std::string_view::npos) continue;
+            size_t start = std::min(colon, line.find_first_not_of(' '));
+            std::string_view name = line.substr(start, colon - start);
+            if(types == last_.types.size()) {
+                last_.types.emplace_back(name);
+                comparable = false;
+            } else if(last_.types[types] != name) {
+                last_.types[types] = name;
+                comparable = false;
             }
 
-            last_total_ = total_time;
-            last_idle_ = idle_time;
-            return usage;
+            size_t offset = types * cpus;
+            if(counts_.size() < offset + cpus) counts_.resize(offset + cpus);
+            const char* p = line.data() + colon + 1;
+            const char* end = line.data() + line.size();
+            for(size_t cpu = 0; cpu < cpus; ++cpu) {
+                unsigned long long count = 0;
+                p = scan_number(p, end, count);
+                counts_[offset + cpu] = count;
+            }
+            ++types;
+        }
+        last_.types.resize(types);
+        counts_.resize(types * cpus);
+        comparable = comparable && counts_.size() == last_counts_.size();
+
+        double seconds = std::chrono::duration<double>(now - last_time_).count();
+        last_.cpus = cpus;
+        last_.rates.resize(counts_.size());
+        last_.totals.assign(types, 0.0);
+        for(size_t i = 0; i < counts_.size(); ++i) {
+            bool valid = comparable && seconds > 0.0 && counts_[i] >= last_counts_[i];
+            last_.rates[i] = valid ? static_cast<double>(counts_[i] - last_counts_[i]) / seconds : 0.0;
+            last_.totals[i / cpus] += last_.rates[i];
         }
+        std::swap(counts_, last_counts_);
+        last_time_ = now;
+        seen_ = true;
+
+        // The file lists every possible CPU; the mean only counts those that
+        // ran any softirq, offline ones would make any spread look uneven
+        last_.net_rx_imbalance = 0.0;
+        last_.net_rx_busiest = 0;
+        size_t net_rx = last_.find("NET_RX");
+        if(net_rx == types || last_.totals[net_rx] <= 0.0) return;
+        size_t active = 0, busiest = 0;
+        for(size_t cpu = 0; cpu < cpus; ++cpu) {
+            bool ran = false;
+            for(size_t type = 0; type < types && !ran; ++type)
+                ran = last_.rate(type, cpu) > 0.0;
+            active += ran;
+            if(last_.rate(net_rx, cpu) > last_.rate(net_rx, busiest))
+                busiest = cpu;
+        }
+        last_.net_rx_busiest = last_.cpu_ids[busiest];
+        last_.net_rx_imbalance = last_.rate(net_rx, busiest) / (last_.totals[net_rx] / static_cast<double>(active));
+    }
+
+    void Softirqs::record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now) {
+        size_t types = last_.types.size();
+        if(types == 0) return;
+        if(metric_ids_.size() != types + 1) {       // first call, or another kernel's types
+            metric_ids_.resize(types + 1);
+            for(size_t type = 0; type < types; ++type) {
+                std::string name = "softirq." + last_.types[type];
+                std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+                metric_ids_[type] = metrics.add(name);
+            }
+            metric_ids_[types] = metrics.add("softirq.net_rx_imbalance");
+        }
+        for(size_t type = 0; type < types; ++type)
+            metrics.record(metric_ids_[type], last_.totals[type], now);
+        metrics.record(metric_ids_[types], last_.net_rx_imbalance, now);
+    }
+
+
+    // Scheduler
+    void Scheduler::sample() {
+        std::string_view loadavg = loadavg_.read();
+        parse(loadavg, schedstat_.read());
+    }
+
+    void Scheduler::parse(std::string_view loadavg, std::string_view schedstat, std::chrono::steady_clock::time_point now) {
+        // "0.52 0.58 0.59 3/1234 56789"
+        FieldScanner fields(loadavg);
+        std::string_view field;
+        for(double& load : last_.load_averages) {
+            load = 0.0;
+            if(fields.next(field)) std::from_chars(field.data(), field.data() + field.size(), load);
+        }
+        unsigned long long runnable = 0, tasks = 0;
+        if(fields.next(runnable) && fields.skip_past('/')) fields.next(tasks);
+        last_.runnable = static_cast<unsigned long>(runnable);
+        last_.tasks = static_cast<unsigned long>(tasks);
+
+        // "cpuN yld_count 0 sched_count sched_goidle ttwu_count ttwu_local
+        // rq_cpu_time run_delay pcount", times in ns, domain lines in between
+        counters_.clear();
+        std::string_view line;
+        while(next_line(schedstat, line)) {
+            if(!line.starts_with("cpu")) continue;
+            FieldScanner cpu(line);
+            Counters counters;
+            if(cpu.skip(7) && cpu.next(counters.run_time) && cpu.next(counters.run_delay)) cpu.next(counters.timeslices);
+            counters_.push_back(counters);
+        }
+
+        size_t cpus = counters_.size();
+        double seconds = std::chrono::duration<double>(now - last_time_).count();
+        bool comparable = cpus == last_counters_.size() && seconds > 0.0;
+        last_.core_latencies.assign(cpus, 0.0);
+        last_.core_waiting.assign(cpus, 0.0);
+        last_.core_running.assign(cpus, 0.0);
+        unsigned long long total_delay = 0, total_timeslices = 0, total_run_time = 0;
+        for(size_t cpu = 0; comparable && cpu < cpus; ++cpu) {
+            const Counters& now_counters = counters_[cpu];
+            const Counters& before = last_counters_[cpu];
+            if(now_counters.run_delay < before.run_delay || now_counters.timeslices < before.timeslices
+               || now_counters.run_time < before.run_time) continue;     // hotplug
+            unsigned long long delay = now_counters.run_delay - before.run_delay;
+            unsigned long long timeslices = now_counters.timeslices - before.timeslices;
+            unsigned long long run_time = now_counters.run_time - before.run_time;
+            last_.core_waiting[cpu] = static_cast<double>(delay) / 1e9 / seconds;
+            last_.core_running[cpu] = std::min(static_cast<double>(run_time) / 1e9 / seconds, 1.0);
+            last_.core_latencies[cpu] = timeslices ? static_cast<double>(delay) / 1e3 / static_cast<double>(timeslices) : 0.0;
+            total_delay += delay;
+            total_timeslices += timeslices;
+            total_run_time += run_time;
+        }
+        last_.latency = total_timeslices ? static_cast<double>(total_delay) / 1e3 / static_cast<double>(total_timeslices) : 0.0;
+        last_.waiting = comparable ? static_cast<double>(total_delay) / 1e9 / seconds : 0.0;
+        last_.running = comparable && cpus != 0 ? std::min(static_cast<double>(total_run_time) / 1e9 / seconds / static_cast<double>(cpus), 1.0) : 0.0;
+        std::swap(counters_, last_counters_);
+        last_time_ = now;
+    }
+
+    void Scheduler::record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now) {
+        if(load_metric_ == MetricTable::no_metric) {
+            load_metric_ = metrics.add("sched.load1");
+            latency_metric_ = metrics.add("sched.latency");
+            waiting_metric_ = metrics.add("sched.waiting");
+            running_metric_ = metrics.add("sched.running");
+        }
+        metrics.record(load_metric_, last_.load_averages[0], now);
+        if(last_.core_latencies.empty()) return;        // no schedstats
+        metrics.record(latency_metric_, last_.latency, now);
+        metrics.record(waiting_metric_, last_.waiting, now);
+        metrics.record(running_metric_, last_.running * 100.0, now);
     }
 
 
     // RAM
-    double Monitor::Ram::get_usage() {
-        struct sysinfo info;
-        if(sysinfo(&info) != 0) return 0.0;
-        if(info.totalram == 0) return 0.0;
-        return static_cast<double>(info.totalram - info.freeram) / static_cast<double>(info.totalram);
+    double Ram::get_usage() {
+        sample();
+        return last_.usage;
     }
 
-    unsigned long long Monitor::Ram::total() {
-        struct sysinfo info;
-        if(sysinfo(&info) != 0) return 0;
-        return info.totalram;
+    void Ram::sample() {
+        parse(meminfo_.read());
     }
 
-    unsigned long long Monitor::Ram::free() {
-        struct sysinfo info;
-        if(sysinfo(&info) != 0) return 0;
-        return info.freeram;
+    void Ram::record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now) {
+        if(usage_metric_ == MetricTable::no_metric) {
+            usage_metric_ = metrics.add("ram.usage");
+            swap_metric_ = metrics.add("swap.usage");
+        }
+        metrics.record(usage_metric_, last_.usage * 100.0, now);
+        double swap_used = last_.swap_total > last_.swap_free ? static_cast<double>(last_.swap_total - last_.swap_free) : 0.0;
+        metrics.record(swap_metric_, last_.swap_total > 0 ? swap_used / static_cast<double>(last_.swap_total) * 100.0 : 0.0, now);
     }
 
-    unsigned long long Monitor::Ram::used() {
-        struct sysinfo info;
-        if(sysinfo(&info) != 0) return 0;
-        return info.totalram - info.freeram;
+    namespace {
+        constexpr std::string_view meminfo_keys[] = {
+            "MemTotal", "MemFree", "MemAvailable", "Buffers", "Cached", "Shmem", "Slab",
+            "SwapTotal", "SwapFree", "Dirty", "Writeback"
+        };
+        constexpr unsigned long long Ram::Sample::* meminfo_members[] = {
+            &Ram::Sample::total, &Ram::Sample::free, &Ram::Sample::available, &Ram::Sample::buffers,
+            &Ram::Sample::cached, &Ram::Sample::shmem, &Ram::Sample::slab, &Ram::Sample::swap_total,
+            &Ram::Sample::swap_free, &Ram::Sample::dirty, &Ram::Sample::writeback
+        };
+
+        // Value of a "Key:   1234 kB" line in bytes
+        unsigned long long meminfo_value(std::string_view line, size_t colon) {
+            return parse_number(line.substr(colon + 1)) * 1024;
+        }
+    }
+
+    void Ram::parse(std::string_view meminfo) {
+        if(meminfo.empty()) return;
+        if(!parse_with_table(meminfo)) {        // first parse, or the layout changed
+            build_line_table(meminfo);
+            last_ = Sample{};
+            parse_with_table(meminfo);
+        }
+
+        last_.used = last_.total > last_.available ? last_.total - last_.available : 0;
+        last_.usage = last_.total == 0 ? 0.0 : static_cast<double>(last_.used) / static_cast<double>(last_.total);
+    }
+
+    // Walks the lines with the table, no key is compared; false if the table does not fit
+    bool Ram::parse_with_table(std::string_view meminfo) {
+        if(line_table_.empty()) return false;
+
+        std::string_view line;
+        for(size_t i = 0; i < table_lines_; ++i) {
+            if(!next_line(meminfo, line)) return false;
+            const LineSlot& slot = line_table_[i];
+            if(line.size() <= slot.key_length || line[slot.key_length] != ':' || line[0] != slot.first) return false;
+            if(slot.field != ignored)
+                last_.*meminfo_members[slot.field] = meminfo_value(line, slot.key_length);
+        }
+        return true;
+    }
+
+    void Ram::build_line_table(std::string_view meminfo) {
+        static_assert(std::size(meminfo_keys) == n_fields && std::size(meminfo_members) == n_fields);
+
+        line_table_.clear();
+        table_lines_ = 0;
+        std::string_view line;
+        while(next_line(meminfo, line)) {
+            size_t colon = line.find(':');
+            LineSlot slot{ignored, 0, line.empty() ? '\0' : line[0]};
+            if(colon != std::string_view::npos && colon <= UINT8_MAX) {
+                slot.key_length = static_cast<uint8_t>(colon);
+                auto key = std::find(std::begin(meminfo_keys), std::end(meminfo_keys), line.substr(0, colon));
+                if(key != std::end(meminfo_keys)) {
+                    slot.field = static_cast<Field>(key - std::begin(meminfo_keys));
+                    table_lines_ = line_table_.size() + 1;
+                }
+            }
+            line_table_.push_back(slot);
+        }
+        line_table_.resize(table_lines_);
+    }
+
+    unsigned long long Ram::total() {
+        sample();
+        return last_.total;
+    }
+
+    unsigned long long Ram::free() {
+        sample();
+        return last_.free;
+    }
+
+    unsigned long long Ram::used() {
+        sample();
+        return last_.used;
     }
 
 
     // Used drive space (e.g.: 0.0 to 1.0)
-    double Monitor::Drive::get_usage(const std::string& path) {
+    double Drive::get_usage(const std::string& path) {
         unsigned long long t = total(path);
         unsigned long long  u = used(path);
         if(t == 0) return 0.0;
         return static_cast<double>(u) / static_cast<double>(t);
     }
     // Total drive space
-    unsigned long long Monitor::Drive::total(const std::string& path) {
+    unsigned long long Drive::total(const std::string& path) {
         struct statvfs vfs;
         if(statvfs(path.c_str(), &vfs) != 0) return 0.0;
         return vfs.f_blocks * vfs.f_frsize;
     }
 
     // Free drive space
-    unsigned long long Monitor::Drive::free(const std::string& path) {
+    unsigned long long Drive::free(const std::string& path) {
         struct statvfs vfs;
         if(statvfs(path.c_str(), &vfs) != 0) return 0.0;
         return vfs.f_bfree * vfs.f_frsize;
     }
 
+    // one statvfs per mount
+    void Drive::sample() {
+        auto mount_points = get_mount_points();
+        last_.mounts.resize(mount_points.size());
+        for(size_t i = 0; i < mount_points.size(); ++i) {
+            Mount& mount = last_.mounts[i];
+            mount.path = std::move(mount_points[i]);
+
+            struct statvfs vfs;
+            count_syscalls();
+            if(statvfs(mount.path.c_str(), &vfs) != 0) {
+                mount.total = mount.free = mount.used = 0;
+                mount.usage = 0.0;
+                continue;
+            }
+            mount.total = vfs.f_blocks * vfs.f_frsize;
+            mount.free = vfs.f_bfree * vfs.f_frsize;
+            mount.used = mount.total > mount.free ? mount.total - mount.free : 0;
+            mount.usage = mount.total > 0 ? static_cast<double>(mount.used) / static_cast<double>(mount.total) : 0.0;
+        }
+    }
+
+    void Drive::record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now) {
+        const auto& mounts = last_.mounts;
+        bool changed = metric_paths_.size() != mounts.size();
+        for(size_t i = 0; i < mounts.size() && !changed; ++i)
+            changed = metric_paths_[i] != mounts[i].path;
+        if(changed) {
+            metric_paths_.resize(mounts.size());
+            metric_ids_.resize(mounts.size());
+            for(size_t i = 0; i < mounts.size(); ++i) {
+                metric_paths_[i] = mounts[i].path;
+                metric_ids_[i] = metrics.add("drive." + mounts[i].path + ".usage");
+            }
+        }
+        for(size_t i = 0; i < mounts.size(); ++i)
+            metrics.record(metric_ids_[i], mounts[i].usage * 100.0, now);
+    }
+
+    // Mount points backed by a block device (no loop devices, no pseudo filesystems)
+    std::vector<string> Drive::get_mount_points() {
+        std::vector<string> mounts{"/"};
+        std::string_view table = mounts_.read();
+        std::string_view line;
+
+        while(next_line(table, line)) {
+            FieldScanner fields(line);
+            std::string_view device, mount_point;
+            if(!fields.next(device) || !fields.next(mount_point)) continue;
+            if(!device.starts_with("/dev/") || device.starts_with("/dev/loop")) continue;
+            if(std::find(mounts.begin(), mounts.end(), mount_point) != mounts.end()) continue;
+            mounts.emplace_back(mount_point);
+        }
+        return mounts;
+    }
+
     // Used Drive space
-    unsigned long long Monitor::Drive::used(const std::string& path) {
+    unsigned long long Drive::used(const std::string& path) {
         if(total(path) < free(path)) return 0;
         return total(path) - free(path);
     }
@@ -1,75 +1,511 @@
 #ifndef SYSTEM_MONITOR_HPP
 #define SYSTEM_MONITOR_HPP
+#include <array>
 #include <string>
+#include <string_view>
 #include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "procfs_reader.hpp"
+#include "cgroups.hpp"
+#include "numa_memory.hpp"
+#include "thermal.hpp"
+#include "cpu_identity.hpp"
+#include "cpu_topology.hpp"
+#include "metrics.hpp"
 
 namespace system_monitor {
 
-    class Monitor {
+    // A collector reads one group of metrics. sample() refreshes the values
+    // returned by last(), the get_* functions read the system directly.
+    // Collectors may declare how often they want to be sampled (`period`,
+    // zero means once) and whether they keep running in background.
+    template <typename T>
+    concept Collector = std::default_initializable<T> && requires(T& collector, const T& const_collector) {
+        typename T::Sample;
+        { collector.sample() } -> std::same_as<void>;
+        { const_collector.last() } -> std::same_as<const typename T::Sample&>;
+    };
+
+    // Collectors reading procfs files through a shared ProcfsReader. attach()
+    // opens their files in the reader, prefetch() queues the reads of the
+    // next sample so that the reads of a whole batch go out together.
+    template <typename T>
+    concept ProcfsCollector = Collector<T> && requires(T& collector, ProcfsReader& reader) {
+        collector.attach(reader);
+        collector.prefetch();
+    };
+
+    // Collectors feeding the metric sketches. record_metrics() records the
+    // values of last(), the metrics are registered in the table on first use.
+    template <typename T>
+    concept MetricCollector = Collector<T> && requires(T& collector, MetricTable& metrics, std::chrono::steady_clock::time_point now) {
+        collector.record_metrics(metrics, now);
+    };
+
+    class General {         // General informations about the system
+        public:
+            static constexpr std::chrono::milliseconds period{1000};
+            static constexpr const char* name = "general";
+
+            struct Sample {
+                unsigned long uptime = 0;
+                unsigned long procs_num = 0;
+
+                // Inventory, read with the first sample only
+                unsigned int cpu_cores = 0;             // logical CPUs
+                unsigned int cpu_physical_cores = 0;    // from the topology, 0 if unknown
+                unsigned int cpu_sockets = 0;
+                unsigned int numa_nodes = 0;
+                std::string cpu_model;
+                CpuIdentity cpu_identity;               // caches, features, revision
+                std::string product_name;
+                std::string os_version;
+                std::string kernel_version;
+            };
+
+            void sample();
+            const Sample& last() const { return last_; }
+
+            void record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now);
+
+            unsigned long get_uptime();
+            unsigned long get_procs_num();
+
+            // Hardware
+            unsigned int get_cpu_cores();
+            std::string get_cpu_model();            // from CpuIdentity::system(), read once
+            std::string get_product_name();
+
+            // Software
+            std::string get_os_version();
+            std::string get_kernel_version();
+
+        private:
+            Sample last_;
+            bool inventory_read_ = false;
+            MetricTable::Id procs_metric_ = MetricTable::no_metric;
+    };
+
+    class Network {         // Network informations
+        public:
+            static constexpr std::chrono::milliseconds period{500};
+            static constexpr const char* name = "network";
+            static constexpr bool keep_in_background = true;    // feeds the network history
+
+            struct Sample {
+                double download_rate = 0.0;     // bytes/s
+                double upload_rate = 0.0;
+            };
+
+            void sample();
+            const Sample& last() const { return last_; }
+
+            void attach(ProcfsReader& reader);
+            void prefetch();
+
+            void record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now);     // bytes/s
+
+            // Parses /proc/net/wireless and /proc/net/dev, now times the rates
+            void parse(std::string_view wireless, std::string_view netdev,
+                       std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+            std::string get_wifi_ssid();
+            double get_download_rate();
+            double get_upload_rate();
+
+        private:
+            unsigned long long last_rx_bytes_ = 0;
+            unsigned long long last_tx_bytes_ = 0;
+            std::chrono::steady_clock::time_point last_time_ = std::chrono::steady_clock::now();
+            static std::string_view primary_interface(std::string_view wireless);
+            void update_counter();
+            double last_download_rate_ = 0.0;
+            double last_upload_rate_ = 0.0;
+            Sample last_;
+
+            ProcfsFile wireless_{"/proc/net/wireless"};
+            ProcfsFile net_dev_{"/proc/net/dev"};
+            MetricTable::Id download_metric_ = MetricTable::no_metric;
+            MetricTable::Id upload_metric_ = MetricTable::no_metric;
+    };
+
+    class Cpu {         // CPU informations
+        public:
+            static constexpr std::chrono::milliseconds period{100};
+            static constexpr const char* name = "cpu";
+
+            // Time states of a "cpu" line, in /proc/stat column order
+            enum State : size_t { user, nice, system, idle, iowait, irq, softirq, steal, guest, guest_nice, n_states };
+            static const char* state_name(State state);
+
+            struct Sample {
+                double usage = 0.0;
+                std::vector<double> core_usages;
+                std::vector<uint32_t> cpu_ids;          // N of the cpuN line of every core_usages entry
+
+                // Share of every state in the last interval, struct of arrays:
+                // states[s][0] is the aggregate, states[s][1 + n] core n. The
+                // kernel counts guest time in user (and guest_nice in nice),
+                // here user and nice exclude it so that the states add up to 1.
+                std::array<std::vector<double>, n_states> states;
+
+                // Kernel activity from the lines after the cpu lines, per
+                // second over the last interval; running and blocked are
+                // the current task counts
+                double context_switch_rate = 0.0;      // ctxt
+                double interrupt_rate = 0.0;           // intr, all sources
+                double fork_rate = 0.0;                // processes
+                unsigned long procs_running = 0;
+                unsigned long procs_blocked = 0;
+
+                // Mean usage of the online CPUs of every physical core, socket
+                // and NUMA node (see CpuTopology), empty without topology
+                std::vector<double> physical_core_usages;
+                std::vector<double> socket_usages;
+                std::vector<double> node_usages;
+            };
+
+            void sample();          // aggregate, cores and kernel activity from one read of /proc/stat
+            const Sample& last() const { return last_; }
+
+            // Topology the cores are grouped by; sample() uses CpuTopology::system() unless set
+            void set_topology(CpuTopology topology);
+
+            // Parses the contents of /proc/stat into last(), now times the rates
+            void parse(std::string_view stat, std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+            void attach(ProcfsReader& reader) { stat_.attach(reader); }
+            void prefetch() { stat_.prefetch(); }
+
+            void record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now);     // percent
+
+            double get_usage();
+            std::vector<double> get_core_usages();      // one entry per "cpuN" line
+
+        private:
+            // Previous ticks per state and slot: 0 the aggregate, 1 + N cpuN,
+            // so that a CPU keeps its history when the lines before it change
+            std::array<std::vector<unsigned long long>, n_states> last_ticks_;
+            std::vector<char> seen_;        // slots with previous ticks
+
+            // Counters of the ctxt, intr and processes lines at the previous parse
+            enum Counter : size_t { context_switches, interrupts, forks, n_counters };
+            std::array<unsigned long long, n_counters> last_counters_{};
+            std::chrono::steady_clock::time_point last_counter_time_{};
+            bool counters_seen_ = false;
+
+            Sample last_;
+            ProcfsFile stat_{"/proc/stat"};
+            std::vector<MetricTable::Id> metric_ids_;       // aggregate, then cores
+            std::vector<uint32_t> metric_cpu_ids_;          // cpu ids when metric_ids_ were built
+            std::array<MetricTable::Id, n_states> state_metric_ids_{};
+            std::array<MetricTable::Id, n_counters> counter_metric_ids_{};
+
+            // Index maps from cpuN line to group, rebuilt only when the online
+            // CPUs change, so that grouping a sample only adds and divides
+            enum Level : size_t { level_core, level_socket, level_node, n_levels };
+            struct Grouping {
+                std::vector<uint32_t> group_of;     // per cpuN line, CpuTopology::unknown if ungrouped
+                std::vector<double> sizes;          // online CPUs per group
+            };
+            CpuTopology topology_;
+            bool topology_set_ = false;
+            bool cpus_changed_ = true;
+            std::array<Grouping, n_levels> groupings_;
+            std::vector<MetricTable::Id> group_metric_ids_;     // sockets, then nodes
+
+            void build_groupings();
+            void aggregate_groups();
+
+            double update_usage(std::string_view line);
+            double update_core_usage(size_t core, uint32_t id, std::string_view line);
+            double update_row(size_t slot, size_t row, std::string_view line);      // busy ratio, 0.0 the first time
+            void update_counters(const std::array<unsigned long long, n_counters>& counters, std::chrono::steady_clock::time_point now);
+    };
+
+    class Softirqs {        // softirqs per type and CPU from /proc/softirqs
+        public:
+            static constexpr std::chrono::milliseconds period{1000};
+            static constexpr const char* name = "softirqs";
+
+            struct Sample {
+                std::vector<std::string> types;     // HI, TIMER, NET_TX, NET_RX, ... in file order
+                size_t cpus = 0;
+                // N of the CPUn header columns: every possible CPU, where
+                // /proc/stat lists only the online ones
+                std::vector<uint32_t> cpu_ids;
+
+                // Per second over the last interval, rates[type * cpus + cpu]
+                std::vector<double> rates;
+                std::vector<double> totals;         // per type, all CPUs
+
+                // NET_RX rate of the busiest CPU over the mean of all CPUs:
+                // 1 when the receive work is spread evenly, cpus when a
+                // single CPU does it all, 0 without NET_RX softirqs
+                double net_rx_imbalance = 0.0;
+                uint32_t net_rx_busiest = 0;        // CPU id
+
+                // cpu is a column, cpu_ids[cpu] its CPU id
+                double rate(size_t type, size_t cpu) const { return rates[type * cpus + cpu]; }
+                // Index of the type in types, types.size() if absent
+                size_t find(std::string_view type) const;
+            };
+
+            void sample();
+            const Sample& last() const { return last_; }
+
+            // Parses the contents of /proc/softirqs into last(), now times the rates
+            void parse(std::string_view softirqs, std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+            void attach(ProcfsReader& reader) { softirqs_.attach(reader); }
+            void prefetch() { softirqs_.prefetch(); }
+
+            void record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now);     // per second
+
+        private:
+            std::vector<unsigned long long> counts_;            // of the current parse, same layout as rates
+            std::vector<unsigned long long> last_counts_;
+            std::chrono::steady_clock::time_point last_time_{};
+            bool seen_ = false;
+
+            Sample last_;
+            ProcfsFile softirqs_{"/proc/softirqs"};
+            std::vector<MetricTable::Id> metric_ids_;       // totals per type, then the NET_RX imbalance
+    };
+
+    // Load averages from /proc/loadavg and run-queue wait per CPU from
+    // /proc/schedstat (kernels with CONFIG_SCHEDSTATS). Sampled with the CPU
+    // usage, both files are read in the same batch as /proc/stat.
+    class Scheduler {
         public:
-            class General {         // General informations about the system
-                public:
-                    unsigned long get_uptime();
-                    unsigned long get_procs_num();
-
-                    // Hardware
-                    unsigned int get_cpu_cores();
-                    std::string get_cpu_model();
-                    std::string get_product_name();
-
-                    // Software
-                    std::string get_os_version();
-                    std::string get_kernel_version();
+            static constexpr std::chrono::milliseconds period = Cpu::period;
+            static constexpr const char* name = "scheduler";
+
+            struct Sample {
+                std::array<double, 3> load_averages{};     // 1, 5 and 15 minutes
+                unsigned long runnable = 0;                 // running or runnable tasks now
+                unsigned long tasks = 0;                    // threads
+
+                // Over the last interval, per CPU in /proc/stat order; empty
+                // without schedstats. latency: mean wait of a task in the run
+                // queue before each timeslice (microseconds); waiting: tasks waiting on
+                // average, 1 is one task always kept from the CPU; running: share
+                // of the interval the CPU spent running tasks (rq_cpu_time)
+                std::vector<double> core_latencies;
+                std::vector<double> core_waiting;
+                std::vector<double> core_running;
+                double latency = 0.0;                       // over all CPUs' timeslices
+                double waiting = 0.0;                       // sum over the CPUs
+                double running = 0.0;                       // mean over the CPUs
             };
 
-            class Network {         // Network informations
-                public:
-                    std::string get_wifi_ssid();
-                    double get_download_rate();
-                    double get_upload_rate();
-
-                private:
-                    unsigned long long last_rx_bytes_ = 0;
-                    unsigned long long last_tx_bytes_ = 0;
-                    std::chrono::steady_clock::time_point last_time_ = std::chrono::steady_clock::now();
-                    std::string get_primary_interface();
-                    void update_counter();
-                    double last_download_rate_ = 0.0;
-                    double last_upload_rate_ = 0.0;
+            void sample();
+            const Sample& last() const { return last_; }
+
+            // Parses the contents of /proc/loadavg and /proc/schedstat into last(), now times the rates
+            void parse(std::string_view loadavg, std::string_view schedstat,
+                       std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+            void attach(ProcfsReader& reader) {
+                loadavg_.attach(reader);
+                schedstat_.attach(reader);
+            }
+            void prefetch() {
+                loadavg_.prefetch();
+                schedstat_.prefetch();
+            }
+
+            void record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now);     // load, microseconds, tasks, percent
+
+        private:
+            struct Counters {
+                unsigned long long run_time = 0;        // ns spent running tasks
+                unsigned long long run_delay = 0;       // ns waited in the run queue
+                unsigned long long timeslices = 0;
             };
+            std::vector<Counters> counters_;            // of the current parse, per CPU
+            std::vector<Counters> last_counters_;
+            std::chrono::steady_clock::time_point last_time_{};
+
+            Sample last_;
+            ProcfsFile loadavg_{"/proc/loadavg"};
+            ProcfsFile schedstat_{"/proc/schedstat"};
+            MetricTable::Id load_metric_ = MetricTable::no_metric;
+            MetricTable::Id latency_metric_ = MetricTable::no_metric;
+            MetricTable::Id waiting_metric_ = MetricTable::no_metric;
+            MetricTable::Id running_metric_ = MetricTable::no_metric;
+    };
+
+    class Ram {         // RAM informations from /proc/meminfo
+        public:
+            static constexpr std::chrono::milliseconds period{500};
+            static constexpr const char* name = "ram";
+
+            struct Sample {
+                double usage = 0.0;                 // (total - available) / total
+                unsigned long long total = 0;       // bytes
+                unsigned long long free = 0;
+                unsigned long long used = 0;        // total - available, page cache is not counted
+                unsigned long long available = 0;
+                unsigned long long buffers = 0;
+                unsigned long long cached = 0;
+                unsigned long long shmem = 0;
+                unsigned long long slab = 0;
+                unsigned long long swap_total = 0;
+                unsigned long long swap_free = 0;
+                unsigned long long dirty = 0;
+                unsigned long long writeback = 0;
+            };
+
+            void sample();
+            const Sample& last() const { return last_; }
+
+            void attach(ProcfsReader& reader) { meminfo_.attach(reader); }
+            void prefetch() { meminfo_.prefetch(); }
+
+            void record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now);     // percent
 
-            class Cpu {         // CPU informations
-                public:
-                    double get_usage();
+            // Parses the contents of /proc/meminfo into last()
+            void parse(std::string_view meminfo);
 
-                private:
-                    unsigned long long last_total_ = 0;
-                    unsigned long long last_idle_ = 0;
-                    bool first_call_ = true;
+            double get_usage();
+            unsigned long long total();
+            unsigned long long free();
+            unsigned long long used();
+
+        private:
+            // Fields read from /proc/meminfo, in the order of field_names
+            enum Field : uint8_t {
+                mem_total, mem_free, mem_available, buffers, cached, shmem, slab,
+                swap_total, swap_free, dirty, writeback, n_fields, ignored = n_fields
             };
 
-            class Ram {         // RAM informations
-                public:
-                    double get_usage();
-                    unsigned long long total();
-                    unsigned long long free();
-                    unsigned long long used();
+            // What every line of /proc/meminfo holds, built once from the keys
+            // and then only checked (key length and first letter) on each parse
+            struct LineSlot {
+                Field field;
+                uint8_t key_length;
+                char first;
             };
 
-            class Drive {       // Drive informations
-                public:
-                    double get_usage(const std::string& path = "/");
-                    unsigned long long total(const std::string& path = "/");
-                    unsigned long long free(const std::string& path = "/");
-                    unsigned long long used(const std::string& path = "/");
+            Sample last_;
+            ProcfsFile meminfo_{"/proc/meminfo"};
+            std::vector<LineSlot> line_table_;
+            size_t table_lines_ = 0;        // lines up to the last field read
+            MetricTable::Id usage_metric_ = MetricTable::no_metric;
+            MetricTable::Id swap_metric_ = MetricTable::no_metric;
+
+            bool parse_with_table(std::string_view meminfo);
+            void build_line_table(std::string_view meminfo);
+    };
+
+    class Drive {       // Drive informations
+        public:
+            static constexpr std::chrono::milliseconds period{30000};
+            static constexpr const char* name = "drive";
+
+            struct Mount {
+                std::string path;
+                double usage = 0.0;
+                unsigned long long total = 0;
+                unsigned long long free = 0;
+                unsigned long long used = 0;
+            };
+            struct Sample {
+                std::vector<Mount> mounts;      // "/" first
             };
 
-            Cpu cpu;
-            Ram ram;
-            Drive drive;
-            General general;
-            Network network;
+            void sample();
+            const Sample& last() const { return last_; }
+
+            void attach(ProcfsReader& reader) { mounts_.attach(reader); }
+            void prefetch() { mounts_.prefetch(); }
+
+            void record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now);     // percent
+
+            double get_usage(const std::string& path = "/");
+            unsigned long long total(const std::string& path = "/");
+            unsigned long long free(const std::string& path = "/");
+            unsigned long long used(const std::string& path = "/");
+
+            // Mount points of block devices, "/" first
+            std::vector<std::string> get_mount_points();
+
+        private:
+            Sample last_;
+            ProcfsFile mounts_{"/proc/mounts"};
+            std::vector<std::string> metric_paths_;         // mounts the metrics were registered for
+            std::vector<MetricTable::Id> metric_ids_;
     };
+
+    // Sampling period of a collector, default_period if it does not declare one
+    inline constexpr std::chrono::milliseconds default_period{500};
+
+    template <Collector C>
+    constexpr std::chrono::milliseconds sampling_period() {
+        if constexpr (requires { C::period; }) return C::period;
+        else return default_period;
+    }
+
+    // Name of a collector in the overhead accounting and its metrics
+    template <Collector C>
+    constexpr const char* collector_name() {
+        if constexpr (requires { C::name; }) return C::name;
+        else return "collector";
+    }
+
+    template <Collector C>
+    constexpr bool keeps_in_background() {
+        if constexpr (requires { C::keep_in_background; }) return C::keep_in_background;
+        else return false;
+    }
+
+    // Composition of collectors resolved at compile time. sample() is a fold
+    // over the collector types, there are no virtual calls. Builds that need
+    // fewer metrics instantiate e.g. BasicMonitor<Cpu, Ram>.
+    template <Collector... Collectors>
+    class BasicMonitor {
+        public:
+            static constexpr size_t size = sizeof...(Collectors);
+
+            // Monitor::Cpu etc. name the collector types
+            using General = system_monitor::General;
+            using Network = system_monitor::Network;
+            using Cpu = system_monitor::Cpu;
+            using Ram = system_monitor::Ram;
+            using Drive = system_monitor::Drive;
+            using Cgroups = system_monitor::Cgroups;
+            using Softirqs = system_monitor::Softirqs;
+            using Scheduler = system_monitor::Scheduler;
+            using NumaMemory = system_monitor::NumaMemory;
+            using Thermal = system_monitor::Thermal;
+
+            template <typename C>
+            static constexpr bool has = (std::same_as<C, Collectors> || ...);
+
+            template <typename C> requires has<C>
+            C& get() { return std::get<C>(collectors_); }
+
+            template <typename C> requires has<C>
+            const C& get() const { return std::get<C>(collectors_); }
+
+            // Access by position, for code iterating over the composition
+            template <size_t I>
+            auto& at() { return std::get<I>(collectors_); }
+
+            void sample() {
+                std::apply([](Collectors&... collectors) { (collectors.sample(), ...); }, collectors_);
+            }
+
+        private:
+            std::tuple<Collectors...> collectors_;
+    };
+
+    using Monitor = BasicMonitor<Cpu, Ram, Drive, General, Network, Cgroups, Softirqs, Scheduler, NumaMemory, Thermal>;
 }
 
 #endif
@@ -60,6 +60,281 @@ TEST_CASE("Monitor::CPU get_usage", "[system_monitor][Cpu]") {
     CHECK(usage2 <= 1.0);
 }
 
+// per core usage
+TEST_CASE("Monitor::CPU get_core_usages", "[system_monitor][Cpu]") {
+    system_monitor::Monitor::Cpu cpu;
+
+    auto first_usages = cpu.get_core_usages();
+    CHECK(!first_usages.empty());       // at least one core
+    for(double usage : first_usages)
+        CHECK(usage == 0.0);            // First Call should always return 0.0
+
+    auto usages = cpu.get_core_usages();
+    CHECK(usages.size() == first_usages.size());
+    for(double usage : usages) {
+        CHECK(usage >= 0.0);
+        CHECK(usage <= 1.0);
+    }
+}
+
+// time states, guest time is taken out of user/nice
+TEST_CASE("Monitor::CPU states", "[system_monitor][Cpu]") {
+    using Cpu = system_monitor::Cpu;
+    Cpu cpu;
+    cpu.parse("cpu  1000 100 500 8000 200 10 20 30 50 0\n"
+              "cpu0 500 50 250 4000 100 5 10 15 50 0\n"
+              "cpu1 500 50 250 4000 100 5 10 15 0 0\n"
+              "intr 12345 0 0\n");
+    CHECK(cpu.last().usage == 0.0);
+    REQUIRE(cpu.last().states[Cpu::steal].size() == 3);
+    CHECK(cpu.last().states[Cpu::steal][0] == 0.0);
+
+    // +100 ticks per core: cpu0 40 user of which 20 guest, 10 steal, 20 iowait, 30 idle;
+    // cpu1 40 system, 10 steal, 20 iowait, 30 idle
+    cpu.parse("cpu  1040 100 540 8060 240 10 20 50 70 0\n"
+              "cpu0 540 50 250 4030 120 5 10 25 70 0\n"
+              "cpu1 500 50 290 4030 120 5 10 25 0 0\n");
+    const auto& states = cpu.last().states;
+    CHECK(states[Cpu::user][1] == Catch::Approx(0.2));
+    CHECK(states[Cpu::guest][1] == Catch::Approx(0.2));
+    CHECK(states[Cpu::steal][1] == Catch::Approx(0.1));
+    CHECK(states[Cpu::iowait][1] == Catch::Approx(0.2));
+    CHECK(states[Cpu::idle][1] == Catch::Approx(0.3));
+    CHECK(cpu.last().core_usages[0] == Catch::Approx(0.5));     // iowait counts as idle
+    CHECK(states[Cpu::user][2] == 0.0);
+    CHECK(states[Cpu::system][2] == Catch::Approx(0.4));
+    CHECK(states[Cpu::steal][2] == Catch::Approx(0.1));
+
+    // Aggregate over 200 ticks
+    CHECK(states[Cpu::steal][0] == Catch::Approx(0.1));
+    CHECK(states[Cpu::guest][0] == Catch::Approx(0.1));
+    CHECK(cpu.last().usage == Catch::Approx(0.5));
+    for(size_t row = 0; row < 3; ++row) {
+        double sum = 0.0;
+        for(size_t state = 0; state < Cpu::n_states; ++state) sum += states[state][row];
+        CHECK(sum == Catch::Approx(1.0));
+    }
+
+    // Old kernels without the guest columns
+    Cpu old;
+    old.parse("cpu  100 0 100 800 0 0 0\n");
+    old.parse("cpu  150 0 150 900 0 0 0\n");
+    CHECK(old.last().usage == Catch::Approx(0.5));
+    CHECK(old.last().states[Cpu::user][0] == Catch::Approx(0.25));
+}
+
+TEST_CASE("Monitor::CPU kernel activity", "[system_monitor][Cpu]") {
+    using Cpu = system_monitor::Cpu;
+    auto start = std::chrono::steady_clock::now();
+    Cpu cpu;
+    cpu.parse("cpu  100 0 100 800 0 0 0 0 0 0\n"
+              "cpu0 100 0 100 800 0 0 0 0 0 0\n"
+              "intr 5000 10 0 0 7 0\n"
+              "ctxt 20000\n"
+              "btime 1700000000\n"
+              "processes 300\n"
+              "procs_running 3\n"
+              "procs_blocked 1\n"
+              "softirq 900 0 400 2 300 0 0 50 100 0 48\n", start);
+    CHECK(cpu.last().context_switch_rate == 0.0);
+    CHECK(cpu.last().procs_running == 3);
+    CHECK(cpu.last().procs_blocked == 1);
+
+    cpu.parse("cpu  150 0 150 900 0 0 0 0 0 0\n"
+              "cpu0 150 0 150 900 0 0 0 0 0 0\n"
+              "intr 6000 10 0 0 7 0\n"
+              "ctxt 24000\n"
+              "processes 310\n"
+              "procs_running 5\n"
+              "procs_blocked 0\n", start + std::chrono::milliseconds(500));
+    CHECK(cpu.last().usage == Catch::Approx(0.5));
+    CHECK(cpu.last().interrupt_rate == Catch::Approx(2000.0));
+    CHECK(cpu.last().context_switch_rate == Catch::Approx(8000.0));
+    CHECK(cpu.last().fork_rate == Catch::Approx(20.0));
+    CHECK(cpu.last().procs_running == 5);
+    CHECK(cpu.last().procs_blocked == 0);
+
+    // A counter going backwards (e.g. a truncated read) gives no rate
+    cpu.parse("cpu  150 0 150 900 0 0 0 0 0 0\nctxt 100\n", start + std::chrono::milliseconds(1000));
+    CHECK(cpu.last().context_switch_rate == 0.0);
+}
+
+TEST_CASE("Monitor::CPU topology groups", "[system_monitor][Cpu]") {
+    using Cpu = system_monitor::Cpu;
+    // Two sockets, one node each, cores of two SMT threads: cpu0/cpu4 and
+    // cpu1/cpu5 on socket 0, cpu2/cpu6 and cpu3/cpu7 on socket 1
+    system_monitor::CpuTopology topology;
+    topology.core_of = {0, 1, 2, 3, 0, 1, 2, 3};
+    topology.socket_of = {0, 0, 1, 1, 0, 0, 1, 1};
+    topology.node_of = topology.socket_of;
+    topology.cpus = 8;
+    topology.cores = 4;
+    topology.sockets = 2;
+    topology.nodes = 2;
+
+    Cpu cpu;
+    cpu.set_topology(topology);
+    // user and idle ticks of every cpuN line, `total` ticks per line
+    auto stat = [](const std::vector<unsigned>& ids, const std::vector<unsigned>& busy, unsigned total) {
+        std::string text = "cpu  0 0 0 0 0 0 0 0 0 0\n";
+        for(size_t i = 0; i < ids.size(); ++i)
+            text += "cpu" + std::to_string(ids[i]) + " " + std::to_string(busy[i]) + " 0 0 " + std::to_string(total - busy[i]) + " 0 0 0 0 0 0\n";
+        return text;
+    };
+    cpu.parse(stat({0, 1, 2, 3, 4, 5, 6, 7}, {0, 0, 0, 0, 0, 0, 0, 0}, 0));
+    // +100 ticks each, socket 0 busy: 100% on cpu0, 50% on the others of socket 0
+    cpu.parse(stat({0, 1, 2, 3, 4, 5, 6, 7}, {100, 50, 0, 0, 50, 50, 0, 0}, 100));
+    const auto& last = cpu.last();
+    REQUIRE(last.physical_core_usages.size() == 4);
+    CHECK(last.physical_core_usages[0] == Catch::Approx(0.75));
+    CHECK(last.physical_core_usages[1] == Catch::Approx(0.5));
+    CHECK(last.physical_core_usages[2] == 0.0);
+    REQUIRE(last.socket_usages.size() == 2);
+    CHECK(last.socket_usages[0] == Catch::Approx(0.625));
+    CHECK(last.socket_usages[1] == 0.0);
+    CHECK(last.node_usages == last.socket_usages);
+    system_monitor::MetricTable metrics;
+    auto before = std::chrono::steady_clock::now();
+    cpu.record_metrics(metrics, before);
+
+    // cpu5 and cpu6 go offline: the maps and the previous ticks follow the
+    // cpuN ids, not the line positions (cpu7 moves to the sixth line but
+    // keeps its own ticks)
+    cpu.parse(stat({0, 1, 2, 3, 4, 7}, {200, 100, 100, 0, 100, 50}, 200));
+    REQUIRE(last.core_usages.size() == 6);
+    CHECK(last.cpu_ids == std::vector<uint32_t>{0, 1, 2, 3, 4, 7});
+    CHECK(last.core_usages[5] == Catch::Approx(0.5));               // cpu7: 50 of its 100 ticks
+    CHECK(last.physical_core_usages[1] == Catch::Approx(0.5));       // cpu1 alone
+    CHECK(last.socket_usages[0] == Catch::Approx(2.0 / 3));          // cpu0 100%, cpu1 and cpu4 50%
+    CHECK(last.socket_usages[1] == Catch::Approx(0.5));              // cpu2 100%, cpu3 idle, cpu7 50%
+
+    // The per-core metrics follow the CPUs too: cpu.core5 is no longer recorded
+    auto after = before + std::chrono::seconds(1);
+    cpu.record_metrics(metrics, after);
+    REQUIRE(metrics.find("cpu.core7.usage") != system_monitor::MetricTable::no_metric);
+    CHECK(metrics.last(metrics.find("cpu.core7.usage")) == Catch::Approx(50.0));
+    CHECK(metrics.updated(metrics.find("cpu.core7.usage")) == after);
+    CHECK(metrics.updated(metrics.find("cpu.core5.usage")) == before);
+
+    Cpu plain;
+    plain.parse(stat({0}, {0}, 0));
+    CHECK(plain.last().socket_usages.empty());
+}
+
+TEST_CASE("Monitor::Softirqs", "[system_monitor][Softirqs]") {
+    using Softirqs = system_monitor::Softirqs;
+    auto start = std::chrono::steady_clock::now();
+    Softirqs softirqs;
+    softirqs.parse("                    CPU0       CPU1       CPU2       CPU3\n"
+                   "          HI:          1          0          0          0\n"
+                   "       TIMER:       1000       1000       1000          0\n"
+                   "      NET_RX:        100        100        100          0\n"
+                   "         RCU:        500        500        500          0\n", start);
+    const auto& last = softirqs.last();
+    REQUIRE(last.types.size() == 4);
+    CHECK(last.cpus == 4);
+    CHECK(last.types[2] == "NET_RX");
+    CHECK(last.find("NET_RX") == 2);
+    CHECK(last.find("BLOCK") == 4);
+    CHECK(last.totals[1] == 0.0);
+
+    // CPU3 is offline; CPU0 takes 300 of the 400 NET_RX/s
+    softirqs.parse("                    CPU0       CPU1       CPU2       CPU3\n"
+                   "          HI:          1          0          0          0\n"
+                   "       TIMER:       1500       1500       1500          0\n"
+                   "      NET_RX:        400        150        150          0\n"
+                   "         RCU:        500        500        500          0\n", start + std::chrono::milliseconds(500));
+    CHECK(last.rate(1, 0) == Catch::Approx(1000.0));
+    CHECK(last.rate(2, 0) == Catch::Approx(600.0));
+    CHECK(last.rate(2, 1) == Catch::Approx(100.0));
+    CHECK(last.rate(2, 3) == 0.0);
+    CHECK(last.totals[2] == Catch::Approx(800.0));
+    CHECK(last.net_rx_busiest == 0);
+    CHECK(last.net_rx_imbalance == Catch::Approx(600.0 / (800.0 / 3)));
+
+    // Columns are CPU ids, not positions: with CPU1 not possible at all
+    // (e.g. maxcpus) the busiest column is CPU2
+    Softirqs sparse;
+    sparse.parse("                    CPU0       CPU2       CPU3\n"
+                 "      NET_RX:        100        100          0\n", start);
+    sparse.parse("                    CPU0       CPU2       CPU3\n"
+                 "      NET_RX:        150        400          0\n", start + std::chrono::seconds(1));
+    CHECK(sparse.last().cpu_ids == std::vector<uint32_t>{0, 2, 3});
+    CHECK(sparse.last().net_rx_busiest == 2);
+    CHECK(sparse.last().rate(0, 1) == Catch::Approx(300.0));
+
+    // A CPU coming online changes the layout: no rates until the next parse
+    softirqs.parse("                    CPU0       CPU1       CPU2       CPU3       CPU4\n"
+                   "      NET_RX:        500        250        250          0          0\n", start + std::chrono::milliseconds(1000));
+    REQUIRE(last.types.size() == 1);
+    CHECK(last.cpus == 5);
+    CHECK(last.cpu_ids.back() == 4);
+    CHECK(last.totals[0] == 0.0);
+    CHECK(last.net_rx_imbalance == 0.0);
+
+    Softirqs local;
+    local.sample();
+    CHECK(local.last().find("NET_RX") < local.last().types.size());
+}
+
+// Scheduler Tests
+// load averages and run-queue wait per CPU over the interval
+TEST_CASE("Monitor::Scheduler", "[system_monitor][Scheduler]") {
+    using Scheduler = system_monitor::Scheduler;
+    auto schedstat = [](unsigned long long delay0, unsigned long long slices0, unsigned long long delay1, unsigned long long slices1,
+                        unsigned long long run0 = 900000000, unsigned long long run1 = 900000000) {
+        return "version 15\ntimestamp 4295893456\n"
+               "cpu0 0 0 5000 200 3000 1000 " + std::to_string(run0) + " " + std::to_string(delay0) + " " + std::to_string(slices0) + "\n"
+               "domain0 00000003 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20 21 22 23 24 25 26 27 28 29 30 31 32 33 34 35 36\n"
+               "cpu1 0 0 5000 200 3000 1000 " + std::to_string(run1) + " " + std::to_string(delay1) + " " + std::to_string(slices1) + "\n"
+               "domain0 00000003 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20 21 22 23 24 25 26 27 28 29 30 31 32 33 34 35 36\n";
+    };
+
+    Scheduler scheduler;
+    auto now = std::chrono::steady_clock::now();
+    scheduler.parse("0.52 1.58 12.00 3/1234 56789\n", schedstat(1000000, 100, 0, 0), now);
+    const auto& last = scheduler.last();
+    CHECK(last.load_averages[0] == Catch::Approx(0.52));
+    CHECK(last.load_averages[2] == Catch::Approx(12.0));
+    CHECK(last.runnable == 3);
+    CHECK(last.tasks == 1234);
+    REQUIRE(last.core_latencies.size() == 2);
+    CHECK(last.core_latencies[0] == 0.0);           // no previous counters
+
+    // cpu0: 500 ms waited over 1000 timeslices in 1 s, ran tasks for 800 ms;
+    // cpu1 never waited and ran for 200 ms
+    scheduler.parse("0.60 1.60 11.90 9/1240 56800\n", schedstat(501000000, 1100, 0, 400, 1700000000, 1100000000),
+                    now + std::chrono::seconds(1));
+    CHECK(last.core_latencies[0] == Catch::Approx(500.0));
+    CHECK(last.core_waiting[0] == Catch::Approx(0.5));
+    CHECK(last.core_latencies[1] == 0.0);
+    CHECK(last.latency == Catch::Approx(500000.0 / 1400.0));
+    CHECK(last.waiting == Catch::Approx(0.5));
+    REQUIRE(last.core_running.size() == 2);
+    CHECK(last.core_running[0] == Catch::Approx(0.8));
+    CHECK(last.core_running[1] == Catch::Approx(0.2));
+    CHECK(last.running == Catch::Approx(0.5));
+    CHECK(last.runnable == 9);
+
+    // counters reset on one CPU: no rate for it
+    scheduler.parse("0.60 1.60 11.90 9/1240 56800\n", schedstat(1000, 10, 2000000, 400, 1000, 1600000000), now + std::chrono::seconds(2));
+    CHECK(last.core_waiting[0] == 0.0);
+    CHECK(last.core_latencies[1] == 0.0);           // no timeslice
+    CHECK(last.core_waiting[1] == Catch::Approx(0.002));
+    CHECK(last.core_running[0] == 0.0);
+    CHECK(last.core_running[1] == Catch::Approx(0.5));
+
+    // without schedstats only the load is known
+    Scheduler plain;
+    plain.parse("1.00 2.00 3.00 1/100 1\n", "", now);
+    CHECK(plain.last().load_averages[1] == Catch::Approx(2.0));
+    CHECK(plain.last().core_latencies.empty());
+
+    Scheduler local;
+    local.sample();
+    CHECK(local.last().tasks > 0);
+}
+
 // Network Tests
 // download and upload rate
 TEST_CASE("Monitor::Network get_download_rate and get_upload_rate", "[system_monitor][Network]") {
@@ -79,6 +354,41 @@ TEST_CASE("Monitor::Network get_download_rate and get_upload_rate", "[system_mon
 
 }
 
+// rates of the primary wireless interface; tx_bytes is the 9th column
+TEST_CASE("Monitor::Network parse", "[system_monitor][Network]") {
+    const char* wireless =
+        "Inter-| sta-|   Quality        |   Discarded packets               | Missed | WE\n"
+        " face | tus | link level noise |  nwid  crypt   frag  retry   misc | beacon | 22\n"
+        "wlp3s0: 0000   54.  -56.  -256        0      0      0      0     23        0\n";
+    auto netdev = [](unsigned long long rx, unsigned long long tx) {
+        return "Inter-|   Receive                                                |  Transmit\n"
+               " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n"
+               "    lo:  999999     100    0    0    0     0          0         0   999999     100    0    0    0     0       0          0\n"
+               "wlp3s0x: 5 5 0 0 0 0 0 0 5 5 0 0 0 0 0 0\n"
+               "wlp3s0:" + std::to_string(rx) + "   81234    0    0    0     0          0         0 " + std::to_string(tx)
+               + "   4321    0    0    0     0       0          0\n";
+    };
+
+    system_monitor::Network net;
+    auto now = std::chrono::steady_clock::now();
+    net.parse(wireless, netdev(1000000, 20000), now);
+    CHECK(net.last().download_rate == 0.0);         // no previous counters
+    net.parse(wireless, netdev(3000000, 520000), now + std::chrono::seconds(2));
+    CHECK(net.last().download_rate == Catch::Approx(1000000.0));
+    CHECK(net.last().upload_rate == Catch::Approx(250000.0));
+
+    // counters restarted (interface down and up)
+    net.parse(wireless, netdev(1000, 500), now + std::chrono::seconds(3));
+    CHECK(net.last().download_rate == 0.0);
+    CHECK(net.last().upload_rate == 0.0);
+
+    // no wireless interface, no rates
+    system_monitor::Network wired;
+    wired.parse("", netdev(1000000, 20000), now);
+    wired.parse("", netdev(3000000, 520000), now + std::chrono::seconds(2));
+    CHECK(wired.last().download_rate == 0.0);
+}
+
 // RAM Tests
 // usage
 TEST_CASE("Monitor::RAM get_usage", "[system_monitor][Ram]") {
@@ -117,6 +427,78 @@ TEST_CASE("Monitor::RAM total/free/used", "[system_monitor][Ram]") {
     CHECK(total == Catch::Approx(free + used).epsilon(0.5));        // total should be approximately constistent with free + used
 }
 
+// /proc/meminfo parsing, page cache counts as available
+TEST_CASE("Monitor::RAM parse meminfo", "[system_monitor][Ram]") {
+    system_monitor::Monitor::Ram ram;
+
+    ram.parse("MemTotal:       16000000 kB\n"
+              "MemFree:         1000000 kB\n"
+              "MemAvailable:   12000000 kB\n"
+              "Buffers:          500000 kB\n"
+              "Cached:         10000000 kB\n"
+              "SwapCached:            0 kB\n"
+              "SwapTotal:       2000000 kB\n"
+              "SwapFree:        1500000 kB\n"
+              "Dirty:               128 kB\n"
+              "Writeback:             4 kB\n"
+              "Shmem:            300000 kB\n"
+              "Slab:             700000 kB\n"
+              "HugePages_Total:       0\n");
+    auto sample = ram.last();
+    CHECK(sample.total == 16000000ull * 1024);
+    CHECK(sample.free == 1000000ull * 1024);
+    CHECK(sample.available == 12000000ull * 1024);
+    CHECK(sample.used == 4000000ull * 1024);
+    CHECK(sample.usage == Catch::Approx(0.25));
+    CHECK(sample.buffers == 500000ull * 1024);
+    CHECK(sample.cached == 10000000ull * 1024);
+    CHECK(sample.swap_total == 2000000ull * 1024);
+    CHECK(sample.swap_free == 1500000ull * 1024);
+    CHECK(sample.dirty == 128ull * 1024);
+    CHECK(sample.writeback == 4ull * 1024);
+    CHECK(sample.shmem == 300000ull * 1024);
+    CHECK(sample.slab == 700000ull * 1024);
+
+    // Same layout, new values
+    ram.parse("MemTotal:       16000000 kB\n"
+              "MemFree:         2000000 kB\n"
+              "MemAvailable:    8000000 kB\n"
+              "Buffers:          500000 kB\n"
+              "Cached:         10000000 kB\n"
+              "SwapCached:            0 kB\n"
+              "SwapTotal:       2000000 kB\n"
+              "SwapFree:        1500000 kB\n"
+              "Dirty:               256 kB\n"
+              "Writeback:             4 kB\n"
+              "Shmem:            300000 kB\n"
+              "Slab:             700000 kB\n");
+    CHECK(ram.last().usage == Catch::Approx(0.5));
+    CHECK(ram.last().dirty == 256ull * 1024);
+
+    // Different layout (e.g. another kernel), the line table is rebuilt
+    ram.parse("MemTotal:       8000000 kB\n"
+              "MemAvailable:   2000000 kB\n"
+              "MemFree:        1000000 kB\n");
+    CHECK(ram.last().total == 8000000ull * 1024);
+    CHECK(ram.last().available == 2000000ull * 1024);
+    CHECK(ram.last().free == 1000000ull * 1024);
+    CHECK(ram.last().usage == Catch::Approx(0.75));
+}
+
+TEST_CASE("Monitor::RAM sample", "[system_monitor][Ram]") {
+    system_monitor::Monitor::Ram ram;
+    ram.sample();
+    const auto& sample = ram.last();
+
+    CHECK(sample.total > 0);
+    CHECK(sample.available <= sample.total);
+    CHECK(sample.free <= sample.total);
+    CHECK(sample.used == sample.total - sample.available);
+    CHECK(sample.swap_free <= sample.swap_total);
+    CHECK(sample.usage >= 0.0);
+    CHECK(sample.usage <= 1.0);
+}
+
 // Drive Tests
 // usage
 TEST_CASE("Monitor::Drive get_usage", "[system_monitor][Drive]") {
@@ -165,6 +547,17 @@ TEST_CASE("Monitor::Drive path", "[system_monitor][Drive]") {
     CHECK(drive.used("/wrong/path/for/total/test") == 0);
 }
 
+// mount points
+TEST_CASE("Monitor::Drive get_mount_points", "[system_monitor][Drive]") {
+    system_monitor::Monitor::Drive drive;
+
+    auto mounts = drive.get_mount_points();
+    REQUIRE(!mounts.empty());
+    CHECK(mounts.front() == "/");       // root always comes first
+    for(const auto& mount : mounts)
+        CHECK(mount.front() == '/');    // absolute paths only
+}
+
 // stress test of all
 TEST_CASE("Monitor::Ram and Drive don't crash over multiple valls", "[system_monitor][Ram][Drive]") {
     system_monitor::Monitor::Ram ram;
@@ -181,3 +574,41 @@ TEST_CASE("Monitor::Ram and Drive don't crash over multiple valls", "[system_mon
         drive.used();
     }
 }
+
+// Collector composition
+TEST_CASE("BasicMonitor composition and sample", "[system_monitor][BasicMonitor]") {
+    using namespace system_monitor;
+
+    static_assert(Collector<Cpu> && Collector<Ram> && Collector<Drive> && Collector<General> && Collector<Network>);
+    static_assert(!Collector<int>);
+
+    // A reduced monitor only knows its own collectors
+    using SmallMonitor = BasicMonitor<Cpu, Ram>;
+    static_assert(SmallMonitor::has<Cpu> && SmallMonitor::has<Ram>);
+    static_assert(!SmallMonitor::has<Drive> && !SmallMonitor::has<Network>);
+
+    SmallMonitor monitor;
+    monitor.sample();
+    monitor.sample();
+
+    CHECK(monitor.get<Cpu>().last().usage >= 0.0);
+    CHECK(monitor.get<Cpu>().last().usage <= 1.0);
+    CHECK(!monitor.get<Cpu>().last().core_usages.empty());
+    CHECK(monitor.get<Ram>().last().total > 0);
+    CHECK(monitor.get<Ram>().last().used <= monitor.get<Ram>().last().total);
+}
+
+// sample() of the full monitor
+TEST_CASE("Monitor sample", "[system_monitor][BasicMonitor]") {
+    system_monitor::Monitor monitor;
+    monitor.sample();
+
+    const auto& drive = monitor.get<system_monitor::Drive>().last();
+    REQUIRE(!drive.mounts.empty());
+    CHECK(drive.mounts.front().path == "/");
+    CHECK(drive.mounts.front().used <= drive.mounts.front().total);
+
+    const auto& general = monitor.get<system_monitor::General>().last();
+    CHECK(general.cpu_cores > 0);
+    CHECK(!general.kernel_version.empty());
+}
@@ -0,0 +1,25 @@
+#ifndef TEMP_TREE_TESTS_HPP
+#define TEMP_TREE_TESTS_HPP
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+namespace system_monitor::testing {
+
+    // Temporary directory removed with its contents at the end of the test;
+    // the cgroup-, sysfs- and procfs-like fixtures build their trees in it
+    struct TempTree {
+        std::filesystem::path root;
+
+        explicit TempTree(const std::string& prefix) {
+            std::string name = "/tmp/" + prefix + "XXXXXX";
+            root = mkdtemp(name.data());
+        }
+        ~TempTree() { std::filesystem::remove_all(root); }
+
+        TempTree(const TempTree&) = delete;
+        TempTree& operator=(const TempTree&) = delete;
+    };
+}
+
+#endif
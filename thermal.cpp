@@ -0,0 +1,162 @@
+#include "thermal.hpp"
+#include "procfs_parse.hpp"
+#include "sysfs.hpp"
+#include <cctype>
+#include <cstring>
+#include <utility>
+
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace system_monitor {
+
+    namespace {
+        // Without uevents sensors are discovered again every this many samples
+        constexpr size_t unwatched_rediscover_interval = 60;
+
+        // Zones and hwmon drivers measuring the CPU package or cores
+        bool is_cpu_sensor(std::string_view name) {
+            for(std::string_view cpu : {"x86_pkg_temp", "cpu-thermal", "cpu_thermal", "coretemp", "k10temp", "zenpower"}) {
+                if(name == cpu) return true;
+            }
+            return false;
+        }
+
+        // "thermal.<source>.<name>" with anything but letters and digits in the name as '_'
+        std::string metric_name(const Thermal::Sensor& sensor) {
+            std::string name = "thermal." + sensor.source + ".";
+            for(char c : sensor.name)
+                name += std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::tolower(static_cast<unsigned char>(c))) : '_';
+            return name;
+        }
+    }
+
+    Thermal::Thermal() : Thermal("/sys/class/thermal", "/sys/class/hwmon") {
+        unwatched_ = true;
+        uevents_ = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+        if(uevents_ < 0) return;
+        sockaddr_nl address{};
+        address.nl_family = AF_NETLINK;
+        address.nl_groups = 1;          // kernel uevents
+        if(bind(uevents_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            close(uevents_);
+            uevents_ = -1;
+            return;
+        }
+        unwatched_ = false;
+    }
+
+    Thermal::Thermal(std::string thermal_root, std::string hwmon_root)
+        : thermal_root_(std::move(thermal_root)), hwmon_root_(std::move(hwmon_root)) {}
+
+    Thermal::~Thermal() {
+        if(uevents_ >= 0) close(uevents_);
+    }
+
+    void Thermal::attach(ProcfsReader& reader) {
+        reader_.attach(reader);
+        files_.clear();
+        last_.sensors.clear();
+        changed_ = true;
+    }
+
+    void Thermal::prefetch() {
+        reader_.prefetch();
+    }
+
+    void Thermal::sample() {
+        if(poll_uevents()) discover();
+        reader_.read();
+
+        double hottest = 0.0, hottest_cpu = 0.0;
+        bool any = false, any_cpu = false;
+        for(size_t i = 0; i < files_.size(); ++i) {
+            Sensor& sensor = last_.sensors[i];
+            std::string_view text = reader_.data(files_[i]);
+            bool negative = !text.empty() && text[0] == '-';
+            const char* start = text.data() + negative;
+            unsigned long long millidegrees = 0;
+            sensor.valid = parse_number(start, text.data() + text.size(), millidegrees) != start;      // disabled zones fail with ENODATA
+            if(!sensor.valid) continue;
+            sensor.celsius = (negative ? -1.0 : 1.0) * static_cast<double>(millidegrees) / 1000.0;
+            if(!any || sensor.celsius > hottest) hottest = sensor.celsius;
+            any = true;
+            if(sensor.cpu && (!any_cpu || sensor.celsius > hottest_cpu)) hottest_cpu = sensor.celsius;
+            any_cpu = any_cpu || sensor.cpu;
+        }
+        last_.cpu_celsius = any_cpu ? hottest_cpu : hottest;
+    }
+
+    void Thermal::record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now) {
+        if(last_.sensors.empty()) return;
+        if(cpu_metric_ == MetricTable::no_metric)
+            cpu_metric_ = metrics.add("thermal.cpu");
+        if(metric_discovery_ != last_.discoveries) {
+            metric_ids_.clear();
+            for(const Sensor& sensor : last_.sensors)
+                metric_ids_.push_back(metrics.add(metric_name(sensor)));
+            metric_discovery_ = last_.discoveries;
+        }
+        metrics.record(cpu_metric_, last_.cpu_celsius, now);
+        for(size_t i = 0; i < metric_ids_.size(); ++i) {
+            if(last_.sensors[i].valid) metrics.record(metric_ids_[i], last_.sensors[i].celsius, now);
+        }
+    }
+
+    // True when thermal or hwmon devices were added or removed since the last call
+    bool Thermal::poll_uevents() {
+        bool changed = std::exchange(changed_, false);
+        if(uevents_ < 0)
+            return changed || (unwatched_ && ++samples_ % unwatched_rediscover_interval == 0);
+
+        // "add@/devices/virtual/thermal/thermal_zone3\0ACTION=add\0..."
+        char buffer[4096];
+        ssize_t n;
+        while((n = recv(uevents_, buffer, sizeof(buffer), 0)) > 0) {
+            count_syscalls();
+            std::string_view header(buffer, strnlen(buffer, static_cast<size_t>(n)));
+            bool added_or_removed = header.starts_with("add@") || header.starts_with("remove@");
+            if(added_or_removed && (header.find("/thermal/") != std::string_view::npos || header.find("/hwmon") != std::string_view::npos))
+                changed = true;
+        }
+        count_syscalls();          // the recv that found the socket empty
+        return changed;
+    }
+
+    // Lists the sensors and opens their temperature files; names are read once here
+    void Thermal::discover() {
+        reader_.close_all();
+        files_.clear();
+        last_.sensors.clear();
+
+        auto add = [&](const std::string& path, std::string name, std::string source) {
+            int file = reader_.open(path.c_str());
+            if(file < 0) return;
+            Sensor sensor;
+            sensor.cpu = is_cpu_sensor(name.substr(0, name.find(' ')));
+            sensor.name = std::move(name);
+            sensor.source = std::move(source);
+            last_.sensors.push_back(std::move(sensor));
+            files_.push_back(file);
+        };
+
+        for(uint32_t zone : numbered_entries(thermal_root_, "thermal_zone")) {
+            std::string dir = thermal_root_ + "/thermal_zone" + std::to_string(zone);
+            std::string type = read_line(dir + "/type");
+            add(dir + "/temp", type.empty() ? "thermal_zone" + std::to_string(zone) : type, "zone" + std::to_string(zone));
+        }
+
+        for(uint32_t hwmon : numbered_entries(hwmon_root_, "hwmon")) {
+            std::string dir = hwmon_root_ + "/hwmon" + std::to_string(hwmon);
+            std::string device = read_line(dir + "/name");
+            if(device.empty()) device = "hwmon" + std::to_string(hwmon);
+            for(uint32_t input : numbered_entries(dir, "temp", "_input")) {
+                std::string prefix = dir + "/temp" + std::to_string(input);
+                std::string label = read_line(prefix + "_label");
+                add(prefix + "_input", device + " " + (label.empty() ? "temp" + std::to_string(input) : label), "hwmon" + std::to_string(hwmon));
+            }
+        }
+        ++last_.discoveries;
+    }
+}
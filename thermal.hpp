@@ -0,0 +1,73 @@
+#ifndef THERMAL_HPP
+#define THERMAL_HPP
+#include <chrono>
+#include <string>
+#include <vector>
+#include "metrics.hpp"
+#include "procfs_reader.hpp"
+
+namespace system_monitor {
+
+    class Thermal {         // temperatures of the thermal zones and hwmon sensors
+        public:
+            static constexpr std::chrono::milliseconds period{1000};
+            static constexpr const char* name = "thermal";
+
+            struct Sensor {
+                std::string name;           // zone type, or hwmon name and label ("coretemp Package id 0")
+                std::string source;         // "zone<n>" or "hwmon<n>"; names repeat across zones, drives and sockets
+                double celsius = 0.0;
+                bool cpu = false;           // package or core sensor (coretemp, k10temp, x86_pkg_temp, ...)
+                bool valid = false;         // last read succeeded
+            };
+
+            struct Sample {
+                std::vector<Sensor> sensors;        // thermal zones, then hwmon sensors
+                double cpu_celsius = 0.0;           // hottest CPU sensor, else hottest sensor; 0 without any
+                size_t discoveries = 0;
+            };
+
+            // /sys/class/thermal and /sys/class/hwmon, discovered again on thermal
+            // and hwmon uevents (periodically if the uevent socket is unavailable)
+            Thermal();
+            // Other roots, e.g. a test tree; discovered again only through rediscover()
+            Thermal(std::string thermal_root, std::string hwmon_root);
+            ~Thermal();
+
+            Thermal(const Thermal&) = delete;
+            Thermal& operator=(const Thermal&) = delete;
+
+            void sample();
+            const Sample& last() const { return last_; }
+
+            void attach(ProcfsReader& reader);
+            void prefetch();
+
+            void record_metrics(MetricTable& metrics, std::chrono::steady_clock::time_point now);     // celsius, thermal.<source>.<name>
+
+            // Discovers the sensors again on the next sample
+            void rediscover() { changed_ = true; }
+
+        private:
+            std::string thermal_root_;
+            std::string hwmon_root_;
+            Sample last_;
+            std::vector<int> files_;            // temperature files, parallel to last_.sensors
+
+            ProcfsFileSet reader_;
+
+            int uevents_ = -1;                  // NETLINK_KOBJECT_UEVENT socket
+            bool unwatched_ = false;            // system roots without uevents, rediscovered periodically
+            bool changed_ = true;
+            size_t samples_ = 0;
+
+            MetricTable::Id cpu_metric_ = MetricTable::no_metric;
+            std::vector<MetricTable::Id> metric_ids_;       // per sensor
+            size_t metric_discovery_ = 0;                   // discovery the sensor metrics belong to
+
+            bool poll_uevents();
+            void discover();
+    };
+}
+
+#endif
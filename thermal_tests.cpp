@@ -0,0 +1,181 @@
+#include "catch_amalgamated.hpp"
+#include "thermal.hpp"
+#include "temp_tree_tests.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+    using system_monitor::MetricTable;
+    using system_monitor::ProcfsReader;
+    using system_monitor::Thermal;
+    using namespace std::chrono_literals;
+
+    // /sys/class/thermal and /sys/class/hwmon-like trees in a temporary directory
+    struct FakeSensors : system_monitor::testing::TempTree {
+        FakeSensors() : TempTree("thermal_test") {
+            std::filesystem::create_directories(root / "thermal" / "cooling_device0");     // not a zone
+            std::filesystem::create_directories(root / "hwmon");
+        }
+
+        std::string thermal() const { return (root / "thermal").string(); }
+        std::string hwmon() const { return (root / "hwmon").string(); }
+
+        void zone(unsigned id, const std::string& type, const std::string& temp) {
+            auto dir = root / "thermal" / ("thermal_zone" + std::to_string(id));
+            std::filesystem::create_directories(dir);
+            std::ofstream(dir / "type") << type << "\n";
+            std::ofstream(dir / "temp") << temp;
+        }
+
+        void device(unsigned id, const std::string& name) {
+            auto dir = root / "hwmon" / ("hwmon" + std::to_string(id));
+            std::filesystem::create_directories(dir);
+            std::ofstream(dir / "name") << name << "\n";
+        }
+
+        void input(unsigned device, unsigned id, const std::string& temp, const std::string& label = "") {
+            auto dir = root / "hwmon" / ("hwmon" + std::to_string(device));
+            std::ofstream(dir / ("temp" + std::to_string(id) + "_input")) << temp;
+            if(!label.empty()) std::ofstream(dir / ("temp" + std::to_string(id) + "_label")) << label << "\n";
+        }
+
+        void remove_device(unsigned id) { std::filesystem::remove_all(root / "hwmon" / ("hwmon" + std::to_string(id))); }
+    };
+}
+
+// Thermal Tests
+TEST_CASE("Thermal sensors", "[thermal]") {
+    FakeSensors sensors;
+    sensors.zone(0, "acpitz", "27800\n");
+    sensors.zone(1, "x86_pkg_temp", "54000\n");
+    sensors.zone(2, "iwlwifi_1", "");           // disabled zone, the read fails
+    sensors.device(0, "coretemp");
+    sensors.input(0, 1, "55000\n", "Package id 0");
+    sensors.input(0, 2, "58500\n", "Core 0");
+    sensors.device(1, "nvme");
+    sensors.input(1, 1, "64850\n");
+    sensors.zone(3, "acpitz", "30000\n");      // names repeat across zones, drives and sockets
+    sensors.device(2, "nvme");
+    sensors.input(2, 1, "40000\n");
+
+    Thermal thermal(sensors.thermal(), sensors.hwmon());
+    thermal.sample();
+    const auto& last = thermal.last();
+    REQUIRE(last.sensors.size() == 8);
+    CHECK(last.discoveries == 1);
+    CHECK(last.sensors[0].name == "acpitz");
+    CHECK(last.sensors[0].celsius == Catch::Approx(27.8));
+    CHECK_FALSE(last.sensors[0].cpu);
+    CHECK(last.sensors[1].cpu);
+    CHECK_FALSE(last.sensors[2].valid);
+    CHECK(last.sensors[3].name == "acpitz");
+    CHECK(last.sensors[3].source == "zone3");
+    CHECK(last.sensors[4].name == "coretemp Package id 0");
+    CHECK(last.sensors[5].name == "coretemp Core 0");
+    CHECK(last.sensors[5].source == "hwmon0");
+    CHECK(last.sensors[5].cpu);
+    CHECK(last.sensors[6].name == "nvme temp1");
+    CHECK(last.sensors[6].celsius == Catch::Approx(64.85));
+    CHECK(last.cpu_celsius == Catch::Approx(58.5));     // the hotter nvme is no CPU sensor
+
+    // Values are re-read through the open files, names are not
+    sensors.input(0, 2, "61000\n");
+    sensors.zone(1, "renamed", "53000\n");
+    thermal.sample();
+    CHECK(last.discoveries == 1);
+    CHECK(last.sensors[1].name == "x86_pkg_temp");
+    CHECK(last.sensors[5].celsius == Catch::Approx(61.0));
+    CHECK(last.cpu_celsius == Catch::Approx(61.0));
+
+    MetricTable metrics;
+    auto now = std::chrono::steady_clock::now();
+    thermal.record_metrics(metrics, now);
+    REQUIRE(metrics.find("thermal.cpu") != MetricTable::no_metric);
+    CHECK(metrics.last(metrics.find("thermal.cpu")) == Catch::Approx(61.0));
+    REQUIRE(metrics.find("thermal.hwmon0.coretemp_package_id_0") != MetricTable::no_metric);
+    REQUIRE(metrics.find("thermal.hwmon1.nvme_temp1") != MetricTable::no_metric);
+    CHECK(metrics.last(metrics.find("thermal.hwmon1.nvme_temp1")) == Catch::Approx(64.85));
+    CHECK(metrics.last(metrics.find("thermal.hwmon2.nvme_temp1")) == Catch::Approx(40.0));
+    CHECK(metrics.last(metrics.find("thermal.zone0.acpitz")) == Catch::Approx(27.8));
+    CHECK(metrics.last(metrics.find("thermal.zone3.acpitz")) == Catch::Approx(30.0));
+}
+
+// Sensors that appear or go away are only seen after a rediscovery
+TEST_CASE("Thermal rediscovery", "[thermal]") {
+    FakeSensors sensors;
+    sensors.device(0, "k10temp");
+    sensors.input(0, 1, "48000\n", "Tctl");
+
+    ProcfsReader reader(ProcfsReader::Backend::pread);
+    Thermal thermal(sensors.thermal(), sensors.hwmon());
+    thermal.attach(reader);
+    thermal.sample();
+    REQUIRE(thermal.last().sensors.size() == 1);
+    CHECK(thermal.last().cpu_celsius == Catch::Approx(48.0));
+    size_t files = reader.size();
+
+    sensors.device(1, "amdgpu");
+    sensors.input(1, 1, "71000\n", "edge");
+    thermal.prefetch();
+    reader.read_queued();
+    thermal.sample();
+    CHECK(thermal.last().sensors.size() == 1);
+
+    thermal.rediscover();
+    thermal.sample();
+    REQUIRE(thermal.last().sensors.size() == 2);
+    CHECK(thermal.last().sensors[1].name == "amdgpu edge");
+    CHECK(thermal.last().cpu_celsius == Catch::Approx(48.0));
+    CHECK(thermal.last().discoveries == 2);
+
+    sensors.remove_device(0);
+    thermal.rediscover();
+    thermal.sample();
+    REQUIRE(thermal.last().sensors.size() == 1);
+    CHECK(thermal.last().cpu_celsius == Catch::Approx(71.0));       // no CPU sensor left, hottest overall
+    CHECK(reader.size() == files);              // the old descriptors were closed
+
+    Thermal missing((sensors.root / "missing").string(), (sensors.root / "missing").string());
+    missing.sample();
+    CHECK(missing.last().sensors.empty());
+    CHECK(missing.last().cpu_celsius == 0.0);
+}
+
+// 50 sensors re-read in a batch, the tick cost of the collector
+TEST_CASE("Thermal throughput", "[thermal][benchmark]") {
+    FakeSensors sensors;
+    for(unsigned device = 0; device < 5; ++device) {
+        sensors.device(device, "coretemp");
+        for(unsigned input = 1; input <= 10; ++input)
+            sensors.input(device, input, std::to_string(40000 + input * 1000) + "\n", "Core " + std::to_string(input));
+    }
+
+    ProcfsReader reader;
+    Thermal thermal(sensors.thermal(), sensors.hwmon());
+    thermal.attach(reader);
+    thermal.sample();
+    REQUIRE(thermal.last().sensors.size() == 50);
+
+    constexpr int samples = 1000;
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < samples; ++i) {
+        thermal.prefetch();
+        reader.read_queued();
+        thermal.sample();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    CHECK(thermal.last().cpu_celsius == Catch::Approx(50.0));
+    CHECK(thermal.last().discoveries == 1);
+    CHECK(elapsed < 1000ms);        // under 1 ms per tick
+}
+
+// The system's sensors, if any
+TEST_CASE("Thermal system", "[thermal]") {
+    Thermal thermal;
+    thermal.sample();
+    for(const auto& sensor : thermal.last().sensors) {
+        if(sensor.valid) CHECK(sensor.celsius > -60.0);
+    }
+}
@@ -0,0 +1,96 @@
+#include "timer_wheel.hpp"
+#include <algorithm>
+
+namespace system_monitor {
+
+    void TimerWheel::schedule(uint32_t id, uint64_t delay) {
+        insert({id, now_ + std::max<uint64_t>(delay, 1)});
+        ++size_;
+    }
+
+    // The level is chosen by the distance to the expiry, the slot by the expiry itself
+    void TimerWheel::insert(const Timer& timer) {
+        uint64_t delta = timer.expiry > now_ ? timer.expiry - now_ : 0;
+        int level = 0;
+        while(level + 1 < n_levels && delta >= (uint64_t(1) << (slot_bits * (level + 1))))
+            ++level;
+
+        // Timers beyond the last level wait in its farthest slot and get re-inserted
+        uint64_t expiry = timer.expiry;
+        if(level == n_levels - 1 && delta >= (uint64_t(1) << (slot_bits * n_levels)))
+            expiry = now_ + (uint64_t(1) << (slot_bits * n_levels)) - 1;
+
+        size_t slot = static_cast<size_t>((expiry >> (slot_bits * level)) & (n_slots - 1));
+        slots_[static_cast<size_t>(level)][slot].push_back(timer);
+    }
+
+    // Moves the timers of the current slot of a level one level down
+    void TimerWheel::cascade(int level) {
+        size_t slot = static_cast<size_t>((now_ >> (slot_bits * level)) & (n_slots - 1));
+        std::vector<Timer> timers;
+        timers.swap(slots_[static_cast<size_t>(level)][slot]);
+        for(const Timer& timer : timers)
+            insert(timer);
+    }
+
+    void TimerWheel::advance(uint64_t now, std::vector<uint32_t>& due) {
+        if(size_ == 0) {            // nothing to cascade, jump
+            now_ = std::max(now_, now);
+            return;
+        }
+
+        while(now_ < now) {
+            ++now_;
+
+            // Cascade higher levels when the lower bits wrap
+            for(int level = 1; level < n_levels; ++level) {
+                if((now_ & ((uint64_t(1) << (slot_bits * level)) - 1)) != 0) break;
+                cascade(level);
+            }
+
+            auto& slot = slots_[0][static_cast<size_t>(now_ & (n_slots - 1))];
+            for(size_t i = 0; i < slot.size();) {
+                if(slot[i].expiry <= now_) {
+                    due.push_back(slot[i].id);
+                    slot[i] = slot.back();
+                    slot.pop_back();
+                    --size_;
+                } else {
+                    ++i;
+                }
+            }
+            if(size_ == 0) {
+                now_ = now;
+                return;
+            }
+        }
+    }
+
+    // Level 0 slots expire at their tick, higher levels at their cascade
+    uint64_t TimerWheel::next_expiry() const {
+        if(size_ == 0) return no_expiry;
+
+        uint64_t next = no_expiry;
+        for(int level = 0; level < n_levels; ++level) {
+            int shift = slot_bits * level;
+            uint64_t base = now_ >> shift;
+            for(uint64_t k = 1; k <= n_slots; ++k) {
+                uint64_t tick = (base + k) << shift;
+                if(tick >= next) break;
+                if(!slots_[static_cast<size_t>(level)][static_cast<size_t>((base + k) & (n_slots - 1))].empty()) {
+                    next = tick;
+                    break;
+                }
+            }
+        }
+        return next;
+    }
+
+    void TimerWheel::clear() {
+        for(auto& level : slots_) {
+            for(auto& slot : level)
+                slot.clear();
+        }
+        size_ = 0;
+    }
+}
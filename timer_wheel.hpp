@@ -0,0 +1,47 @@
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace system_monitor {
+
+    // Hierarchical timer wheel (4 levels of 64 slots) counting in abstract ticks.
+    // Timers due on the same tick are returned together by advance().
+    class TimerWheel {
+        public:
+            static constexpr int slot_bits = 6;
+            static constexpr size_t n_slots = size_t(1) << slot_bits;
+            static constexpr int n_levels = 4;
+            static constexpr uint64_t no_expiry = ~uint64_t(0);
+
+            // Fires id `delay` ticks from now (a delay of 0 fires on the next tick)
+            void schedule(uint32_t id, uint64_t delay);
+
+            // Moves the wheel forward to tick `now` and appends the ids of the expired timers to due
+            void advance(uint64_t now, std::vector<uint32_t>& due);
+
+            // Earliest tick at which advance() can have something to do, no_expiry if empty
+            uint64_t next_expiry() const;
+
+            uint64_t now() const { return now_; }
+            size_t size() const { return size_; }
+            void clear();
+
+        private:
+            struct Timer {
+                uint32_t id;
+                uint64_t expiry;
+            };
+
+            std::array<std::array<std::vector<Timer>, n_slots>, n_levels> slots_;
+            uint64_t now_ = 0;
+            size_t size_ = 0;
+
+            void insert(const Timer& timer);
+            void cascade(int level);
+    };
+}
+
+#endif
@@ -0,0 +1,76 @@
+#include "catch_amalgamated.hpp"
+#include "timer_wheel.hpp"
+#include <algorithm>
+#include <vector>
+
+// TimerWheel Tests
+// expiry on the right tick
+TEST_CASE("TimerWheel schedule/advance", "[timer_wheel]") {
+    system_monitor::TimerWheel wheel;
+    std::vector<uint32_t> due;
+
+    wheel.schedule(1, 10);
+    wheel.schedule(2, 10);
+    wheel.schedule(3, 25);
+    CHECK(wheel.size() == 3);
+    CHECK(wheel.next_expiry() == 10);
+
+    wheel.advance(9, due);
+    CHECK(due.empty());
+
+    wheel.advance(10, due);
+    std::sort(due.begin(), due.end());
+    CHECK(due == std::vector<uint32_t>{1, 2});      // batched on the same tick
+    CHECK(wheel.next_expiry() == 25);
+
+    due.clear();
+    wheel.advance(100, due);
+    CHECK(due == std::vector<uint32_t>{3});
+    CHECK(wheel.size() == 0);
+    CHECK(wheel.next_expiry() == system_monitor::TimerWheel::no_expiry);
+}
+
+// delays on every level of the wheel
+TEST_CASE("TimerWheel long delays", "[timer_wheel]") {
+    system_monitor::TimerWheel wheel;
+    std::vector<uint32_t> due;
+
+    const std::vector<uint64_t> delays = {1, 63, 64, 65, 3000, 4095, 4096, 300000, 20000000};
+    for(uint32_t i = 0; i < delays.size(); ++i)
+        wheel.schedule(i, delays[i]);
+
+    // step from expiry to expiry, every timer has to fire exactly on its tick
+    for(uint32_t i = 0; i < delays.size(); ++i) {
+        uint64_t next = wheel.next_expiry();
+        REQUIRE(next <= delays[i]);
+        due.clear();
+        wheel.advance(delays[i] - 1, due);
+        CHECK(due.empty());
+        wheel.advance(delays[i], due);
+        CHECK(due == std::vector<uint32_t>{i});
+    }
+    CHECK(wheel.size() == 0);
+}
+
+// periodic rescheduling
+TEST_CASE("TimerWheel periodic timers", "[timer_wheel]") {
+    system_monitor::TimerWheel wheel;
+    std::vector<uint32_t> due;
+    int fast = 0, slow = 0;
+
+    wheel.schedule(0, 10);
+    wheel.schedule(1, 3000);
+    for(uint64_t tick = 1; tick <= 6000; ++tick) {
+        due.clear();
+        wheel.advance(tick, due);
+        for(uint32_t id : due) {
+            if(id == 0) { ++fast; wheel.schedule(0, 10); }
+            else { ++slow; wheel.schedule(1, 3000); }
+        }
+    }
+    CHECK(fast == 600);
+    CHECK(slow == 2);
+
+    wheel.clear();
+    CHECK(wheel.size() == 0);
+}